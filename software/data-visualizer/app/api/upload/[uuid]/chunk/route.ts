@@ -1,3 +1,4 @@
+import { RUN_CONTAINER_FILE, unpackRunContainer } from "@/lib/dlf-container";
 import {
   BufferAdapter,
   DLF_FILES,
@@ -13,7 +14,7 @@ import { NextRequest, NextResponse, after } from "next/server";
 
 export const dynamic = "force-dynamic";
 
-const ACCEPTED_FILES = new Set<string>(DLF_FILES);
+const ACCEPTED_FILES = new Set<string>([...DLF_FILES, RUN_CONTAINER_FILE]);
 const MERGE_CHUNK_INTERVAL = 10;
 
 /**
@@ -22,7 +23,8 @@ const MERGE_CHUNK_INTERVAL = 10;
  * Receives a single binary chunk for a DLF file.
  *
  * Required headers:
- *   x-filename: file name, such as "polled.dlf"
+ *   x-filename: file name, such as "polled.dlf", or "run.dlf" for a run
+ *     logged as a container
  *   x-chunk-number: one-based chunk number (integer)
  *
  * Optional headers:
@@ -128,6 +130,8 @@ export async function POST(
 
   // Keep the DB run record current.
   // On meta.dlf chunk #1 the run record is created if it doesn't exist yet.
+  // A container holds meta.dlf in its first sections, so run.dlf chunk #1
+  // does the same.
   // All other chunks update isActive (and optionally durationS) if the run exists.
   const isActive = request.headers.get("x-is-active") === "true";
   const durationSHeader = request.headers.get("x-duration-s");
@@ -140,9 +144,16 @@ export async function POST(
     create: { id: deviceId },
   });
 
-  if (filename === "meta.dlf" && chunkNumber === 1) {
+  let metaBytes: Buffer | null = null;
+  if (chunkNumber === 1 && filename === "meta.dlf") {
+    metaBytes = Buffer.from(body);
+  } else if (chunkNumber === 1 && filename === RUN_CONTAINER_FILE) {
+    metaBytes = unpackRunContainer(Buffer.from(body))?.get("meta.dlf") ?? null;
+  }
+
+  if (metaBytes) {
     try {
-      const metaAdapter = new BufferAdapter(Buffer.from(body), null, null);
+      const metaAdapter = new BufferAdapter(metaBytes, null, null);
       const meta = await metaAdapter.getMetaDlf();
       await prisma.run.upsert({
         where: { uuid },
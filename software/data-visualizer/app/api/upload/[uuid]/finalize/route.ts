@@ -1,3 +1,4 @@
+import { RUN_CONTAINER_FILE, unpackRunContainer } from "@/lib/dlf-container";
 import {
   BufferAdapter,
   DLF_FILES,
@@ -70,8 +71,10 @@ async function computeRunDurationS(
  *   x-is-active: "true" if the run is still recording, omit or any other value for false.
  *
  * Returns 202 immediately; assembly + S3 upload + DB write happen in background.
- * All three DLF files (meta.dlf, polled.dlf, event.dlf) are assembled from their
- * chunks. Files with no chunks are silently skipped.
+ * All DLF files (meta.dlf, polled.dlf, event.dlf and the optional event.idx)
+ * are assembled from their chunks. Files with no chunks are skipped. A run
+ * logged as a container uploads run.dlf instead, which is assembled and
+ * unpacked into those files.
  */
 export async function POST(
   request: NextRequest,
@@ -131,7 +134,22 @@ export async function POST(
     try {
       // Assemble all DLF files from chunks into memory, skipping files with no chunks
       const fileBuffers = new Map<string, Buffer>();
+      const chunkedFiles: string[] = [];
+      const container = await assembleChunksToBuffer(uuid, RUN_CONTAINER_FILE);
+      if (container) {
+        const files = unpackRunContainer(container);
+        console.log(
+          `[api/upload/finalize] Unpacked ${RUN_CONTAINER_FILE} for ${uuid} (${container.byteLength} bytes): [${[...(files?.keys() ?? [])].join(", ")}]`,
+        );
+        for (const [filename, buf] of files ?? []) {
+          fileBuffers.set(filename, buf);
+        }
+        chunkedFiles.push(RUN_CONTAINER_FILE);
+      }
       for (const filename of DLF_FILES) {
+        if (fileBuffers.has(filename)) {
+          continue;
+        }
         const buf = await assembleChunksToBuffer(uuid, filename);
         if (!buf) {
           console.warn(
@@ -143,6 +161,7 @@ export async function POST(
           `[api/upload/finalize] Assembled chunks for ${uuid}/${filename} (${buf.byteLength} bytes)`,
         );
         fileBuffers.set(filename, buf);
+        chunkedFiles.push(filename);
       }
 
       if (fileBuffers.size === 0) {
@@ -250,7 +269,7 @@ export async function POST(
         console.log(
           `[api/upload/finalize] Run complete. Deleting all chunks for run ${uuid}`,
         );
-        for (const filename of fileBuffers.keys()) {
+        for (const filename of chunkedFiles) {
           const chunkKeys = await listChunkKeys(uuid, filename);
           for (let i = 0; i < chunkKeys.length; i += 1000) {
             await s3Client.send(
@@ -1,3 +1,4 @@
+import { RUN_CONTAINER_FILE, unpackRunContainer } from "@/lib/dlf-container";
 import { BufferAdapter, DLF_FILES, dlfS3Key } from "@/lib/dlf-s3";
 import prisma from "@/lib/prisma";
 import { s3Client } from "@/lib/s3";
@@ -133,10 +134,21 @@ export async function POST(
     }
   }
 
-  // Read accepted files into memory
+  // Read accepted files into memory. A run logged as a container sends
+  // run.dlf instead, which is unpacked into the files it holds.
   const fileBuffers = new Map<string, Buffer>();
   for (const file of formData.getAll("files")) {
-    if (!(file instanceof File) || !ACCEPTED_FILES.has(file.name)) {
+    if (!(file instanceof File)) {
+      continue;
+    }
+    if (file.name === RUN_CONTAINER_FILE) {
+      const files = unpackRunContainer(Buffer.from(await file.arrayBuffer()));
+      for (const [filename, buf] of files ?? []) {
+        fileBuffers.set(filename, buf);
+      }
+      continue;
+    }
+    if (!ACCEPTED_FILES.has(file.name)) {
       continue;
     }
     fileBuffers.set(file.name, Buffer.from(await file.arrayBuffer()));
@@ -0,0 +1,89 @@
+import { unpackRunContainer } from "@/lib/dlf-container";
+import { describe, expect, it } from "vitest";
+
+function header(): Buffer {
+  const buf = Buffer.alloc(13);
+  buf.writeUInt16LE(0x8416, 0); // magic
+  buf.writeUInt16LE(13, 2); // header_size
+  return buf;
+}
+
+function section(tag: number, body: Buffer): Buffer {
+  const head = Buffer.alloc(5);
+  head.writeUInt8(tag, 0);
+  head.writeUInt32LE(body.byteLength, 1);
+  return Buffer.concat([head, body]);
+}
+
+function commit(tick: number, polledBytes: number, eventBytes: number) {
+  const body = Buffer.alloc(24);
+  body.writeBigUInt64LE(BigInt(tick), 0);
+  body.writeBigUInt64LE(BigInt(polledBytes), 8);
+  body.writeBigUInt64LE(BigInt(eventBytes), 16);
+  return section(5, body);
+}
+
+describe("unpackRunContainer", () => {
+  it("rejects a buffer without the container magic", () => {
+    expect(unpackRunContainer(Buffer.from([0x14, 0x84, 0, 0]))).toBeNull();
+  });
+
+  it("concatenates the sections of each file", () => {
+    const files = unpackRunContainer(
+      Buffer.concat([
+        header(),
+        section(1, Buffer.from("meta")),
+        section(2, Buffer.from("pol")),
+        section(3, Buffer.from("ev")),
+        section(2, Buffer.from("led")),
+        section(4, Buffer.from("idx")),
+      ]),
+    )!;
+    expect(files.get("meta.dlf")?.toString()).toBe("meta");
+    expect(files.get("polled.dlf")?.toString()).toBe("polled");
+    expect(files.get("event.dlf")?.toString()).toBe("ev");
+    expect(files.get("event.idx")?.toString()).toBe("idx");
+  });
+
+  it("cuts polled and event data at the last commit", () => {
+    const files = unpackRunContainer(
+      Buffer.concat([
+        header(),
+        section(2, Buffer.from("abc")),
+        section(3, Buffer.from("xy")),
+        commit(1, 2, 1),
+        section(2, Buffer.from("d")),
+        commit(2, 4, 1),
+        section(3, Buffer.from("z")),
+      ]),
+    )!;
+    expect(files.get("polled.dlf")?.toString()).toBe("abcd");
+    expect(files.get("event.dlf")?.toString()).toBe("x");
+  });
+
+  it("stops at a torn section and skips unknown tags", () => {
+    const torn = section(2, Buffer.from("lost"));
+    const files = unpackRunContainer(
+      Buffer.concat([
+        header(),
+        section(9, Buffer.from("future")),
+        section(2, Buffer.from("kept")),
+        torn.subarray(0, torn.byteLength - 1),
+      ]),
+    )!;
+    expect([...files.keys()]).toEqual(["polled.dlf"]);
+    expect(files.get("polled.dlf")?.toString()).toBe("kept");
+  });
+
+  it("stops at a zero tag", () => {
+    const files = unpackRunContainer(
+      Buffer.concat([
+        header(),
+        section(1, Buffer.from("meta")),
+        Buffer.alloc(16),
+        section(2, Buffer.from("never")),
+      ]),
+    )!;
+    expect([...files.keys()]).toEqual(["meta.dlf"]);
+  });
+});
@@ -0,0 +1,82 @@
+/**
+ * Reader for run.dlf, the single file a device writes for a run instead of
+ * meta.dlf, polled.dlf, event.dlf and event.idx when the run is logged as a
+ * container (see dlf_run_container_header_t in dlflib's dlf_types.h).
+ */
+
+export const RUN_CONTAINER_FILE = "run.dlf";
+
+const RUN_CONTAINER_MAGIC = 0x8416;
+// uint16 magic, uint16 header_size
+const MIN_HEADER_BYTES = 4;
+// uint8 tag, uint32 length
+const SECTION_HEADER_BYTES = 5;
+
+const SECTION_FILES: Record<number, string> = {
+  1: "meta.dlf",
+  2: "polled.dlf",
+  3: "event.dlf",
+  4: "event.idx",
+};
+const SECTION_COMMIT = 5;
+// uint64 tick, uint64 polled_bytes, uint64 event_bytes
+const COMMIT_BYTES = 24;
+
+/**
+ * Splits a run container (or the part of it uploaded so far) into the files it
+ * holds, keyed by file name. Files without any data are left out.
+ *
+ * The sections of each file are concatenated in order. Sections stop at tag 0
+ * or at one that runs past the end of the buffer, which is what a torn write
+ * or a partial upload leaves. polled.dlf and event.dlf are cut at the lengths
+ * of the last commit record, as bytes past it may end in a torn record.
+ *
+ * Returns null if the buffer is not a run container.
+ */
+export function unpackRunContainer(buf: Buffer): Map<string, Buffer> | null {
+  if (
+    buf.byteLength < MIN_HEADER_BYTES ||
+    buf.readUInt16LE(0) !== RUN_CONTAINER_MAGIC
+  ) {
+    return null;
+  }
+
+  const sections = new Map<string, Buffer[]>();
+  let committed: Record<string, number> | null = null;
+  let pos = buf.readUInt16LE(2);
+  while (pos + SECTION_HEADER_BYTES <= buf.byteLength) {
+    const tag = buf.readUInt8(pos);
+    const length = buf.readUInt32LE(pos + 1);
+    const start = pos + SECTION_HEADER_BYTES;
+    if (tag === 0 || start + length > buf.byteLength) {
+      break;
+    }
+
+    const filename = SECTION_FILES[tag];
+    if (filename) {
+      const parts = sections.get(filename) ?? [];
+      parts.push(buf.subarray(start, start + length));
+      sections.set(filename, parts);
+    } else if (tag === SECTION_COMMIT && length >= COMMIT_BYTES) {
+      committed = {
+        "polled.dlf": Number(buf.readBigUInt64LE(start + 8)),
+        "event.dlf": Number(buf.readBigUInt64LE(start + 16)),
+      };
+    }
+    // Unknown tags are skipped
+    pos = start + length;
+  }
+
+  const files = new Map<string, Buffer>();
+  for (const [filename, parts] of sections) {
+    let data = Buffer.concat(parts);
+    const limit = committed?.[filename];
+    if (limit !== undefined && data.byteLength > limit) {
+      data = data.subarray(0, limit);
+    }
+    if (data.byteLength > 0) {
+      files.set(filename, data);
+    }
+  }
+  return files;
+}
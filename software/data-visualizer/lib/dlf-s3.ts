@@ -1,3 +1,4 @@
+import { RUN_CONTAINER_FILE, unpackRunContainer } from "@/lib/dlf-container";
 import { s3Client } from "@/lib/s3";
 import {
   DeleteObjectsCommand,
@@ -7,7 +8,14 @@ import {
 } from "@aws-sdk/client-s3";
 import { Adapter } from "dlflib-js";
 
-export const DLF_FILES = ["meta.dlf", "polled.dlf", "event.dlf"] as const;
+// event.idx is an optional seek index of event.dlf. It is stored with the
+// run, but the viewer does not read it.
+export const DLF_FILES = [
+  "meta.dlf",
+  "polled.dlf",
+  "event.dlf",
+  "event.idx",
+] as const;
 
 /**
  * Adapter that reads DLF files from in-memory buffers fetched from S3.
@@ -158,7 +166,8 @@ export async function mergeChunks(
  * Returns a BufferAdapter loaded with this run's DLF files from S3,
  * or null if no DLF files exist for this run.
  *
- * When isActive=true, assembles data directly from individual chunks.
+ * When isActive=true, assembles data directly from individual chunks, unpacking
+ * run.dlf for runs logged as a container.
  * When isActive=false, reads the assembled dlf files.
  */
 export async function getRunDlfAdapter(
@@ -172,7 +181,19 @@ export async function getRunDlfAdapter(
       assembleChunksToBuffer(runUuid, "event.dlf"),
     ]);
     if (!meta && !polled && !event) {
-      return null;
+      const container = await assembleChunksToBuffer(
+        runUuid,
+        RUN_CONTAINER_FILE,
+      );
+      const files = container ? unpackRunContainer(container) : null;
+      if (!files || files.size === 0) {
+        return null;
+      }
+      return new BufferAdapter(
+        files.get("meta.dlf") ?? null,
+        files.get("polled.dlf") ?? null,
+        files.get("event.dlf") ?? null,
+      );
     }
 
     return new BufferAdapter(meta, polled, event);
@@ -0,0 +1,264 @@
+/**
+ * Host benchmark for the polled stream block codecs (dlf::format::codec).
+ *
+ * Reports, per codec and data set, the compression ratio against raw storage,
+ * the encode cost per sample (what the sampler pays) and the decode throughput
+ * (what a host reader gets).
+ *
+ * The GPS data sets are a synthetic 1 Hz track of a vehicle driving field
+ * rows, quantized the way TinyGPS++ reports NMEA fixes. To use a recorded
+ * track instead, pass a CSV file with one "lat,lng,alt" fix per line.
+ *
+ * Build and run from software/dlflib:
+ *   g++ -std=c++17 -O2 -I include -I test/stubs bench/codec_benchmark.cpp \
+ *       src/format/codec.cpp -o /tmp/codec_benchmark && \
+ *       /tmp/codec_benchmark [track.csv]
+ */
+#include <Arduino.h>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "dlflib/format/codec.h"
+
+using namespace dlf;
+using dlf::format::BlockEncoder;
+
+namespace {
+
+constexpr size_t BLOCK_SAMPLES = 128;
+constexpr size_t REPEATS = 200;
+
+struct DataSet {
+  const char* name;
+  size_t typeSize;
+  std::vector<uint8_t> bytes;
+
+  size_t samples() const { return bytes.size() / typeSize; }
+};
+
+template <typename T>
+DataSet makeSet(const char* name, const std::vector<T>& values) {
+  DataSet d{name, sizeof(T), {}};
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(values.data());
+  d.bytes.assign(p, p + values.size() * sizeof(T));
+  return d;
+}
+
+struct Fix {
+  double lat;
+  double lng;
+  double alt;
+};
+
+// NMEA gives 5 decimal minutes; TinyGPS++ returns degrees + billionths
+double nmeaDegrees(double deg) {
+  const double whole = floor(fabs(deg));
+  const double minutes = round((fabs(deg) - whole) * 60 * 1e5) / 1e5;
+  const double billionths = round(minutes * 1e9 / 60);
+  return copysign(whole + billionths / 1e9, deg);
+}
+
+// Rows of 150 m, 1.5 m apart, driven at 1.2 m/s with a stop at each turn
+std::vector<Fix> syntheticTrack() {
+  const double metersPerDegLat = 111000;
+  const double metersPerDegLng = 89000;
+  std::vector<Fix> track;
+  uint32_t lcg = 7;
+  auto noise = [&lcg] {
+    lcg = lcg * 1664525u + 1013904223u;
+    return (static_cast<int32_t>(lcg >> 16) % 1000) / 1000.0;
+  };
+  double x = 0;
+  double y = 0;
+  double alt = 42.0;
+  double dir = 1;
+  for (size_t i = 0; i < 20000; i++) {
+    const size_t inRow = i % 140;
+    if (inRow < 125) {
+      y += dir * 1.2;
+    } else if (inRow == 125) {
+      x += 1.5;
+      dir = -dir;
+    }
+    alt += noise() * 0.05;
+    const double jitter = noise() * 0.3;
+    track.push_back(
+        {nmeaDegrees(36.9060 + (y + jitter) / metersPerDegLat),
+         nmeaDegrees(-121.7580 + (x + jitter) / metersPerDegLng),
+         round(alt * 100) / 100});
+  }
+  return track;
+}
+
+std::vector<Fix> loadTrack(const char* path) {
+  std::vector<Fix> track;
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    printf("could not open %s\n", path);
+    return track;
+  }
+  Fix fix;
+  while (fscanf(f, "%lf,%lf,%lf", &fix.lat, &fix.lng, &fix.alt) == 3) {
+    track.push_back(fix);
+  }
+  fclose(f);
+  return track;
+}
+
+std::vector<DataSet> dataSets(const std::vector<Fix>& track) {
+  std::vector<DataSet> sets;
+
+  std::vector<double> lat, lng, alt;
+  std::vector<float> altF;
+  for (const Fix& fix : track) {
+    lat.push_back(fix.lat);
+    lng.push_back(fix.lng);
+    alt.push_back(fix.alt);
+    altF.push_back(fix.alt);
+  }
+  sets.push_back(makeSet("gps lat f64", lat));
+  sets.push_back(makeSet("gps lng f64", lng));
+  sets.push_back(makeSet("gps alt f64", alt));
+  sets.push_back(makeSet("gps alt f32", altF));
+
+  // gpsData.satellites: changes every few minutes
+  std::vector<uint32_t> sats;
+  for (size_t i = 0; i < 100000; i++) {
+    sats.push_back(9 + (i / 700) % 4);
+  }
+  sets.push_back(makeSet("satellites u32", sats));
+
+  // wifiRssi: noisy around a slowly moving level
+  std::vector<int32_t> rssi;
+  uint32_t lcg = 1;
+  for (size_t i = 0; i < 100000; i++) {
+    lcg = lcg * 1664525u + 1013904223u;
+    rssi.push_back(-60 + static_cast<int32_t>(10 * sin(i / 5000.0)) +
+                   static_cast<int32_t>(lcg >> 29) - 4);
+  }
+  sets.push_back(makeSet("rssi i32", rssi));
+
+  // Millisecond counter sampled every 100 ms
+  std::vector<uint64_t> millisCounter;
+  for (size_t i = 0; i < 100000; i++) {
+    millisCounter.push_back(1000 + i * 100 + (i % 3));
+  }
+  sets.push_back(makeSet("millis u64", millisCounter));
+
+  return sets;
+}
+
+struct Encoded {
+  std::vector<std::vector<uint8_t>> blocks;
+  std::vector<size_t> counts;
+  size_t bytes = 0;
+};
+
+// Encodes `d` block by block, handing each block to `sink`
+template <typename Sink>
+void encodeInto(BlockEncoder& enc, const DataSet& d, Sink&& sink) {
+  for (size_t i = 0; i < d.samples(); i++) {
+    enc.add(&d.bytes[i * d.typeSize]);
+    if (enc.full() || i + 1 == d.samples()) {
+      size_t len;
+      const uint8_t* payload = enc.finish(len);
+      sink(payload, len, enc.count());
+      enc.reset();
+    }
+  }
+}
+
+Encoded encode(dlf_codec_e codec, const DataSet& d, double& nsPerSample) {
+  BlockEncoder enc(codec, d.typeSize, BLOCK_SAMPLES);
+
+  // Timed without keeping the output, like the sampler which only hands the
+  // block to the ring
+  size_t sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < REPEATS; r++) {
+    encodeInto(enc, d, [&](const uint8_t* p, size_t len, size_t) {
+      sum += len + p[0];
+    });
+  }
+  auto ns = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  nsPerSample = ns / (REPEATS * d.samples());
+  if (sum == 0) {
+    printf("nothing encoded\n");
+  }
+
+  Encoded e;
+  encodeInto(enc, d, [&](const uint8_t* p, size_t len, size_t count) {
+    e.blocks.emplace_back(p, p + len);
+    e.counts.push_back(count);
+    e.bytes += sizeof(dlf_codec_block_header_t) + len;
+  });
+  return e;
+}
+
+double decodeMiBps(dlf_codec_e codec, const DataSet& d, const Encoded& e) {
+  std::vector<uint8_t> out(d.bytes.size());
+  auto start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < REPEATS; r++) {
+    uint8_t* o = out.data();
+    for (size_t b = 0; b < e.blocks.size(); b++) {
+      if (!format::decodeBlock(codec, d.typeSize, e.blocks[b].data(),
+                               e.blocks[b].size(), e.counts[b], o)) {
+        printf("decode failed\n");
+        return 0;
+      }
+      o += e.counts[b] * d.typeSize;
+    }
+  }
+  auto s = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+               .count();
+  if (out != d.bytes) {
+    printf("round trip mismatch\n");
+    return 0;
+  }
+  return REPEATS * d.bytes.size() / s / (1 << 20);
+}
+
+const char* codecName(dlf_codec_e codec) {
+  switch (codec) {
+    case DLF_CODEC_DELTA_VARINT:
+      return "delta";
+    case DLF_CODEC_RLE:
+      return "rle";
+    case DLF_CODEC_XOR:
+      return "xor";
+    default:
+      return "raw";
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<Fix> track = argc > 1 ? loadTrack(argv[1]) : syntheticTrack();
+  if (track.size() < 2) {
+    printf("track needs at least 2 fixes\n");
+    return 1;
+  }
+  printf("%zu samples per block, %zu GPS fixes (%s)\n", BLOCK_SAMPLES,
+         track.size(), argc > 1 ? argv[1] : "synthetic");
+  printf("%-16s %-6s %8s %12s %14s\n", "data", "codec", "ratio", "encode ns",
+         "decode MiB/s");
+  for (const DataSet& d : dataSets(track)) {
+    for (dlf_codec_e codec :
+         {DLF_CODEC_DELTA_VARINT, DLF_CODEC_RLE, DLF_CODEC_XOR}) {
+      if (!format::codecSupports(codec, d.typeSize)) {
+        continue;
+      }
+      double ns;
+      Encoded e = encode(codec, d, ns);
+      printf("%-16s %-6s %7.2fx %12.1f %14.0f\n", d.name, codecName(codec),
+             double(d.bytes.size()) / e.bytes, ns, decodeMiBps(codec, d, e));
+    }
+  }
+  return 0;
+}
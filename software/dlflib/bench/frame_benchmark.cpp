@@ -0,0 +1,100 @@
+/**
+ * Host benchmark for block compression of log file data
+ * (DLF_LOGFILE_FLAG_BLOCK_COMPRESSION).
+ *
+ * Frames synthetic polled.dlf and event.dlf data sections the way the flusher
+ * does and reports the size on SD relative to the uncompressed file, and the
+ * compression throughput the flusher needs.
+ *
+ * Build and run from software/dlflib:
+ *   g++ -std=c++17 -O2 -I include -I test/stubs bench/frame_benchmark.cpp \
+ *       src/format/lz4.cpp src/format/frames.cpp src/format/crc32.cpp \
+ *       -o /tmp/frame_benchmark && /tmp/frame_benchmark
+ */
+#include <Arduino.h>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "dlflib/dlf_cfg.h"
+#include "dlflib/format/frames.h"
+
+using namespace dlf;
+
+namespace {
+
+constexpr size_t REPEATS = 20;
+
+template <typename T>
+void append(std::vector<uint8_t>& out, const T& v) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+  out.insert(out.end(), p, p + sizeof(T));
+}
+
+// The app's polled set at 1 Hz: lat, lng, alt doubles every tick, satellites
+// and RSSI every 5th tick
+std::vector<uint8_t> polledData() {
+  std::vector<uint8_t> out;
+  uint32_t lcg = 5;
+  for (size_t t = 0; t < 100000; t++) {
+    lcg = lcg * 1664525u + 1013904223u;
+    const double y = t * 1.2 + (lcg >> 24) / 1000.0;
+    append(out, round((36.9060 + y / 111000) * 1e7) / 1e7);
+    append(out, round((-121.7580 + (t / 140) * 1.5 / 89000) * 1e7) / 1e7);
+    append(out, round((42.0 + sin(t / 300.0)) * 100) / 100);
+    if (t % 5 == 0) {
+      append(out, static_cast<uint32_t>(9 + (t / 700) % 4));
+      append(out, static_cast<int32_t>(-60 + (lcg >> 29)));
+    }
+  }
+  return out;
+}
+
+// Boolean and small-enum watches changing every few ticks
+std::vector<uint8_t> eventData() {
+  std::vector<uint8_t> out;
+  uint32_t lcg = 9;
+  dlf_tick_t tick = 0;
+  for (size_t i = 0; i < 100000; i++) {
+    lcg = lcg * 1664525u + 1013904223u;
+    tick += 1 + (lcg >> 28);
+    dlf_event_stream_sample_t h;
+    h.stream = (lcg >> 20) % 6;
+    h.sample_tick = tick;
+    append(out, h);
+    out.push_back(static_cast<uint8_t>((lcg >> 12) & 1));
+  }
+  return out;
+}
+
+void run(const char* name, const std::vector<uint8_t>& data) {
+  format::Lz4Compressor compressor;
+  std::vector<uint8_t> frame(format::maxFrameBytes(DLF_FRAME_RAW_BYTES));
+  size_t fileBytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < REPEATS; r++) {
+    fileBytes = 0;
+    for (size_t off = 0; off < data.size(); off += DLF_FRAME_RAW_BYTES) {
+      const size_t len = std::min<size_t>(DLF_FRAME_RAW_BYTES,
+                                          data.size() - off);
+      fileBytes += format::encodeFrame(compressor, &data[off], len, 0, off, 0,
+                                       frame.data());
+    }
+  }
+  const double s = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  printf("%-8s %10zu B -> %10zu B  %5.1f%%  %7.0f MiB/s\n", name, data.size(),
+         fileBytes, 100.0 * fileBytes / data.size(),
+         REPEATS * data.size() / s / (1 << 20));
+}
+
+}  // namespace
+
+int main() {
+  printf("%d B frames\n", DLF_FRAME_RAW_BYTES);
+  run("polled", polledData());
+  run("event", eventData());
+  return 0;
+}
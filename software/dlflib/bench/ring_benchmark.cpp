@@ -0,0 +1,198 @@
+/**
+ * Host benchmark for the sampler -> flusher hand-off in LogFile.
+ *
+ * Compares the old FreeRTOS StreamBuffer path against dlf::util::ByteRing.
+ * The StreamBuffer is emulated by a mutex-guarded copying ring, which is what
+ * xStreamBufferSend/Receive amount to (critical section + memcpy in and out).
+ * The "file" is a memory buffer standing in for the FS cache, so the numbers
+ * measure the hand-off, not the SD card.
+ *
+ * Build and run from software/dlflib:
+ *   g++ -std=c++17 -O2 -I include -I test/stubs bench/ring_benchmark.cpp \
+ *       -lpthread -o /tmp/ring_benchmark && /tmp/ring_benchmark
+ */
+#include <Arduino.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dlflib/util/byte_ring.h"
+
+namespace {
+
+constexpr size_t RING_BYTES = 8192;
+constexpr size_t BLOCK_BYTES = 512;
+constexpr size_t TOTAL_BYTES = 256u << 20;
+
+struct Counters {
+  size_t copies = 0;
+  size_t bytesCopied = 0;
+
+  void copy(void* dst, const void* src, size_t len) {
+    memcpy(dst, src, len);
+    copies++;
+    bytesCopied += len;
+  }
+};
+
+/**
+ * Emulated StreamBuffer: every send and receive copies under a lock.
+ */
+class LockedStreamBuffer {
+ public:
+  explicit LockedStreamBuffer(size_t capacity) : buf_(capacity) {}
+
+  bool send(const void* data, size_t len, Counters& c) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buf_.size() - count_ < len) {
+      return false;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    size_t idx = (start_ + count_) % buf_.size();
+    size_t n = std::min(len, buf_.size() - idx);
+    c.copy(&buf_[idx], p, n);
+    if (len > n) {
+      c.copy(&buf_[0], p + n, len - n);
+    }
+    count_ += len;
+    return true;
+  }
+
+  size_t receive(void* dst, size_t len, Counters& c) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    len = std::min(len, count_);
+    uint8_t* p = static_cast<uint8_t*>(dst);
+    size_t n = std::min(len, buf_.size() - start_);
+    c.copy(p, &buf_[start_], n);
+    if (len > n) {
+      c.copy(p + n, &buf_[0], len - n);
+    }
+    start_ = (start_ + len) % buf_.size();
+    count_ -= len;
+    return len;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<uint8_t> buf_;
+  size_t start_ = 0;
+  size_t count_ = 0;
+};
+
+struct Result {
+  double seconds;
+  Counters producer;
+  Counters consumer;
+};
+
+// Old path: source -> dataBuffer_ -> StreamBuffer -> flusher buf -> FS cache
+Result runStreamBuffer(size_t sampleBytes) {
+  LockedStreamBuffer stream(RING_BYTES);
+  std::vector<uint8_t> source(sampleBytes, 0x5A);
+  std::vector<uint8_t> fsCache(1 << 20);
+  Result r{};
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread flusher([&] {
+    uint8_t buf[BLOCK_BYTES];
+    size_t received = 0;
+    size_t pos = 0;
+    while (received < TOTAL_BYTES) {
+      size_t n = stream.receive(buf, sizeof(buf), r.consumer);
+      if (n == 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (pos + n > fsCache.size()) {
+        pos = 0;
+      }
+      r.consumer.copy(&fsCache[pos], buf, n);
+      pos += n;
+      received += n;
+    }
+  });
+
+  std::vector<uint8_t> dataBuffer(sampleBytes);
+  for (size_t sent = 0; sent < TOTAL_BYTES; sent += sampleBytes) {
+    r.producer.copy(dataBuffer.data(), source.data(), sampleBytes);
+    while (!stream.send(dataBuffer.data(), sampleBytes, r.producer)) {
+      std::this_thread::yield();
+    }
+  }
+  flusher.join();
+  r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                            start)
+                  .count();
+  return r;
+}
+
+// New path: source -> reserved ring span -> FS cache
+Result runByteRing(size_t sampleBytes) {
+  dlf::util::ByteRing ring(RING_BYTES);
+  std::vector<uint8_t> source(sampleBytes, 0x5A);
+  std::vector<uint8_t> fsCache(1 << 20);
+  Result r{};
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread flusher([&] {
+    size_t received = 0;
+    size_t pos = 0;
+    while (received < TOTAL_BYTES) {
+      dlf::util::ByteRing::Spans s = ring.peek();
+      if (s.size() == 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (pos + s.size() > fsCache.size()) {
+        pos = 0;
+      }
+      r.consumer.copy(&fsCache[pos], s.first, s.firstLen);
+      if (s.secondLen > 0) {
+        r.consumer.copy(&fsCache[pos + s.firstLen], s.second, s.secondLen);
+      }
+      pos += s.size();
+      received += s.size();
+      ring.consume(s.size());
+    }
+  });
+
+  for (size_t sent = 0; sent < TOTAL_BYTES; sent += sampleBytes) {
+    dlf::util::ByteRing::Spans s;
+    while ((s = ring.reserve(sampleBytes)).size() == 0) {
+      std::this_thread::yield();
+    }
+    s.write(0, source.data(), sampleBytes);
+    r.producer.copies += s.secondLen > 0 ? 2 : 1;
+    r.producer.bytesCopied += sampleBytes;
+    ring.commit(sampleBytes);
+  }
+  flusher.join();
+  r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                            start)
+                  .count();
+  return r;
+}
+
+void report(const char* name, size_t sampleBytes, const Result& r) {
+  const double mb = TOTAL_BYTES / double(1 << 20);
+  printf("%-12s %6zu B  %8.1f MiB/s  copies/sample %.2f  bytes copied x%.2f\n",
+         name, sampleBytes, mb / r.seconds,
+         double(r.producer.copies + r.consumer.copies) /
+             (TOTAL_BYTES / sampleBytes),
+         double(r.producer.bytesCopied + r.consumer.bytesCopied) /
+             TOTAL_BYTES);
+}
+
+}  // namespace
+
+int main() {
+  printf("%zu MiB per run, %zu B ring, %zu B flusher block\n",
+         TOTAL_BYTES >> 20, RING_BYTES, BLOCK_BYTES);
+  for (size_t sampleBytes : {4u, 16u, 64u, 256u}) {
+    report("StreamBuffer", sampleBytes, runStreamBuffer(sampleBytes));
+    report("ByteRing", sampleBytes, runByteRing(sampleBytes));
+  }
+  return 0;
+}
@@ -8,6 +8,7 @@
 
 #include "dlflib/auth/request_signer.h"
 #include "dlflib/components/component.h"
+#include "dlflib/dlf_run.h"
 
 namespace dlf::components {
 
@@ -83,12 +84,20 @@ class UploaderComponent : public Component {
    * chunks.
    * @param durationS Duration of the run so far.
    * @param maxChunkSize Maximum bytes per chunk.
+   * @param committed For active runs, the result of Run::commit(). Log files
+   * are only uploaded up to their committed offsets, so the upload ends at a
+   * consistent tick.
+   * @param container For active container runs, the run's open container.
+   * Upload progress is kept in its header.
+   * Capture files (raw-<id>.dlf) are not sent; only uploadRun() sends them.
    * @return true on success (or if there was nothing new to upload).
    */
   bool uploadRunChunked(fs::File runDir, const char* runUuid,
                         bool isActive = false, bool finalize = false,
                         float durationS = 0.0f,
-                        size_t maxChunkSize = 256 * 1024);
+                        size_t maxChunkSize = 256 * 1024,
+                        const dlf::Run::CommitResult* committed = nullptr,
+                        dlf::storage::RunContainer* container = nullptr);
 
   /**
    * Blocks until the background sync task has finished uploading all pending
@@ -127,14 +136,18 @@ class UploaderComponent : public Component {
                           uint32_t& polledNextChunkNum,
                           uint32_t& polledNextByteOffset,
                           uint32_t& eventNextChunkNum,
-                          uint32_t& eventNextByteOffset);
+                          uint32_t& eventNextByteOffset,
+                          uint32_t& indexNextChunkNum,
+                          uint32_t& indexNextByteOffset);
   bool saveUploadProgress(const char* progressFilePath,
                           uint32_t metaNextChunkNum,
                           uint32_t metaNextByteOffset,
                           uint32_t polledNextChunkNum,
                           uint32_t polledNextByteOffset,
                           uint32_t eventNextChunkNum,
-                          uint32_t eventNextByteOffset);
+                          uint32_t eventNextByteOffset,
+                          uint32_t indexNextChunkNum,
+                          uint32_t indexNextByteOffset);
 
   std::unique_ptr<WiFiClient> wifiClient_;
   std::unique_ptr<WiFiClientSecure> wifiClientSecure_;
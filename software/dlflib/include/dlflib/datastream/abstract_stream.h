@@ -19,6 +19,8 @@ inline const char* streamTypeToString(dlf_stream_type_e t) {
       return "polled";
     case EVENT:
       return "event";
+    case RAW:
+      return "raw";
     default:
       return "PROBLEM";
   }
@@ -33,6 +35,8 @@ class AbstractStreamHandle;
  */
 class AbstractStream {
  public:
+  virtual ~AbstractStream() = default;
+
   /**
    * @brief Creates a new, linked StreamHandle
    * @param tickInterval
@@ -44,6 +48,13 @@ class AbstractStream {
 
   virtual dlf_stream_type_e type() = 0;
 
+  /**
+   * Brings the value at dataSource() up to date, for streams whose value is
+   * derived from other sources. Handles call it right before each read of
+   * the value, with mutex() held if they take it.
+   */
+  virtual void refresh() {}
+
   size_t dataSize() { return src_.dataSize; }
 
   const uint8_t* dataSource() { return src_.data; }
@@ -66,6 +77,13 @@ class AbstractStream {
     snprintf(notes_, sizeof(notes_), "%s", notes ? notes : "");
   }
 
+  /**
+   * Replaces the notes, for streams that describe themselves in them.
+   */
+  void setNotes(const char* notes) {
+    snprintf(notes_, sizeof(notes_), "%s", notes ? notes : "");
+  }
+
  private:
   const Encodable src_;
   char id_[32];
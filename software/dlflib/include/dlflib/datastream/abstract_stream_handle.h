@@ -1,9 +1,9 @@
 #pragma once
 
 #include <Arduino.h>
-#include <freertos/stream_buffer.h>
 
 #include "dlflib/datastream/abstract_stream.h"
+#include "dlflib/util/byte_ring.h"
 
 namespace dlf::datastream {
 
@@ -15,11 +15,37 @@ namespace dlf::datastream {
  */
 class AbstractStreamHandle {
  public:
+  virtual ~AbstractStreamHandle() = default;
+
   virtual bool available(dlf_tick_t tick) = 0;
 
-  virtual size_t encodeInto(StreamBufferHandle_t buf, dlf_tick_t tick) = 0;
+  /**
+   * Encodes a sample for `tick`.
+   * @return Number of bytes committed to `buf`
+   */
+  virtual size_t encodeInto(dlf::util::ByteRing& buf, dlf_tick_t tick) = 0;
+
+  /**
+   * Encodes whatever this stream still holds back once sampling has stopped.
+   * Called on close, after the last tick.
+   * @return Number of bytes committed to `buf`
+   */
+  virtual size_t encodeTrailerInto(dlf::util::ByteRing& /*buf*/) {
+    return 0;
+  }
+
+  /**
+   * DLF_LOGFILE_FLAG_* bits this stream needs set in the logfile header.
+   */
+  virtual uint32_t logfileFlags() const { return 0; }
 
-  virtual size_t encodeHeaderInto(StreamBufferHandle_t buf) {
+  /**
+   * Encodes this stream's header.
+   * @param fileFlags The flags the logfile header was written with
+   * @return Number of bytes committed to `buf`
+   */
+  virtual size_t encodeHeaderInto(dlf::util::ByteRing& buf,
+                                  uint32_t /*fileFlags*/) {
     dlf_stream_header_t h{
         stream->typeStructure(),
         stream->id(),
@@ -27,25 +53,52 @@ class AbstractStreamHandle {
         stream->dataSize(),
     };
 
-    send(buf, h.type_structure);
-    send(buf, h.id);
-    send(buf, h.notes);
-    send(buf, h.type_size);
-    return 1;
+    size_t written = send(buf, h.type_structure);
+    written += send(buf, h.id);
+    written += send(buf, h.notes);
+    written += send(buf, h.type_size);
+    return written;
   }
 
   template <typename T>
-  size_t send(StreamBufferHandle_t buf, T data) {
-    return xStreamBufferSend(buf, reinterpret_cast<uint8_t*>(&data), sizeof(T),
-                             portMAX_DELAY);
+  size_t send(dlf::util::ByteRing& buf, T data) {
+    return sendBytes(buf, &data, sizeof(T));
   }
 
-  size_t send(StreamBufferHandle_t buf, const char* data) {
+  // A null string is sent as an empty one, so that the fields after it stay
+  // where readers expect them. (The StreamBuffer version sent nothing.)
+  size_t send(dlf::util::ByteRing& buf, const char* data) {
     if (data) {
-      return xStreamBufferSend(buf, data, strlen(data) + 1, portMAX_DELAY);
+      return sendBytes(buf, data, strlen(data) + 1);
     } else {
-      return xStreamBufferSend(buf, "", strlen(""), portMAX_DELAY);
+      return sendBytes(buf, "", 1);
+    }
+  }
+
+  /**
+   * Blocks until `len` bytes can be reserved in `buf`, then commits them.
+   */
+  static size_t sendBytes(dlf::util::ByteRing& buf, const void* data,
+                          size_t len) {
+    if (!waitForSpace(buf, len)) {
+      return 0;
+    }
+    return buf.write(data, len) ? len : 0;
+  }
+
+  /**
+   * Blocks until `buf` has room for `len` bytes. The flusher drains the ring
+   * independently, so this only waits out an SD stall.
+   * @return false if `len` can never fit
+   */
+  static bool waitForSpace(dlf::util::ByteRing& buf, size_t len) {
+    if (len > buf.capacity()) {
+      return false;
+    }
+    while (buf.writable() < len) {
+      vTaskDelay(1);
     }
+    return true;
   }
 
  protected:
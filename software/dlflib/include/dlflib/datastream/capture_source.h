@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "dlflib/dlf_types.h"
+#include "dlflib/util/byte_ring.h"
+
+namespace dlf::datastream {
+
+/**
+ * Bulk byte source drained by a CaptureStream, such as the receive buffer of
+ * a UART driver. Only the sampler reads from it.
+ */
+class CaptureSource {
+ public:
+  virtual ~CaptureSource() = default;
+
+  /**
+   * Number of bytes that read() can return right away.
+   */
+  virtual size_t available() = 0;
+
+  /**
+   * Copies up to `len` bytes to `dst` without blocking.
+   * @return Number of bytes copied
+   */
+  virtual size_t read(uint8_t* dst, size_t len) = 0;
+};
+
+/**
+ * CaptureSource over bytes appended by the caller, as a stand-in for a UART
+ * in tests or to replay a recording.
+ */
+class MemoryCaptureSource : public CaptureSource {
+ public:
+  void append(const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    bytes_.insert(bytes_.end(), p, p + len);
+  }
+
+  /**
+   * Limits each read() to `len` bytes, like a driver that returns less than
+   * it reported available. Zero lifts the limit.
+   */
+  void setReadLimit(size_t len) { readLimit_ = len; }
+
+  size_t available() override { return bytes_.size() - pos_; }
+
+  size_t read(uint8_t* dst, size_t len) override;
+
+ private:
+  std::vector<uint8_t> bytes_;
+  size_t pos_ = 0;
+  size_t readLimit_ = 0;
+};
+
+/**
+ * Moves up to `maxLen` bytes from `source` into `ring` as one record of a
+ * DLF_EVENT_STREAM_VARIABLE stream: a dlf_event_stream_sample_t for `idx`
+ * and `tick`, a varint length and the bytes. The bytes are read straight
+ * into the reserved ring space, so there is no copy and no per-byte work.
+ * Nothing is written if no bytes are waiting or if the record does not fit
+ * in `ring`, in which case the bytes stay in the source for the next tick.
+ * @return Number of bytes committed to `ring`
+ */
+size_t writeCaptureChunk(CaptureSource& source, size_t maxLen,
+                         dlf_stream_idx_t idx, dlf_tick_t tick,
+                         dlf::util::ByteRing& ring);
+
+}  // namespace dlf::datastream
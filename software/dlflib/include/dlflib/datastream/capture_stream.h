@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+
+#include "dlflib/datastream/capture_source.h"
+#include "dlflib/datastream/event_stream.h"
+#include "dlflib/dlf_cfg.h"
+
+namespace dlf::datastream {
+
+/**
+ * Raw byte stream, such as the output of a GNSS receiver kept for
+ * post-processing next to the values decoded from it. Bytes are taken from
+ * a CaptureSource in bulk by the sampler and written, unparsed, as
+ * tick-stamped chunks to a file of the stream's own, raw-<id>.dlf. Each chunk
+ * is a record of a single "uint8_t[]" DLF_EVENT_STREAM_VARIABLE stream, so the
+ * file reads like an event file.
+ */
+class CaptureStream : public EventStream {
+ public:
+  struct Options {
+    const char* notes = nullptr;
+    // Bytes to wait for before writing a chunk, so that a slow source gives
+    // fewer, larger chunks. Zero writes whatever arrived on every tick.
+    size_t threshold = 0;
+    // Longest bytes wait for the threshold before they are written anyway
+    std::chrono::microseconds maxWait = std::chrono::seconds(1);
+    // Largest chunk, at most DLF_CAPTURE_MAX_CHUNK. At most one chunk is
+    // written per tick, so the source must buffer the bytes of a tick or two
+    // beyond it. Recorded as the stream's type_size.
+    size_t maxChunk = DLF_CAPTURE_MAX_CHUNK;
+  };
+
+  /**
+   * @param source Must outlive the stream. Only the sampler reads from it.
+   */
+  CaptureStream(const char* id, CaptureSource& source,
+                const Options& options);
+
+  std::unique_ptr<dlf::datastream::AbstractStreamHandle> createHandle(
+      std::chrono::microseconds tickInterval, dlf_stream_idx_t idx) override;
+
+  dlf_stream_type_e type() override;
+
+  CaptureSource& source() { return source_; }
+
+ private:
+  CaptureSource& source_;
+  size_t threshold_;
+  std::chrono::microseconds maxWait_;
+};
+
+/**
+ * CaptureSource for a UART. HardwareSerial::read() copies straight out of
+ * the UART driver's receive buffer, whose size (setRxBufferSize()) bounds
+ * what can be held between ticks.
+ */
+class SerialCaptureSource : public CaptureSource {
+ public:
+  explicit SerialCaptureSource(HardwareSerial& serial) : serial_(serial) {}
+
+  size_t available() override {
+    const int n = serial_.available();
+    return n > 0 ? static_cast<size_t>(n) : 0;
+  }
+
+  size_t read(uint8_t* dst, size_t len) override {
+    return serial_.read(dst, len);
+  }
+
+ private:
+  HardwareSerial& serial_;
+};
+
+}  // namespace dlf::datastream
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "dlflib/datastream/capture_stream.h"
+#include "dlflib/datastream/event_stream_handle.h"
+
+namespace dlf::datastream {
+
+/**
+ * Drains a CaptureStream's source into its raw-<id>.dlf, one chunk per tick
+ * at most. See writeCaptureChunk().
+ */
+class CaptureStreamHandle : public EventStreamHandle {
+ public:
+  /**
+   * @param maxWaitTicks Ticks bytes wait for `threshold` before they are
+   * written anyway
+   */
+  CaptureStreamHandle(CaptureStream* stream, dlf_stream_idx_t idx,
+                      size_t threshold, dlf_tick_t maxWaitTicks);
+
+  bool available(dlf_tick_t tick) override;
+
+  size_t encodeInto(dlf::util::ByteRing& buf, dlf_tick_t tick) override;
+
+  /**
+   * Writes the bytes still waiting for the threshold, at the last tick.
+   */
+  size_t encodeTrailerInto(dlf::util::ByteRing& buf) override;
+
+  uint32_t logfileFlags() const override {
+    return DLF_LOGFILE_FLAG_VARIABLE_EVENTS;
+  }
+
+  bool variableLength() const override { return true; }
+
+ private:
+  CaptureSource& source_;
+  size_t threshold_;
+  dlf_tick_t maxWaitTicks_;
+  bool waiting_ = false;  // Bytes arrived that are not written yet
+  dlf_tick_t waitingSince_ = 0;
+  dlf_tick_t lastTick_ = 0;
+};
+
+}  // namespace dlf::datastream
@@ -11,9 +11,48 @@ class EventStreamHandle : public AbstractStreamHandle {
 
   bool available(dlf_tick_t tick);
 
-  size_t encodeHeaderInto(StreamBufferHandle_t buf);
-
-  size_t encodeInto(StreamBufferHandle_t buf, dlf_tick_t tick);
+  size_t encodeHeaderInto(dlf::util::ByteRing& buf, uint32_t fileFlags);
+
+  size_t encodeInto(dlf::util::ByteRing& buf, dlf_tick_t tick);
+
+  /**
+   * Whether the stream's values are variable-length messages
+   * (DLF_EVENT_STREAM_VARIABLE).
+   */
+  virtual bool variableLength() const { return false; }
+
+  /**
+   * Number of records this stream adds to a tick group once available()
+   * returned true (DLF_LOGFILE_FLAG_COMPACT_EVENTS).
+   */
+  virtual size_t groupedRecordCount() const { return 1; }
+
+  /**
+   * Size of this stream's records in a tick group.
+   */
+  virtual size_t groupedRecordSize() const;
+
+  /**
+   * Writes this stream's records of a tick group at `offset` within `spans`,
+   * which the caller has reserved for the whole group.
+   * @return Number of bytes written
+   */
+  virtual size_t encodeGroupedInto(const dlf::util::ByteRing::Spans& spans,
+                                   size_t offset);
+
+  /**
+   * Size of this stream's value in a keyframe.
+   */
+  virtual size_t valueSize() const { return stream->dataSize(); }
+
+  /**
+   * Writes the stream's current value at `offset` within `spans`, for a
+   * record the caller has already sized (a group or a keyframe). Counts as
+   * logging the value, so available() is false until it changes again.
+   * @return Number of bytes written
+   */
+  virtual size_t encodeValueInto(const dlf::util::ByteRing::Spans& spans,
+                                 size_t offset);
 
  private:
   size_t currentHash();
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace dlf::datastream {
+
+/**
+ * Up to 64 boolean flags, such as status and fault flags, sampled together
+ * into one bitmask so that they are logged as a single stream at one bit per
+ * flag. Bit i holds the flag added i-th. See DLFLogger::pollFlags() and
+ * watchFlags().
+ */
+class FlagGroup {
+ public:
+  static constexpr size_t MAX_FLAGS = 64;
+
+  /**
+   * Adds a flag.
+   * @param name Must outlive the group
+   * @return false if the group is full
+   */
+  bool add(const char* name, const volatile bool& flag);
+
+  /**
+   * Adds bit `bit` of `word`, such as a status register or flags packed into
+   * an integer.
+   * @return false if the group is full or `bit` is out of range
+   */
+  bool add(const char* name, const volatile uint32_t& word, uint8_t bit);
+
+  size_t size() const { return flags_.size(); }
+
+  /**
+   * Bytes of the mask: 4 for up to 32 flags, otherwise 8.
+   */
+  size_t maskSize() const { return flags_.size() <= 32 ? 4 : 8; }
+
+  /**
+   * The mask with the bit of every flag set.
+   */
+  uint64_t validMask() const;
+
+  /**
+   * Samples every flag into a mask.
+   */
+  uint64_t read() const;
+
+  /**
+   * type_structure of the group's value: the mask as "values", or with
+   * `withChanges` a mask of "changed" flags followed by it, each maskSize()
+   * bytes, plus a "bit" field naming each flag.
+   * @return Valid until the next call or until the group is destroyed
+   */
+  const char* typeStructure(bool withChanges);
+
+ private:
+  struct Flag {
+    const char* name;
+    const volatile bool* flag;      // If set, the flag
+    const volatile uint32_t* word;  // Otherwise, a bit of this
+    uint32_t mask;
+  };
+
+  std::vector<Flag> flags_;
+  std::string typeStructure_;
+};
+
+}  // namespace dlf::datastream
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+
+#include "dlflib/datastream/event_stream.h"
+#include "dlflib/datastream/flag_group.h"
+#include "dlflib/datastream/polled_stream.h"
+
+namespace dlf::datastream {
+
+/**
+ * Polled stream of a FlagGroup: one mask of FlagGroup::maskSize() bytes per
+ * sample.
+ */
+class PolledFlagStream : public PolledStream {
+ public:
+  PolledFlagStream(std::unique_ptr<FlagGroup> flags, const char* id,
+                   std::chrono::microseconds sampleInterval,
+                   const Options& options);
+
+  void refresh() override { mask_ = flags_->read(); }
+
+ private:
+  uint64_t mask_ = 0;  // Little-endian, so its low bytes are the value
+  std::unique_ptr<FlagGroup> flags_;
+};
+
+/**
+ * Event stream of a FlagGroup. A record is written whenever any flag
+ * changes and holds the mask of the flags that changed since the previous
+ * record, followed by the mask of their values. On the first record, every
+ * flag counts as changed.
+ */
+class EventFlagStream : public EventStream {
+ public:
+  EventFlagStream(std::unique_ptr<FlagGroup> flags, const char* id,
+                  const char* notes, SemaphoreHandle_t mutex = nullptr);
+
+  std::unique_ptr<dlf::datastream::AbstractStreamHandle> createHandle(
+      std::chrono::microseconds tickInterval, dlf_stream_idx_t idx) override;
+
+  /**
+   * Samples the flags into the value: the changes against the last logged
+   * values, then the values.
+   */
+  void refresh() override;
+
+  /**
+   * Flags that changed as of the last refresh().
+   */
+  uint64_t changes() const { return changes_; }
+
+  /**
+   * Records that the value as of the last refresh() was logged.
+   */
+  void markLogged() {
+    logged_ = values_;
+    hasLogged_ = true;
+  }
+
+ private:
+  uint8_t value_[16] = {};
+  uint64_t changes_ = 0;
+  uint64_t values_ = 0;
+  uint64_t logged_ = 0;
+  bool hasLogged_ = false;
+  std::unique_ptr<FlagGroup> flags_;
+};
+
+}  // namespace dlf::datastream
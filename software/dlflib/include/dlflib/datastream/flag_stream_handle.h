@@ -0,0 +1,42 @@
+#pragma once
+
+#include "dlflib/datastream/event_stream_handle.h"
+#include "dlflib/datastream/flag_stream.h"
+
+namespace dlf::datastream {
+
+/**
+ * Writes an EventFlagStream's record when a flag changes. Changes are
+ * tracked against the last logged values rather than by hash, so a record
+ * deferred for lack of space still carries every change once written.
+ */
+class EventFlagStreamHandle : public EventStreamHandle {
+ public:
+  EventFlagStreamHandle(EventFlagStream* stream, dlf_stream_idx_t idx)
+      : EventStreamHandle(stream, idx), flags_(stream) {}
+
+  bool available(dlf_tick_t tick) override {
+    flags_->refresh();
+    return flags_->changes() != 0;
+  }
+
+  size_t encodeInto(dlf::util::ByteRing& buf, dlf_tick_t tick) override {
+    const size_t written = EventStreamHandle::encodeInto(buf, tick);
+    if (written > 0) {
+      flags_->markLogged();
+    }
+    return written;
+  }
+
+  size_t encodeValueInto(const dlf::util::ByteRing::Spans& spans,
+                         size_t offset) override {
+    const size_t written = EventStreamHandle::encodeValueInto(spans, offset);
+    flags_->markLogged();
+    return written;
+  }
+
+ private:
+  EventFlagStream* flags_;
+};
+
+}  // namespace dlf::datastream
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <type_traits>
+
+#include "dlflib/datastream/polled_stream.h"
+#include "dlflib/dlf_struct.h"
+
+namespace dlf::datastream {
+
+/**
+ * Polled stream whose value is computed by a function instead of read from a
+ * fixed address. The function is called by the sampler on the ticks the
+ * stream is due, with the mutex held if one is set. Every stream shares the
+ * sampler's tick and its DLF_SAMPLER_STACK_SIZE stack, so the function must
+ * not block (no driver calls that take locks, such as WiFi.RSSI(), and no
+ * I/O) and must not use much stack. Cache such values in another task and
+ * return the cached copy. T is a primitive, a DLF_STRUCT type or a
+ * std::array.
+ */
+template <typename T>
+class GetterStream : public PolledStream {
+  static_assert(!std::is_array<T>::value,
+                "Use std::array for arrays computed by a function");
+
+ public:
+  using Getter = T (*)();
+  using Filler = void (*)(T& out);
+
+  GetterStream(Getter getter, const char* id,
+               std::chrono::microseconds sampleInterval,
+               const Options& options)
+      : PolledStream(Encodable(value_, typeStructureOf<T>()), id,
+                     sampleInterval, options),
+        getter_(getter) {}
+
+  GetterStream(Filler filler, const char* id,
+               std::chrono::microseconds sampleInterval,
+               const Options& options)
+      : PolledStream(Encodable(value_, typeStructureOf<T>()), id,
+                     sampleInterval, options),
+        filler_(filler) {}
+
+  void refresh() override {
+    if (getter_ != nullptr) {
+      value_ = getter_();
+    } else {
+      filler_(value_);
+    }
+  }
+
+ private:
+  T value_{};
+  Getter getter_ = nullptr;
+  Filler filler_ = nullptr;
+};
+
+}  // namespace dlf::datastream
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "dlflib/datastream/event_stream.h"
+#include "dlflib/dlf_cfg.h"
+#include "dlflib/util/byte_ring.h"
+
+namespace dlf::datastream {
+
+/**
+ * Event stream of variable-length messages, such as state machine
+ * transitions, error strings or received NMEA sentences. Any task can hand
+ * messages to write(); the sampler moves them to event.dlf on the next tick,
+ * time-aligned with the other event streams. Messages are staged in a buffer
+ * allocated once, at construction, so write() never allocates.
+ */
+class MessageStream : public EventStream {
+ public:
+  struct Options {
+    const char* notes = nullptr;
+    // Messages are bytes ("uint8_t[]") rather than text ("char[]")
+    bool binary = false;
+    // Bytes of messages (plus 2 per message) staged between ticks. Messages
+    // that do not fit are dropped.
+    size_t bufferSize = DLF_MESSAGE_BUFFER_SIZE;
+  };
+
+  /**
+   * @param maxSize Longest message, at most DLF_MESSAGE_MAX_SIZE. Recorded
+   * as the stream's type_size.
+   */
+  MessageStream(const char* id, size_t maxSize, const Options& options);
+
+  ~MessageStream() override;
+
+  /**
+   * Queues a message for the next tick. Messages longer than the stream's
+   * max size are truncated.
+   * @return false if the message was dropped because the buffer is full
+   */
+  bool write(const void* data, size_t len);
+
+  /**
+   * Queues a null-terminated string, without the terminator.
+   */
+  bool print(const char* s) { return write(s, strlen(s)); }
+
+  /**
+   * Number of messages dropped so far because the buffer was full.
+   */
+  uint32_t dropped() const { return dropped_.load(); }
+
+  std::unique_ptr<dlf::datastream::AbstractStreamHandle> createHandle(
+      std::chrono::microseconds tickInterval, dlf_stream_idx_t idx) override;
+
+  /**
+   * Staged messages, each a uint16_t length and that many bytes. Written by
+   * write() and read by the sampler only.
+   */
+  dlf::util::ByteRing& staged() { return ring_; }
+
+ private:
+  dlf::util::ByteRing ring_;
+  SemaphoreHandle_t writeMutex_;
+  std::atomic<uint32_t> dropped_{0};
+};
+
+}  // namespace dlf::datastream
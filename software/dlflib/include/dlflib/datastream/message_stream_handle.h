@@ -0,0 +1,59 @@
+#pragma once
+
+#include "dlflib/datastream/event_stream_handle.h"
+#include "dlflib/datastream/message_stream.h"
+
+namespace dlf::datastream {
+
+/**
+ * Writes a MessageStream's staged messages as DLF_EVENT_STREAM_VARIABLE
+ * records. available() takes the messages staged so far; the encode calls
+ * that follow it on the same tick write exactly those.
+ */
+class MessageStreamHandle : public EventStreamHandle {
+ public:
+  MessageStreamHandle(MessageStream* stream, dlf_stream_idx_t idx);
+
+  bool available(dlf_tick_t tick) override;
+
+  size_t encodeInto(dlf::util::ByteRing& buf, dlf_tick_t tick) override;
+
+  uint32_t logfileFlags() const override {
+    return DLF_LOGFILE_FLAG_VARIABLE_EVENTS;
+  }
+
+  bool variableLength() const override { return true; }
+
+  size_t groupedRecordCount() const override { return pendingCount_; }
+
+  size_t groupedRecordSize() const override;
+
+  size_t encodeGroupedInto(const dlf::util::ByteRing::Spans& spans,
+                           size_t offset) override;
+
+  // An empty message
+  size_t valueSize() const override { return 1; }
+
+  /**
+   * Writes an empty message. Staged messages are left for the next tick.
+   */
+  size_t encodeValueInto(const dlf::util::ByteRing::Spans& spans,
+                         size_t offset) override;
+
+ private:
+  /**
+   * Writes the taken messages at `offset` within `spans`, each after a
+   * dlf_event_stream_sample_t for `tick` or, if `grouped`, after the stream
+   * index, and releases them from the staging buffer.
+   * @return Number of bytes written
+   */
+  size_t writeMessages(const dlf::util::ByteRing::Spans& spans, size_t offset,
+                       bool grouped, dlf_tick_t tick);
+
+  MessageStream* messages_;
+  size_t pendingCount_ = 0;  // Messages taken by available()
+  size_t pendingBytes_ = 0;  // Their size in the staging buffer
+  size_t payloadBytes_ = 0;  // Their size as varint lengths and bytes
+};
+
+}  // namespace dlf::datastream
@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "dlflib/datastream/abstract_stream.h"
+#include "dlflib/dlf_cfg.h"
 
 namespace dlf::datastream {
 
@@ -12,19 +13,74 @@ namespace dlf::datastream {
  */
 class PolledStream : public AbstractStream {
  public:
+  struct Options {
+    std::chrono::microseconds phase = std::chrono::microseconds::zero();
+    const char* notes = nullptr;
+    SemaphoreHandle_t mutex = nullptr;
+    // How samples are stored in polled.dlf. Codecs that don't support the
+    // type fall back to DLF_CODEC_RAW. See dlf_codec_e.
+    dlf_codec_e codec = DLF_CODEC_RAW;
+    // Samples per coded block. Larger blocks compress better but hold samples
+    // back from the file for longer; partial blocks are only written at
+    // commits, checkpoints and close.
+    uint16_t blockSamples = DLF_CODEC_BLOCK_SAMPLES;
+    // Whether the value is currently valid, e.g. whether the GNSS receiver
+    // has a fix: a flag, or a predicate called with the mutex held. With
+    // either set, samples are written in blocks (even without a codec) that
+    // record which samples were valid, and invalid samples are stored as
+    // `validity` says. See dlf_validity_e.
+    const volatile bool* validFlag = nullptr;
+    bool (*validIf)() = nullptr;
+    dlf_validity_e validity = DLF_VALIDITY_OMIT;
+  };
+
   PolledStream(const Encodable& src, const char* id,
                std::chrono::microseconds sampleInterval,
                std::chrono::microseconds phase, const char* notes,
                SemaphoreHandle_t mutex = nullptr);
 
+  PolledStream(const Encodable& src, const char* id,
+               std::chrono::microseconds sampleInterval,
+               const Options& options);
+
   std::unique_ptr<dlf::datastream::AbstractStreamHandle> createHandle(
       std::chrono::microseconds tickInterval, dlf_stream_idx_t idx);
 
   dlf_stream_type_e type();
 
+  /**
+   * Whether the current value is valid. Always true for streams without a
+   * validity flag or predicate.
+   */
+  bool valid() const {
+    if (validIf_ != nullptr) {
+      return validIf_();
+    }
+    return validFlag_ == nullptr || *validFlag_;
+  }
+
+ protected:
+  /**
+   * The sample interval and phase in ticks of `tickInterval`. An interval of
+   * 0 samples every tick.
+   */
+  void scheduleTicks(std::chrono::microseconds tickInterval,
+                     dlf_tick_t& interval, dlf_tick_t& phase) const;
+
+  dlf_codec_e codec() const { return codec_; }
+
+  uint16_t blockSamples() const { return blockSamples_; }
+
+  dlf_validity_e validity() const { return validity_; }
+
  private:
   std::chrono::microseconds sampleInterval_;
   std::chrono::microseconds phase_;
+  dlf_codec_e codec_;
+  uint16_t blockSamples_;
+  const volatile bool* validFlag_ = nullptr;
+  bool (*validIf_)() = nullptr;
+  dlf_validity_e validity_ = DLF_VALIDITY_NONE;
 };
 
 }  // namespace dlf::datastream
\ No newline at end of file
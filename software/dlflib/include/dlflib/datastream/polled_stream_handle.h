@@ -5,24 +5,89 @@
 
 #include "dlflib/datastream/abstract_stream_handle.h"
 #include "dlflib/datastream/polled_stream.h"
+#include "dlflib/format/codec.h"
 
 namespace dlf::datastream {
 
 class PolledStreamHandle : public AbstractStreamHandle {
  public:
   PolledStreamHandle(PolledStream* stream, dlf_stream_idx_t idx,
-                     dlf_tick_t sampleIntervalTicks, dlf_tick_t samplePhase);
+                     dlf_tick_t sampleIntervalTicks, dlf_tick_t samplePhase,
+                     dlf_codec_e codec = DLF_CODEC_RAW,
+                     uint16_t blockSamples = 0,
+                     dlf_validity_e validity = DLF_VALIDITY_NONE);
 
   bool available(dlf_tick_t tick);
 
-  size_t encodeHeaderInto(StreamBufferHandle_t buf);
+  size_t encodeHeaderInto(dlf::util::ByteRing& buf, uint32_t fileFlags);
 
-  size_t encodeInto(StreamBufferHandle_t buf, dlf_tick_t tick);
+  size_t encodeInto(dlf::util::ByteRing& buf, dlf_tick_t tick);
+
+  size_t encodeTrailerInto(dlf::util::ByteRing& buf);
+
+  uint32_t logfileFlags() const;
+
+  /**
+   * Samples in the open block, which are not in the file yet. Always 0 for
+   * raw and columnar streams.
+   */
+  size_t pendingSamples() const;
+
+  /**
+   * Writes the open block early if it holds samples
+   * (DLF_LOGFILE_FLAG_BLOCK_CUTS).
+   * @return Number of bytes committed to `buf`
+   */
+  size_t cutBlock(dlf::util::ByteRing& buf);
+
+  /**
+   * Largest column this stream can write into a block of `blockTicks` ticks
+   * (DLF_LOGFILE_FLAG_COLUMNAR).
+   */
+  size_t maxColumnBytes(dlf_tick_t blockTicks) const;
+
+  /**
+   * Switches to the columnar layout: from now on, encodeInto() collects
+   * samples into a column of up to `blockTicks` ticks instead of writing
+   * them, and the LogFile writes the column with finishColumn().
+   */
+  void setColumnar(dlf_tick_t blockTicks);
+
+  /**
+   * Completes the current column: the raw samples, or a block payload for
+   * coded streams and streams with validity.
+   * @param len Set to the length of the returned column
+   * @return The column, valid until the next encodeInto() or resetColumn()
+   */
+  const uint8_t* finishColumn(size_t& len);
+
+  /**
+   * Starts a new, empty column.
+   */
+  void resetColumn();
 
  private:
+  /**
+   * Writes the encoder's current block, with its header, and starts a new one.
+   */
+  size_t writeBlock(dlf::util::ByteRing& buf);
+
+  /**
+   * Whether the stream's current value is valid. Called with its mutex held.
+   */
+  bool valid() const;
+
   dlf_tick_t sampleIntervalTicks_;
   dlf_tick_t samplePhaseTicks_;
-  std::vector<uint8_t> dataBuffer_;
+  dlf_codec_e codec_;
+  uint16_t blockSamples_;
+  dlf_validity_e validity_;
+  // Null for DLF_CODEC_RAW without validity
+  std::unique_ptr<dlf::format::BlockEncoder> encoder_;
+  // Columnar layout: samples of the open block, for raw streams
+  bool columnar_ = false;
+  std::vector<uint8_t> column_;
+  size_t columnLen_ = 0;
 };
 
 }  // namespace dlf::datastream
\ No newline at end of file
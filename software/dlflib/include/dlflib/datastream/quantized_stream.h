@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+
+#include "dlflib/datastream/polled_stream.h"
+#include "dlflib/datastream/quantizer.h"
+
+namespace dlf::datastream {
+
+/**
+ * Polled stream of a float or double stored as fixed point. The value is
+ * quantized as it is sampled; see Quantizer.
+ */
+class QuantizedStream : public PolledStream {
+ public:
+  QuantizedStream(std::unique_ptr<Quantizer> quantizer, const char* id,
+                  std::chrono::microseconds sampleInterval,
+                  const Options& options);
+
+  void refresh() override { quantizer_->sample(); }
+
+ private:
+  std::unique_ptr<Quantizer> quantizer_;
+};
+
+}  // namespace dlf::datastream
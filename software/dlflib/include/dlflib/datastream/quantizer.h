@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace dlf::datastream {
+
+/**
+ * Fixed-point storage for a floating-point value: value = raw * scale +
+ * offset, with raw stored as an int16_t or int32_t. For a value whose source
+ * has a known resolution, such as GNSS coordinates in 1e-7 degrees, this
+ * halves (or quarters) its storage at no loss.
+ */
+struct Quantization {
+  enum Storage : uint8_t { INT16, INT32 };
+
+  double scale = 1;  // Value of one count. Must be finite and non-zero.
+  double offset = 0;
+  Storage storage = INT32;
+};
+
+/**
+ * Samples a float or double into its quantized form. Out of range values
+ * saturate to the storage type's limits; NaN is stored as 0.
+ */
+class Quantizer {
+ public:
+  Quantizer(const volatile double& value, const Quantization& quantization);
+
+  Quantizer(const volatile float& value, const Quantization& quantization);
+
+  /**
+   * @return false if the scale is 0 or the scale or offset is not finite
+   */
+  static bool isValid(const Quantization& quantization);
+
+  /**
+   * Rounds `value` to the nearest count, saturating to the storage range.
+   */
+  static int32_t quantize(double value, const Quantization& quantization);
+
+  const Quantization& quantization() const { return quantization_; }
+
+  /**
+   * Bytes of the quantized value: 2 for INT16, 4 for INT32.
+   */
+  size_t size() const {
+    return quantization_.storage == Quantization::INT16 ? 2 : 4;
+  }
+
+  /**
+   * The quantized value as of the last sample(), little-endian.
+   */
+  uint8_t* data() { return raw_; }
+
+  /**
+   * Reads the source value and quantizes it into data().
+   */
+  void sample();
+
+  /**
+   * type_structure of the quantized value, e.g.
+   * "Quantized;value:int32_t:0:1e-07:0". The scale and offset follow the
+   * field's offset.
+   */
+  const char* typeStructure() const { return typeStructure_.c_str(); }
+
+ private:
+  void describe();
+
+  const volatile double* double_ = nullptr;
+  const volatile float* float_ = nullptr;
+  Quantization quantization_;
+  uint8_t raw_[4] = {};
+  std::string typeStructure_;
+};
+
+}  // namespace dlf::datastream
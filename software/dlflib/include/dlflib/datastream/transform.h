@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace dlf::datastream {
+
+/**
+ * A chain of stages applied to a polled value in the sampler, after it is
+ * read and before it is stored, so that filtered or derived channels are
+ * computed once on the device. Stages run in the order they are added:
+ *
+ *   dlf::datastream::Transform().scale(0.01).movingAverage(10).decimate(10)
+ *
+ * Memory is allocated when stages are added, never while sampling. The
+ * transform passed to DLFLogger::poll() is a description; each run works on
+ * a copy of its own, so filters start over with every run.
+ */
+class Transform {
+ public:
+  static constexpr size_t MAX_STAGES = 8;
+
+  /**
+   * value * factor + offset, e.g. for unit conversion.
+   */
+  Transform& scale(double factor, double offset = 0);
+
+  /**
+   * Mean of the last `window` values (fewer until that many were seen). At
+   * most DLF_TRANSFORM_MAX_WINDOW.
+   */
+  Transform& movingAverage(uint16_t window);
+
+  /**
+   * First-order IIR low-pass: y += alpha * (value - y), with 0 < alpha <= 1.
+   * Starts from the first value.
+   */
+  Transform& lowPass(double alpha);
+
+  /**
+   * Change from the previous value, 0 for the first.
+   */
+  Transform& difference();
+
+  /**
+   * Passes one value in `factor` on to the following stages and the file.
+   * The stream is still read at its sample interval, and its values are
+   * stored every `factor` samples, which is its interval in the file.
+   */
+  Transform& decimate(uint16_t factor);
+
+  /**
+   * Whether every stage was accepted. A stage is rejected if its parameters
+   * are out of range or the chain already holds MAX_STAGES.
+   */
+  bool valid() const { return valid_; }
+
+  bool empty() const { return stages_.empty(); }
+
+  /**
+   * Product of the decimation factors: input samples per stored sample.
+   */
+  uint32_t decimation() const;
+
+  /**
+   * Runs the value of input sample `index` through the chain. Samples are
+   * numbered by tick, (tick + phase) / interval, so that decimation picks the
+   * same samples regardless of where it starts; a decimate stage passes
+   * those whose index is a multiple of the factors up to and including it.
+   * @return false if a decimate stage dropped the value
+   */
+  bool apply(double& value, uint64_t index);
+
+  /**
+   * Clears the state of every stage.
+   */
+  void reset();
+
+  /**
+   * The chain as text, e.g. "scale(0.01,0) > movingAverage(10) >
+   * decimate(10)".
+   */
+  std::string describe() const;
+
+ private:
+  enum Kind : uint8_t { SCALE, MOVING_AVERAGE, LOW_PASS, DIFFERENCE, DECIMATE };
+
+  struct Stage {
+    Kind kind;
+    double a = 0;    // Scale: factor. Low-pass: alpha.
+    double b = 0;    // Scale: offset
+    uint32_t n = 0;  // Moving average: window. Decimate: cumulative factor.
+    // State
+    double last = 0;    // Low-pass: output. Difference: previous value.
+    double sum = 0;     // Moving average: sum of the window
+    uint32_t seen = 0;  // Values seen, up to the window for moving averages
+    uint32_t pos = 0;   // Moving average: next slot of the window
+    std::vector<double> window;
+  };
+
+  Transform& add(const Stage& stage);
+
+  std::vector<Stage> stages_;
+  bool valid_ = true;
+};
+
+}  // namespace dlf::datastream
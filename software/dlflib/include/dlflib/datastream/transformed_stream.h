@@ -0,0 +1,63 @@
+#pragma once
+
+#include <type_traits>
+
+#include "dlflib/datastream/polled_stream.h"
+#include "dlflib/datastream/transform.h"
+
+namespace dlf::datastream {
+
+/**
+ * Polled stream of a number passed through a Transform. The source is read
+ * at the stream's sample interval, and every value the transform passes on
+ * is stored as a double (for double sources) or a float. With decimation,
+ * the stream's interval in the file is the sample interval times the
+ * decimation. The chain is described in the stream's notes.
+ */
+class TransformedStream : public PolledStream {
+ public:
+  template <typename T,
+            typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+  TransformedStream(const volatile T& value, const Transform& transform,
+                    const char* id, std::chrono::microseconds sampleInterval,
+                    const Options& options)
+      : TransformedStream(&value, &readAs<T>, std::is_same<T, double>::value,
+                          transform, id, sampleInterval, options) {}
+
+  std::unique_ptr<dlf::datastream::AbstractStreamHandle> createHandle(
+      std::chrono::microseconds tickInterval, dlf_stream_idx_t idx) override;
+
+  const Transform& transform() const { return transform_; }
+
+  /**
+   * Reads the source, with the mutex held if set.
+   * @return false if the mutex could not be taken
+   */
+  bool read(double& value);
+
+  /**
+   * Sets the value to be stored.
+   */
+  void store(double value);
+
+ private:
+  using Reader = double (*)(const volatile void* source);
+
+  TransformedStream(const volatile void* source, Reader read, bool wide,
+                    const Transform& transform, const char* id,
+                    std::chrono::microseconds sampleInterval,
+                    const Options& options);
+
+  template <typename T>
+  static double readAs(const volatile void* source) {
+    return static_cast<double>(*static_cast<const volatile T*>(source));
+  }
+
+  const volatile void* source_;
+  Reader read_;
+  bool wide_;
+  uint8_t value_[8] = {};
+  Transform transform_;
+};
+
+}  // namespace dlf::datastream
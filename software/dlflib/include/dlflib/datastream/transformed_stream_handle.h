@@ -0,0 +1,30 @@
+#pragma once
+
+#include "dlflib/datastream/polled_stream_handle.h"
+#include "dlflib/datastream/transformed_stream.h"
+
+namespace dlf::datastream {
+
+/**
+ * Reads a TransformedStream's source on every input sample tick and runs it
+ * through the handle's own copy of the transform, which holds the filter
+ * state for this run. Values the transform passes on are written like any
+ * polled sample, on the ticks of the output schedule.
+ */
+class TransformedStreamHandle : public PolledStreamHandle {
+ public:
+  TransformedStreamHandle(TransformedStream* stream, dlf_stream_idx_t idx,
+                          dlf_tick_t inputIntervalTicks, dlf_tick_t phaseTicks,
+                          dlf_tick_t outputIntervalTicks, dlf_codec_e codec,
+                          uint16_t blockSamples, dlf_validity_e validity);
+
+  bool available(dlf_tick_t tick) override;
+
+ private:
+  TransformedStream* transformed_;
+  dlf_tick_t inputIntervalTicks_;
+  dlf_tick_t phaseTicks_;
+  Transform transform_;
+};
+
+}  // namespace dlf::datastream
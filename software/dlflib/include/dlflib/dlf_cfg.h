@@ -10,6 +10,32 @@
 #define DLF_FREERTOS_DURATION \
   std::chrono::duration<TickType_t, std::ratio<1, configTICK_RATE_HZ>>
 #define LOCKFILE_NAME "LOCK"
+// Upper bound on the time DLFLogger::begin() spends repairing each run left
+// open by an unclean shutdown
+#define DLF_RECOVERY_BUDGET_MS 2000
+// Default samples per block for polled streams with a codec
+#define DLF_CODEC_BLOCK_SAMPLES 128
+// Default time Run::commit() waits for log files to become durable
+#define DLF_COMMIT_TIMEOUT_MS 5000
+// Largest slice of data the flusher compresses into one frame when block
+// compression is enabled
+#define DLF_FRAME_RAW_BYTES 4096
+// Event index entries the sampler can queue for the flusher (event.idx)
+#define DLF_EVENT_INDEX_PENDING 32
+// A jump of the system clock against the monotonic timer larger than this
+// is taken as the clock being set, and gets a time anchor right away
+#define DLF_TIME_STEP_US 50000
+// Default bytes a MessageStream stages between ticks, and the largest
+// message it accepts
+#define DLF_MESSAGE_BUFFER_SIZE 1024
+#define DLF_MESSAGE_MAX_SIZE 1024
+// Largest chunk a CaptureStream writes per tick
+#define DLF_CAPTURE_MAX_CHUNK 2048
+// Stack of the sampler task, which runs every polled stream's refresh(), getter
+// and transform stages
+#define DLF_SAMPLER_STACK_SIZE 4096
+// Largest window of a moving average transform stage
+#define DLF_TRANSFORM_MAX_WINDOW 256
 #define UPLOAD_MARKER_FILE_NAME "UPLOADED"
 
 // Comment out the following to remove debug messaging
@@ -17,4 +17,10 @@ class Encodable {
         typeHash(dlf::util::hashStr(typeStructure)),
         data((uint8_t*)(&v)),
         dataSize(sizeof(T)) {}
+
+  Encodable(uint8_t* data, size_t dataSize, const char* typeStructure)
+      : typeStructure(typeStructure),
+        typeHash(dlf::util::hashStr(typeStructure)),
+        data(data),
+        dataSize(dataSize) {}
 };
@@ -2,12 +2,18 @@
 
 #include <Arduino.h>
 #include <FS.h>
-#include <freertos/stream_buffer.h>
 
 #include <vector>
 
 #include "dlflib/datastream/abstract_stream_handle.h"
+#include "dlflib/dlf_cfg.h"
 #include "dlflib/dlf_types.h"
+#include "dlflib/format/lz4.h"
+#include "dlflib/storage/block_device.h"
+#include "dlflib/storage/log_sink.h"
+#include "dlflib/storage/run_container.h"
+#include "dlflib/util/byte_ring.h"
+#include "dlflib/util/latency_histogram.h"
 
 namespace dlf {
 
@@ -27,9 +33,76 @@ namespace dlf {
  */
 class LogFile {
  public:
+  /**
+   * Snapshot of buffer and writer telemetry. Values are updated by the sampler
+   * (buffer occupancy) and the flusher (everything else) without locking, so a
+   * snapshot may be slightly torn but is always safe to read.
+   */
+  struct Stats {
+    size_t bufferCapacity = 0;
+    // Peak number of bytes held in the ring buffer since the file was opened
+    size_t bufferHighWaterBytes = 0;
+    size_t bytesWritten = 0;
+    // Write throughput over the last completed ~1s window
+    uint32_t bytesPerSecond = 0;
+    // Duration of each sink write call
+    dlf::util::LatencyHistogram writeLatency;
+    // Duration of each flush / SD sync
+    dlf::util::LatencyHistogram commitLatency;
+  };
+
+  struct Options {
+    // File name without the .dlf extension. Defaults to the stream type
+    // ("polled", "event").
+    const char* name = nullptr;
+    // If set, data is written as raw sectors into a file preallocated on this
+    // volume instead of through the filesystem. See storage::RawSectorSink.
+    dlf::storage::RawVolume* rawVolume = nullptr;
+    // Size of the preallocated extent. Bytes beyond it are appended through
+    // the filesystem.
+    uint64_t rawPreallocateBytes = 0;
+    // If set, the file (and event.idx) is written as sections of this run
+    // container instead of as files of its own. Takes precedence over
+    // rawVolume. RAW files have no section and are written as files anyway.
+    dlf::storage::RunContainer* container = nullptr;
+    // If nonzero, the file is append-only: instead of rewriting tick_span in
+    // the header, a dlf_checkpoint_t is appended every this many ticks, on
+    // each commit and on close.
+    dlf_tick_t checkpointIntervalTicks = 0;
+    // If set, the flusher LZ4-compresses the data section into
+    // dlf_frame_header_t frames (DLF_LOGFILE_FLAG_BLOCK_COMPRESSION). Costs
+    // about 16 KiB of RAM per file for the compressor and frame buffers. The
+    // sampler is unaffected.
+    bool compressBlocks = false;
+    // If set, the data section is written as frames (stored ones unless
+    // compressBlocks is set too), each followed by its CRC-32
+    // (DLF_LOGFILE_FLAG_BLOCK_CRC). Costs the frame buffers, about 8 KiB of
+    // RAM per file, and a CRC pass over each frame in the flusher.
+    bool blockCrc = false;
+    // Event files only: group event records by tick with varint headers
+    // instead of a full dlf_event_stream_sample_t per record. See
+    // DLF_LOGFILE_FLAG_COMPACT_EVENTS.
+    bool compactEvents = false;
+    // Event files only: if nonzero, the flusher keeps a sparse tick -> offset
+    // index of the file in event.idx, with an entry at the first record at
+    // least this many ticks after the previous entry.
+    dlf_tick_t indexIntervalTicks = 0;
+    // Event files only: if nonzero, a dlf_keyframe_t with the value of every
+    // stream is written on the first tick and then every this many ticks.
+    dlf_tick_t keyframeIntervalTicks = 0;
+    // Event files only: the file may hold dlf_time_anchor_t records, queued
+    // with queueTimeAnchor() (DLF_LOGFILE_FLAG_TIME_ANCHORS).
+    bool timeAnchors = false;
+    // Polled files only: if nonzero, samples are collected into blocks of
+    // this many ticks and written column by column (DLF_LOGFILE_FLAG_COLUMNAR).
+    // Limited so that a block fits in half the buffer.
+    dlf_tick_t columnBlockTicks = 0;
+  };
+
   LogFile(std::vector<std::unique_ptr<dlf::datastream::AbstractStreamHandle>>
               handles,
-          dlf_stream_type_e streamType, const char* dir, fs::FS& fs);
+          dlf_stream_type_e streamType, const char* dir, fs::FS& fs,
+          const Options& options);
 
   /**
    * Samples data. Intended to be externally called at the tick interval.
@@ -38,15 +111,65 @@ class LogFile {
    */
   void sample(dlf_tick_t tick);
 
+  /**
+   * Has the next sample() write a dlf_time_anchor_t for its tick, after the
+   * tick's records. Must only be called from the task that samples this
+   * logfile. Ignored unless Options::timeAnchors is set.
+   * @param epochUs Wall clock time at the start of that tick
+   */
+  void queueTimeAnchor(int64_t epochUs, dlf_time_source_e source);
+
   /**
    * Flushes and closes this logfile.
+   * @return false if the file had stopped on an error (see state()). Its sink
+   * is closed all the same, but the file is left for recovery to bound.
+   */
+  bool close();
+
+  /**
+   * Sequence number identifying a commit requested with requestCommit().
    */
-  void close();
+  using CommitSeq = uint32_t;
+
+  /**
+   * Where a completed commit landed.
+   */
+  struct Commit {
+    // Tick the commit point was taken at (>= the requested tick)
+    dlf_tick_t tick = 0;
+    // File offset just past the committed data. For compressed files this is
+    // the end of the frame holding the commit point.
+    size_t bytes = 0;
+  };
+
+  /**
+   * Asks for everything up to and including `throughTick` to be made durable.
+   * The sampler marks the commit point once that tick has been sampled (for
+   * append-only files, by appending a checkpoint there), and the flusher
+   * syncs the file once it has written past it. Does not block.
+   */
+  CommitSeq requestCommit(dlf_tick_t throughTick);
+
+  /**
+   * Blocks on a task notification until commit `seq` is durable. Only one
+   * task may wait on a LogFile at a time.
+   * @return false on timeout, or if the file stopped logging first
+   */
+  bool waitForCommit(CommitSeq seq, TickType_t timeout, Commit& out);
+
+  /**
+   * Live view of this file's telemetry. Copy it for a stable snapshot.
+   */
+  const Stats& stats() const { return stats_; }
+
+  dlf_stream_type_e streamType() const { return streamType_; }
 
   /**
-   * Force a manual flush on the logfile.
+   * LOGGING while the file is being written. Errors are negative, e.g.
+   * WRITE_ERROR once the sink stopped taking data, after which the file is no
+   * longer sampled.
    */
-  void flush();
+  dlf_file_state_e state() const { return state_; }
 
   /**
    * Lock the file mutex
@@ -61,7 +184,7 @@ class LogFile {
  private:
   /**
    * @brief Task responsible for writing data to SD
-   * Constantly receives data from _stream streambuffer and writes to SD.
+   * Constantly takes committed data from ring_ and writes it to SD.
    * @param arg
    */
   static void taskFlusher(void* arg);
@@ -69,37 +192,242 @@ class LogFile {
   /**
    * @brief Writes a complete header into this logfile.
    *
-   * Uses existing streambuffer architecture because why not.
+   * Uses the existing ring buffer architecture because why not.
    */
   void writeHeader(dlf_stream_type_e streamType);
 
+  /**
+   * Syncs the sink at the latched commit point and wakes the waiting task.
+   * Called by the flusher, with fileMutex_ held, once it has written past
+   * commitTargetBytes_.
+   */
+  void completeCommit();
+
+  /**
+   * Queues a checkpoint for `tick`. Must only be called from the task that
+   * samples this logfile.
+   */
+  void writeCheckpoint(dlf_tick_t tick);
+
+  /**
+   * Samples an event file with compact events as one tick group. The group
+   * is reserved as a whole, so if the ring is short of space the entire tick
+   * is deferred to the next one.
+   */
+  void sampleEventGroup(dlf_tick_t tick);
+
+  /**
+   * Writes a keyframe for `tick` in place of the tick's change records.
+   * @return false if it did not fit in ring_, in which case nothing was
+   * written
+   */
+  bool writeKeyframe(dlf_tick_t tick);
+
+  /**
+   * Writes the queued time anchor for `tick`. An anchor that does not fit in
+   * ring_ is dropped.
+   */
+  void writeTimeAnchor(dlf_tick_t tick);
+
+  /**
+   * Worst-case size of a column block of `blockTicks` ticks.
+   */
+  size_t maxColumnBlockBytes(dlf_tick_t blockTicks) const;
+
+  /**
+   * Writes the open column block, which ends with `lastTick`. Blocks until
+   * the block fits in ring_, like polled samples do.
+   */
+  void writeColumnBlock(dlf_tick_t lastTick);
+
+  /**
+   * Writes a dlf_block_cut_t for `tick` and the open block of every coded
+   * stream that has samples in it (DLF_LOGFILE_FLAG_BLOCK_CUTS).
+   */
+  void writeBlockCut(dlf_tick_t tick);
+
+  /**
+   * Updates the buffer high-water mark after data was queued, and stops
+   * logging if ring_ has filled up.
+   */
+  void trackRingUsage(dlf_tick_t tick);
+
+  /**
+   * Syncs the sink. For a preallocated file, then records the synced length
+   * in the header (dlf_logfile_ext_header_t::written_bytes). Caller must hold
+   * fileMutex_.
+   */
+  void syncSink();
+
+  /**
+   * Writes to the sink, flagging a WRITE_ERROR for the sampler if the sink
+   * takes less than `len`. Caller must hold fileMutex_.
+   */
+  void writeSink(const uint8_t* data, size_t len);
+
+  /**
+   * Writes committed ring spans to the sink and releases them. Caller must
+   * hold fileMutex_.
+   */
+  void writeSpans(const dlf::util::ByteRing::Spans& spans);
+
+  /**
+   * Writes as much of `spans` as is ready to go to the sink, either as is or
+   * as frames, and releases it. Caller must hold fileMutex_.
+   * @param idle Whether the flusher woke up without being notified, in which
+   * case frames smaller than DLF_FRAME_RAW_BYTES are cut too
+   * @return Number of uncompressed bytes released from ring_
+   */
+  size_t writeData(const dlf::util::ByteRing::Spans& spans, bool idle);
+
+  /**
+   * Framed counterpart of writeSpans(). Frames are cut at tick boundaries
+   * (the commit point, or tick marks published by the sampler) unless a
+   * single tick outgrows a frame, and compressed and checksummed as
+   * configured.
+   */
+  size_t writeFrames(const dlf::util::ByteRing::Spans& spans, bool idle);
+
+  /**
+   * Publishes the end of the data queued so far as a tick boundary, for
+   * writeFrames(). Sampler side.
+   */
+  void publishTickMark(dlf_tick_t nextTick);
+
+  /**
+   * Picks up the sampler's latest tick mark. Flusher side.
+   */
+  void collectTickMark();
+
+  /**
+   * Queues an event.idx entry for the records just written at `tick`, which
+   * start at `offset`. Sampler side.
+   */
+  void queueIndexEntry(dlf_tick_t tick, size_t offset);
+
+  /**
+   * Appends the queued index entries whose records have been written to the
+   * data file. Flusher side; caller must hold fileMutex_.
+   */
+  void writeIndexEntries();
+
   /**
    * Updates and closes the underlying file. Does not flush internal
    * buffers
    */
   void closeFile();
 
+  /**
+   * close() for a file stopped by QUEUE_FULL or WRITE_ERROR.
+   */
+  void closeAfterError();
+
   /**
    * @brief Data stream handles logged by this logfile
    */
   std::vector<std::unique_ptr<dlf::datastream::AbstractStreamHandle>> handles_;
 
   fs::FS& fs_;
+  dlf_stream_type_e streamType_;
   char filename_[128];
-  fs::File file_;
+  std::unique_ptr<dlf::storage::LogSink> sink_;
+  // Written through a RawSectorSink (DLF_LOGFILE_FLAG_PREALLOCATED)
+  bool preallocated_ = false;
 
-  /**
-   * @brief Streambuffer responsible for transferring data from sampler task to
-   * SD writer task
-   */
-  StreamBufferHandle_t stream_;
-  dlf_file_state_e state_;
+  volatile dlf_file_state_e state_;
+  volatile bool writeFailed_ = false;  // Set by the flusher on a short write
   SemaphoreHandle_t syncSemaphore_;
   SemaphoreHandle_t
       fileMutex_;  // Protects file operations from race conditions
   dlf_tick_t lastTick_;
   size_t fileEndPosition_;  // Track file end position to prevent truncation
                             // on close
+  size_t bytesQueued_;      // Bytes committed to ring_ so far, i.e. the
+                            // file offset of the next record
+  dlf_tick_t checkpointIntervalTicks_;
+  bool compactEvents_;
+  dlf_tick_t lastGroupTick_ = 0;    // Base of the next group's tick delta
+  std::vector<uint16_t> groupDue_;  // Handles with a record in this group
+  // Compact events: tick delta varint and a count of 0
+  static constexpr size_t MAX_EMPTY_GROUP_BYTES = 11;
+  dlf_tick_t keyframeIntervalTicks_ = 0;
+  dlf_tick_t nextKeyframeTick_ = 0;
+  size_t keyframeBytes_ = 0;  // Sum of the stream value sizes
+  bool timeAnchors_ = false;
+  bool anchorQueued_ = false;
+  int64_t anchorEpochUs_ = 0;
+  dlf_time_source_e anchorSource_ = DLF_TIME_SOURCE_SYSTEM;
+
+  // Columnar layout (Options::columnBlockTicks). Handles collect the samples
+  // of the open block, which spans columnFirstTick_ through the last tick.
+  dlf_tick_t columnBlockTicks_ = 0;
+  dlf_tick_t columnFirstTick_ = 0;
+  bool columnOpen_ = false;
+  std::vector<const uint8_t*> columnData_;  // writeColumnBlock() scratch
+  std::vector<uint32_t> columnLens_;
+  // Otherwise, coded streams cut their blocks at commits and checkpoints
+  // (DLF_LOGFILE_FLAG_BLOCK_CUTS)
+  bool blockCuts_ = false;
+
+  // Event index (Options::indexIntervalTicks). The sampler queues entries in
+  // indexPending_ and the flusher appends them to indexSink_ once the data
+  // they point at is written.
+  std::unique_ptr<dlf::storage::LogSink> indexSink_;
+  dlf_tick_t indexIntervalTicks_ = 0;
+  dlf_tick_t nextIndexTick_ = 0;  // Sampler: earliest tick of the next entry
+  dlf_event_index_entry_t indexPending_[DLF_EVENT_INDEX_PENDING];
+  volatile uint32_t indexQueued_ = 0;   // Written by the sampler
+  volatile uint32_t indexWritten_ = 0;  // Written by the flusher
+
+  // Commit barrier. Each seq is written by one task only: requested by the
+  // caller, latched by the sampler, done by the flusher. The sampler fills in
+  // the target before publishing commitLatchedSeq_.
+  volatile CommitSeq commitRequestSeq_ = 0;
+  volatile dlf_tick_t commitRequestTick_ = 0;
+  volatile CommitSeq commitLatchedSeq_ = 0;
+  volatile dlf_tick_t commitTargetTick_ = 0;
+  volatile size_t commitTargetBytes_ = 0;
+  volatile CommitSeq commitDoneSeq_ = 0;
+  volatile dlf_tick_t committedTick_ = 0;
+  volatile size_t committedBytes_ = 0;
+  volatile TaskHandle_t commitWaiter_ = nullptr;
+
+  // Bytes handed to the sink so far. Equals the uncompressed length written
+  // unless the file is compressed.
+  size_t fileBytes_ = 0;
+  size_t rawWritten_ = 0;  // Uncompressed bytes released from ring_
+
+  // Frames (Options::compressBlocks, Options::blockCrc). The sampler
+  // publishes a tick mark after each tick through a sequence lock: ring data
+  // before markBytes_ is from ticks before markTick_. The flusher keeps the
+  // marks it has seen in marks_ until it cuts a frame past them.
+  struct TickMark {
+    dlf_tick_t tick;
+    size_t bytes;
+  };
+  static constexpr size_t MAX_TICK_MARKS = 16;
+  bool framed_ = false;
+  bool blockCrc_ = false;
+  std::unique_ptr<dlf::format::Lz4Compressor> compressor_;  // May be null
+  std::vector<uint8_t> frameRaw_;
+  std::vector<uint8_t> frameOut_;
+  volatile size_t headerBytes_ = 0;  // Set once the header is queued
+  volatile uint32_t markSeq_ = 0;
+  volatile dlf_tick_t markTick_ = 0;
+  volatile size_t markBytes_ = 0;
+  TickMark marks_[MAX_TICK_MARKS];
+  size_t numMarks_ = 0;
+  dlf_tick_t frameTick_ = 0;     // first_tick of the next frame
+  bool frameContinued_ = false;  // Next frame continues a split tick
+
+  /**
+   * @brief Lock-free ring transferring data from the sampler task to the SD
+   * writer task. The sampler encodes samples in place; the flusher writes
+   * committed spans straight to the sink.
+   */
+  dlf::util::ByteRing ring_;
+  TaskHandle_t flusherTask_ = nullptr;
+  Stats stats_;
 };
 
 }  // namespace dlf
\ No newline at end of file
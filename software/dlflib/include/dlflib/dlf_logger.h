@@ -9,10 +9,17 @@
 
 #include "dlflib/components/component.h"
 #include "dlflib/components/uploader_component.h"
+#include "dlflib/datastream/capture_stream.h"
 #include "dlflib/datastream/event_stream.h"
+#include "dlflib/datastream/flag_stream.h"
+#include "dlflib/datastream/getter_stream.h"
+#include "dlflib/datastream/message_stream.h"
 #include "dlflib/datastream/polled_stream.h"
+#include "dlflib/datastream/quantized_stream.h"
+#include "dlflib/datastream/transformed_stream.h"
 #include "dlflib/dlf_logfile.h"
 #include "dlflib/dlf_run.h"
+#include "dlflib/dlf_struct.h"
 #include "dlflib/dlf_types.h"
 
 #define POLL(type_name)                                                        \
@@ -35,6 +42,12 @@
                   SemaphoreHandle_t mutex) {                                   \
     return pollInternal(Encodable(value, #type_name), id, sampleInterval,      \
                         std::chrono::microseconds::zero(), nullptr, mutex);    \
+  }                                                                            \
+  DLFLogger& poll(type_name& value, const char* id,                            \
+                  std::chrono::microseconds sampleInterval,                    \
+                  const dlf::datastream::PolledStream::Options& options) {     \
+    return pollInternal(Encodable(value, #type_name), id, sampleInterval,      \
+                        options);                                              \
   }
 
 #define WATCH(type_name)                                                  \
@@ -63,7 +76,8 @@ class DLFLogger : public dlf::components::Component,
 
   run_handle_t startRun(
       const Encodable& meta,
-      std::chrono::microseconds tickRate = std::chrono::milliseconds(100));
+      std::chrono::microseconds tickRate = std::chrono::milliseconds(100),
+      const Run::Options& options = Run::Options());
 
   void stopRun(run_handle_t h);
 
@@ -91,6 +105,190 @@ class DLFLogger : public dlf::components::Component,
   POLL(double)
   POLL(float)
 
+  /**
+   * poll() and watch() for structs registered with DLF_STRUCT and for
+   * fixed-size arrays (T[N], std::array<T, N>). The value is logged as a
+   * single stream, copied whole on each sample, so its fields or elements
+   * are always consistent with each other.
+   */
+  template <typename T,
+            typename = std::enable_if_t<HasTypeStructure<T>::value>>
+  DLFLogger& poll(
+      T& value, const char* id, std::chrono::microseconds sampleInterval,
+      std::chrono::microseconds phase = std::chrono::microseconds::zero(),
+      const char* notes = nullptr, SemaphoreHandle_t mutex = nullptr) {
+    return pollInternal(Encodable(value, typeStructureOf<T>()), id,
+                        sampleInterval, phase, notes, mutex);
+  }
+
+  template <typename T,
+            typename = std::enable_if_t<HasTypeStructure<T>::value>>
+  DLFLogger& poll(T& value, const char* id,
+                  std::chrono::microseconds sampleInterval, const char* notes,
+                  SemaphoreHandle_t mutex = nullptr) {
+    return pollInternal(Encodable(value, typeStructureOf<T>()), id,
+                        sampleInterval, std::chrono::microseconds::zero(),
+                        notes, mutex);
+  }
+
+  template <typename T,
+            typename = std::enable_if_t<HasTypeStructure<T>::value>>
+  DLFLogger& poll(T& value, const char* id,
+                  std::chrono::microseconds sampleInterval,
+                  SemaphoreHandle_t mutex) {
+    return pollInternal(Encodable(value, typeStructureOf<T>()), id,
+                        sampleInterval, std::chrono::microseconds::zero(),
+                        nullptr, mutex);
+  }
+
+  template <typename T,
+            typename = std::enable_if_t<HasTypeStructure<T>::value>>
+  DLFLogger& poll(T& value, const char* id,
+                  std::chrono::microseconds sampleInterval,
+                  const dlf::datastream::PolledStream::Options& options) {
+    return pollInternal(Encodable(value, typeStructureOf<T>()), id,
+                        sampleInterval, options);
+  }
+
+  template <typename T,
+            typename = std::enable_if_t<HasTypeStructure<T>::value>>
+  DLFLogger& watch(T& value, const char* id, const char* notes = nullptr,
+                   SemaphoreHandle_t mutex = nullptr) {
+    return watchInternal(Encodable(value, typeStructureOf<T>()), id,
+                         notes, mutex);
+  }
+
+  /**
+   * Polls the value returned by `getter`, a function pointer or capture-free
+   * lambda, e.g. `[]() -> float { return hypotf(accel.x, accel.y); }`. It is
+   * called by the sampler only on the ticks the stream is due, with
+   * `options.mutex` held if set, so the value needs no variable of its own.
+   * It must not block; see GetterStream. The value is a primitive, a
+   * DLF_STRUCT type or a std::array.
+   */
+  template <typename F, typename T = std::decay_t<std::invoke_result_t<F&>>,
+            typename = std::enable_if_t<!std::is_void<T>::value &&
+                                        std::is_convertible<F, T (*)()>::value>>
+  DLFLogger& poll(F getter, const char* id,
+                  std::chrono::microseconds sampleInterval,
+                  const dlf::datastream::PolledStream::Options& options =
+                      dlf::datastream::PolledStream::Options()) {
+    streams_.push_back(
+        dlf::util::make_unique<dlf::datastream::GetterStream<T>>(
+            static_cast<T (*)()>(getter), id, sampleInterval, options));
+    return *this;
+  }
+
+  /**
+   * Like the getter form, for values that are written into place, e.g.
+   * `poll<GpsData>([](GpsData& out) { ... }, "gps", 1s)`.
+   */
+  template <typename T>
+  DLFLogger& poll(void (*fill)(T& out), const char* id,
+                  std::chrono::microseconds sampleInterval,
+                  const dlf::datastream::PolledStream::Options& options =
+                      dlf::datastream::PolledStream::Options()) {
+    streams_.push_back(
+        dlf::util::make_unique<dlf::datastream::GetterStream<T>>(
+            fill, id, sampleInterval, options));
+    return *this;
+  }
+
+  /**
+   * Polls a float or double stored as fixed point, e.g.
+   * Quantization{1e-7} for GNSS coordinates that are only resolved to 1e-7
+   * degrees, which an int32_t holds exactly. The scale and offset are part
+   * of the stream's type_structure so that readers can restore the value.
+   */
+  DLFLogger& poll(double& value, const char* id,
+                  std::chrono::microseconds sampleInterval,
+                  const dlf::datastream::Quantization& quantization,
+                  const dlf::datastream::PolledStream::Options& options =
+                      dlf::datastream::PolledStream::Options()) {
+    return pollQuantized(
+        dlf::util::make_unique<dlf::datastream::Quantizer>(value,
+                                                           quantization),
+        id, sampleInterval, options);
+  }
+
+  DLFLogger& poll(float& value, const char* id,
+                  std::chrono::microseconds sampleInterval,
+                  const dlf::datastream::Quantization& quantization,
+                  const dlf::datastream::PolledStream::Options& options =
+                      dlf::datastream::PolledStream::Options()) {
+    return pollQuantized(
+        dlf::util::make_unique<dlf::datastream::Quantizer>(value,
+                                                           quantization),
+        id, sampleInterval, options);
+  }
+
+  /**
+   * Polls a number through a chain of transform stages run in the sampler,
+   * e.g. Transform().lowPass(0.1).decimate(10) to store a filtered channel
+   * at a tenth of the rate it is read at. See dlf::datastream::Transform.
+   */
+  template <typename T,
+            typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+  DLFLogger& poll(T& value, const char* id,
+                  std::chrono::microseconds sampleInterval,
+                  const dlf::datastream::Transform& transform,
+                  const dlf::datastream::PolledStream::Options& options =
+                      dlf::datastream::PolledStream::Options()) {
+    return pollTransformed(
+        dlf::util::make_unique<dlf::datastream::TransformedStream>(
+            value, transform, id, sampleInterval, options));
+  }
+
+  /**
+   * Polls a group of boolean flags as one stream of a bitmask, 4 bytes per
+   * sample for up to 32 flags and 8 for up to 64. The group is copied; the
+   * flags it refers to must outlive the logger.
+   */
+  DLFLogger& pollFlags(const dlf::datastream::FlagGroup& flags, const char* id,
+                       std::chrono::microseconds sampleInterval,
+                       const dlf::datastream::PolledStream::Options& options =
+                           dlf::datastream::PolledStream::Options());
+
+  /**
+   * Watches a group of boolean flags as one event stream. Each change of any
+   * of them is one record with the mask of the flags that changed and the
+   * mask of their values.
+   */
+  DLFLogger& watchFlags(const dlf::datastream::FlagGroup& flags,
+                        const char* id, const char* notes = nullptr,
+                        SemaphoreHandle_t mutex = nullptr);
+
+  /**
+   * Adds an event stream of variable-length messages of up to `maxSize`
+   * bytes, such as state machine transitions, error strings or received
+   * NMEA sentences. Messages passed to the returned stream's write() or
+   * print() are logged to event.dlf on the next tick.
+   * @return The stream, owned by the logger
+   */
+  dlf::datastream::MessageStream* messages(
+      const char* id, size_t maxSize,
+      const dlf::datastream::MessageStream::Options& options =
+          dlf::datastream::MessageStream::Options());
+
+  /**
+   * Adds a stream of raw bytes read in bulk from `source`, such as the UART
+   * of a GNSS receiver, logged as tick-stamped chunks to raw-<id>.dlf. See
+   * dlf::datastream::CaptureStream.
+   * @param source Must outlive the logger
+   * @return The stream, owned by the logger
+   */
+  dlf::datastream::CaptureStream* capture(
+      const char* id, dlf::datastream::CaptureSource& source,
+      const dlf::datastream::CaptureStream::Options& options =
+          dlf::datastream::CaptureStream::Options());
+
+  /**
+   * VFS path the logger's filesystem is mounted at, e.g. "/sdcard" for
+   * SD_MMC. Needed for begin() to truncate torn data off runs that were not
+   * closed cleanly; without it those runs only get their header repaired.
+   */
+  DLFLogger& setVfsMountPoint(const char* mountPoint);
+
   DLFLogger& syncTo(const char* endpoint, const char* deviceUid,
                     const dlf::components::UploaderComponent::Options& options);
 
@@ -118,10 +316,42 @@ class DLFLogger : public dlf::components::Component,
                           std::chrono::microseconds phase, const char* notes,
                           SemaphoreHandle_t mutex = nullptr);
 
+  DLFLogger& pollInternal(
+      const Encodable& value, const char* id,
+      std::chrono::microseconds sampleInterval,
+      const dlf::datastream::PolledStream::Options& options);
+
+  DLFLogger& pollQuantized(
+      std::unique_ptr<dlf::datastream::Quantizer> quantizer, const char* id,
+      std::chrono::microseconds sampleInterval,
+      const dlf::datastream::PolledStream::Options& options);
+
+  DLFLogger& pollTransformed(
+      std::unique_ptr<dlf::datastream::TransformedStream> stream);
+
   run_handle_t getAvailableHandle();
 
   void prune();
 
+  /**
+   * Repairs the log files of a run left open by an unclean shutdown: finds
+   * the end of the valid data, truncates anything after it and records the
+   * recovered tick span. Bounded by DLF_RECOVERY_BUDGET_MS.
+   */
+  void recoverRun(const char* runDirPath);
+
+  /**
+   * recoverRun() for a run written as a container (run.dlf): cuts off a torn
+   * section, appends a commit record with the recovered lengths and tick
+   * span, and marks the container closed.
+   */
+  void recoverContainer(const char* path);
+
+  /**
+   * Truncates a file through the VFS mount point (see setVfsMountPoint).
+   */
+  bool truncateFile(const char* path, size_t length);
+
   // ComponentRegistry
   dlf::components::Component* findById(size_t id) const override;
 
@@ -146,6 +376,7 @@ class DLFLogger : public dlf::components::Component,
   std::vector<std::unique_ptr<dlf::datastream::AbstractStream>> streams_;
   fs::FS& fs_;
   char fsDir_[128];
+  char vfsMountPoint_[32] = {0};
   // Used to signal that a new run is available
   EventGroupHandle_t loggerEventGroup_{nullptr};
 };
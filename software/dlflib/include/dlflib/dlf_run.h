@@ -9,20 +9,92 @@
 #include <vector>
 
 #include "dlflib/datastream/abstract_stream.h"
+#include "dlflib/datastream/polled_stream.h"
+#include "dlflib/dlf_cfg.h"
 #include "dlflib/dlf_logfile.h"
 #include "dlflib/dlf_types.h"
+#include "dlflib/storage/run_container.h"
 
 namespace dlf {
 
 class Run {
  public:
+  struct Options {
+    // Interval at which LogFile telemetry is logged as the internal
+    // DLF_DIAGNOSTICS_STREAM_ID polled stream. Zero disables the stream.
+    std::chrono::microseconds diagnosticsInterval =
+        std::chrono::microseconds::zero();
+    // If set, log files bypass the filesystem and are written as raw sectors
+    // into contiguous files preallocated on this volume. Until the run closes,
+    // the files report their preallocated size and may contain stale bytes
+    // past the data, so partial-run uploads should not be used with it.
+    // Recovery keeps the data up to the length last synced
+    // (DLF_LOGFILE_FLAG_PREALLOCATED).
+    dlf::storage::RawVolume* rawVolume = nullptr;
+    // If set, the run is written to a single run.dlf in the run directory,
+    // with meta.dlf, polled.dlf, event.dlf and event.idx as interleaved
+    // sections, and the lock and upload state in its header. Fewer files
+    // mean fewer FAT directory updates and one upload stream per run. Takes
+    // precedence over rawVolume. Capture streams still get a raw-<id>.dlf
+    // each. See DLF_RUN_CONTAINER_MAGIC.
+    bool container = false;
+    // Preallocated size of each log file when rawVolume is set
+    uint64_t rawPreallocateBytes = 64ull * 1024 * 1024;
+    // If nonzero, log files are written strictly append-only, with progress
+    // recorded as checkpoint records at this interval instead of by rewriting
+    // tick_span in the header. See DLF_LOGFILE_FLAG_CHECKPOINTS.
+    std::chrono::microseconds checkpointInterval =
+        std::chrono::microseconds::zero();
+    // If set, log files are LZ4-compressed in blocks by the flusher, which
+    // cuts both SD writes and upload size. See
+    // DLF_LOGFILE_FLAG_BLOCK_COMPRESSION.
+    bool compressBlocks = false;
+    // If set, log file data is written in frames that each carry a CRC-32,
+    // so readers can skip a corrupted block and keep the data after it. See
+    // DLF_LOGFILE_FLAG_BLOCK_CRC.
+    bool blockCrc = false;
+    // If set, the event file groups records by tick with varint headers,
+    // which roughly halves the size of small events. See
+    // DLF_LOGFILE_FLAG_COMPACT_EVENTS.
+    bool compactEvents = false;
+    // If nonzero, a sparse tick -> offset index of event.dlf is kept in
+    // event.idx, with about one entry per this interval, so that readers can
+    // seek by time. See dlf::format::EventIndex.
+    std::chrono::microseconds eventIndexInterval =
+        std::chrono::microseconds::zero();
+    // If nonzero, the event file gets a keyframe holding the value of every
+    // event stream at the start of the run and then at this interval, so
+    // readers can start decoding there. See DLF_LOGFILE_FLAG_KEYFRAMES.
+    std::chrono::microseconds keyframeInterval =
+        std::chrono::microseconds::zero();
+    // If nonzero, polled.dlf is written in column blocks of this duration, so
+    // that one stream can be read without decoding the others. See
+    // DLF_LOGFILE_FLAG_COLUMNAR.
+    std::chrono::microseconds columnBlockDuration =
+        std::chrono::microseconds::zero();
+    // If nonzero, the event file gets a time anchor pairing a tick with the
+    // system clock on the first tick, then at this interval and whenever the
+    // system clock is set, so that readers can correct the drift of the tick
+    // clock. See DLF_LOGFILE_FLAG_TIME_ANCHORS.
+    std::chrono::microseconds timeAnchorInterval =
+        std::chrono::microseconds::zero();
+    // What the system clock was set from, recorded with each anchor taken
+    // from it. Update it with setTimeSource().
+    dlf_time_source_e timeSource = DLF_TIME_SOURCE_SYSTEM;
+  };
+
   Run(fs::FS& fs, const char* fsDir,
       const std::vector<std::unique_ptr<dlf::datastream::AbstractStream>>&
           streams,
-      std::chrono::microseconds tickInterval, const Encodable& meta);
+      std::chrono::microseconds tickInterval, const Encodable& meta,
+      const Options& options);
+
+  ~Run();
 
   /**
-   * End the run. Cleans up and closes out log files.
+   * End the run. Cleans up and closes out log files. If one of them stopped
+   * on an error, the run keeps its LOCK (or stays open, for a container) and
+   * is recovered by the next DLFLogger::begin().
    */
   void close();
 
@@ -33,9 +105,70 @@ class Run {
   }
 
   /**
-   * Force a manual flush of log files.
+   * Telemetry for the log file of the given stream type. Returns an empty
+   * Stats if the run has no such log file.
+   */
+  LogFile::Stats logFileStats(dlf_stream_type_e t) const;
+
+  /**
+   * State of the log file of the given stream type, e.g. WRITE_ERROR if it
+   * stopped logging because the card would not take more data. Returns
+   * UNINITIALIZED if the run has no such log file.
+   */
+  dlf_file_state_e logFileState(dlf_stream_type_e t) const;
+
+  /**
+   * Byte offsets up to which each log file was made durable by commit(). Data
+   * past these offsets belongs to later ticks.
+   */
+  struct CommitResult {
+    // Every tick up to this one (>= the requested tick) is durable in all
+    // files
+    dlf_tick_t tick = 0;
+    size_t polledBytes = 0;
+    size_t eventBytes = 0;  // Capture files (raw-<id>.dlf) are not reported
+    // Container runs: length of run.dlf up to the commit record, which
+    // applies the offsets above to its sections
+    size_t containerBytes = 0;
+  };
+
+  /**
+   * Flush barrier. Blocks until every sample up to and including
+   * `throughTick` is durable on the card in all log files, then reports where
+   * each file's committed data ends. For files that rewrite their header,
+   * tick_span is updated to the commit point first; append-only files get a
+   * checkpoint there instead.
+   * @return false if the run stopped logging or the timeout expired first
+   */
+  bool commit(dlf_tick_t throughTick, CommitResult& result,
+              TickType_t timeout = pdMS_TO_TICKS(DLF_COMMIT_TIMEOUT_MS));
+
+  /**
+   * Records that the system clock was just set from `source`. The next tick
+   * gets a time anchor, and later anchors taken from the system clock carry
+   * `source`. Has no effect unless Options::timeAnchorInterval is set.
+   */
+  void setTimeSource(dlf_time_source_e source);
+
+  /**
+   * Anchors the current tick to a time from an external reference, such as a
+   * GPS fix, without setting the system clock. The anchor is written on the
+   * next tick, with the time carried forward by the monotonic timer.
+   * @param epochUs The reference time now, in microseconds since the Unix
+   * epoch
+   * @return false if time anchors are disabled
+   */
+  bool addTimeAnchor(int64_t epochUs, dlf_time_source_e source);
+
+  /**
+   * Most recent tick handed to the log files by the sampler.
+   */
+  dlf_tick_t currentTick() const { return currentTick_; }
+
+  /**
+   * The run's container when Options::container is set, otherwise nullptr.
    */
-  void flushLogFiles();
+  dlf::storage::RunContainer* container() const { return container_.get(); }
 
   /**
    * Acquire locks on all log files.
@@ -56,6 +189,28 @@ class Run {
 
   void createLogfile(dlf_stream_type_e t);
 
+  /**
+   * Creates the raw-<id>.dlf of a RAW stream.
+   */
+  void createCaptureLogfile(dlf::datastream::AbstractStream* stream);
+
+  /**
+   * LogFile::Options for this run's Options.
+   */
+  LogFile::Options logFileOptions() const;
+
+  /**
+   * Copies current LogFile telemetry into diagnostics_. Called from the sampler
+   * task on ticks where the diagnostics stream is due.
+   */
+  void refreshDiagnostics();
+
+  /**
+   * Reads the system clock and queues a time anchor on the event file if one
+   * is due. Called from the sampler task before the log files sample `tick`.
+   */
+  void queueTimeAnchor(dlf_tick_t tick);
+
   char uuid_[37];
   uint32_t startMillis_;
   fs::FS& fs_;
@@ -63,9 +218,29 @@ class Run {
   char lockfilePath_[128];
   volatile dlf_file_state_e status_{UNINITIALIZED};
   SemaphoreHandle_t syncSemaphore_;
+  SemaphoreHandle_t commitMutex_{nullptr};  // Serializes commit() callers
+  volatile dlf_tick_t currentTick_{0};
   std::chrono::microseconds tickInterval_;
   const std::vector<std::unique_ptr<dlf::datastream::AbstractStream>>& streams_;
+  std::unique_ptr<dlf::storage::RunContainer> container_;
   std::vector<std::unique_ptr<LogFile>> logFiles_;
+  Options options_;
+  dlf_run_diagnostics_t diagnostics_{};
+  dlf_tick_t diagnosticsIntervalTicks_{0};
+  std::unique_ptr<dlf::datastream::PolledStream> diagnosticsStream_;
+
+  // Time anchors (Options::timeAnchorInterval)
+  dlf_tick_t timeAnchorIntervalTicks_{0};
+  dlf_tick_t nextTimeAnchorTick_{0};
+  int64_t clockOffsetUs_{0};  // System clock minus monotonic timer
+  volatile dlf_time_source_e timeSource_{DLF_TIME_SOURCE_SYSTEM};
+  volatile bool timeSourceChanged_{false};
+  // Guards the external anchor below
+  SemaphoreHandle_t anchorMutex_{nullptr};
+  bool externalAnchorQueued_{false};
+  int64_t externalEpochUs_{0};
+  int64_t externalTimerUs_{0};  // Monotonic timer when it was taken
+  dlf_time_source_e externalSource_{DLF_TIME_SOURCE_SYSTEM};
 };
 
 /**
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <type_traits>
+
+/**
+ * Registers a struct so that it can be logged as one stream with poll() or
+ * watch(). Use it at namespace scope, in the namespace of the struct, after
+ * its definition:
+ *
+ *   struct GpsData {
+ *     double lat;
+ *     double lng;
+ *     double alt;
+ *     uint32_t satellites;
+ *   };
+ *   DLF_STRUCT(GpsData, lat, lng, alt, satellites)
+ *
+ * The type_structure string ("GpsData;lat:double:0;lng:double:8;...") is
+ * built at compile time, with offsets from offsetof. Fields may be integers,
+ * enums, bool, float or double, or fixed-size arrays of them; up to 16 can
+ * be listed. Fields left out are still stored, but readers skip them.
+ *
+ * Fixed-size arrays (T[N] and std::array<T, N>) of those types need no
+ * registration; their type_structure is "T[N]", e.g. "float[32]".
+ */
+#define DLF_STRUCT(Type, ...)                                                 \
+  inline const char* dlfTypeStructure(const Type*) {                          \
+    static_assert(std::is_trivially_copyable<Type>::value,                    \
+                  "DLF_STRUCT types are stored as raw bytes");                \
+    static constexpr ::dlf::detail::StructField fields[] = {                  \
+        DLF_STRUCT_FOR_EACH_(DLF_STRUCT_FIELD_, Type, __VA_ARGS__)};          \
+    static constexpr auto s =                                                 \
+        ::dlf::detail::buildTypeStructure<::dlf::detail::typeStructureLength( \
+            #Type, fields)>(#Type, fields);                                   \
+    return s.data();                                                          \
+  }
+
+#define DLF_STRUCT_FIELD_(Type, field)                                     \
+  ::dlf::detail::StructField{                                              \
+      #field,                                                              \
+      ::dlf::detail::fieldTypeName<decltype(static_cast<Type*>(nullptr)    \
+                                                ->field)>(),               \
+      offsetof(Type, field)},
+
+// DLF_STRUCT_FOR_EACH_(m, Type, a, b, ...) expands to m(Type, a) m(Type, b)...
+#define DLF_STRUCT_EXPAND_(x) x
+#define DLF_STRUCT_NTH_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, \
+                        _13, _14, _15, _16, N, ...)                        \
+  N
+#define DLF_STRUCT_FOR_EACH_(m, T, ...)                                      \
+  DLF_STRUCT_EXPAND_(DLF_STRUCT_NTH_(                                        \
+      __VA_ARGS__, DLF_STRUCT_16_, DLF_STRUCT_15_, DLF_STRUCT_14_,           \
+      DLF_STRUCT_13_, DLF_STRUCT_12_, DLF_STRUCT_11_, DLF_STRUCT_10_,        \
+      DLF_STRUCT_9_, DLF_STRUCT_8_, DLF_STRUCT_7_, DLF_STRUCT_6_,            \
+      DLF_STRUCT_5_, DLF_STRUCT_4_, DLF_STRUCT_3_, DLF_STRUCT_2_,            \
+      DLF_STRUCT_1_)(m, T, __VA_ARGS__))
+#define DLF_STRUCT_1_(m, T, x) m(T, x)
+#define DLF_STRUCT_2_(m, T, x, ...) m(T, x) DLF_STRUCT_1_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_3_(m, T, x, ...) m(T, x) DLF_STRUCT_2_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_4_(m, T, x, ...) m(T, x) DLF_STRUCT_3_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_5_(m, T, x, ...) m(T, x) DLF_STRUCT_4_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_6_(m, T, x, ...) m(T, x) DLF_STRUCT_5_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_7_(m, T, x, ...) m(T, x) DLF_STRUCT_6_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_8_(m, T, x, ...) m(T, x) DLF_STRUCT_7_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_9_(m, T, x, ...) m(T, x) DLF_STRUCT_8_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_10_(m, T, x, ...) m(T, x) DLF_STRUCT_9_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_11_(m, T, x, ...) m(T, x) DLF_STRUCT_10_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_12_(m, T, x, ...) m(T, x) DLF_STRUCT_11_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_13_(m, T, x, ...) m(T, x) DLF_STRUCT_12_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_14_(m, T, x, ...) m(T, x) DLF_STRUCT_13_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_15_(m, T, x, ...) m(T, x) DLF_STRUCT_14_(m, T, __VA_ARGS__)
+#define DLF_STRUCT_16_(m, T, x, ...) m(T, x) DLF_STRUCT_15_(m, T, __VA_ARGS__)
+
+namespace dlf {
+
+namespace detail {
+
+struct StructField {
+  const char* name;
+  const char* type;
+  size_t offset;
+};
+
+template <typename T>
+struct IsStdArray : std::false_type {};
+
+template <typename T, size_t N>
+struct IsStdArray<std::array<T, N>> : std::true_type {};
+
+template <typename T, size_t N>
+struct ArrayTypeName;
+
+template <typename T>
+constexpr const char* fieldTypeName();
+
+// Type names as used by the POLL/WATCH primitives. Integers are named by
+// size and signedness, since e.g. int and long are both 32 bits here.
+template <typename T>
+constexpr const char* fieldTypeName() {
+  using U = std::remove_cv_t<T>;
+  if constexpr (std::is_array<U>::value) {
+    return ArrayTypeName<std::remove_extent_t<U>,
+                         std::extent<U>::value>::value.data();
+  } else if constexpr (IsStdArray<U>::value) {
+    return ArrayTypeName<typename U::value_type,
+                         std::tuple_size<U>::value>::value.data();
+  } else if constexpr (std::is_enum<U>::value) {
+    return fieldTypeName<std::underlying_type_t<U>>();
+  } else if constexpr (std::is_same<U, bool>::value) {
+    return "bool";
+  } else if constexpr (std::is_same<U, float>::value) {
+    return "float";
+  } else if constexpr (std::is_same<U, double>::value) {
+    return "double";
+  } else {
+    static_assert(std::is_integral<U>::value && sizeof(U) <= 8,
+                  "DLF_STRUCT fields must be integers, enums, bool, float or "
+                  "double");
+    constexpr bool s = std::is_signed<U>::value;
+    switch (sizeof(U)) {
+      case 1:
+        return s ? "int8_t" : "uint8_t";
+      case 2:
+        return s ? "int16_t" : "uint16_t";
+      case 4:
+        return s ? "int32_t" : "uint32_t";
+      default:
+        return s ? "int64_t" : "uint64_t";
+    }
+  }
+}
+
+constexpr size_t strLength(const char* s) {
+  size_t n = 0;
+  while (s[n] != '\0') {
+    n++;
+  }
+  return n;
+}
+
+constexpr size_t decimalLength(size_t v) {
+  size_t n = 1;
+  while (v >= 10) {
+    v /= 10;
+    n++;
+  }
+  return n;
+}
+
+// Length of "Type;name:type:offset;..." without the terminator
+template <size_t N>
+constexpr size_t typeStructureLength(const char* type,
+                                     const StructField (&fields)[N]) {
+  size_t n = strLength(type);
+  for (size_t i = 0; i < N; i++) {
+    n += 1 + strLength(fields[i].name) + 1 + strLength(fields[i].type) + 1 +
+         decimalLength(fields[i].offset);
+  }
+  return n;
+}
+
+constexpr void putDecimal(char* out, size_t v, size_t digits) {
+  for (size_t d = digits; d > 0; d--) {
+    out[d - 1] = static_cast<char>('0' + v % 10);
+    v /= 10;
+  }
+}
+
+// "T[N]", for arrays of the types fieldTypeName() knows
+template <typename T, size_t N>
+struct ArrayTypeName {
+  static_assert(!std::is_array<T>::value && !IsStdArray<T>::value,
+                "Arrays of arrays are not supported");
+
+  static constexpr size_t length =
+      strLength(fieldTypeName<T>()) + 2 + decimalLength(N);
+
+  static constexpr std::array<char, length + 1> build() {
+    std::array<char, length + 1> out{};
+    const char* element = fieldTypeName<T>();
+    size_t pos = 0;
+    for (; element[pos] != '\0'; pos++) {
+      out[pos] = element[pos];
+    }
+    out[pos++] = '[';
+    putDecimal(&out[pos], N, decimalLength(N));
+    out[length - 1] = ']';
+    return out;
+  }
+
+  static constexpr std::array<char, length + 1> value = build();
+};
+
+template <size_t Len, size_t N>
+constexpr std::array<char, Len + 1> buildTypeStructure(
+    const char* type, const StructField (&fields)[N]) {
+  std::array<char, Len + 1> out{};
+  size_t pos = 0;
+  auto put = [&out, &pos](const char* s) {
+    for (size_t i = 0; s[i] != '\0'; i++) {
+      out[pos++] = s[i];
+    }
+  };
+  put(type);
+  for (size_t i = 0; i < N; i++) {
+    out[pos++] = ';';
+    put(fields[i].name);
+    out[pos++] = ':';
+    put(fields[i].type);
+    out[pos++] = ':';
+    const size_t digits = decimalLength(fields[i].offset);
+    putDecimal(&out[pos], fields[i].offset, digits);
+    pos += digits;
+  }
+  return out;
+}
+
+}  // namespace detail
+
+/**
+ * Whether T was registered with DLF_STRUCT.
+ */
+template <typename T, typename = void>
+struct IsDlfStruct : std::false_type {};
+
+template <typename T>
+struct IsDlfStruct<T, std::void_t<decltype(dlfTypeStructure(
+                          static_cast<const T*>(nullptr)))>>
+    : std::true_type {};
+
+/**
+ * Whether T is a fixed-size array (T[N] or std::array<T, N>) that can be
+ * logged as one stream.
+ */
+template <typename T>
+struct IsDlfArray
+    : std::bool_constant<std::is_array<T>::value ||
+                         detail::IsStdArray<std::remove_cv_t<T>>::value> {};
+
+/**
+ * Whether T can be passed to poll() and watch() as a struct or array.
+ */
+template <typename T>
+struct HasTypeStructure
+    : std::bool_constant<IsDlfStruct<T>::value || IsDlfArray<T>::value> {};
+
+/**
+ * The type_structure string of a DLF_STRUCT type.
+ */
+template <typename T>
+const char* structTypeStructure() {
+  return dlfTypeStructure(static_cast<const T*>(nullptr));
+}
+
+/**
+ * The type_structure string of a DLF_STRUCT type or fixed-size array.
+ */
+template <typename T>
+const char* typeStructureOf() {
+  if constexpr (IsDlfStruct<T>::value) {
+    return structTypeStructure<T>();
+  } else {
+    return detail::fieldTypeName<T>();
+  }
+}
+
+}  // namespace dlf
@@ -13,6 +13,7 @@ using dlf_stream_idx_t = uint16_t;
 
 enum dlf_file_state_e : int8_t {
   // Errors are (-)
+  WRITE_ERROR = -8,
   FILE_OPEN_ERROR = -7,
   SYNC_CREATE_ERROR = -6,
   STREAM_CREATE_ERROR = -5,
@@ -29,7 +30,10 @@ enum dlf_file_state_e : int8_t {
   CLOSED = 5,
 };
 
-enum dlf_stream_type_e : uint8_t { POLLED, EVENT };
+// RAW files (raw-<id>.dlf) hold one CaptureStream each and are laid out like
+// EVENT files, with a single "uint8_t[]" DLF_EVENT_STREAM_VARIABLE stream
+// whose records are chunks of captured bytes
+enum dlf_stream_type_e : uint8_t { POLLED, EVENT, RAW };
 
 /* Overall Header Definition (meta.dlf) */
 struct dlf_meta_header_t {
@@ -53,10 +57,111 @@ struct dlf_logfile_header_t {
   dlf_tick_t tick_span;  // Total number of ticks this file spans.
 
   uint16_t num_streams;
+  // Next: dlf_logfile_ext_header_t if stream_type has DLF_LOGFILE_EXTENDED
   // Next: Array of dlf_polled_stream_header_segment_t OR
   // dlf_event_stream_header_t
 } __attribute__((packed));
 
+// Set in dlf_logfile_header_t::stream_type when the file uses optional format
+// features. The low bits still hold the dlf_stream_type_e.
+#define DLF_LOGFILE_EXTENDED 0x80
+#define DLF_LOGFILE_STREAM_TYPE_MASK 0x7F
+
+// dlf_logfile_ext_header_t::flags
+// tick_span in the file header is not maintained. Progress is recorded by
+// dlf_checkpoint_t records appended to the data section instead.
+#define DLF_LOGFILE_FLAG_CHECKPOINTS (1u << 0)
+// Every polled stream header ends with a dlf_polled_stream_codec_segment_t.
+// Streams with a codec other than DLF_CODEC_RAW write their samples in
+// dlf_codec_block_header_t blocks instead of one raw value per sample.
+#define DLF_LOGFILE_FLAG_STREAM_CODECS (1u << 1)
+// Everything after the header is stored as dlf_frame_header_t frames, each
+// holding an LZ4-compressed slice of the data section. Offsets elsewhere in
+// the file (e.g. dlf_checkpoint_t::byte_offset) refer to the uncompressed
+// file, in which the data section directly follows the header.
+#define DLF_LOGFILE_FLAG_BLOCK_COMPRESSION (1u << 2)
+// Event records are grouped by tick instead of being written as
+// dlf_event_stream_sample_t records. Each group is:
+//   LEB128 varint  tick - tick of the previous group (the first: tick - 0)
+//   LEB128 varint  number of records
+//   per record:    LEB128 varint stream index, raw value (type_size bytes)
+// A group with 0 records is followed by a dlf_checkpoint_t or dlf_keyframe_t
+// for its tick instead.
+#define DLF_LOGFILE_FLAG_COMPACT_EVENTS (1u << 3)
+// The event data section contains dlf_keyframe_t records holding the value of
+// every stream.
+#define DLF_LOGFILE_FLAG_KEYFRAMES (1u << 4)
+// The polled data section is a sequence of dlf_column_block_header_t blocks,
+// each holding a range of ticks with every stream's samples stored
+// contiguously, instead of samples interleaved tick by tick.
+#define DLF_LOGFILE_FLAG_COLUMNAR (1u << 5)
+// Everything after the header is stored as dlf_frame_header_t frames, as with
+// DLF_LOGFILE_FLAG_BLOCK_COMPRESSION (without it, every frame is stored), and
+// each frame is followed by a uint32_t CRC-32 of its header and payload. A
+// reader that finds a corrupted frame skips to the next intact one, whose
+// raw_offset and first_tick say where its data belongs.
+#define DLF_LOGFILE_FLAG_BLOCK_CRC (1u << 6)
+// The event data section contains dlf_time_anchor_t records pairing ticks
+// with wall clock time.
+#define DLF_LOGFILE_FLAG_TIME_ANCHORS (1u << 7)
+// Every event stream header ends with a dlf_event_stream_segment_t. Records
+// of streams with DLF_EVENT_STREAM_VARIABLE hold a LEB128 varint length and
+// that many bytes (at most type_size) in place of a type_size value.
+#define DLF_LOGFILE_FLAG_VARIABLE_EVENTS (1u << 8)
+// Every polled stream header ends with a
+// dlf_polled_stream_validity_segment_t, after its codec segment
+// (DLF_LOGFILE_FLAG_STREAM_CODECS is always set as well). Streams with a
+// validity other than DLF_VALIDITY_NONE are written in blocks or columns like
+// coded streams, even with DLF_CODEC_RAW, whose payload starts with a bitmap
+// of which samples were valid.
+#define DLF_LOGFILE_FLAG_VALIDITY (1u << 9)
+// The file was written into a preallocated extent, so after an unclean
+// shutdown its length is that of the extent, and the bytes past the data are
+// stale. dlf_logfile_ext_header_t::written_bytes holds the length of the data
+// as of the last sync, and only that much of the file is valid.
+#define DLF_LOGFILE_FLAG_PREALLOCATED (1u << 10)
+// Streams written in blocks (not columns) close their open block early at
+// commits and checkpoints, so that those cover every sample up to their tick.
+// That tick's data is then followed by a dlf_block_cut_t and a partial block
+// of each such stream holding samples, in header order. Their sample count
+// starts over after it.
+#define DLF_LOGFILE_FLAG_BLOCK_CUTS (1u << 11)
+
+/* Extended Logfile Header (follows num_streams when DLF_LOGFILE_EXTENDED) */
+struct dlf_logfile_ext_header_t {
+  uint16_t ext_size = sizeof(dlf_logfile_ext_header_t);  // Readers skip
+                                                          // unknown fields
+  uint32_t flags = 0;
+  dlf_tick_t checkpoint_interval = 0;  // Ticks between periodic checkpoints
+  uint64_t written_bytes = 0;  // DLF_LOGFILE_FLAG_PREALLOCATED: synced length
+} __attribute__((packed));
+
+/*
+ * Type descriptors (type_structure, meta_structure):
+ *   "double"               A single primitive (stdint name, bool, float,
+ *                          double)
+ *   "Name;f:type:off;..."  A packed struct; each field is read at its byte
+ *                          offset, and bytes not covered by a field are
+ *                          skipped
+ *   "float[32]"            A fixed-size array: N values of the primitive
+ *                          back to back, N * sizeof(type) bytes. Same layout
+ *                          as "float[32];0:float:0;1:float:4;...", so
+ *                          readers without array support can expand it
+ *   "char[]", "uint8_t[]"  A variable-length message of text or bytes, at
+ *                          most type_size of them (DLF_EVENT_STREAM_VARIABLE)
+ *   "!..."                 Opaque, no parser
+ * A struct field type may itself be an array ("samples:int16_t[8]:4"). A
+ * field of type "bit" is a single bit, whose offset counts bits rather than
+ * bytes, of the value read as a little-endian integer of type_size bytes.
+ * Flag groups are described as "Flags;values:uint32_t:0;pump:bit:0;...",
+ * and as event streams as
+ * "Flags;changed:uint32_t:0;values:uint32_t:4;pump:bit:32;...".
+ * A struct field may end with a scale and an offset
+ * ("value:int32_t:0:1e-07:0"), in which case the stored integer is a count
+ * and the value it stands for is count * scale + offset. Quantized streams
+ * are described as "Quantized;value:int32_t:0:<scale>:<offset>".
+ */
+
 /* Stream Header Definitions (polled.dlf, event.dlf) */
 struct dlf_stream_header_t {
   const char* type_structure;  // das
@@ -72,6 +177,80 @@ struct dlf_polled_stream_header_segment_t {
   dlf_tick_t tick_phase;     // Tick offset defining when this stream starts
 } __attribute__((packed));
 
+/* Polled Stream Codecs (DLF_LOGFILE_FLAG_STREAM_CODECS) */
+enum dlf_codec_e : uint8_t {
+  DLF_CODEC_RAW = 0,  // One raw value per sample, as without codecs
+  // First value raw, then the difference to the previous value as a zigzag
+  // LEB128 varint. Integers of 1, 2, 4 or 8 bytes; wraps like the type does.
+  DLF_CODEC_DELTA_VARINT = 1,
+  // (LEB128 varint run length, raw value) pairs
+  DLF_CODEC_RLE = 2,
+  // Gorilla-style XOR with the previous value, for 4 or 8 byte values (float,
+  // double). The codes form a bit stream, most significant bit first,
+  // zero-padded to a whole byte.
+  // First value raw, then per value, with x = value ^ previous:
+  //     '0'                   x == 0
+  //     '10' + bits           x fits the previous leading/trailing zero
+  //                           window; bits are x without those zeros
+  //     '11' + 5 bit leading zeros (capped at 31) + 6 bit length - 1 + bits
+  DLF_CODEC_XOR = 3,
+};
+
+struct dlf_polled_stream_codec_segment_t {
+  uint8_t codec;           // dlf_codec_e
+  uint16_t block_samples;  // Samples per block. Unused for DLF_CODEC_RAW
+                           // without validity.
+} __attribute__((packed));
+
+/* Polled Stream Validity (DLF_LOGFILE_FLAG_VALIDITY) */
+// A block's (or column's) payload is a bitmap of ceil(samples / 8) bytes, in
+// which bit i % 8 of byte i / 8 is set if sample i was valid, followed by the
+// codec payload of the stored samples.
+enum dlf_validity_e : uint8_t {
+  DLF_VALIDITY_NONE = 0,  // Every sample is valid. No bitmap.
+  DLF_VALIDITY_ZERO = 1,  // Every sample is stored, invalid ones as zeros
+  DLF_VALIDITY_OMIT = 2,  // Only valid samples are stored
+};
+
+struct dlf_polled_stream_validity_segment_t {
+  uint8_t validity;  // dlf_validity_e
+} __attribute__((packed));
+
+// A coded stream writes nothing on its sample ticks until a block is full. On
+// the tick of the block's last sample, the block is written in the stream's
+// place. Blocks are independent, so decoding can start at any block. On
+// close, partially filled blocks follow the last tick's data in stream order.
+struct dlf_codec_block_header_t {
+  uint16_t sample_count;  // Including invalid samples
+  uint16_t payload_bytes;  // Encoded bytes following this header
+  // Next: payload
+} __attribute__((packed));
+
+/* Columnar Polled Block (DLF_LOGFILE_FLAG_COLUMNAR) */
+// Blocks cover consecutive tick ranges. Within a block, each stream has one
+// column with its samples due in [first_tick, first_tick + tick_count), in
+// header order. A raw stream's column is its samples back to back; a coded
+// stream's column is one codec payload of those samples. The number of
+// samples in a column follows from the stream's schedule.
+struct dlf_column_block_header_t {
+  dlf_tick_t first_tick;
+  uint32_t tick_count;
+  // Next: uint32_t column_bytes[num_streams]
+  // Next: the columns
+} __attribute__((packed));
+
+/* Event Stream Segment (DLF_LOGFILE_FLAG_VARIABLE_EVENTS) */
+// dlf_event_stream_segment_t::flags
+// Values are variable-length messages, such as strings or received
+// sentences. Unlike other streams, such a stream may have several records on
+// one tick, back to back, also within a compact group. Its value in a
+// keyframe is an empty message (a single 0 length byte).
+#define DLF_EVENT_STREAM_VARIABLE (1u << 0)
+
+struct dlf_event_stream_segment_t {
+  uint8_t flags;
+} __attribute__((packed));
+
 /* Event Stream Sample Definitions */
 struct dlf_event_stream_sample_t {
   dlf_stream_idx_t stream;
@@ -79,4 +258,179 @@ struct dlf_event_stream_sample_t {
   // Next: raw data
 } __attribute__((packed));
 
+/* Checkpoint Record Definition (DLF_LOGFILE_FLAG_CHECKPOINTS) */
+// Stream index reserved for checkpoints. In event files a checkpoint is laid
+// out like an event record of this stream with an 8 byte payload. In polled
+// files one may follow the data of any tick.
+#define DLF_CHECKPOINT_STREAM_IDX 0xFFFF
+
+struct dlf_checkpoint_t {
+  dlf_stream_idx_t marker = DLF_CHECKPOINT_STREAM_IDX;
+  dlf_tick_t tick_span;  // Same meaning as the header field, at this point
+  uint64_t byte_offset;  // File offset of this record. Lets readers tell a
+                         // real checkpoint from sample bytes.
+} __attribute__((packed));
+
+/* Block Cut Record Definition (DLF_LOGFILE_FLAG_BLOCK_CUTS) */
+// Stream index reserved for block cuts. Like a checkpoint, a cut may follow
+// the data of any polled tick.
+#define DLF_BLOCK_CUT_STREAM_IDX 0xFFFC
+
+struct dlf_block_cut_t {
+  dlf_stream_idx_t marker = DLF_BLOCK_CUT_STREAM_IDX;
+  dlf_tick_t tick;       // Last tick whose samples the partial blocks hold
+  uint64_t byte_offset;  // File offset of this record, as in checkpoints
+  // Next: the partial blocks
+} __attribute__((packed));
+
+/* Keyframe Record Definition (DLF_LOGFILE_FLAG_KEYFRAMES) */
+// Stream index reserved for keyframes. Like a checkpoint, a keyframe is laid
+// out like an event record of this stream. In compact event files it follows
+// an empty group, as checkpoints do.
+#define DLF_KEYFRAME_STREAM_IDX 0xFFFE
+
+// Holds the value of every event stream at `tick`, so decoding can start here
+// instead of at the beginning of the file. A keyframe replaces the change
+// records of its tick: changes at that tick are only in the keyframe.
+struct dlf_keyframe_t {
+  dlf_stream_idx_t marker = DLF_KEYFRAME_STREAM_IDX;
+  dlf_tick_t tick;
+  uint64_t byte_offset;  // File offset of this record, as in checkpoints
+  // Next: the raw value of each stream, in header order
+} __attribute__((packed));
+
+/* Time Anchor Record Definition (DLF_LOGFILE_FLAG_TIME_ANCHORS) */
+// Stream index reserved for time anchors. Laid out like a keyframe, and in
+// compact event files it also follows an empty group.
+#define DLF_TIME_ANCHOR_STREAM_IDX 0xFFFD
+
+// Where the time of a dlf_time_anchor_t came from
+enum dlf_time_source_e : uint8_t {
+  DLF_TIME_SOURCE_SYSTEM = 0,  // System clock, set from an unknown source
+  DLF_TIME_SOURCE_GPS = 1,
+  DLF_TIME_SOURCE_NTP = 2,
+  DLF_TIME_SOURCE_RTC = 3,
+};
+
+// Wall clock time at the start of `tick`. Ticks are counted by the ESP32's
+// crystal, which drifts, so readers should convert ticks to time by
+// interpolating between anchors rather than from epoch_time_s alone.
+struct dlf_time_anchor_t {
+  dlf_stream_idx_t marker = DLF_TIME_ANCHOR_STREAM_IDX;
+  dlf_tick_t tick;
+  uint64_t byte_offset;  // File offset of this record, as in checkpoints
+  int64_t epoch_us;      // Microseconds since the Unix epoch
+  dlf_time_source_e source;
+} __attribute__((packed));
+
+/* Compressed Data Frame (DLF_LOGFILE_FLAG_BLOCK_COMPRESSION) */
+// dlf_frame_header_t::flags
+// Payload is stored as is, because it did not compress
+#define DLF_FRAME_FLAG_STORED (1u << 0)
+// Frame starts partway through the data of first_tick, so decoding must start
+// at an earlier frame
+#define DLF_FRAME_FLAG_CONTINUED (1u << 1)
+// Frame ends partway through a tick; the next frame continues it
+#define DLF_FRAME_FLAG_SPLIT (1u << 2)
+
+// Frame headers are back to back with their payloads, so they double as the
+// file's block index: a reader seeks by tick by hopping from header to header
+// without decompressing anything.
+struct dlf_frame_header_t {
+  uint8_t flags;
+  uint16_t stored_bytes;  // Payload bytes following this header
+  uint16_t raw_bytes;     // Payload bytes once decompressed
+  dlf_tick_t first_tick;  // No data in the frame is from an earlier tick
+  uint64_t raw_offset;    // Offset of the frame's data in the uncompressed
+                          // file
+  // Next: payload, an LZ4 block (see dlf::format::lz4), then the CRC-32 with
+  // DLF_LOGFILE_FLAG_BLOCK_CRC
+} __attribute__((packed));
+
+/* Event Seek Index (event.idx, see Run::Options::eventIndexInterval) */
+// A sidecar file next to event.dlf: one dlf_event_index_header_t, then
+// dlf_event_index_entry_t records appended in tick and offset order. Entries
+// are sparse, roughly one per index_interval ticks with events. The file is
+// only ever appended to, so a torn last entry is dropped by readers.
+#define DLF_EVENT_INDEX_MAGIC 0x8415
+
+struct dlf_event_index_header_t {
+  uint16_t magic = DLF_EVENT_INDEX_MAGIC;
+  dlf_tick_t index_interval;  // Ticks between entries, at least
+} __attribute__((packed));
+
+struct dlf_event_index_entry_t {
+  dlf_tick_t tick;       // Tick of the record (or compact group) at
+                         // byte_offset. No earlier records follow it.
+  uint64_t byte_offset;  // Offset in event.dlf, uncompressed if the file is
+                         // compressed
+} __attribute__((packed));
+
+/* Run Container (run.dlf, see Run::Options::container) */
+// A whole run in one file: a dlf_run_container_header_t, then sections
+// appended in the order they reach the card. Each section is a
+// dlf_section_header_t and `length` bytes of one logical file (meta.dlf,
+// polled.dlf, ...), which is the concatenation of all sections with its tag.
+// The header takes the place of the LOCK and UPLOADED marker files and of the
+// upload progress file.
+#define DLF_RUN_CONTAINER_MAGIC 0x8416
+
+enum dlf_run_state_e : uint8_t {
+  DLF_RUN_OPEN = 0,      // Being written, or left open by a shutdown (LOCK)
+  DLF_RUN_CLOSED = 1,    // Complete and not uploaded yet
+  DLF_RUN_UPLOADED = 2,  // Uploaded (UPLOADED)
+};
+
+struct dlf_run_container_header_t {
+  uint16_t magic = DLF_RUN_CONTAINER_MAGIC;
+  uint16_t header_size = sizeof(dlf_run_container_header_t);  // Sections
+                                                               // start here
+  dlf_run_state_e state = DLF_RUN_OPEN;
+  uint32_t upload_next_chunk = 1;   // Chunked upload progress of run.dlf
+  uint32_t upload_next_offset = 0;  // (as in .uploadprog)
+} __attribute__((packed));
+
+enum dlf_section_tag_e : uint8_t {
+  DLF_SECTION_META = 1,         // meta.dlf
+  DLF_SECTION_POLLED = 2,       // polled.dlf
+  DLF_SECTION_EVENT = 3,        // event.dlf
+  DLF_SECTION_EVENT_INDEX = 4,  // event.idx
+  DLF_SECTION_COMMIT = 5,       // One dlf_container_commit_t
+};
+#define DLF_SECTION_TAG_COUNT 6
+
+struct dlf_section_header_t {
+  dlf_section_tag_e tag;  // Never 0. Readers skip tags they do not know.
+  uint32_t length;
+} __attribute__((packed));
+
+// Appended on every Run::commit(), on close and by recovery. Bytes of
+// polled.dlf and event.dlf past the lengths in the last commit are from
+// after its tick and may end in a torn record, so readers cut them off.
+struct dlf_container_commit_t {
+  dlf_tick_t tick;  // Last tick covered, in place of tick_span
+  uint64_t polled_bytes;
+  uint64_t event_bytes;
+} __attribute__((packed));
+
+/* Internal diagnostics stream (see Run::Options::diagnosticsInterval) */
+#define DLF_DIAGNOSTICS_STREAM_ID "dlf.diagnostics"
+#define DLF_DIAGNOSTICS_TYPE_STRUCTURE                                 \
+  "RunDiagnostics;"                                                    \
+  "polled_buffer_hwm:uint32_t:0;polled_bytes_per_s:uint32_t:4;"        \
+  "polled_write_max_us:uint32_t:8;polled_commit_max_us:uint32_t:12;"   \
+  "event_buffer_hwm:uint32_t:16;event_bytes_per_s:uint32_t:20;"        \
+  "event_write_max_us:uint32_t:24;event_commit_max_us:uint32_t:28"
+
+struct dlf_run_diagnostics_t {
+  uint32_t polled_buffer_hwm;     // Peak bytes buffered, polled.dlf
+  uint32_t polled_bytes_per_s;    // Write throughput, polled.dlf
+  uint32_t polled_write_max_us;   // Slowest write so far, polled.dlf
+  uint32_t polled_commit_max_us;  // Slowest flush/sync so far, polled.dlf
+  uint32_t event_buffer_hwm;
+  uint32_t event_bytes_per_s;
+  uint32_t event_write_max_us;
+  uint32_t event_commit_max_us;
+} __attribute__((packed));
+
 }  // namespace dlf
\ No newline at end of file
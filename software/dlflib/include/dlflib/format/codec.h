@@ -0,0 +1,153 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "dlflib/dlf_types.h"
+
+namespace dlf::format {
+
+/**
+ * Block codecs for polled streams (DLF_LOGFILE_FLAG_STREAM_CODECS). Values are
+ * treated as little-endian integers of the stream's type_size. Every block
+ * starts over from a raw value, so each block is a decoding reset point.
+ */
+
+/**
+ * Whether `codec` can encode values of `typeSize` bytes.
+ */
+bool codecSupports(dlf_codec_e codec, size_t typeSize);
+
+/**
+ * Bytes of the validity bitmap of a block of `samples` samples
+ * (DLF_LOGFILE_FLAG_VALIDITY).
+ */
+inline size_t validityBitmapBytes(size_t samples) { return (samples + 7) / 8; }
+
+/**
+ * Worst-case payload size of a block of `blockSamples` values, including the
+ * validity bitmap unless `validity` is DLF_VALIDITY_NONE.
+ */
+size_t maxBlockBytes(dlf_codec_e codec, size_t typeSize, size_t blockSamples,
+                     dlf_validity_e validity = DLF_VALIDITY_NONE);
+
+/**
+ * Largest block size whose worst-case payload fits in `maxBytes`, which is
+ * itself capped to what dlf_codec_block_header_t::payload_bytes can hold.
+ */
+size_t maxBlockSamples(dlf_codec_e codec, size_t typeSize,
+                       size_t maxBytes = UINT16_MAX,
+                       dlf_validity_e validity = DLF_VALIDITY_NONE);
+
+/**
+ * Appends `v` to `out` as an unsigned LEB128 varint.
+ * @return Number of bytes written (at most 10)
+ */
+size_t putVarint(uint8_t* out, uint64_t v);
+
+/**
+ * Number of bytes putVarint() writes for `v`.
+ */
+inline size_t varintSize(uint64_t v) {
+  size_t n = 1;
+  while (v >= 0x80) {
+    v >>= 7;
+    n++;
+  }
+  return n;
+}
+
+/**
+ * Reads an unsigned LEB128 varint from `in`.
+ * @return Number of bytes consumed, or 0 if it is truncated or too long
+ */
+size_t getVarint(const uint8_t* in, size_t len, uint64_t& v);
+
+inline uint64_t zigzag(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t unzigzag(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+/**
+ * Incrementally encodes one block at a time. add() does a constant amount of
+ * work per sample, so it is safe to call from the sampler. The output buffer
+ * is allocated once, at construction.
+ *
+ * Unless `validity` is DLF_VALIDITY_NONE, the payload starts with the
+ * validity bitmap, and invalid samples are stored as `validity` says.
+ */
+class BlockEncoder {
+ public:
+  BlockEncoder(dlf_codec_e codec, size_t typeSize, size_t blockSamples,
+               dlf_validity_e validity = DLF_VALIDITY_NONE);
+
+  void add(const uint8_t* value, bool valid = true);
+
+  /**
+   * Samples in the current block, including invalid ones.
+   */
+  size_t count() const { return count_; }
+
+  bool full() const { return count_ >= blockSamples_; }
+
+  /**
+   * Completes the current block.
+   * @param payloadBytes Set to the length of the returned payload
+   * @return The payload, valid until the next add() or reset()
+   */
+  const uint8_t* finish(size_t& payloadBytes);
+
+  /**
+   * Starts a new, empty block.
+   */
+  void reset();
+
+ private:
+  void flushRun();
+  void addXor(const uint8_t* value);
+  void putBits(uint64_t v, unsigned n);
+
+  dlf_codec_e codec_;
+  size_t typeSize_;
+  size_t blockSamples_;
+  dlf_validity_e validity_;
+  // Room reserved at the start of out_ for the bitmap of a full block. The
+  // payload follows it, and finish() moves the bitmap up against it.
+  size_t bitmapBytes_;
+  std::vector<uint8_t> out_;
+  size_t len_ = 0;
+  size_t count_ = 0;
+  size_t stored_ = 0;          // Samples in the payload
+  std::vector<uint8_t> zero_;  // DLF_VALIDITY_ZERO: stored when invalid
+  uint64_t prev_ = 0;             // Delta: previous value
+  std::vector<uint8_t> runValue_;  // RLE: value of the open run
+  size_t runLength_ = 0;
+  unsigned bitCount_ = 0;  // XOR: bits used in out_[len_]
+  unsigned leading_ = 0;   // XOR: zero window of the last stored bits
+  unsigned trailing_ = 0;
+  bool haveWindow_ = false;
+};
+
+/**
+ * Decodes one block payload into `sampleCount` raw values written back to back
+ * to `out`.
+ * @return false if the payload is malformed or does not hold exactly
+ * `sampleCount` values
+ */
+bool decodeBlock(dlf_codec_e codec, size_t typeSize, const uint8_t* payload,
+                 size_t payloadBytes, size_t sampleCount, uint8_t* out);
+
+/**
+ * decodeBlock() for a block starting with a validity bitmap. Every sample is
+ * written to `out` in its place, with invalid ones as zeros; the bitmap is
+ * the first validityBitmapBytes(sampleCount) bytes of `payload`.
+ */
+bool decodeBlock(dlf_codec_e codec, size_t typeSize, dlf_validity_e validity,
+                 const uint8_t* payload, size_t payloadBytes,
+                 size_t sampleCount, uint8_t* out);
+
+}  // namespace dlf::format
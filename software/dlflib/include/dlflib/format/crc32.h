@@ -0,0 +1,17 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace dlf::format {
+
+/**
+ * CRC-32 (IEEE 802.3, as in zlib and PNG) of `len` bytes, continuing from the
+ * CRC of the bytes before them. Pass 0 for the first chunk.
+ *
+ * On the ESP32 this is the ROM routine, which runs from ROM with its own
+ * table, so checking a 4 KiB frame costs the flusher a few tens of
+ * microseconds. Elsewhere it is a 256-entry table implementation.
+ */
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0);
+
+}  // namespace dlf::format
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "dlflib/dlf_types.h"
+
+namespace dlf::format {
+
+/**
+ * Reader for the sparse tick -> offset index written next to event.dlf
+ * (event.idx). Looking up a tick is a binary search over the entries; the
+ * reader then walks event.dlf forward from the returned offset.
+ */
+class EventIndex {
+ public:
+  /**
+   * Parses an event.idx image. A torn last entry, and anything after an entry
+   * that is out of order, is dropped.
+   * @param dataLength Valid length of the (uncompressed) event.dlf. Entries
+   * at or past it point at data that never made it to the card.
+   * @return false if `data` is not an event index
+   */
+  bool parse(const uint8_t* data, size_t len, size_t dataLength = SIZE_MAX);
+
+  dlf_tick_t interval() const { return interval_; }
+
+  const std::vector<dlf_event_index_entry_t>& entries() const {
+    return entries_;
+  }
+
+  /**
+   * Finds where to start reading to see every record from `tick` on: the
+   * last entry at or before `tick`.
+   * @return false if `tick` is before the first entry, in which case reading
+   * starts at the beginning of the data section
+   */
+  bool seek(dlf_tick_t tick, dlf_event_index_entry_t& out) const;
+
+ private:
+  dlf_tick_t interval_ = 0;
+  std::vector<dlf_event_index_entry_t> entries_;
+};
+
+}  // namespace dlf::format
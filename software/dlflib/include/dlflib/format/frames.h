@@ -0,0 +1,141 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "dlflib/dlf_types.h"
+#include "dlflib/format/lz4.h"
+#include "dlflib/format/recovery.h"
+
+namespace dlf::format {
+
+/**
+ * Largest encoded frame (header and payload) for `rawLen` bytes of data.
+ * Incompressible data is stored as is, so this is only the header's worth
+ * more than the data.
+ */
+constexpr size_t maxFrameBytes(size_t rawLen) {
+  return sizeof(dlf_frame_header_t) + rawLen;
+}
+
+/**
+ * Encodes one frame into `out`, which must hold maxFrameBytes(rawLen) bytes.
+ * The payload is LZ4-compressed when that makes it smaller, and stored
+ * otherwise.
+ * @return Size of the frame
+ */
+size_t encodeFrame(Lz4Compressor& compressor, const uint8_t* raw,
+                   size_t rawLen, dlf_tick_t firstTick, uint64_t rawOffset,
+                   uint8_t flags, uint8_t* out);
+
+/**
+ * Encodes `rawLen` bytes as a stored (uncompressed) frame, e.g. to append a
+ * record to a compressed file without a compressor at hand.
+ */
+size_t encodeStoredFrame(const uint8_t* raw, size_t rawLen,
+                         dlf_tick_t firstTick, uint64_t rawOffset,
+                         uint8_t flags, uint8_t* out);
+
+/**
+ * Bytes that follow each frame's payload with DLF_LOGFILE_FLAG_BLOCK_CRC.
+ */
+constexpr size_t FRAME_CRC_BYTES = sizeof(uint32_t);
+
+/**
+ * Appends the CRC-32 of the `frameLen`-byte frame at `frame` right after it
+ * (DLF_LOGFILE_FLAG_BLOCK_CRC). The buffer must have room for
+ * FRAME_CRC_BYTES more.
+ * @return Size of the frame including the CRC
+ */
+size_t appendFrameCrc(uint8_t* frame, size_t frameLen);
+
+/**
+ * Uncompressed view of a framed file (LogfileInfo::framed()), so that
+ * everything that reads logfiles through a ByteSource (e.g. RecoveryScanner)
+ * works on compressed files unchanged.
+ *
+ * The constructor walks the frame headers once. The view ends at the last
+ * frame that is complete and ends on a tick boundary, so a frame torn by a
+ * power loss, and any split tick before it, are left out. One frame at a time
+ * is kept decompressed.
+ *
+ * With block CRCs, a corrupted frame no longer ends the view. The walk skips
+ * ahead to the next frame whose CRC checks out, and the bytes in between
+ * become a damaged frame, so later data keeps its offsets. Payload CRCs are
+ * checked as frames are read: reads stop short at a damaged frame, and
+ * resumeOffset() says where to pick up.
+ */
+class FrameByteSource : public ByteSource {
+ public:
+  struct Frame {
+    uint32_t fileOffset;  // Offset of the frame header in the file
+    uint32_t rawOffset;
+    uint32_t storedBytes;  // Damaged: file bytes up to the next frame
+    uint32_t rawBytes;
+    uint8_t flags;
+    dlf_tick_t firstTick;
+    bool damaged;
+  };
+
+  /**
+   * @param dataOffset Where the header ends and the first frame starts
+   * @param checked Whether frames carry CRCs (LogfileInfo::blockCrc())
+   */
+  FrameByteSource(ByteSource& file, size_t dataOffset, bool checked = false);
+
+  size_t size() override { return size_; }
+
+  size_t read(size_t offset, uint8_t* dst, size_t len) override;
+
+  /**
+   * Length of the file up to the end of the frames in this view. Truncating
+   * the file to this drops what the view leaves out.
+   */
+  size_t fileLength() const { return fileLength_; }
+
+  const std::vector<Frame>& frames() const { return frames_; }
+
+  /**
+   * Index of the frame to start decoding at to reach the data of `tick`: the
+   * last frame that starts on a tick boundary at or before it.
+   * @return frames().size() if there are no frames
+   */
+  size_t frameForTick(dlf_tick_t tick) const;
+
+  /**
+   * Where reading can go on after damaged data at `offset`: the start of the
+   * next frame after it that begins on a tick boundary.
+   * @return size() if there is none
+   */
+  size_t resumeOffset(size_t offset) const;
+
+  /**
+   * Number of frames found to be damaged so far.
+   */
+  size_t damagedFrames() const;
+
+ private:
+  bool load(size_t index);
+  // Whether a plausible frame header for this file is at `pos`
+  bool headerAt(size_t pos, dlf_frame_header_t& h);
+  // Reads the frame at `fileOffset` into stored_ and checks its CRC
+  bool readFrame(size_t fileOffset, size_t storedBytes);
+  // Finds the first intact frame at or after `from` that starts past
+  // `rawOffset`
+  bool findFrame(size_t from, uint64_t rawOffset, size_t& pos,
+                 dlf_frame_header_t& h);
+
+  ByteSource& file_;
+  size_t dataOffset_;
+  bool checked_;
+  size_t fileSize_;
+  size_t size_;
+  size_t fileLength_;
+  std::vector<Frame> frames_;
+  std::vector<uint8_t> stored_;  // Header and payload of the loaded frame
+  std::vector<uint8_t> raw_;
+  size_t loaded_ = SIZE_MAX;
+};
+
+}  // namespace dlf::format
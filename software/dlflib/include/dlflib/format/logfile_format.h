@@ -0,0 +1,178 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "dlflib/dlf_types.h"
+
+namespace dlf::format {
+
+/**
+ * Parsing helpers for polled.dlf / event.dlf contents held in memory. Used by
+ * on-device recovery and host tools; they never allocate beyond the returned
+ * stream list and never read past `len`.
+ */
+
+struct LogfileStreamInfo {
+  uint32_t typeSize = 0;
+  dlf_tick_t tickInterval = 0;  // Polled only
+  dlf_tick_t tickPhase = 0;     // Polled only
+  dlf_codec_e codec = DLF_CODEC_RAW;  // Polled only
+  uint16_t blockSamples = 0;          // Polled only
+  dlf_validity_e validity = DLF_VALIDITY_NONE;  // Polled only
+  // Event only: records hold messages of up to typeSize bytes
+  // (DLF_EVENT_STREAM_VARIABLE)
+  bool variable = false;
+
+  /**
+   * Whether the stream writes blocks (or, in columnar files, columns of
+   * unknown length): a codec other than DLF_CODEC_RAW or a validity bitmap.
+   */
+  bool blocked() const {
+    return codec != DLF_CODEC_RAW || validity != DLF_VALIDITY_NONE;
+  }
+};
+
+struct LogfileInfo {
+  dlf_stream_type_e streamType = POLLED;
+  dlf_tick_t tickSpan = 0;
+  bool extended = false;
+  dlf_logfile_ext_header_t ext;
+  std::vector<LogfileStreamInfo> streams;
+  // Offset of the first byte after the stream headers
+  size_t dataOffset = 0;
+
+  /**
+   * Whether any polled stream writes blocks, in which case data offsets can no
+   * longer be computed from the header alone.
+   */
+  bool hasCodedStreams() const {
+    for (const auto& s : streams) {
+      if (s.blocked()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Whether the data section is stored as compressed frames.
+   */
+  bool compressed() const {
+    return (ext.flags & DLF_LOGFILE_FLAG_BLOCK_COMPRESSION) != 0;
+  }
+
+  /**
+   * Whether every frame carries a CRC-32 (DLF_LOGFILE_FLAG_BLOCK_CRC).
+   */
+  bool blockCrc() const {
+    return (ext.flags & DLF_LOGFILE_FLAG_BLOCK_CRC) != 0;
+  }
+
+  /**
+   * Whether the data section is stored as dlf_frame_header_t frames, which
+   * is the case with either block compression or block CRCs.
+   */
+  bool framed() const { return compressed() || blockCrc(); }
+
+  /**
+   * Whether event records are grouped by tick
+   * (DLF_LOGFILE_FLAG_COMPACT_EVENTS).
+   */
+  bool compactEvents() const {
+    return (ext.flags & DLF_LOGFILE_FLAG_COMPACT_EVENTS) != 0;
+  }
+
+  /**
+   * Whether polled data is stored in column blocks
+   * (DLF_LOGFILE_FLAG_COLUMNAR).
+   */
+  bool columnar() const {
+    return (ext.flags & DLF_LOGFILE_FLAG_COLUMNAR) != 0;
+  }
+
+  /**
+   * Whether blocks may be cut short at commits and checkpoints
+   * (DLF_LOGFILE_FLAG_BLOCK_CUTS).
+   */
+  bool blockCuts() const {
+    return (ext.flags & DLF_LOGFILE_FLAG_BLOCK_CUTS) != 0;
+  }
+
+  /**
+   * Whether the event data contains keyframes (DLF_LOGFILE_FLAG_KEYFRAMES).
+   */
+  bool keyframes() const {
+    return (ext.flags & DLF_LOGFILE_FLAG_KEYFRAMES) != 0;
+  }
+
+  /**
+   * Whether the event data contains time anchors
+   * (DLF_LOGFILE_FLAG_TIME_ANCHORS).
+   */
+  bool timeAnchors() const {
+    return (ext.flags & DLF_LOGFILE_FLAG_TIME_ANCHORS) != 0;
+  }
+
+  /**
+   * Whether any event stream holds variable-length messages
+   * (DLF_LOGFILE_FLAG_VARIABLE_EVENTS).
+   */
+  bool hasVariableStreams() const {
+    for (const auto& s : streams) {
+      if (s.variable) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Length of the file that holds data, for a file of `fileSize` bytes. Less
+   * than the file size for a preallocated file (DLF_LOGFILE_FLAG_PREALLOCATED)
+   * that was not closed.
+   */
+  size_t writtenLength(size_t fileSize) const {
+    if ((ext.flags & DLF_LOGFILE_FLAG_PREALLOCATED) == 0 ||
+        ext.written_bytes >= fileSize) {
+      return fileSize;
+    }
+    return static_cast<size_t>(ext.written_bytes);
+  }
+
+  /**
+   * Size of a dlf_keyframe_t record including the stream values.
+   */
+  size_t keyframeBytes() const {
+    size_t bytes = sizeof(dlf_keyframe_t);
+    for (const auto& s : streams) {
+      // Message streams hold an empty message
+      bytes += s.variable ? 1 : s.typeSize;
+    }
+    return bytes;
+  }
+};
+
+/**
+ * Parses the file header and all stream headers.
+ * @return false if the header is truncated or not a DLF logfile.
+ */
+bool parseLogfileHeader(const uint8_t* data, size_t len, LogfileInfo& out);
+
+/**
+ * Whether a valid dlf_checkpoint_t starts at `pos`, i.e. it carries the marker
+ * and its byte_offset equals `pos`.
+ */
+bool checkpointAt(const uint8_t* data, size_t len, size_t pos,
+                  dlf_checkpoint_t* out = nullptr);
+
+/**
+ * Scans backward from the end of `data` for the last valid checkpoint at or
+ * after `dataOffset`.
+ * @param pos Set to the checkpoint's file offset.
+ */
+bool findLastCheckpoint(const uint8_t* data, size_t len, size_t dataOffset,
+                        dlf_checkpoint_t& out, size_t& pos);
+
+}  // namespace dlf::format
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace dlf::format {
+
+/**
+ * Compressor for the LZ4 block format, as used by the payloads of
+ * dlf_frame_header_t frames. The output can be read by any LZ4 block
+ * decompressor (e.g. LZ4_decompress_safe). Inputs are limited to 64 KiB, the
+ * most a frame can hold.
+ *
+ * This is the greedy single-probe matcher from the reference implementation,
+ * without acceleration. The hash table is the only state, so an instance costs
+ * a fixed 8 KiB and compress() never allocates.
+ */
+class Lz4Compressor {
+ public:
+  /**
+   * Compresses `len` bytes from `src` into `dst`.
+   * @return Compressed size, or 0 if it would exceed `dstCapacity` or `len` is
+   * too large
+   */
+  size_t compress(const uint8_t* src, size_t len, uint8_t* dst,
+                  size_t dstCapacity);
+
+ private:
+  static constexpr unsigned HASH_LOG = 12;
+  uint16_t table_[1u << HASH_LOG];
+};
+
+/**
+ * Worst-case compressed size of `len` bytes.
+ */
+inline size_t lz4CompressBound(size_t len) { return len + len / 255 + 16; }
+
+/**
+ * Decompresses an LZ4 block.
+ * @return true only if the block is well formed and decompresses to exactly
+ * `dstLen` bytes
+ */
+bool lz4Decompress(const uint8_t* src, size_t len, uint8_t* dst,
+                   size_t dstLen);
+
+}  // namespace dlf::format
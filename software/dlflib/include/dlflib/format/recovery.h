@@ -0,0 +1,174 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "dlflib/format/logfile_format.h"
+
+namespace dlf::format {
+
+/**
+ * Random-access view of a file's bytes, so that recovery can run over
+ * fs::File on the device and over memory in tests.
+ */
+class ByteSource {
+ public:
+  virtual ~ByteSource() = default;
+
+  virtual size_t size() = 0;
+
+  /**
+   * @return Number of bytes copied into `dst`. Short only at end of file or on
+   * a read error.
+   */
+  virtual size_t read(size_t offset, uint8_t* dst, size_t len) = 0;
+};
+
+class MemoryByteSource : public ByteSource {
+ public:
+  MemoryByteSource(const uint8_t* data, size_t len) : data_(data), len_(len) {}
+
+  size_t size() override { return len_; }
+
+  size_t read(size_t offset, uint8_t* dst, size_t len) override {
+    if (offset >= len_) {
+      return 0;
+    }
+    if (len > len_ - offset) {
+      len = len_ - offset;
+    }
+    memcpy(dst, data_ + offset, len);
+    return len;
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t len_;
+};
+
+/**
+ * The first `len` bytes of another source, e.g. the written length of a
+ * preallocated file (LogfileInfo::writtenLength()), past which it holds stale
+ * bytes that must not be scanned.
+ */
+class TruncatedByteSource : public ByteSource {
+ public:
+  TruncatedByteSource(ByteSource& src, size_t len) : src_(src), len_(len) {}
+
+  size_t size() override { return len_; }
+
+  size_t read(size_t offset, uint8_t* dst, size_t len) override {
+    if (offset >= len_) {
+      return 0;
+    }
+    if (len > len_ - offset) {
+      len = len_ - offset;
+    }
+    return src_.read(offset, dst, len);
+  }
+
+ private:
+  ByteSource& src_;
+  size_t len_;
+};
+
+/**
+ * Reads and parses the header of a logfile, reading only as much of the file
+ * as the stream headers take up.
+ */
+bool readLogfileHeader(ByteSource& src, LogfileInfo& out);
+
+/**
+ * Number of polled data bytes written for ticks [0, ticks). Only meaningful
+ * when the file has no coded streams.
+ */
+uint64_t polledBytesBefore(const LogfileInfo& info, dlf_tick_t ticks);
+
+/**
+ * Number of samples `stream` has in the ticks [first, first + count), e.g. in
+ * one column of a column block.
+ */
+uint64_t polledSamplesIn(const LogfileStreamInfo& stream, dlf_tick_t first,
+                         dlf_tick_t count);
+
+/**
+ * Outcome of a recovery pass over one logfile.
+ */
+struct RecoveryResult {
+  // Whether the end of the valid data was found. If false, the walk ran out of
+  // budget and validLength is only a lower bound.
+  bool complete = false;
+  // Whether any tick was found at all. tickSpan is meaningless otherwise.
+  bool hasTicks = false;
+  // Last tick covered by the valid data
+  dlf_tick_t tickSpan = 0;
+  // Length of the file once trailing garbage is cut off
+  size_t validLength = 0;
+};
+
+/**
+ * Incremental scan for the end of the valid data in a polled.dlf or event.dlf
+ * left behind by an unclean shutdown. Work is done in step() calls so the
+ * caller can bound the time spent per file.
+ *
+ * - Polled files without checkpoints, coded streams or column blocks are
+ *   resolved arithmetically from the file size and the stream schedules, in
+ *   a single step.
+ * - Otherwise records are walked forward, starting from the last checkpoint
+ *   found near the end of the file when there is one. Where the file has
+ *   block cuts, the partial blocks of coded streams after each cut record
+ *   start their sample counts over. Event records stop
+ *   being valid at the first one that is torn, has an unknown stream index,
+ *   a message longer than its stream allows or goes back in time. Compact
+ *   event groups stop being valid at the first one that is torn or lists a
+ *   stream it cannot hold.
+ */
+class RecoveryScanner {
+ public:
+  RecoveryScanner(ByteSource& src, const LogfileInfo& info,
+                  size_t tailScanBytes = 16 * 1024);
+
+  /**
+   * Scans about `maxBytes` further.
+   * @return true once the result is complete
+   */
+  bool step(size_t maxBytes);
+
+  const RecoveryResult& result() const { return result_; }
+
+ private:
+  bool stepPolled(size_t maxBytes);
+  bool stepEvent(size_t maxBytes);
+  // Checks the column block at pos_ and notes its ticks
+  bool columnBlockAt(size_t& blockBytes);
+  // Checks the partial blocks after the block cut at pos_ and notes its tick
+  bool blockCutAt(const dlf_block_cut_t& cut, size_t& cutBytes);
+  bool stepCompactEvent(size_t maxBytes);
+  void seekToLastCheckpoint(size_t tailScanBytes);
+  void noteTick(dlf_tick_t tick);
+  size_t read(size_t offset, uint8_t* dst, size_t len);
+  // Reads a varint at `offset` and advances it past the varint
+  bool readVarint(size_t& offset, uint64_t& v);
+  // Checks the length of the message value at `offset` of a variable stream
+  // and sets `valueBytes` to the size of the value including its length
+  bool messageAt(size_t offset, const LogfileStreamInfo& s,
+                 size_t& valueBytes);
+
+  ByteSource& src_;
+  const LogfileInfo& info_;
+  size_t fileSize_;
+  bool checkpoints_;
+  size_t pos_;
+  dlf_tick_t nextTick_ = 0;  // Polled: next tick to consume
+  dlf_tick_t lastTick_ = 0;  // Event: tick of the last valid record/group
+  // Polled with block cuts: samples of each stream in its open block
+  std::vector<uint64_t> pending_;
+  size_t lastCheckedPos_ = SIZE_MAX;
+  RecoveryResult result_;
+  uint8_t cache_[512];
+  size_t cacheStart_ = 0;
+  size_t cacheLen_ = 0;
+};
+
+}  // namespace dlf::format
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "dlflib/dlf_types.h"
+#include "dlflib/format/recovery.h"
+
+namespace dlf::format {
+
+/**
+ * Reader for a run container (run.dlf). The constructor walks the section
+ * headers once and keeps every INDEX_STRIDE-th section of each tag, so that
+ * each logical file can then be read at any offset through a
+ * SectionByteSource. Memory stays small on long runs, and sequential reads
+ * pick up where the last one left off.
+ *
+ * A section torn by a power loss, and anything after it, is left out.
+ */
+class RunContainerReader {
+ public:
+  explicit RunContainerReader(ByteSource& file);
+
+  /**
+   * Whether the file starts with a run container header.
+   */
+  bool valid() const { return valid_; }
+
+  const dlf_run_container_header_t& header() const { return header_; }
+
+  /**
+   * Length of the file up to the end of the last complete section. Truncating
+   * the file to this drops a torn section.
+   */
+  size_t validLength() const { return validLength_; }
+
+  /**
+   * Length of the logical file made of the sections with `tag`.
+   */
+  uint64_t sectionBytes(dlf_section_tag_e tag) const;
+
+  /**
+   * The last commit record.
+   * @return false if there is none
+   */
+  bool lastCommit(dlf_container_commit_t& out) const;
+
+  /**
+   * Reads from the logical file made of the sections with `tag`.
+   * @return Number of bytes copied. Short only at its end or on a read error.
+   */
+  size_t readSection(dlf_section_tag_e tag, size_t offset, uint8_t* dst,
+                     size_t len);
+
+  static constexpr size_t INDEX_STRIDE = 64;
+
+ private:
+  struct Section {
+    uint32_t dataOffset;  // File offset of the section's data
+    uint32_t logicalOffset;
+    uint32_t length;
+  };
+
+  // Finds the section of `tag` that holds `offset`
+  bool find(dlf_section_tag_e tag, size_t offset, Section& out);
+
+  ByteSource& file_;
+  bool valid_ = false;
+  dlf_run_container_header_t header_;
+  size_t validLength_ = 0;
+  uint64_t bytes_[DLF_SECTION_TAG_COUNT] = {};
+  uint32_t counts_[DLF_SECTION_TAG_COUNT] = {};
+  std::vector<Section> index_[DLF_SECTION_TAG_COUNT];
+  Section cursor_[DLF_SECTION_TAG_COUNT] = {};  // Last section read per tag
+  bool hasCommit_ = false;
+  dlf_container_commit_t commit_ = {};
+};
+
+/**
+ * One logical file of a run container, e.g. polled.dlf, so that
+ * readLogfileHeader(), RecoveryScanner and FrameByteSource work on it as on
+ * a file of its own.
+ */
+class SectionByteSource : public ByteSource {
+ public:
+  /**
+   * @param limit Length to cut the logical file at, e.g. from the last
+   * commit record
+   */
+  SectionByteSource(RunContainerReader& container, dlf_section_tag_e tag,
+                    uint64_t limit = UINT64_MAX);
+
+  size_t size() override { return size_; }
+
+  size_t read(size_t offset, uint8_t* dst, size_t len) override;
+
+ private:
+  RunContainerReader& container_;
+  dlf_section_tag_e tag_;
+  size_t size_;
+};
+
+}  // namespace dlf::format
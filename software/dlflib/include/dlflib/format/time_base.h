@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "dlflib/dlf_types.h"
+
+namespace dlf::format {
+
+/**
+ * Converts ticks to wall clock time using the time anchors of an event file
+ * (DLF_LOGFILE_FLAG_TIME_ANCHORS). Between two anchors, time is interpolated
+ * linearly, which takes out the drift of the tick clock. Before the first
+ * and after the last anchor, ticks count at the nominal tick_base_us.
+ */
+class TimeBase {
+ public:
+  /**
+   * @param tickBaseUs, epochTimeS From meta.dlf. Used when there are no
+   * anchors.
+   */
+  TimeBase(dlf_time_us_t tickBaseUs, dlf_time_t epochTimeS);
+
+  /**
+   * Adds the next anchor, in file order. An anchor for the same tick as the
+   * previous one replaces it.
+   * @return false if it is out of order, in which case it is ignored
+   */
+  bool add(const dlf_time_anchor_t& anchor);
+
+  const std::vector<dlf_time_anchor_t>& anchors() const { return anchors_; }
+
+  /**
+   * Wall clock time at the start of `tick`, in microseconds since the Unix
+   * epoch.
+   */
+  int64_t epochUs(dlf_tick_t tick) const;
+
+ private:
+  dlf_time_us_t tickBaseUs_;
+  dlf_time_t epochTimeS_;
+  std::vector<dlf_time_anchor_t> anchors_;
+};
+
+}  // namespace dlf::format
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace dlf::storage {
+
+/**
+ * Minimal sector-addressed storage device. Sector numbers are absolute on the
+ * device.
+ */
+class BlockDevice {
+ public:
+  virtual ~BlockDevice() = default;
+
+  virtual size_t sectorSize() const = 0;
+
+  virtual bool readSectors(uint32_t sector, void* dst, size_t count) = 0;
+
+  virtual bool writeSectors(uint32_t sector, const void* src,
+                            size_t count) = 0;
+};
+
+/**
+ * A contiguous run of sectors backing a single file.
+ */
+struct RawExtent {
+  uint32_t firstSector = 0;
+  uint32_t sectorCount = 0;
+};
+
+/**
+ * A filesystem volume that can hand out contiguous, preallocated files whose
+ * data may then be written directly through device(), bypassing the
+ * filesystem. The file only becomes a normal, correctly-sized file once
+ * finalize() is called.
+ */
+class RawVolume {
+ public:
+  virtual ~RawVolume() = default;
+
+  virtual BlockDevice& device() = 0;
+
+  /**
+   * Creates (or truncates) the file at `path` and allocates at least `bytes`
+   * of contiguous storage for it.
+   * @param path Path relative to the filesystem root, as passed to fs::FS.
+   */
+  virtual bool allocate(const char* path, uint64_t bytes, RawExtent& out) = 0;
+
+  /**
+   * Sets the file length to `length`, releasing unused preallocated space and
+   * updating the directory entry.
+   */
+  virtual bool finalize(const char* path, uint64_t length) = 0;
+};
+
+}  // namespace dlf::storage
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include <sdmmc_cmd.h>
+
+#include "dlflib/storage/block_device.h"
+
+namespace dlf::storage {
+
+/**
+ * BlockDevice writing straight to an SD card through the SDMMC driver.
+ */
+class SdmmcBlockDevice : public BlockDevice {
+ public:
+  explicit SdmmcBlockDevice(sdmmc_card_t* card) : card_(card) {}
+
+  size_t sectorSize() const override { return card_->csd.sector_size; }
+
+  bool readSectors(uint32_t sector, void* dst, size_t count) override;
+
+  bool writeSectors(uint32_t sector, const void* src, size_t count) override;
+
+ private:
+  sdmmc_card_t* card_;
+};
+
+/**
+ * RawVolume backed by the FATFS volume mounted on an SD card.
+ *
+ * Files are preallocated with f_expand, so their clusters are contiguous and
+ * the starting sector can be resolved once. Requires FF_USE_EXPAND.
+ */
+class FatfsRawVolume : public RawVolume {
+ public:
+  /**
+   * @param card Card the volume lives on (e.g. from esp_vfs_fat_sdmmc_mount).
+   * @param drive FATFS logical drive prefix of the volume, e.g. "0:".
+   */
+  FatfsRawVolume(sdmmc_card_t* card, const char* drive = "0:");
+
+  BlockDevice& device() override { return device_; }
+
+  bool allocate(const char* path, uint64_t bytes, RawExtent& out) override;
+
+  bool finalize(const char* path, uint64_t length) override;
+
+ private:
+  void fatfsPath(char* out, size_t outSize, const char* path) const;
+
+  SdmmcBlockDevice device_;
+  char drive_[8];
+};
+
+}  // namespace dlf::storage
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "dlflib/storage/log_sink.h"
+#include "dlflib/storage/run_container.h"
+
+namespace dlf::storage {
+
+/**
+ * Writes through the regular filesystem API.
+ */
+class FileSink : public LogSink {
+ public:
+  /**
+   * @param append Open the existing file and write after its end, instead of
+   * creating it empty.
+   */
+  FileSink(fs::FS& fs, const char* path, bool append = false);
+
+  bool open() override;
+  size_t write(const uint8_t* data, size_t len) override;
+  void flush() override;
+  void sync() override;
+  bool patch(size_t offset, const void* data, size_t len) override;
+  void close() override;
+
+ private:
+  fs::FS& fs_;
+  char path_[128];
+  bool append_;
+  fs::File file_;
+};
+
+/**
+ * Writes one logical file into the run's container (run.dlf), which it shares
+ * with the run's other files. Each write becomes one section.
+ */
+class ContainerSink : public LogSink {
+ public:
+  ContainerSink(RunContainer& container, dlf_section_tag_e tag)
+      : container_(container), tag_(tag) {}
+
+  bool open() override { return container_.isOpen(); }
+  size_t write(const uint8_t* data, size_t len) override;
+  void flush() override;
+  void sync() override;
+  bool patch(size_t offset, const void* data, size_t len) override;
+  // The container outlives its sinks, so this only flushes
+  void close() override;
+
+ private:
+  RunContainer& container_;
+  dlf_section_tag_e tag_;
+};
+
+}  // namespace dlf::storage
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace dlf::storage {
+
+/**
+ * @brief Destination for the bytes drained by a LogFile's flusher task.
+ *
+ * Sinks are only ever driven by one task at a time (the LogFile serializes
+ * access with its file mutex).
+ */
+class LogSink {
+ public:
+  virtual ~LogSink() = default;
+
+  virtual bool open() = 0;
+
+  /**
+   * Appends bytes to the end of the log.
+   * @return Number of bytes written.
+   */
+  virtual size_t write(const uint8_t* data, size_t len) = 0;
+
+  /**
+   * Cheap commit of buffered data. May not reach the card.
+   */
+  virtual void flush() = 0;
+
+  /**
+   * Forces written data and the current length to the card.
+   */
+  virtual void sync() = 0;
+
+  /**
+   * Overwrites already written bytes at `offset` without moving the append
+   * position.
+   */
+  virtual bool patch(size_t offset, const void* data, size_t len) = 0;
+
+  virtual void close() = 0;
+};
+
+}  // namespace dlf::storage
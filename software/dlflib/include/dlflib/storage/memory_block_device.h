@@ -0,0 +1,123 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dlflib/storage/block_device.h"
+
+namespace dlf::storage {
+
+/**
+ * RAM-backed BlockDevice. Stand-in for the SD card when testing raw sector
+ * writes on the host. Counts device operations so callers can compare I/O
+ * patterns between write paths.
+ */
+class MemoryBlockDevice : public BlockDevice {
+ public:
+  explicit MemoryBlockDevice(size_t sectorCount, size_t sectorSize = 512)
+      : sectorSize_(sectorSize), data_(sectorCount * sectorSize, 0) {}
+
+  size_t sectorSize() const override { return sectorSize_; }
+
+  size_t sectorCount() const { return data_.size() / sectorSize_; }
+
+  bool readSectors(uint32_t sector, void* dst, size_t count) override {
+    if (!inRange(sector, count)) {
+      return false;
+    }
+    memcpy(dst, data_.data() + sector * sectorSize_, count * sectorSize_);
+    readCalls++;
+    return true;
+  }
+
+  bool writeSectors(uint32_t sector, const void* src, size_t count) override {
+    if (!inRange(sector, count) || writeCalls >= failAfterWrites) {
+      return false;
+    }
+    memcpy(data_.data() + sector * sectorSize_, src, count * sectorSize_);
+    writeCalls++;
+    sectorsWritten += count;
+    return true;
+  }
+
+  const uint8_t* data() const { return data_.data(); }
+
+  size_t readCalls = 0;
+  size_t writeCalls = 0;
+  size_t sectorsWritten = 0;
+  // Writes fail once this many have succeeded, like a card that was pulled
+  size_t failAfterWrites = SIZE_MAX;
+
+ private:
+  bool inRange(uint32_t sector, size_t count) const {
+    return (static_cast<size_t>(sector) + count) * sectorSize_ <= data_.size();
+  }
+
+  size_t sectorSize_;
+  std::vector<uint8_t> data_;
+};
+
+/**
+ * RawVolume over a MemoryBlockDevice. Files are bump-allocated as contiguous
+ * extents; finalize() records the length, which is what a filesystem read of
+ * the file would then see.
+ */
+class MemoryRawVolume : public RawVolume {
+ public:
+  explicit MemoryRawVolume(MemoryBlockDevice& device) : device_(device) {}
+
+  BlockDevice& device() override { return device_; }
+
+  bool allocate(const char* path, uint64_t bytes, RawExtent& out) override {
+    const size_t ss = device_.sectorSize();
+    const uint32_t sectors = static_cast<uint32_t>((bytes + ss - 1) / ss);
+    if (nextSector_ + sectors > device_.sectorCount()) {
+      return false;
+    }
+    out.firstSector = nextSector_;
+    out.sectorCount = sectors;
+    nextSector_ += sectors;
+    files_[path] = File{out, 0, false};
+    return true;
+  }
+
+  bool finalize(const char* path, uint64_t length) override {
+    auto it = files_.find(path);
+    if (it == files_.end()) {
+      return false;
+    }
+    it->second.length = length;
+    it->second.finalized = true;
+    return true;
+  }
+
+  /**
+   * Contents of a finalized file, as the filesystem would return them.
+   */
+  std::vector<uint8_t> read(const char* path) const {
+    auto it = files_.find(path);
+    if (it == files_.end() || !it->second.finalized) {
+      return {};
+    }
+    const uint8_t* begin = device_.data() + static_cast<size_t>(
+                                                it->second.extent.firstSector) *
+                                                device_.sectorSize();
+    return std::vector<uint8_t>(begin, begin + it->second.length);
+  }
+
+ private:
+  struct File {
+    RawExtent extent;
+    uint64_t length;
+    bool finalized;
+  };
+
+  MemoryBlockDevice& device_;
+  uint32_t nextSector_ = 0;
+  std::map<std::string, File> files_;
+};
+
+}  // namespace dlf::storage
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <memory>
+
+#include "dlflib/storage/block_device.h"
+#include "dlflib/storage/log_sink.h"
+#include "dlflib/storage/sector_writer.h"
+
+namespace dlf::storage {
+
+/**
+ * Writes data as raw sectors into a contiguous, preallocated file, bypassing
+ * the filesystem until close(). Until then, the file's directory entry reports
+ * the preallocated size.
+ *
+ * Once the extent is full, the file is finalized at that length and the rest
+ * of the log goes to the overflow sink, which must append to the same file
+ * (e.g. a FileSink opened with append set). From then on every call is passed
+ * to it. Without an overflow sink, writes past the extent are short.
+ * close() finalizes the file at the length that reached the card, which
+ * after a device error is less than what was written.
+ */
+class RawSectorSink : public LogSink {
+ public:
+  RawSectorSink(RawVolume& volume, const char* path, uint64_t preallocateBytes,
+                std::unique_ptr<LogSink> overflow = nullptr);
+
+  bool open() override;
+  size_t write(const uint8_t* data, size_t len) override;
+  void flush() override;
+  void sync() override;
+  bool patch(size_t offset, const void* data, size_t len) override;
+  void close() override;
+
+ private:
+  /**
+   * Finalizes the full extent and opens the overflow sink after it.
+   */
+  bool spill();
+
+  RawVolume& volume_;
+  char path_[128];
+  uint64_t preallocateBytes_;
+  std::unique_ptr<SectorWriter> writer_;
+  std::unique_ptr<LogSink> overflow_;
+  bool spilled_ = false;
+};
+
+}  // namespace dlf::storage
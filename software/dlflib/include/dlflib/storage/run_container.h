@@ -0,0 +1,110 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "dlflib/dlf_types.h"
+
+namespace dlf::storage {
+
+/**
+ * Writer for a run container (run.dlf), the single file that holds all of a
+ * run's logical files when Run::Options::container is set. Every write is
+ * appended as one section tagged with the logical file it belongs to, so the
+ * polled and event flushers share one file, one cluster chain and one
+ * directory entry.
+ *
+ * All methods take an internal mutex, since the flushers, the sampler (on
+ * commit) and the uploader use the container concurrently.
+ */
+class RunContainer {
+ public:
+  /**
+   * Path of the container in a run directory.
+   */
+  static constexpr const char* FILE_NAME = "run.dlf";
+
+  RunContainer(fs::FS& fs, const char* path);
+  ~RunContainer();
+
+  /**
+   * Creates the file with a header in state DLF_RUN_OPEN.
+   */
+  bool open();
+
+  bool isOpen() const { return static_cast<bool>(file_); }
+
+  /**
+   * Appends `len` bytes to the logical file `tag` as one section.
+   * @return Number of bytes of `data` written
+   */
+  size_t append(dlf_section_tag_e tag, const uint8_t* data, size_t len);
+
+  /**
+   * Appends a commit record, then syncs.
+   * @return Length of the container up to the end of the record, i.e. how far
+   * a partial upload may go
+   */
+  size_t commit(const dlf_container_commit_t& c);
+
+  /**
+   * Overwrites bytes of the logical file `tag`. Only the first section of a
+   * tag is tracked, which holds at least its file header.
+   */
+  bool patch(dlf_section_tag_e tag, size_t offset, const void* data,
+             size_t len);
+
+  /**
+   * Length of the logical file `tag` so far.
+   */
+  uint64_t sectionBytes(dlf_section_tag_e tag);
+
+  void flush();
+
+  /**
+   * Forces written data and the current length to the card.
+   */
+  void sync();
+
+  bool setState(dlf_run_state_e state);
+
+  bool setUploadProgress(uint32_t nextChunk, uint32_t nextOffset);
+
+  void close();
+
+  /**
+   * Reads the header of the container at `path`, e.g. of a closed run.
+   */
+  static bool readHeader(fs::FS& fs, const char* path,
+                         dlf_run_container_header_t& out);
+
+  /**
+   * Overwrites header fields of the container at `path`, which must not be
+   * open for writing.
+   */
+  static bool writeState(fs::FS& fs, const char* path, dlf_run_state_e state);
+
+  static bool writeUploadProgress(fs::FS& fs, const char* path,
+                                  uint32_t nextChunk, uint32_t nextOffset);
+
+ private:
+  struct FirstSection {
+    size_t dataOffset = 0;  // 0 until the tag's first section is written
+    size_t length = 0;
+  };
+
+  size_t appendLocked(dlf_section_tag_e tag, const uint8_t* data, size_t len);
+  bool patchFile(size_t offset, const void* data, size_t len);
+
+  fs::FS& fs_;
+  char path_[128];
+  fs::File file_;
+  SemaphoreHandle_t mutex_;
+  size_t size_ = 0;
+  uint64_t bytes_[DLF_SECTION_TAG_COUNT] = {};
+  FirstSection first_[DLF_SECTION_TAG_COUNT];
+};
+
+}  // namespace dlf::storage
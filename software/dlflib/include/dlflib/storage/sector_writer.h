@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "dlflib/storage/block_device.h"
+
+namespace dlf::storage {
+
+/**
+ * @brief Streams bytes into a contiguous extent using whole-sector writes.
+ *
+ * Bytes are staged in a small multi-sector buffer and written to the device
+ * once the buffer fills, so the steady-state cost is one multi-sector device
+ * write per `stagingSectors` sectors with no filesystem bookkeeping.
+ */
+class SectorWriter {
+ public:
+  SectorWriter(BlockDevice& device, const RawExtent& extent,
+               size_t stagingSectors = 8);
+
+  /**
+   * @return Number of bytes accepted. Short if the extent is full or the
+   * device reported an error.
+   */
+  size_t write(const void* data, size_t len);
+
+  /**
+   * Writes any partially filled sectors (zero padded) to the device. The
+   * staged bytes are kept, so later writes rewrite those sectors in place.
+   */
+  bool flush();
+
+  /**
+   * Overwrites `len` bytes at byte `offset` from the start of the extent. The
+   * range must already have been written. Staged bytes are patched in memory
+   * (call flush() to persist them); already written sectors are updated with a
+   * read-modify-write.
+   */
+  bool patch(uint64_t offset, const void* data, size_t len);
+
+  uint64_t bytesWritten() const { return bytesWritten_; }
+
+  /**
+   * Bytes known to be on the device: all of them after a successful flush(),
+   * otherwise those of the last staging buffer that was written out.
+   */
+  uint64_t syncedBytes() const { return syncedBytes_; }
+
+  uint64_t capacityBytes() const {
+    return static_cast<uint64_t>(extent_.sectorCount) * sectorSize_;
+  }
+
+  bool failed() const { return failed_; }
+
+ private:
+  bool writeStaging(size_t sectors);
+
+  BlockDevice& device_;
+  RawExtent extent_;
+  size_t sectorSize_;
+  std::vector<uint8_t> staging_;
+  // Sector (relative to the extent) that staging_[0] maps to
+  uint32_t stagingSector_ = 0;
+  size_t stagingFill_ = 0;
+  uint64_t bytesWritten_ = 0;
+  uint64_t syncedBytes_ = 0;
+  bool failed_ = false;
+};
+
+}  // namespace dlf::storage
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+
+namespace dlf::util {
+
+/**
+ * Lock-free single-producer/single-consumer byte ring.
+ *
+ * The producer reserves space, fills it in place and commits it. The consumer
+ * peeks at the committed bytes as (at most) two contiguous spans, hands them
+ * directly to whatever consumes them and then releases them. Neither side
+ * copies through an intermediate buffer or enters a critical section; the two
+ * sides only share a pair of monotonically increasing byte counters.
+ *
+ * Capacity is rounded up to a power of two so that the counters may wrap.
+ */
+class ByteRing {
+ public:
+  /**
+   * Up to two contiguous regions of the ring. The second is only used when
+   * the region wraps around the end of the buffer.
+   */
+  struct Spans {
+    uint8_t* first = nullptr;
+    size_t firstLen = 0;
+    uint8_t* second = nullptr;
+    size_t secondLen = 0;
+
+    size_t size() const { return firstLen + secondLen; }
+
+    /**
+     * Copies `len` bytes from `src` to `offset` within the spans.
+     */
+    void write(size_t offset, const void* src, size_t len) const {
+      const uint8_t* p = static_cast<const uint8_t*>(src);
+      if (offset < firstLen) {
+        size_t n = firstLen - offset < len ? firstLen - offset : len;
+        memcpy(first + offset, p, n);
+        p += n;
+        len -= n;
+        offset = firstLen;
+      }
+      if (len > 0) {
+        memcpy(second + (offset - firstLen), p, len);
+      }
+    }
+
+    /**
+     * Copies `len` bytes at `offset` within the spans to `dst`.
+     */
+    void read(size_t offset, void* dst, size_t len) const {
+      uint8_t* p = static_cast<uint8_t*>(dst);
+      if (offset < firstLen) {
+        size_t n = firstLen - offset < len ? firstLen - offset : len;
+        memcpy(p, first + offset, n);
+        p += n;
+        len -= n;
+        offset = firstLen;
+      }
+      if (len > 0) {
+        memcpy(p, second + (offset - firstLen), len);
+      }
+    }
+  };
+
+  explicit ByteRing(size_t capacity) {
+    size_t cap = 1;
+    while (cap < capacity) {
+      cap <<= 1;
+    }
+    buf_.reset(new (std::nothrow) uint8_t[cap]);
+    capacity_ = buf_ ? cap : 0;
+  }
+
+  ByteRing(const ByteRing&) = delete;
+  ByteRing& operator=(const ByteRing&) = delete;
+
+  bool valid() const { return capacity_ > 0; }
+
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * Committed bytes not yet released by the consumer. Safe from either side.
+   */
+  size_t readable() const {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+
+  // Producer side
+
+  size_t writable() const {
+    return capacity_ - (head_.load(std::memory_order_relaxed) -
+                        tail_.load(std::memory_order_acquire));
+  }
+
+  /**
+   * Reserves `len` bytes for writing. Returns empty spans if there is not
+   * enough space. Nothing is visible to the consumer until commit().
+   */
+  Spans reserve(size_t len) const {
+    if (len == 0 || len > writable()) {
+      return Spans();
+    }
+    return spansAt(head_.load(std::memory_order_relaxed), len);
+  }
+
+  /**
+   * Publishes `len` reserved bytes to the consumer.
+   */
+  void commit(size_t len) {
+    head_.store(head_.load(std::memory_order_relaxed) + len,
+                std::memory_order_release);
+  }
+
+  /**
+   * Copies `len` bytes in, all or nothing.
+   */
+  bool write(const void* data, size_t len) {
+    Spans s = reserve(len);
+    if (s.size() != len) {
+      return false;
+    }
+    s.write(0, data, len);
+    commit(len);
+    return true;
+  }
+
+  /**
+   * Total bytes committed since construction, modulo SIZE_MAX + 1.
+   */
+  size_t committed() const { return head_.load(std::memory_order_relaxed); }
+
+  // Consumer side
+
+  /**
+   * All committed bytes, in order.
+   */
+  Spans peek() const {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    return spansAt(tail, head_.load(std::memory_order_acquire) - tail);
+  }
+
+  /**
+   * Releases the oldest `len` bytes back to the producer.
+   */
+  void consume(size_t len) {
+    tail_.store(tail_.load(std::memory_order_relaxed) + len,
+                std::memory_order_release);
+  }
+
+  /**
+   * Copies up to `len` bytes out and releases them.
+   */
+  size_t read(void* dst, size_t len) {
+    Spans s = peek();
+    if (len > s.size()) {
+      len = s.size();
+    }
+    uint8_t* p = static_cast<uint8_t*>(dst);
+    size_t n = len < s.firstLen ? len : s.firstLen;
+    memcpy(p, s.first, n);
+    if (len > n) {
+      memcpy(p + n, s.second, len - n);
+    }
+    consume(len);
+    return len;
+  }
+
+ private:
+  Spans spansAt(size_t pos, size_t len) const {
+    Spans s;
+    if (len == 0) {
+      return s;
+    }
+    const size_t idx = pos & (capacity_ - 1);
+    s.first = buf_.get() + idx;
+    s.firstLen = capacity_ - idx < len ? capacity_ - idx : len;
+    if (s.firstLen < len) {
+      s.second = buf_.get();
+      s.secondLen = len - s.firstLen;
+    }
+    return s;
+  }
+
+  std::unique_ptr<uint8_t[]> buf_;
+  size_t capacity_ = 0;
+  std::atomic<size_t> head_{0};  // Written by the producer only
+  std::atomic<size_t> tail_{0};  // Written by the consumer only
+};
+
+}  // namespace dlf::util
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace dlf::util {
+
+/**
+ * Fixed-size latency histogram with power-of-two microsecond buckets.
+ *
+ * Bucket 0 counts samples below 1us. Bucket i (i > 0) counts samples in
+ * [2^(i-1), 2^i) us. The last bucket is open-ended and also counts everything
+ * above its lower bound. Recording is O(1) and never allocates, so it is safe
+ * to use from the flusher hot path.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t NUM_BUCKETS = 20;
+
+  void record(uint32_t us) {
+    buckets_[bucketIndex(us)]++;
+    count_++;
+    totalUs_ += us;
+    if (us > maxUs_) {
+      maxUs_ = us;
+    }
+  }
+
+  void reset() { *this = LatencyHistogram(); }
+
+  uint32_t count() const { return count_; }
+
+  uint32_t maxUs() const { return maxUs_; }
+
+  uint64_t totalUs() const { return totalUs_; }
+
+  uint32_t meanUs() const {
+    return count_ == 0 ? 0 : static_cast<uint32_t>(totalUs_ / count_);
+  }
+
+  uint32_t bucketCount(size_t i) const {
+    return i < NUM_BUCKETS ? buckets_[i] : 0;
+  }
+
+  /**
+   * Exclusive upper bound of bucket i, in us. The last bucket is unbounded and
+   * returns UINT32_MAX.
+   */
+  static uint32_t bucketUpperBoundUs(size_t i) {
+    return i + 1 >= NUM_BUCKETS ? UINT32_MAX : (1u << i);
+  }
+
+  /**
+   * Approximates the p-th percentile (0-100) as the upper bound of the bucket
+   * containing it, capped to the largest recorded value.
+   */
+  uint32_t percentileUs(float p) const {
+    if (count_ == 0) {
+      return 0;
+    }
+
+    const uint64_t target =
+        static_cast<uint64_t>((p / 100.0f) * static_cast<float>(count_) + 0.5f);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      seen += buckets_[i];
+      if (seen >= target && seen > 0) {
+        uint32_t bound = bucketUpperBoundUs(i);
+        return bound < maxUs_ ? bound : maxUs_;
+      }
+    }
+    return maxUs_;
+  }
+
+  static size_t bucketIndex(uint32_t us) {
+    if (us == 0) {
+      return 0;
+    }
+    size_t i = 32 - __builtin_clz(us);
+    return i < NUM_BUCKETS ? i : NUM_BUCKETS - 1;
+  }
+
+ private:
+  uint32_t buckets_[NUM_BUCKETS] = {0};
+  uint32_t count_ = 0;
+  uint32_t maxUs_ = 0;
+  uint64_t totalUs_ = 0;
+};
+
+}  // namespace dlf::util
@@ -330,6 +330,19 @@ void UploaderComponent::syncTask(void* arg) {
         }
       }
 
+      // Container runs keep the same state in the run.dlf header
+      char containerPath[128];
+      dlf::util::joinPath(containerPath, sizeof(containerPath), runDirPath,
+                          dlf::storage::RunContainer::FILE_NAME);
+      dlf_run_container_header_t container;
+      const bool isContainer = dlf::storage::RunContainer::readHeader(
+          uploaderComponent->fs_, containerPath, container);
+      if (isContainer) {
+        lockfileFound = lockfileFound || container.state == DLF_RUN_OPEN;
+        uploadMarkerFound =
+            uploadMarkerFound || container.state == DLF_RUN_UPLOADED;
+      }
+
       // Skip uploading active run
       if (lockfileFound) {
         DLFLIB_LOG_INFO(
@@ -393,14 +406,19 @@ void UploaderComponent::syncTask(void* arg) {
 
         case RetentionMode::MARK: {
           // Add upload marker to indicate that this run has been uploaded
-          char markerFilePath[128];
-          dlf::util::joinPath(markerFilePath, sizeof(markerFilePath),
-                              runDirPath, UPLOAD_MARKER_FILE_NAME);
-          fs::File file =
-              uploaderComponent->fs_.open(markerFilePath, "w", true);
-          if (file) {
-            file.write(0);
-            file.close();
+          if (isContainer) {
+            dlf::storage::RunContainer::writeState(
+                uploaderComponent->fs_, containerPath, DLF_RUN_UPLOADED);
+          } else {
+            char markerFilePath[128];
+            dlf::util::joinPath(markerFilePath, sizeof(markerFilePath),
+                                runDirPath, UPLOAD_MARKER_FILE_NAME);
+            fs::File file =
+                uploaderComponent->fs_.open(markerFilePath, "w", true);
+            if (file) {
+              file.write(0);
+              file.close();
+            }
           }
           DLFLIB_LOG_INFO(
               "[UploaderComponent][syncTask] RetentionMode is MARK. Marked %s "
@@ -480,9 +498,15 @@ void UploaderComponent::partialRunUploadTask(void* arg) {
           "active run %s",
           run->uuid());
 
-      // Manually flush the log files for the run. This updates the log file
-      // headers.
-      run->flushLogFiles();
+      // Commit everything sampled so far. This updates the log file headers,
+      // or appends a checkpoint to append-only log files, and syncs them.
+      Run::CommitResult committed;
+      if (!run->commit(run->currentTick(), committed)) {
+        DLFLIB_LOG_WARNING(
+            "[UploaderComponent][partialRunUploadTask] Commit failed. "
+            "Skipping");
+        continue;
+      }
 
       // Acquire locks on run's LogFiles to avoid conflict with SD card writes
       // when uploading.
@@ -504,7 +528,8 @@ void UploaderComponent::partialRunUploadTask(void* arg) {
           uploaderComponent->options_.enableChunkedUpload
               ? uploaderComponent->uploadRunChunked(
                     runDir, runDir.name(), /*isActive=*/true,
-                    /*finalize=*/false, run->elapsedSecs())
+                    /*finalize=*/false, run->elapsedSecs(),
+                    /*maxChunkSize=*/256 * 1024, &committed, run->container())
               : uploaderComponent->uploadRun(runDir, runDir.name(),
                                              /*isActive=*/true);
       if (uploadSuccess) {
@@ -602,9 +627,11 @@ bool UploaderComponent::deleteRunDir(fs::File runDir, const char* runDirPath) {
   return ok;
 }
 
-bool UploaderComponent::uploadRunChunked(fs::File runDir, const char* runUuid,
-                                         bool isActive, bool finalize,
-                                         float durationS, size_t maxChunkSize) {
+bool UploaderComponent::uploadRunChunked(
+    fs::File runDir, const char* runUuid, bool isActive, bool finalize,
+    float durationS, size_t maxChunkSize,
+    const dlf::Run::CommitResult* committed,
+    dlf::storage::RunContainer* container) {
   if (!runDir) {
     DLFLIB_LOG_ERROR("[UploaderComponent][uploadRunChunked] No file to upload");
     return false;
@@ -628,13 +655,28 @@ bool UploaderComponent::uploadRunChunked(fs::File runDir, const char* runUuid,
   dlf::util::joinPath(progressFilePath, sizeof(progressFilePath), runDirPath,
                       UPLOAD_PROGRESS_FILE);
 
-  // Load persisted upload progress
+  char containerPath[128];
+  dlf::util::joinPath(containerPath, sizeof(containerPath), runDirPath,
+                      dlf::storage::RunContainer::FILE_NAME);
+
+  // Load persisted upload progress. A container run keeps it in its header.
   uint32_t metaNextChunkNum = 1, metaNextByteOffset = 0;
   uint32_t polledNextChunkNum = 1, polledNextByteOffset = 0;
   uint32_t eventNextChunkNum = 1, eventNextByteOffset = 0;
-  loadUploadProgress(progressFilePath, metaNextChunkNum, metaNextByteOffset,
-                     polledNextChunkNum, polledNextByteOffset,
-                     eventNextChunkNum, eventNextByteOffset);
+  uint32_t indexNextChunkNum = 1, indexNextByteOffset = 0;
+  uint32_t containerNextChunkNum = 1, containerNextByteOffset = 0;
+  dlf_run_container_header_t containerHeader;
+  const bool isContainer = dlf::storage::RunContainer::readHeader(
+      fs_, containerPath, containerHeader);
+  if (isContainer) {
+    containerNextChunkNum = containerHeader.upload_next_chunk;
+    containerNextByteOffset = containerHeader.upload_next_offset;
+  } else {
+    loadUploadProgress(progressFilePath, metaNextChunkNum, metaNextByteOffset,
+                       polledNextChunkNum, polledNextByteOffset,
+                       eventNextChunkNum, eventNextByteOffset,
+                       indexNextChunkNum, indexNextByteOffset);
+  }
   DLFLIB_LOG_INFO(
       "[UploaderComponent][uploadRunChunked] Starting upload for %s "
       "(next byte offsets: meta=%u polled=%u event=%u)",
@@ -658,11 +700,19 @@ bool UploaderComponent::uploadRunChunked(fs::File runDir, const char* runUuid,
     const char* name;
     uint32_t& nextChunkNum;
     uint32_t& nextByteOffset;
+    size_t limit;  // Upload no further than this. 0 means the whole file.
   };
   FileEntry entries[] = {
-      {"meta.dlf", metaNextChunkNum, metaNextByteOffset},
-      {"polled.dlf", polledNextChunkNum, polledNextByteOffset},
-      {"event.dlf", eventNextChunkNum, eventNextByteOffset},
+      {"meta.dlf", metaNextChunkNum, metaNextByteOffset, 0},
+      {"polled.dlf", polledNextChunkNum, polledNextByteOffset,
+       committed ? committed->polledBytes : 0},
+      {"event.dlf", eventNextChunkNum, eventNextByteOffset,
+       committed ? committed->eventBytes : 0},
+      // Entries past the committed event data are ignored by readers
+      {"event.idx", indexNextChunkNum, indexNextByteOffset, 0},
+      // Holds all of the above in container runs, which have no other files
+      {dlf::storage::RunContainer::FILE_NAME, containerNextChunkNum,
+       containerNextByteOffset, committed ? committed->containerBytes : 0},
   };
   constexpr size_t numEntries = sizeof(entries) / sizeof(entries[0]);
   const char* uploadedFilenames[numEntries] = {};
@@ -683,7 +733,11 @@ bool UploaderComponent::uploadRunChunked(fs::File runDir, const char* runUuid,
       continue;
     }
 
-    const size_t fileSize = file.size();
+    // Bytes past the commit point may belong to a partially written tick
+    size_t fileSize = file.size();
+    if (entries[entryIdx].limit > 0 && entries[entryIdx].limit < fileSize) {
+      fileSize = entries[entryIdx].limit;
+    }
     if (fileSize == 0) {
       file.close();
       DLFLIB_LOG_INFO(
@@ -739,9 +793,17 @@ bool UploaderComponent::uploadRunChunked(fs::File runDir, const char* runUuid,
           filename, nextByteOffset, fileSize);
 
       // Update progress after each successful chunk
-      saveUploadProgress(progressFilePath, metaNextChunkNum, metaNextByteOffset,
-                         polledNextChunkNum, polledNextByteOffset,
-                         eventNextChunkNum, eventNextByteOffset);
+      if (!isContainer) {
+        saveUploadProgress(
+            progressFilePath, metaNextChunkNum, metaNextByteOffset,
+            polledNextChunkNum, polledNextByteOffset, eventNextChunkNum,
+            eventNextByteOffset, indexNextChunkNum, indexNextByteOffset);
+      } else if (container) {
+        container->setUploadProgress(nextChunkNum, nextByteOffset);
+      } else {
+        dlf::storage::RunContainer::writeUploadProgress(
+            fs_, containerPath, nextChunkNum, nextByteOffset);
+      }
     }
 
     file.close();
@@ -829,15 +891,19 @@ bool UploaderComponent::loadUploadProgress(const char* progressFilePath,
                                            uint32_t& polledNextChunkNum,
                                            uint32_t& polledNextByteOffset,
                                            uint32_t& eventNextChunkNum,
-                                           uint32_t& eventNextByteOffset) {
+                                           uint32_t& eventNextByteOffset,
+                                           uint32_t& indexNextChunkNum,
+                                           uint32_t& indexNextByteOffset) {
   fs::File progressFile = fs_.open(progressFilePath, "r");
   if (!progressFile) {
     return false;
   }
 
-  uint32_t buf[6] = {1, 0, 1, 0, 1, 0};
-  if (progressFile.size() == sizeof(buf)) {
-    progressFile.read(reinterpret_cast<uint8_t*>(buf), sizeof(buf));
+  // Progress files written before event.idx was uploaded hold 6 words
+  uint32_t buf[8] = {1, 0, 1, 0, 1, 0, 1, 0};
+  const size_t size = progressFile.size();
+  if (size == sizeof(buf) || size == 6 * sizeof(uint32_t)) {
+    progressFile.read(reinterpret_cast<uint8_t*>(buf), size);
   }
   progressFile.close();
 
@@ -847,6 +913,8 @@ bool UploaderComponent::loadUploadProgress(const char* progressFilePath,
   polledNextByteOffset = buf[3];
   eventNextChunkNum = buf[4];
   eventNextByteOffset = buf[5];
+  indexNextChunkNum = buf[6];
+  indexNextByteOffset = buf[7];
   return true;
 }
 
@@ -856,7 +924,9 @@ bool UploaderComponent::saveUploadProgress(const char* progressFilePath,
                                            uint32_t polledNextChunkNum,
                                            uint32_t polledNextByteOffset,
                                            uint32_t eventNextChunkNum,
-                                           uint32_t eventNextByteOffset) {
+                                           uint32_t eventNextByteOffset,
+                                           uint32_t indexNextChunkNum,
+                                           uint32_t indexNextByteOffset) {
   fs::File progressFile = fs_.open(progressFilePath, "w", true);
   if (!progressFile) {
     DLFLIB_LOG_ERROR("[UploaderComponent][saveUploadProgress] Cannot write %s",
@@ -864,9 +934,10 @@ bool UploaderComponent::saveUploadProgress(const char* progressFilePath,
     return false;
   }
 
-  uint32_t buf[6] = {metaNextChunkNum,   metaNextByteOffset,
+  uint32_t buf[8] = {metaNextChunkNum,   metaNextByteOffset,
                      polledNextChunkNum, polledNextByteOffset,
-                     eventNextChunkNum,  eventNextByteOffset};
+                     eventNextChunkNum,  eventNextByteOffset,
+                     indexNextChunkNum,  indexNextByteOffset};
   progressFile.write(reinterpret_cast<const uint8_t*>(buf), sizeof(buf));
   progressFile.close();
   return true;
@@ -0,0 +1,84 @@
+#include "dlflib/datastream/capture_source.h"
+
+#include <string.h>
+
+#include "dlflib/format/codec.h"
+
+namespace dlf::datastream {
+
+size_t MemoryCaptureSource::read(uint8_t* dst, size_t len) {
+  if (readLimit_ > 0 && len > readLimit_) {
+    len = readLimit_;
+  }
+  if (len > available()) {
+    len = available();
+  }
+  memcpy(dst, bytes_.data() + pos_, len);
+  pos_ += len;
+  return len;
+}
+
+size_t writeCaptureChunk(CaptureSource& source, size_t maxLen,
+                         dlf_stream_idx_t idx, dlf_tick_t tick,
+                         dlf::util::ByteRing& ring) {
+  size_t len = source.available();
+  if (len > maxLen) {
+    len = maxLen;
+  }
+  if (len == 0) {
+    return 0;
+  }
+
+  const size_t lenBytes = dlf::format::varintSize(len);
+  const size_t dataOffset = sizeof(dlf_event_stream_sample_t) + lenBytes;
+  const size_t required = dataOffset + len;
+  const dlf::util::ByteRing::Spans spans = ring.reserve(required);
+  if (spans.size() < required) {
+    return 0;
+  }
+
+  // Read into the reservation itself, in two parts if it wraps
+  size_t got = 0;
+  while (got < len) {
+    const size_t pos = dataOffset + got;
+    uint8_t* dst;
+    size_t room;
+    if (pos < spans.firstLen) {
+      dst = spans.first + pos;
+      room = spans.firstLen - pos;
+    } else {
+      dst = spans.second + (pos - spans.firstLen);
+      room = required - pos;
+    }
+    if (room > len - got) {
+      room = len - got;
+    }
+    const size_t n = source.read(dst, room);
+    got += n;
+    if (n < room) {
+      break;
+    }
+  }
+  if (got == 0) {
+    return 0;
+  }
+
+  dlf_event_stream_sample_t h;
+  h.stream = idx;
+  h.sample_tick = tick;
+  spans.write(0, &h, sizeof(h));
+
+  // The data already sits after a length of lenBytes bytes. A short read
+  // needs fewer, so pad it with continuation bits, which LEB128 allows.
+  uint8_t lenOut[10];
+  for (size_t i = 0; i < lenBytes; i++) {
+    lenOut[i] = static_cast<uint8_t>(((got >> (7 * i)) & 0x7F) |
+                                     (i + 1 < lenBytes ? 0x80 : 0));
+  }
+  spans.write(sizeof(h), lenOut, lenBytes);
+
+  ring.commit(dataOffset + got);
+  return dataOffset + got;
+}
+
+}  // namespace dlf::datastream
@@ -0,0 +1,38 @@
+#include "dlflib/datastream/capture_stream.h"
+
+#include "dlflib/datastream/capture_stream_handle.h"
+#include "dlflib/log.h"
+
+namespace dlf::datastream {
+
+CaptureStream::CaptureStream(const char* id, CaptureSource& source,
+                             const Options& options)
+    : EventStream(Encodable(nullptr,
+                            options.maxChunk < DLF_CAPTURE_MAX_CHUNK
+                                ? options.maxChunk
+                                : DLF_CAPTURE_MAX_CHUNK,
+                            "uint8_t[]"),
+                  id, options.notes),
+      source_(source),
+      threshold_(options.threshold),
+      maxWait_(options.maxWait) {
+  if (dataSize() < options.maxChunk) {
+    DLFLIB_LOG_WARNING("[CaptureStream] %s: chunks limited to %zu bytes",
+                       this->id(), dataSize());
+  }
+  if (threshold_ > dataSize()) {
+    threshold_ = dataSize();
+  }
+}
+
+std::unique_ptr<dlf::datastream::AbstractStreamHandle>
+CaptureStream::createHandle(std::chrono::microseconds tickInterval,
+                            dlf_stream_idx_t idx) {
+  const dlf_tick_t maxWaitTicks = max(maxWait_ / tickInterval, 1ll);
+  return dlf::util::make_unique<CaptureStreamHandle>(this, idx, threshold_,
+                                                     maxWaitTicks);
+}
+
+dlf_stream_type_e CaptureStream::type() { return RAW; }
+
+}  // namespace dlf::datastream
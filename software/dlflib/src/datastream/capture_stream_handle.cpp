@@ -0,0 +1,58 @@
+#include "dlflib/datastream/capture_stream_handle.h"
+
+#include "dlflib/format/codec.h"
+#include "dlflib/log.h"
+
+namespace dlf::datastream {
+
+CaptureStreamHandle::CaptureStreamHandle(CaptureStream* stream,
+                                         dlf_stream_idx_t idx,
+                                         size_t threshold,
+                                         dlf_tick_t maxWaitTicks)
+    : EventStreamHandle(stream, idx),
+      source_(stream->source()),
+      threshold_(threshold),
+      maxWaitTicks_(maxWaitTicks) {}
+
+bool CaptureStreamHandle::available(dlf_tick_t tick) {
+  lastTick_ = tick;
+  const size_t waiting = source_.available();
+  if (waiting == 0) {
+    waiting_ = false;
+    return false;
+  }
+  if (!waiting_) {
+    waiting_ = true;
+    waitingSince_ = tick;
+  }
+  return waiting >= threshold_ || tick - waitingSince_ >= maxWaitTicks_;
+}
+
+size_t CaptureStreamHandle::encodeInto(dlf::util::ByteRing& buf,
+                                       dlf_tick_t tick) {
+  // As with other events, bytes that do not fit stay in the source and are
+  // retried on the next tick
+  const size_t written =
+      writeCaptureChunk(source_, stream->dataSize(), idx, tick, buf);
+  if (written == 0) {
+    DLFLIB_LOG_WARNING(
+        "[CaptureStreamHandle] Buffer full, deferring write for stream %s",
+        stream->id());
+    return 0;
+  }
+  waiting_ = false;
+  return written;
+}
+
+size_t CaptureStreamHandle::encodeTrailerInto(dlf::util::ByteRing& buf) {
+  if (!waiting_ || !waitForSpace(buf, sizeof(dlf_event_stream_sample_t) +
+                                          dlf::format::varintSize(
+                                              stream->dataSize()) +
+                                          stream->dataSize())) {
+    return 0;
+  }
+  waiting_ = false;
+  return writeCaptureChunk(source_, stream->dataSize(), idx, lastTick_, buf);
+}
+
+}  // namespace dlf::datastream
@@ -2,6 +2,7 @@
 
 #include <fnv.h>
 
+#include "dlflib/format/codec.h"
 #include "dlflib/log.h"
 
 namespace dlf::datastream {
@@ -10,6 +11,7 @@ EventStreamHandle::EventStreamHandle(EventStream* stream, dlf_stream_idx_t idx)
     : AbstractStreamHandle(stream, idx) {}
 
 size_t EventStreamHandle::currentHash() {
+  stream->refresh();
   return fnv_32_buf(stream->dataSource(), stream->dataSize(), FNV1_32_INIT);
 }
 
@@ -20,7 +22,8 @@ bool EventStreamHandle::available(dlf_tick_t tick) {
   return hash_ != currentHash();
 }
 
-size_t EventStreamHandle::encodeHeaderInto(StreamBufferHandle_t buf) {
+size_t EventStreamHandle::encodeHeaderInto(dlf::util::ByteRing& buf,
+                                           uint32_t fileFlags) {
 #ifdef DEBUG
   DLFLIB_LOG_DEBUG(
       "[EventStreamHandle] Encoding event header:\n"
@@ -32,10 +35,16 @@ size_t EventStreamHandle::encodeHeaderInto(StreamBufferHandle_t buf) {
       stream->notes());
 #endif
 
-  return AbstractStreamHandle::encodeHeaderInto(buf);
+  size_t written = AbstractStreamHandle::encodeHeaderInto(buf, fileFlags);
+  if (fileFlags & DLF_LOGFILE_FLAG_VARIABLE_EVENTS) {
+    dlf_event_stream_segment_t seg{static_cast<uint8_t>(
+        variableLength() ? DLF_EVENT_STREAM_VARIABLE : 0)};
+    written += send(buf, seg);
+  }
+  return written;
 }
 
-size_t EventStreamHandle::encodeInto(StreamBufferHandle_t buf,
+size_t EventStreamHandle::encodeInto(dlf::util::ByteRing& buf,
                                      dlf_tick_t tick) {
 #ifdef DEBUG
   DLFLIB_LOG_DEBUG(
@@ -52,7 +61,8 @@ size_t EventStreamHandle::encodeInto(StreamBufferHandle_t buf,
   // changed.
   const size_t required =
       sizeof(dlf_event_stream_sample_t) + stream->dataSize();
-  if (xStreamBufferSpacesAvailable(buf) < required) {
+  dlf::util::ByteRing::Spans spans = buf.reserve(required);
+  if (spans.size() < required) {
     DLFLIB_LOG_WARNING(
         "[EventStreamHandle] Buffer full, deferring write for stream %s",
         stream->id());
@@ -73,17 +83,43 @@ size_t EventStreamHandle::encodeInto(StreamBufferHandle_t buf,
   dlf_event_stream_sample_t h;
   h.stream = idx;
   h.sample_tick = tick;
-  xStreamBufferSend(buf, &h, sizeof(h), portMAX_DELAY);
+  spans.write(0, &h, sizeof(h));
 
   // Write event stream sample data
-  size_t written = xStreamBufferSend(buf, stream->dataSource(),
-                                     stream->dataSize(), portMAX_DELAY);
+  spans.write(sizeof(h), stream->dataSource(), stream->dataSize());
 
   if (stream->mutex()) {
     xSemaphoreGive(stream->mutex());
   }
 
-  return written;
+  buf.commit(required);
+  return required;
+}
+
+size_t EventStreamHandle::groupedRecordSize() const {
+  return dlf::format::varintSize(idx) + stream->dataSize();
+}
+
+size_t EventStreamHandle::encodeGroupedInto(
+    const dlf::util::ByteRing::Spans& spans, size_t offset) {
+  uint8_t idxBytes[3];
+  const size_t idxLen = dlf::format::putVarint(idxBytes, idx);
+  spans.write(offset, idxBytes, idxLen);
+  return idxLen + encodeValueInto(spans, offset + idxLen);
+}
+
+size_t EventStreamHandle::encodeValueInto(
+    const dlf::util::ByteRing::Spans& spans, size_t offset) {
+  // The record has already been sized, so the value is written even if the
+  // mutex cannot be taken
+  const bool locked = stream->mutex() &&
+                      xSemaphoreTake(stream->mutex(), portMAX_DELAY) == pdTRUE;
+  hash_ = currentHash();
+  spans.write(offset, stream->dataSource(), stream->dataSize());
+  if (locked) {
+    xSemaphoreGive(stream->mutex());
+  }
+  return stream->dataSize();
 }
 
 }  // namespace dlf::datastream
\ No newline at end of file
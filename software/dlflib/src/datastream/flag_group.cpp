@@ -0,0 +1,60 @@
+#include "dlflib/datastream/flag_group.h"
+
+namespace dlf::datastream {
+
+bool FlagGroup::add(const char* name, const volatile bool& flag) {
+  if (flags_.size() >= MAX_FLAGS) {
+    return false;
+  }
+  flags_.push_back({name, &flag, nullptr, 0});
+  return true;
+}
+
+bool FlagGroup::add(const char* name, const volatile uint32_t& word,
+                    uint8_t bit) {
+  if (flags_.size() >= MAX_FLAGS || bit >= 32) {
+    return false;
+  }
+  flags_.push_back({name, nullptr, &word, 1u << bit});
+  return true;
+}
+
+uint64_t FlagGroup::validMask() const {
+  return flags_.size() >= 64 ? ~0ull : (1ull << flags_.size()) - 1;
+}
+
+uint64_t FlagGroup::read() const {
+  uint64_t mask = 0;
+  for (size_t i = 0; i < flags_.size(); i++) {
+    const Flag& f = flags_[i];
+    const bool set = f.flag != nullptr ? *f.flag : (*f.word & f.mask) != 0;
+    mask |= static_cast<uint64_t>(set) << i;
+  }
+  return mask;
+}
+
+const char* FlagGroup::typeStructure(bool withChanges) {
+  // "Flags;changed:uint32_t:0;values:uint32_t:4;pump:bit:32;...", where the
+  // offset of a bit field counts bits of the whole value
+  const size_t size = maskSize();
+  const char* word = size == 4 ? "uint32_t" : "uint64_t";
+  const size_t valuesOffset = withChanges ? size : 0;
+
+  typeStructure_ = "Flags";
+  if (withChanges) {
+    typeStructure_ += ";changed:";
+    typeStructure_ += word;
+    typeStructure_ += ":0";
+  }
+  typeStructure_ += ";values:";
+  typeStructure_ += word;
+  typeStructure_ += ":" + std::to_string(valuesOffset);
+  for (size_t i = 0; i < flags_.size(); i++) {
+    typeStructure_ += ";";
+    typeStructure_ += flags_[i].name;
+    typeStructure_ += ":bit:" + std::to_string(valuesOffset * 8 + i);
+  }
+  return typeStructure_.c_str();
+}
+
+}  // namespace dlf::datastream
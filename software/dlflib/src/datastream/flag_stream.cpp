@@ -0,0 +1,40 @@
+#include "dlflib/datastream/flag_stream.h"
+
+#include <string.h>
+
+#include "dlflib/datastream/flag_stream_handle.h"
+
+namespace dlf::datastream {
+
+PolledFlagStream::PolledFlagStream(std::unique_ptr<FlagGroup> flags,
+                                   const char* id,
+                                   std::chrono::microseconds sampleInterval,
+                                   const Options& options)
+    : PolledStream(Encodable(reinterpret_cast<uint8_t*>(&mask_),
+                             flags->maskSize(), flags->typeStructure(false)),
+                   id, sampleInterval, options),
+      flags_(std::move(flags)) {}
+
+EventFlagStream::EventFlagStream(std::unique_ptr<FlagGroup> flags,
+                                 const char* id, const char* notes,
+                                 SemaphoreHandle_t mutex)
+    : EventStream(Encodable(value_, 2 * flags->maskSize(),
+                            flags->typeStructure(true)),
+                  id, notes, mutex),
+      flags_(std::move(flags)) {}
+
+std::unique_ptr<dlf::datastream::AbstractStreamHandle>
+EventFlagStream::createHandle(std::chrono::microseconds tickInterval,
+                              dlf_stream_idx_t idx) {
+  return dlf::util::make_unique<EventFlagStreamHandle>(this, idx);
+}
+
+void EventFlagStream::refresh() {
+  values_ = flags_->read();
+  changes_ = hasLogged_ ? values_ ^ logged_ : flags_->validMask();
+  const size_t size = flags_->maskSize();
+  memcpy(value_, &changes_, size);
+  memcpy(value_ + size, &values_, size);
+}
+
+}  // namespace dlf::datastream
@@ -0,0 +1,82 @@
+#include "dlflib/datastream/message_stream.h"
+
+#include "dlflib/datastream/message_stream_handle.h"
+#include "dlflib/log.h"
+
+namespace dlf::datastream {
+
+namespace {
+
+// Longest message that fits both the limit and the staging buffer, next to
+// its uint16_t length
+size_t messageCapacity(size_t maxSize, size_t bufferSize) {
+  if (maxSize > DLF_MESSAGE_MAX_SIZE) {
+    maxSize = DLF_MESSAGE_MAX_SIZE;
+  }
+  const size_t fits =
+      bufferSize > sizeof(uint16_t) ? bufferSize - sizeof(uint16_t) : 0;
+  return maxSize < fits ? maxSize : fits;
+}
+
+}  // namespace
+
+MessageStream::MessageStream(const char* id, size_t maxSize,
+                             const Options& options)
+    : EventStream(
+          Encodable(nullptr, messageCapacity(maxSize, options.bufferSize),
+                    options.binary ? "uint8_t[]" : "char[]"),
+          id, options.notes),
+      ring_(options.bufferSize),
+      writeMutex_(xSemaphoreCreateMutex()) {
+  if (dataSize() < maxSize) {
+    DLFLIB_LOG_WARNING(
+        "[MessageStream] %s: messages limited to %zu bytes", this->id(),
+        dataSize());
+  }
+  if (!ring_.valid() || writeMutex_ == nullptr) {
+    DLFLIB_LOG_ERROR("[MessageStream] %s: could not allocate buffer",
+                     this->id());
+  }
+}
+
+MessageStream::~MessageStream() {
+  if (writeMutex_ != nullptr) {
+    vSemaphoreDelete(writeMutex_);
+  }
+}
+
+bool MessageStream::write(const void* data, size_t len) {
+  if (!ring_.valid() || writeMutex_ == nullptr ||
+      xSemaphoreTake(writeMutex_, portMAX_DELAY) != pdTRUE) {
+    dropped_++;
+    return false;
+  }
+  if (len > dataSize()) {
+    len = dataSize();
+  }
+
+  const uint16_t len16 = static_cast<uint16_t>(len);
+  const size_t required = sizeof(len16) + len;
+  dlf::util::ByteRing::Spans spans = ring_.reserve(required);
+  const bool fits = spans.size() == required;
+  if (fits) {
+    spans.write(0, &len16, sizeof(len16));
+    spans.write(sizeof(len16), data, len);
+    ring_.commit(required);
+  } else {
+    dropped_++;
+  }
+
+  xSemaphoreGive(writeMutex_);
+  return fits;
+}
+
+std::unique_ptr<dlf::datastream::AbstractStreamHandle>
+MessageStream::createHandle(std::chrono::microseconds tickInterval,
+                            dlf_stream_idx_t idx) {
+  // Messages from before the run have no tick to be logged at
+  ring_.consume(ring_.readable());
+  return dlf::util::make_unique<MessageStreamHandle>(this, idx);
+}
+
+}  // namespace dlf::datastream
@@ -0,0 +1,130 @@
+#include "dlflib/datastream/message_stream_handle.h"
+
+#include "dlflib/format/codec.h"
+#include "dlflib/log.h"
+
+namespace dlf::datastream {
+
+namespace {
+
+// Messages are taken in batches of at most this many record bytes per tick,
+// so that they always fit the LogFile buffer
+constexpr size_t MAX_TICK_BYTES = DLF_LOGFILE_BUFFER_SIZE / 4;
+
+}  // namespace
+
+MessageStreamHandle::MessageStreamHandle(MessageStream* stream,
+                                         dlf_stream_idx_t idx)
+    : EventStreamHandle(stream, idx), messages_(stream) {}
+
+bool MessageStreamHandle::available(dlf_tick_t tick) {
+  pendingCount_ = 0;
+  pendingBytes_ = 0;
+  payloadBytes_ = 0;
+
+  const dlf::util::ByteRing::Spans staged = messages_->staged().peek();
+  size_t recordBytes = 0;
+  while (pendingBytes_ < staged.size()) {
+    uint16_t len;
+    staged.read(pendingBytes_, &len, sizeof(len));
+    const size_t payload = dlf::format::varintSize(len) + len;
+    const size_t record = sizeof(dlf_event_stream_sample_t) + payload;
+    if (pendingCount_ > 0 && recordBytes + record > MAX_TICK_BYTES) {
+      break;
+    }
+    recordBytes += record;
+    pendingCount_++;
+    pendingBytes_ += sizeof(len) + len;
+    payloadBytes_ += payload;
+  }
+  return pendingCount_ > 0;
+}
+
+size_t MessageStreamHandle::encodeInto(dlf::util::ByteRing& buf,
+                                       dlf_tick_t tick) {
+  if (pendingCount_ == 0) {
+    return 0;
+  }
+
+  // As with fixed-size events, the messages stay staged if they do not fit
+  // and are retried on the next tick
+  const size_t required =
+      pendingCount_ * sizeof(dlf_event_stream_sample_t) + payloadBytes_;
+  dlf::util::ByteRing::Spans spans = buf.reserve(required);
+  if (spans.size() < required) {
+    DLFLIB_LOG_WARNING(
+        "[MessageStreamHandle] Buffer full, deferring write for stream %s",
+        stream->id());
+    return 0;
+  }
+
+  writeMessages(spans, 0, false, tick);
+  buf.commit(required);
+  return required;
+}
+
+size_t MessageStreamHandle::groupedRecordSize() const {
+  return pendingCount_ * dlf::format::varintSize(idx) + payloadBytes_;
+}
+
+size_t MessageStreamHandle::encodeGroupedInto(
+    const dlf::util::ByteRing::Spans& spans, size_t offset) {
+  return writeMessages(spans, offset, true, 0);
+}
+
+size_t MessageStreamHandle::encodeValueInto(
+    const dlf::util::ByteRing::Spans& spans, size_t offset) {
+  const uint8_t empty = 0;
+  spans.write(offset, &empty, sizeof(empty));
+  return sizeof(empty);
+}
+
+size_t MessageStreamHandle::writeMessages(
+    const dlf::util::ByteRing::Spans& spans, size_t offset, bool grouped,
+    dlf_tick_t tick) {
+  dlf::util::ByteRing& ring = messages_->staged();
+  const dlf::util::ByteRing::Spans staged = ring.peek();
+  size_t in = 0;
+  size_t out = offset;
+  for (size_t i = 0; i < pendingCount_; i++) {
+    uint16_t len;
+    staged.read(in, &len, sizeof(len));
+    in += sizeof(len);
+
+    if (grouped) {
+      uint8_t idxBytes[3];
+      const size_t n = dlf::format::putVarint(idxBytes, idx);
+      spans.write(out, idxBytes, n);
+      out += n;
+    } else {
+      dlf_event_stream_sample_t h;
+      h.stream = idx;
+      h.sample_tick = tick;
+      spans.write(out, &h, sizeof(h));
+      out += sizeof(h);
+    }
+    uint8_t lenBytes[3];
+    const size_t n = dlf::format::putVarint(lenBytes, len);
+    spans.write(out, lenBytes, n);
+    out += n;
+
+    // Both rings may wrap, so copy through a small buffer
+    uint8_t chunk[64];
+    for (size_t done = 0; done < len;) {
+      const size_t c = len - done < sizeof(chunk) ? len - done : sizeof(chunk);
+      staged.read(in + done, chunk, c);
+      spans.write(out + done, chunk, c);
+      done += c;
+    }
+    in += len;
+    out += len;
+  }
+
+  ring.consume(pendingBytes_);
+  pendingCount_ = 0;
+  pendingBytes_ = 0;
+  payloadBytes_ = 0;
+  return out - offset;
+}
+
+}  // namespace dlf::datastream
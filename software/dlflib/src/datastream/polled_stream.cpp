@@ -1,6 +1,8 @@
 #include "dlflib/datastream/polled_stream.h"
 
 #include "dlflib/datastream/polled_stream_handle.h"
+#include "dlflib/format/codec.h"
+#include "dlflib/log.h"
 
 namespace dlf::datastream {
 
@@ -10,22 +12,73 @@ PolledStream::PolledStream(const Encodable& src, const char* id,
                            SemaphoreHandle_t mutex)
     : AbstractStream(src, id, notes, mutex),
       sampleInterval_(sampleInterval),
-      phase_(phase) {}
+      phase_(phase),
+      codec_(DLF_CODEC_RAW),
+      blockSamples_(0) {}
 
-std::unique_ptr<dlf::datastream::AbstractStreamHandle>
-PolledStream::createHandle(std::chrono::microseconds tickInterval,
-                           dlf_stream_idx_t idx) {
-  dlf_tick_t sampleIntervalTicks = 0;
-  dlf_tick_t samplePhaseTicks = 0;
+PolledStream::PolledStream(const Encodable& src, const char* id,
+                           std::chrono::microseconds sampleInterval,
+                           const Options& options)
+    : AbstractStream(src, id, options.notes, options.mutex),
+      sampleInterval_(sampleInterval),
+      phase_(options.phase),
+      codec_(options.codec),
+      blockSamples_(options.blockSamples),
+      validFlag_(options.validFlag),
+      validIf_(options.validIf) {
+  if (!dlf::format::codecSupports(codec_, src.dataSize)) {
+    DLFLIB_LOG_WARNING(
+        "[PolledStream] Codec %d does not support %s, storing %s raw",
+        (int)codec_, src.typeStructure, this->id());
+    codec_ = DLF_CODEC_RAW;
+  }
+  if (validFlag_ != nullptr || validIf_ != nullptr) {
+    validity_ = options.validity;
+  }
+
+  // Blocks are written to the LogFile buffer in one piece
+  const size_t maxSamples = dlf::format::maxBlockSamples(
+      codec_, src.dataSize,
+      DLF_LOGFILE_BUFFER_SIZE / 2 - sizeof(dlf_codec_block_header_t),
+      validity_);
+  if (blockSamples_ > maxSamples) {
+    blockSamples_ = maxSamples;
+  }
+  if (blockSamples_ == 0) {
+    if (validity_ != DLF_VALIDITY_NONE) {
+      DLFLIB_LOG_WARNING(
+          "[PolledStream] %s has no blocks to record validity in, storing "
+          "every sample",
+          this->id());
+    }
+    codec_ = DLF_CODEC_RAW;
+    validity_ = DLF_VALIDITY_NONE;
+  }
+}
+
+void PolledStream::scheduleTicks(std::chrono::microseconds tickInterval,
+                                 dlf_tick_t& interval,
+                                 dlf_tick_t& phase) const {
+  interval = 0;
+  phase = 0;
 
   // These will throw div/0 if a 0 sample interval (every tick) is given.
   if (sampleInterval_ != std::chrono::microseconds::zero()) {
-    sampleIntervalTicks = max(sampleInterval_ / tickInterval, 1ll);
-    samplePhaseTicks = phase_ / tickInterval;
+    interval = max(sampleInterval_ / tickInterval, 1ll);
+    phase = phase_ / tickInterval;
   }
+}
+
+std::unique_ptr<dlf::datastream::AbstractStreamHandle>
+PolledStream::createHandle(std::chrono::microseconds tickInterval,
+                           dlf_stream_idx_t idx) {
+  dlf_tick_t sampleIntervalTicks;
+  dlf_tick_t samplePhaseTicks;
+  scheduleTicks(tickInterval, sampleIntervalTicks, samplePhaseTicks);
 
   return dlf::util::make_unique<PolledStreamHandle>(
-      this, idx, sampleIntervalTicks, samplePhaseTicks);
+      this, idx, sampleIntervalTicks, samplePhaseTicks, codec_, blockSamples_,
+      validity_);
 }
 
 dlf_stream_type_e PolledStream::type() { return POLLED; }
@@ -7,11 +7,21 @@ namespace dlf::datastream {
 PolledStreamHandle::PolledStreamHandle(PolledStream* stream,
                                        dlf_stream_idx_t idx,
                                        dlf_tick_t sampleIntervalTicks,
-                                       dlf_tick_t samplePhase)
+                                       dlf_tick_t samplePhase,
+                                       dlf_codec_e codec,
+                                       uint16_t blockSamples,
+                                       dlf_validity_e validity)
     : AbstractStreamHandle(stream, idx),
       sampleIntervalTicks_(sampleIntervalTicks),
       samplePhaseTicks_(samplePhase),
-      dataBuffer_(stream->dataSize()) {}
+      codec_(codec),
+      blockSamples_(blockSamples),
+      validity_(validity) {
+  if (codec_ != DLF_CODEC_RAW || validity_ != DLF_VALIDITY_NONE) {
+    encoder_ = dlf::util::make_unique<dlf::format::BlockEncoder>(
+        codec_, stream->dataSize(), blockSamples_, validity_);
+  }
+}
 
 // This called every tick to determine whether we need to write new data
 bool PolledStreamHandle::available(dlf_tick_t tick) {
@@ -19,7 +29,67 @@ bool PolledStreamHandle::available(dlf_tick_t tick) {
          ((tick + samplePhaseTicks_) % sampleIntervalTicks_) == 0;
 }
 
-size_t PolledStreamHandle::encodeHeaderInto(StreamBufferHandle_t buf) {
+uint32_t PolledStreamHandle::logfileFlags() const {
+  uint32_t flags = encoder_ ? DLF_LOGFILE_FLAG_STREAM_CODECS : 0;
+  if (validity_ != DLF_VALIDITY_NONE) {
+    flags |= DLF_LOGFILE_FLAG_VALIDITY;
+  }
+  if (encoder_ && !columnar_) {
+    flags |= DLF_LOGFILE_FLAG_BLOCK_CUTS;
+  }
+  return flags;
+}
+
+size_t PolledStreamHandle::pendingSamples() const {
+  return encoder_ && !columnar_ ? encoder_->count() : 0;
+}
+
+size_t PolledStreamHandle::cutBlock(dlf::util::ByteRing& buf) {
+  return pendingSamples() > 0 ? writeBlock(buf) : 0;
+}
+
+size_t PolledStreamHandle::maxColumnBytes(dlf_tick_t blockTicks) const {
+  // A block can start on a sample tick, so it may hold one sample more than
+  // blockTicks / interval
+  const size_t samples = sampleIntervalTicks_ == 0
+                             ? blockTicks
+                             : blockTicks / sampleIntervalTicks_ + 1;
+  return dlf::format::maxBlockBytes(codec_, stream->dataSize(), samples,
+                                    validity_);
+}
+
+void PolledStreamHandle::setColumnar(dlf_tick_t blockTicks) {
+  columnar_ = true;
+  const size_t samples = sampleIntervalTicks_ == 0
+                             ? blockTicks
+                             : blockTicks / sampleIntervalTicks_ + 1;
+  if (encoder_) {
+    // The whole column is one codec block
+    encoder_ = dlf::util::make_unique<dlf::format::BlockEncoder>(
+        codec_, stream->dataSize(), samples, validity_);
+  } else {
+    column_.resize(samples * stream->dataSize());
+  }
+  resetColumn();
+}
+
+const uint8_t* PolledStreamHandle::finishColumn(size_t& len) {
+  if (encoder_) {
+    return encoder_->finish(len);
+  }
+  len = columnLen_;
+  return column_.data();
+}
+
+void PolledStreamHandle::resetColumn() {
+  if (encoder_) {
+    encoder_->reset();
+  }
+  columnLen_ = 0;
+}
+
+size_t PolledStreamHandle::encodeHeaderInto(dlf::util::ByteRing& buf,
+                                            uint32_t fileFlags) {
 #ifdef DEBUG
   DLFLIB_LOG_DEBUG(
       "[PolledStreamHandle] Encode polled header:\n"
@@ -33,18 +103,31 @@ size_t PolledStreamHandle::encodeHeaderInto(StreamBufferHandle_t buf) {
       stream->notes(), sampleIntervalTicks_, samplePhaseTicks_);
 #endif
 
-  AbstractStreamHandle::encodeHeaderInto(buf);
+  size_t written = AbstractStreamHandle::encodeHeaderInto(buf, fileFlags);
 
   dlf_polled_stream_header_segment_t h{
       sampleIntervalTicks_,
       samplePhaseTicks_,
   };
+  written += send(buf, h);
 
-  return send(buf, h);
+  if (fileFlags & DLF_LOGFILE_FLAG_STREAM_CODECS) {
+    // In the columnar layout each column is a block of its own
+    dlf_polled_stream_codec_segment_t c{
+        codec_,
+        columnar_ ? uint16_t(0) : blockSamples_,
+    };
+    written += send(buf, c);
+  }
+  if (fileFlags & DLF_LOGFILE_FLAG_VALIDITY) {
+    dlf_polled_stream_validity_segment_t v{validity_};
+    written += send(buf, v);
+  }
+  return written;
 }
 
-size_t PolledStreamHandle::encodeInto(StreamBufferHandle_t buf,
-                                      dlf_tick_t tick) {
+size_t PolledStreamHandle::encodeInto(dlf::util::ByteRing& buf,
+                                      dlf_tick_t /*tick*/) {
 #ifdef DEBUG
   DLFLIB_LOG_DEBUG(
       "[PolledStreamHandle] Encode polled data:\n"
@@ -52,6 +135,61 @@ size_t PolledStreamHandle::encodeInto(StreamBufferHandle_t buf,
       stream->id());
 #endif
 
+  if (columnar_) {
+    // The LogFile writes the column once the block is complete
+    const size_t size = stream->dataSize();
+    if (stream->mutex() &&
+        xSemaphoreTake(stream->mutex(), portMAX_DELAY) != pdTRUE) {
+      DLFLIB_LOG_ERROR(
+          "[PolledStreamHandle] Failed to acquire mutex for stream %s",
+          stream->id());
+      return 0;
+    }
+    stream->refresh();
+    if (encoder_) {
+      if (!encoder_->full()) {
+        encoder_->add(stream->dataSource(), valid());
+      }
+    } else if (columnLen_ + size <= column_.size()) {
+      memcpy(&column_[columnLen_], stream->dataSource(), size);
+      columnLen_ += size;
+    }
+    if (stream->mutex()) {
+      xSemaphoreGive(stream->mutex());
+    }
+    return 0;
+  }
+
+  if (encoder_) {
+    // Coded samples go into the open block. The block reaches the file in one
+    // piece once full, which keeps the layout deterministic for readers.
+    if (stream->mutex() &&
+        xSemaphoreTake(stream->mutex(), portMAX_DELAY) != pdTRUE) {
+      DLFLIB_LOG_ERROR(
+          "[PolledStreamHandle] Failed to acquire mutex for stream %s",
+          stream->id());
+      return 0;
+    }
+    stream->refresh();
+    encoder_->add(stream->dataSource(), valid());
+    if (stream->mutex()) {
+      xSemaphoreGive(stream->mutex());
+    }
+    return encoder_->full() ? writeBlock(buf) : 0;
+  }
+
+  // Polled samples (unlike event samples) carry no per-sample framing, and thus
+  // decoding relies entirely on every sample being written in full, in order.
+  // A partial write would permanently desync byte alignment for every sample
+  // downstream. So this must block until the full sample can be reserved.
+  const size_t size = stream->dataSize();
+  if (!waitForSpace(buf, size)) {
+    DLFLIB_LOG_ERROR("[PolledStreamHandle] Sample of %s larger than buffer",
+                     stream->id());
+    return 0;
+  }
+  dlf::util::ByteRing::Spans spans = buf.reserve(size);
+
   if (stream->mutex()) {
     if (xSemaphoreTake(stream->mutex(), portMAX_DELAY) != pdTRUE) {
       DLFLIB_LOG_ERROR(
@@ -61,22 +199,51 @@ size_t PolledStreamHandle::encodeInto(StreamBufferHandle_t buf,
     }
   }
 
-  // Before calling xStreamBufferSend, copy the data out under the mutex
-  // so we don't hold the mutex for longer than necessary.
-  memcpy(dataBuffer_.data(), stream->dataSource(), dataBuffer_.size());
+  // Copy straight from the source into the reserved space. Space is reserved
+  // before taking the mutex so that it is never held while waiting on the SD
+  // card.
+  stream->refresh();
+  spans.write(0, stream->dataSource(), size);
 
   if (stream->mutex()) {
     xSemaphoreGive(stream->mutex());
   }
 
-  // Polled samples (unlike event samples) carry no per-sample framing, and thus
-  // decoding relies entirely on every sample being written in full, in order.
-  // xStreamBufferSend with a timeout of 0 can silently perform a partial write
-  // when the buffer is nearly full, which would permanently desync byte
-  // alignment for every sample downstream. So this must block until the full
-  // sample can be written.
-  return xStreamBufferSend(buf, dataBuffer_.data(), dataBuffer_.size(),
-                           portMAX_DELAY);
+  buf.commit(size);
+  return size;
+}
+
+bool PolledStreamHandle::valid() const {
+  return static_cast<PolledStream*>(stream)->valid();
+}
+
+size_t PolledStreamHandle::encodeTrailerInto(dlf::util::ByteRing& buf) {
+  // Columns are finished by the LogFile
+  return cutBlock(buf);
+}
+
+size_t PolledStreamHandle::writeBlock(dlf::util::ByteRing& buf) {
+  size_t payloadBytes;
+  const uint8_t* payload = encoder_->finish(payloadBytes);
+  dlf_codec_block_header_t h;
+  h.sample_count = encoder_->count();
+  h.payload_bytes = payloadBytes;
+
+  // Like raw samples, a block must never be written partially
+  const size_t size = sizeof(h) + payloadBytes;
+  if (!waitForSpace(buf, size)) {
+    DLFLIB_LOG_ERROR("[PolledStreamHandle] Block of %s larger than buffer",
+                     stream->id());
+    encoder_->reset();
+    return 0;
+  }
+  dlf::util::ByteRing::Spans spans = buf.reserve(size);
+  spans.write(0, &h, sizeof(h));
+  spans.write(sizeof(h), payload, payloadBytes);
+  buf.commit(size);
+
+  encoder_->reset();
+  return size;
 }
 
 }  // namespace dlf::datastream
\ No newline at end of file
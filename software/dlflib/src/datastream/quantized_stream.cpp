@@ -0,0 +1,14 @@
+#include "dlflib/datastream/quantized_stream.h"
+
+namespace dlf::datastream {
+
+QuantizedStream::QuantizedStream(std::unique_ptr<Quantizer> quantizer,
+                                 const char* id,
+                                 std::chrono::microseconds sampleInterval,
+                                 const Options& options)
+    : PolledStream(Encodable(quantizer->data(), quantizer->size(),
+                             quantizer->typeStructure()),
+                   id, sampleInterval, options),
+      quantizer_(std::move(quantizer)) {}
+
+}  // namespace dlf::datastream
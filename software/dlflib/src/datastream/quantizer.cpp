@@ -0,0 +1,81 @@
+#include "dlflib/datastream/quantizer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace dlf::datastream {
+
+namespace {
+
+// Shortest of %.15g and %.17g that reads back as `value`
+std::string formatNumber(double value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.15g", value);
+  if (strtod(buf, nullptr) != value) {
+    snprintf(buf, sizeof(buf), "%.17g", value);
+  }
+  return buf;
+}
+
+}  // namespace
+
+Quantizer::Quantizer(const volatile double& value,
+                     const Quantization& quantization)
+    : double_(&value), quantization_(quantization) {
+  describe();
+}
+
+Quantizer::Quantizer(const volatile float& value,
+                     const Quantization& quantization)
+    : float_(&value), quantization_(quantization) {
+  describe();
+}
+
+bool Quantizer::isValid(const Quantization& quantization) {
+  return isfinite(quantization.scale) && quantization.scale != 0 &&
+         isfinite(quantization.offset);
+}
+
+int32_t Quantizer::quantize(double value, const Quantization& quantization) {
+  const double counts =
+      round((value - quantization.offset) / quantization.scale);
+  const double min = quantization.storage == Quantization::INT16
+                         ? INT16_MIN
+                         : static_cast<double>(INT32_MIN);
+  const double max = quantization.storage == Quantization::INT16
+                         ? INT16_MAX
+                         : static_cast<double>(INT32_MAX);
+  if (isnan(counts)) {
+    return 0;
+  }
+  if (counts <= min) {
+    return static_cast<int32_t>(min);
+  }
+  if (counts >= max) {
+    return static_cast<int32_t>(max);
+  }
+  return static_cast<int32_t>(counts);
+}
+
+void Quantizer::sample() {
+  const double value = double_ != nullptr ? *double_ : *float_;
+  const int32_t counts = quantize(value, quantization_);
+  if (quantization_.storage == Quantization::INT16) {
+    const int16_t narrow = static_cast<int16_t>(counts);
+    memcpy(raw_, &narrow, sizeof(narrow));
+  } else {
+    memcpy(raw_, &counts, sizeof(counts));
+  }
+}
+
+void Quantizer::describe() {
+  typeStructure_ = "Quantized;value:";
+  typeStructure_ +=
+      quantization_.storage == Quantization::INT16 ? "int16_t" : "int32_t";
+  typeStructure_ += ":0:" + formatNumber(quantization_.scale) + ":" +
+                    formatNumber(quantization_.offset);
+}
+
+}  // namespace dlf::datastream
@@ -0,0 +1,168 @@
+#include "dlflib/datastream/transform.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "dlflib/dlf_cfg.h"
+
+namespace dlf::datastream {
+
+Transform& Transform::scale(double factor, double offset) {
+  Stage s;
+  s.kind = SCALE;
+  s.a = factor;
+  s.b = offset;
+  if (!isfinite(factor) || !isfinite(offset)) {
+    valid_ = false;
+    return *this;
+  }
+  return add(s);
+}
+
+Transform& Transform::movingAverage(uint16_t window) {
+  Stage s;
+  s.kind = MOVING_AVERAGE;
+  s.n = window;
+  if (window == 0 || window > DLF_TRANSFORM_MAX_WINDOW) {
+    valid_ = false;
+    return *this;
+  }
+  s.window.resize(window);
+  return add(s);
+}
+
+Transform& Transform::lowPass(double alpha) {
+  Stage s;
+  s.kind = LOW_PASS;
+  s.a = alpha;
+  if (!(alpha > 0 && alpha <= 1)) {
+    valid_ = false;
+    return *this;
+  }
+  return add(s);
+}
+
+Transform& Transform::difference() {
+  Stage s;
+  s.kind = DIFFERENCE;
+  return add(s);
+}
+
+Transform& Transform::decimate(uint16_t factor) {
+  Stage s;
+  s.kind = DECIMATE;
+  s.n = decimation() * factor;
+  if (factor == 0 || s.n > UINT16_MAX) {
+    valid_ = false;
+    return *this;
+  }
+  return add(s);
+}
+
+Transform& Transform::add(const Stage& stage) {
+  if (stages_.size() >= MAX_STAGES) {
+    valid_ = false;
+    return *this;
+  }
+  stages_.push_back(stage);
+  return *this;
+}
+
+uint32_t Transform::decimation() const {
+  for (size_t i = stages_.size(); i-- > 0;) {
+    if (stages_[i].kind == DECIMATE) {
+      return stages_[i].n;
+    }
+  }
+  return 1;
+}
+
+bool Transform::apply(double& value, uint64_t index) {
+  for (Stage& s : stages_) {
+    switch (s.kind) {
+      case SCALE:
+        value = value * s.a + s.b;
+        break;
+      case MOVING_AVERAGE:
+        if (s.seen == s.n) {
+          s.sum -= s.window[s.pos];
+        } else {
+          s.seen++;
+        }
+        s.window[s.pos] = value;
+        s.sum += value;
+        s.pos = (s.pos + 1) % s.n;
+        if (s.pos == 0) {
+          // Start each lap of the window from an exact sum, so that rounding
+          // errors do not build up over a run
+          s.sum = 0;
+          for (double v : s.window) {
+            s.sum += v;
+          }
+        }
+        value = s.sum / s.seen;
+        break;
+      case LOW_PASS:
+        s.last = s.seen == 0 ? value : s.last + s.a * (value - s.last);
+        s.seen = 1;
+        value = s.last;
+        break;
+      case DIFFERENCE: {
+        const double prev = s.seen == 0 ? value : s.last;
+        s.last = value;
+        s.seen = 1;
+        value -= prev;
+        break;
+      }
+      case DECIMATE:
+        if (index % s.n != 0) {
+          return false;
+        }
+        break;
+    }
+  }
+  return true;
+}
+
+void Transform::reset() {
+  for (Stage& s : stages_) {
+    s.last = 0;
+    s.sum = 0;
+    s.seen = 0;
+    s.pos = 0;
+  }
+}
+
+std::string Transform::describe() const {
+  std::string out;
+  uint32_t decimation = 1;
+  char buf[48];
+  for (const Stage& s : stages_) {
+    switch (s.kind) {
+      case SCALE:
+        snprintf(buf, sizeof(buf), "scale(%g,%g)", s.a, s.b);
+        break;
+      case MOVING_AVERAGE:
+        snprintf(buf, sizeof(buf), "movingAverage(%u)", (unsigned)s.n);
+        break;
+      case LOW_PASS:
+        snprintf(buf, sizeof(buf), "lowPass(%g)", s.a);
+        break;
+      case DIFFERENCE:
+        snprintf(buf, sizeof(buf), "difference");
+        break;
+      case DECIMATE:
+        snprintf(buf, sizeof(buf), "decimate(%u)",
+                 (unsigned)(s.n / decimation));
+        decimation = s.n;
+        break;
+    }
+    if (!out.empty()) {
+      out += " > ";
+    }
+    out += buf;
+  }
+  return out;
+}
+
+}  // namespace dlf::datastream
@@ -0,0 +1,76 @@
+#include "dlflib/datastream/transformed_stream.h"
+
+#include <string.h>
+
+#include <string>
+
+#include "dlflib/datastream/transformed_stream_handle.h"
+#include "dlflib/log.h"
+
+namespace dlf::datastream {
+
+TransformedStream::TransformedStream(const volatile void* source, Reader read,
+                                     bool wide, const Transform& transform,
+                                     const char* id,
+                                     std::chrono::microseconds sampleInterval,
+                                     const Options& options)
+    : PolledStream(Encodable(value_, wide ? sizeof(double) : sizeof(float),
+                             wide ? "double" : "float"),
+                   id, sampleInterval, options),
+      source_(source),
+      read_(read),
+      wide_(wide),
+      transform_(transform) {
+  // "<notes>; transform: movingAverage(10) > decimate(10)"
+  std::string notes;
+  if (options.notes != nullptr && options.notes[0] != '\0') {
+    notes = options.notes;
+    notes += "; ";
+  }
+  notes += "transform: " + transform_.describe();
+  setNotes(notes.c_str());
+}
+
+std::unique_ptr<dlf::datastream::AbstractStreamHandle>
+TransformedStream::createHandle(std::chrono::microseconds tickInterval,
+                                dlf_stream_idx_t idx) {
+  dlf_tick_t inputInterval;
+  dlf_tick_t phase;
+  scheduleTicks(tickInterval, inputInterval, phase);
+
+  // Decimation keeps the samples whose index is a multiple of it, i.e. those
+  // due on an interval that many times as long
+  dlf_tick_t outputInterval = inputInterval;
+  if (transform_.decimation() > 1) {
+    outputInterval =
+        (inputInterval == 0 ? 1 : inputInterval) * transform_.decimation();
+  }
+
+  return dlf::util::make_unique<TransformedStreamHandle>(
+      this, idx, inputInterval, phase, outputInterval, codec(),
+      blockSamples(), validity());
+}
+
+bool TransformedStream::read(double& value) {
+  if (mutex() && xSemaphoreTake(mutex(), portMAX_DELAY) != pdTRUE) {
+    DLFLIB_LOG_ERROR(
+        "[TransformedStream] Failed to acquire mutex for stream %s", id());
+    return false;
+  }
+  value = read_(source_);
+  if (mutex()) {
+    xSemaphoreGive(mutex());
+  }
+  return true;
+}
+
+void TransformedStream::store(double value) {
+  if (wide_) {
+    memcpy(value_, &value, sizeof(value));
+  } else {
+    const float narrow = static_cast<float>(value);
+    memcpy(value_, &narrow, sizeof(narrow));
+  }
+}
+
+}  // namespace dlf::datastream
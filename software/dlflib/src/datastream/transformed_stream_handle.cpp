@@ -0,0 +1,32 @@
+#include "dlflib/datastream/transformed_stream_handle.h"
+
+namespace dlf::datastream {
+
+TransformedStreamHandle::TransformedStreamHandle(
+    TransformedStream* stream, dlf_stream_idx_t idx,
+    dlf_tick_t inputIntervalTicks, dlf_tick_t phaseTicks,
+    dlf_tick_t outputIntervalTicks, dlf_codec_e codec, uint16_t blockSamples,
+    dlf_validity_e validity)
+    : PolledStreamHandle(stream, idx, outputIntervalTicks, phaseTicks, codec,
+                         blockSamples, validity),
+      transformed_(stream),
+      inputIntervalTicks_(inputIntervalTicks == 0 ? 1 : inputIntervalTicks),
+      phaseTicks_(phaseTicks),
+      transform_(stream->transform()) {
+  transform_.reset();
+}
+
+bool TransformedStreamHandle::available(dlf_tick_t tick) {
+  if ((tick + phaseTicks_) % inputIntervalTicks_ != 0) {
+    return false;
+  }
+  double value;
+  if (!transformed_->read(value) ||
+      !transform_.apply(value, (tick + phaseTicks_) / inputIntervalTicks_)) {
+    return false;
+  }
+  transformed_->store(value);
+  return true;
+}
+
+}  // namespace dlf::datastream
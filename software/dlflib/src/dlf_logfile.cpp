@@ -1,9 +1,15 @@
 #include "dlflib/dlf_logfile.h"
 
 #include "dlflib/datastream/event_stream.h"
+#include "dlflib/datastream/event_stream_handle.h"
 #include "dlflib/datastream/polled_stream.h"
+#include "dlflib/datastream/polled_stream_handle.h"
 #include "dlflib/dlf_cfg.h"
+#include "dlflib/format/codec.h"
+#include "dlflib/format/frames.h"
 #include "dlflib/log.h"
+#include "dlflib/storage/file_sink.h"
+#include "dlflib/storage/raw_sector_sink.h"
 #include "dlflib/util/util.h"
 #include "dlflib/util/uuid.h"
 
@@ -11,7 +17,7 @@ namespace dlf {
 
 /**
  * @brief Task responsible for writing data to SD
- * Constantly receives data from stream_ streambuffer and writes to SD.
+ * Constantly takes committed data from the ring_ and writes it to SD.
  * @param arg
  */
 void LogFile::taskFlusher(void* arg) {
@@ -20,16 +26,35 @@ void LogFile::taskFlusher(void* arg) {
   DLFLIB_LOG_INFO("[LogFile][taskFlusher] Task started for %s",
                   self->filename_);
 
-  uint8_t buf[DLF_SD_BLOCK_WRITE_SIZE];
   size_t totalBytesWritten = 0;
   const uint32_t SYNC_INTERVAL_MS = 60000;
   const size_t SYNC_THRESHOLD_BYTES = 4096;
   uint32_t lastSyncTime = millis();
   size_t bytesSinceLastSync = 0;
+  uint32_t rateWindowStart = millis();
+  size_t rateWindowBytes = 0;
+  bool starved = false;
 
   while (self->state_ == LOGGING) {
-    size_t received = xStreamBufferReceive(self->stream_, buf, sizeof(buf),
-                                           pdMS_TO_TICKS(1000));
+    // The sampler notifies once a block's worth of data is ready. The timeout
+    // makes sure stragglers are written even when data trickles in. A
+    // compressed file may also hold data back until a frame fills up.
+    bool idle = false;
+    if (starved || self->ring_.readable() < DLF_SD_BLOCK_WRITE_SIZE) {
+      idle = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000)) == 0;
+    }
+    dlf::util::ByteRing::Spans spans = self->ring_.peek();
+    size_t received = spans.size();
+
+    // Throughput is sampled over ~1s windows. This runs even when nothing was
+    // received so that the rate decays to 0 when the writer goes idle.
+    uint32_t now = millis();
+    if (now - rateWindowStart >= 1000) {
+      self->stats_.bytesPerSecond = static_cast<uint32_t>(
+          rateWindowBytes * 1000 / (now - rateWindowStart));
+      rateWindowStart = now;
+      rateWindowBytes = 0;
+    }
 
     if (received > 0) {
 #ifdef DEBUG
@@ -40,53 +65,49 @@ void LogFile::taskFlusher(void* arg) {
 
       // Lock file mutex before writing
       if (xSemaphoreTake(self->fileMutex_, portMAX_DELAY) == pdTRUE) {
-        self->file_.write(buf, received);
-        totalBytesWritten += received;
-        bytesSinceLastSync += received;
-
-        // Track the file end position for proper close
-        self->fileEndPosition_ = totalBytesWritten;
-
-        // Force SD card sync after 60 seconds or 4KB written
-        // .flush() commits data the SD card
-        // only on .close() will directory entry be updated (e.g. 9MB to 10MB)
-        if ((bytesSinceLastSync >= SYNC_THRESHOLD_BYTES ||
-             (millis() - lastSyncTime) >= SYNC_INTERVAL_MS) &&
-            bytesSinceLastSync > 0) {
-          DLFLIB_LOG_INFO(
-              "[LogFile][taskFlusher] %s: Forcing SD sync (close/reopen)...",
-              self->filename_);
-
-          self->file_.flush();
-          self->file_.close();
-
-          // Reopen file in read/write mode to update the header
-          // IMPORTANT: we use "r+" (read/write) mode instead of "a" (append)
-          // here because any write in append mode will always go to end of file
-          // regardless of any seeks.
-          self->file_ = self->fs_.open(self->filename_, "r+");
-          if (!self->file_) {
-            DLFLIB_LOG_ERROR(
-                "[LogFile][taskFlusher] ERROR: Could not reopen file after "
-                "sync!");
+        const size_t fileBytesBefore = self->fileBytes_;
+        const size_t consumed = self->writeData(spans, idle);
+        const size_t written = self->fileBytes_ - fileBytesBefore;
+        starved = consumed == 0;
+        totalBytesWritten += consumed;
+
+        if (written > 0) {
+          bytesSinceLastSync += written;
+          rateWindowBytes += written;
+          self->stats_.bytesWritten = self->fileBytes_;
+
+          // Track the file end position for proper close
+          self->fileEndPosition_ = self->fileBytes_;
+          self->writeIndexEntries();
+
+          uint32_t commitStart = micros();
+
+          // Force SD card sync after 60 seconds or 4KB written
+          if ((bytesSinceLastSync >= SYNC_THRESHOLD_BYTES ||
+               (millis() - lastSyncTime) >= SYNC_INTERVAL_MS) &&
+              bytesSinceLastSync > 0) {
+            DLFLIB_LOG_INFO("[LogFile][taskFlusher] %s: Forcing SD sync...",
+                            self->filename_);
+            self->syncSink();
+            if (self->indexSink_) {
+              self->indexSink_->sync();
+            }
+            lastSyncTime = millis();
+            bytesSinceLastSync = 0;
           } else {
-            self->file_.seek(0, SeekEnd);
-            DLFLIB_LOG_INFO(
-                "[LogFile][taskFlusher] %s: SD sync complete, file reopened",
-                self->filename_);
+            // Regular flush (may not reach SD card)
+            self->sink_->flush();
+            if (self->indexSink_) {
+              self->indexSink_->flush();
+            }
           }
-
-          lastSyncTime = millis();
-          bytesSinceLastSync = 0;
-        } else {
-          // Regular flush (may not reach SD card)
-          self->file_.flush();
+          self->stats_.commitLatency.record(micros() - commitStart);
         }
 
 #ifdef DEBUG
         DLFLIB_LOG_DEBUG(
             "[LogFile][taskFlusher] %s: Wrote %zu bytes, total: %zu",
-            self->filename_, received, totalBytesWritten);
+            self->filename_, written, self->fileBytes_);
 #endif
 
         xSemaphoreGive(self->fileMutex_);
@@ -95,63 +116,71 @@ void LogFile::taskFlusher(void* arg) {
                          self->filename_);
       }
     }
+
+    // Complete a latched commit once everything up to it has been written
+    if (self->commitLatchedSeq_ != self->commitDoneSeq_ &&
+        totalBytesWritten >= self->commitTargetBytes_) {
+      if (xSemaphoreTake(self->fileMutex_, portMAX_DELAY) == pdTRUE) {
+        self->completeCommit();
+        lastSyncTime = millis();
+        bytesSinceLastSync = 0;
+        xSemaphoreGive(self->fileMutex_);
+      }
+    }
   }
 
   DLFLIB_LOG_INFO(
       "[LogFile][taskFlusher] No longer in LOGGING state. Current state: %x",
       self->state_);
 
-  // If no need to flush, exit immediately
+  // The sampler stopped on an error, so nothing more is queued. Sync what was
+  // written, which close() then cuts the file back to.
   if (self->state_ != FLUSHING) {
     DLFLIB_LOG_INFO(
-        "[LogFile][taskFlusher] No need to flush. Terminating task.");
+        "[LogFile][taskFlusher] Stopped by an error. Syncing written data...");
+    if (xSemaphoreTake(self->fileMutex_, portMAX_DELAY) == pdTRUE) {
+      self->syncSink();
+      if (self->indexSink_) {
+        self->indexSink_->sync();
+      }
+      xSemaphoreGive(self->fileMutex_);
+    }
+    xSemaphoreGive(self->syncSemaphore_);
     vTaskDelete(NULL);
     return;
   }
 
   DLFLIB_LOG_INFO("[LogFile][taskFlusher] Flushing remaining bytes...");
   // Flush remaining bytes
-  while (xStreamBufferBytesAvailable(self->stream_) > 0 &&
-         self->state_ == FLUSHING) {
-    size_t received = xStreamBufferReceive(self->stream_, buf, sizeof(buf), 0);
+  while (self->ring_.readable() > 0 && self->state_ == FLUSHING) {
+    dlf::util::ByteRing::Spans spans = self->ring_.peek();
+    size_t received = spans.size();
 
     if (received > 0) {
       // Lock file mutex before writing
       if (xSemaphoreTake(self->fileMutex_, portMAX_DELAY) == pdTRUE) {
-        self->file_.write(buf, received);
-        totalBytesWritten += received;
-        self->fileEndPosition_ = totalBytesWritten;
+        totalBytesWritten += self->writeData(spans, true);
+        self->stats_.bytesWritten = self->fileBytes_;
+        self->fileEndPosition_ = self->fileBytes_;
+        self->writeIndexEntries();
         xSemaphoreGive(self->fileMutex_);
       }
     }
   }
 
-  // CRITICAL: Final SD sync - close and reopen to force all remaining data to
-  // SD card This must happen BEFORE we signal completion so closeFile doesn't
-  // run yet
+  // CRITICAL: Final SD sync - force all remaining data to SD card. This must
+  // happen BEFORE we signal completion so closeFile doesn't run yet
   if (xSemaphoreTake(self->fileMutex_, portMAX_DELAY) == pdTRUE) {
     DLFLIB_LOG_INFO("[LogFile][taskFlusher] Performing final SD sync...");
 
-    self->file_.flush();
-    self->file_.close();
-
-    self->file_ = self->fs_.open(self->filename_, "r+");
-    if (self->file_) {
-      // Seek to end so we know where data ends
-      self->file_.seek(0, SeekEnd);
-      size_t actualFileSize = self->file_.position();
-      DLFLIB_LOG_INFO(
-          "[LogFile][taskFlusher] Final SD sync complete. Actual file size: "
-          "%zu bytes",
-          actualFileSize);
-      self->file_.close();
-    } else {
-      DLFLIB_LOG_ERROR(
-          "[LogFile][taskFlusher] ERROR: Could not reopen file for final sync "
-          "verification!");
+    uint32_t commitStart = micros();
+    self->syncSink();
+    if (self->indexSink_) {
+      self->indexSink_->sync();
     }
+    self->stats_.commitLatency.record(micros() - commitStart);
 
-    self->fileEndPosition_ = totalBytesWritten;
+    self->fileEndPosition_ = self->fileBytes_;
     DLFLIB_LOG_INFO(
         "[LogFile][taskFlusher] Final flush complete. Total bytes written: "
         "%zu, file end "
@@ -170,18 +199,86 @@ void LogFile::taskFlusher(void* arg) {
 
 LogFile::LogFile(
     std::vector<std::unique_ptr<dlf::datastream::AbstractStreamHandle>> handles,
-    dlf_stream_type_e streamType, const char* dir, fs::FS& fs)
-    : fs_(fs), handles_(std::move(handles)), fileEndPosition_(0) {
-  const char* st = dlf::datastream::streamTypeToString(streamType);
-  snprintf(filename_, sizeof(filename_), "%s/%s.dlf", dir, st ? st : "unknown");
+    dlf_stream_type_e streamType, const char* dir, fs::FS& fs,
+    const Options& options)
+    : fs_(fs),
+      streamType_(streamType),
+      handles_(std::move(handles)),
+      lastTick_(0),
+      fileEndPosition_(0),
+      bytesQueued_(0),
+      checkpointIntervalTicks_(options.checkpointIntervalTicks),
+      compactEvents_(options.compactEvents && streamType == EVENT),
+      indexIntervalTicks_(streamType == EVENT ? options.indexIntervalTicks
+                                              : 0),
+      ring_(DLF_LOGFILE_BUFFER_SIZE) {
+  const char* name = options.name != nullptr
+                         ? options.name
+                         : dlf::datastream::streamTypeToString(streamType);
+  snprintf(filename_, sizeof(filename_), "%s/%s.dlf", dir, name);
 
   // Set up class internals
-  stream_ =
-      xStreamBufferCreate(DLF_LOGFILE_BUFFER_SIZE, DLF_SD_BLOCK_WRITE_SIZE);
-  if (stream_ == nullptr) {
+  if (!ring_.valid()) {
     state_ = STREAM_CREATE_ERROR;
     return;
   }
+  stats_.bufferCapacity = ring_.capacity();
+
+  if (compactEvents_) {
+    groupDue_.resize(handles_.size());
+  }
+
+  if (streamType == POLLED && options.columnBlockTicks > 0) {
+    // Blocks are written to the ring in one piece
+    dlf_tick_t blockTicks = options.columnBlockTicks;
+    while (blockTicks > 1 &&
+           maxColumnBlockBytes(blockTicks) > ring_.capacity() / 2) {
+      blockTicks /= 2;
+    }
+    if (blockTicks < options.columnBlockTicks) {
+      DLFLIB_LOG_WARNING(
+          "[LogFile] %s: column blocks limited to %llu ticks by the buffer",
+          filename_, blockTicks);
+    }
+    for (auto& h : handles_) {
+      static_cast<dlf::datastream::PolledStreamHandle*>(h.get())->setColumnar(
+          blockTicks);
+    }
+    columnBlockTicks_ = blockTicks;
+    columnData_.resize(handles_.size());
+    columnLens_.resize(handles_.size());
+  }
+
+  if (streamType == EVENT && options.keyframeIntervalTicks > 0) {
+    for (auto& h : handles_) {
+      keyframeBytes_ +=
+          static_cast<dlf::datastream::EventStreamHandle*>(h.get())
+              ->valueSize();
+    }
+    // A keyframe is reserved in one piece, so it has to fit in the ring
+    if (MAX_EMPTY_GROUP_BYTES + sizeof(dlf_keyframe_t) + keyframeBytes_ <=
+        ring_.capacity()) {
+      keyframeIntervalTicks_ = options.keyframeIntervalTicks;
+    } else {
+      DLFLIB_LOG_WARNING(
+          "[LogFile] %s: keyframes of %zu bytes do not fit the buffer, "
+          "skipping them",
+          filename_, keyframeBytes_);
+    }
+  }
+
+  timeAnchors_ = streamType == EVENT && options.timeAnchors;
+
+  if (options.compressBlocks) {
+    compressor_ = dlf::util::make_unique<dlf::format::Lz4Compressor>();
+  }
+  if (options.compressBlocks || options.blockCrc) {
+    framed_ = true;
+    blockCrc_ = options.blockCrc;
+    frameRaw_.resize(DLF_FRAME_RAW_BYTES);
+    frameOut_.resize(dlf::format::maxFrameBytes(DLF_FRAME_RAW_BYTES) +
+                     dlf::format::FRAME_CRC_BYTES);
+  }
 
   syncSemaphore_ = xSemaphoreCreateCounting(1, 0);
   if (syncSemaphore_ == nullptr) {
@@ -195,11 +292,57 @@ LogFile::LogFile(
     return;
   }
 
-  // Open logfile
-  file_ = fs_.open(filename_, "w", true);
-  if (!file_) {
-    state_ = FILE_OPEN_ERROR;
-    return;
+  // Open logfile. The raw sector path is an optimization only, so fall back
+  // to the filesystem if the volume cannot provide a contiguous extent.
+  if (options.container != nullptr && streamType != RAW) {
+    sink_ = dlf::util::make_unique<dlf::storage::ContainerSink>(
+        *options.container,
+        streamType == POLLED ? DLF_SECTION_POLLED : DLF_SECTION_EVENT);
+    if (!sink_->open()) {
+      state_ = FILE_OPEN_ERROR;
+      return;
+    }
+  } else if (options.rawVolume != nullptr) {
+    sink_ = dlf::util::make_unique<dlf::storage::RawSectorSink>(
+        *options.rawVolume, filename_, options.rawPreallocateBytes,
+        dlf::util::make_unique<dlf::storage::FileSink>(fs_, filename_, true));
+    if (sink_->open()) {
+      preallocated_ = true;
+    } else {
+      DLFLIB_LOG_WARNING(
+          "[LogFile] %s: raw sector open failed, using filesystem writes",
+          filename_);
+      sink_.reset();
+    }
+  }
+  if (!sink_) {
+    sink_ = dlf::util::make_unique<dlf::storage::FileSink>(fs_, filename_);
+    if (!sink_->open()) {
+      state_ = FILE_OPEN_ERROR;
+      return;
+    }
+  }
+
+  // The index only speeds up readers, so logging goes on without it
+  if (indexIntervalTicks_ > 0) {
+    char indexPath[128];
+    snprintf(indexPath, sizeof(indexPath), "%s/event.idx", dir);
+    if (options.container != nullptr) {
+      indexSink_ = dlf::util::make_unique<dlf::storage::ContainerSink>(
+          *options.container, DLF_SECTION_EVENT_INDEX);
+    } else {
+      indexSink_ =
+          dlf::util::make_unique<dlf::storage::FileSink>(fs_, indexPath);
+    }
+    dlf_event_index_header_t h;
+    h.index_interval = indexIntervalTicks_;
+    if (!indexSink_->open() ||
+        indexSink_->write(reinterpret_cast<const uint8_t*>(&h), sizeof(h)) !=
+            sizeof(h)) {
+      DLFLIB_LOG_WARNING("[LogFile] %s: could not create index, skipping it",
+                         indexPath);
+      indexSink_.reset();
+    }
   }
 
   // Init data flusher
@@ -208,7 +351,8 @@ LogFile::LogFile(
   // Increased stack size from 4096 to 8192 to handle deep SD card call stack
   // (especially for file_.size() and file_.position() which trigger
   // vfs/fatfs/sdmmc operations)
-  if (xTaskCreate(taskFlusher, "Flusher", 8192, this, 5, NULL) != pdTRUE) {
+  if (xTaskCreate(taskFlusher, "Flusher", 8192, this, 5, &flusherTask_) !=
+      pdTRUE) {
     state_ = FLUSHER_CREATE_ERROR;
     return;
   }
@@ -228,53 +372,378 @@ void LogFile::sample(dlf_tick_t tick) {
   if (state_ != LOGGING) {
     return;
   }
+  // The flusher only raises the flag, so that state_ stays the sampler's
+  if (writeFailed_) {
+    DLFLIB_LOG_ERROR("[LogFile][sample] Error: WRITE_ERROR for %s at tick %llu",
+                     filename_, tick);
+    state_ = WRITE_ERROR;
+    return;
+  }
 
   lastTick_ = tick;
 
   // Sample all handles
-  for (auto& h : handles_) {
-    if (h->available(tick)) {
-      size_t beforeBytes = xStreamBufferBytesAvailable(stream_);
-      h->encodeInto(stream_, tick);
-      size_t afterBytes = xStreamBufferBytesAvailable(stream_);
+  const size_t tickOffset = bytesQueued_;
+  if (keyframeIntervalTicks_ > 0 && tick >= nextKeyframeTick_ &&
+      writeKeyframe(tick)) {
+    // The keyframe holds this tick's changes
+  } else if (compactEvents_) {
+    sampleEventGroup(tick);
+  } else {
+    for (auto& h : handles_) {
+      if (h->available(tick)) {
+        size_t beforeBytes = ring_.readable();
+        bytesQueued_ += h->encodeInto(ring_, tick);
+        size_t afterBytes = ring_.readable();
+        if (afterBytes > stats_.bufferHighWaterBytes) {
+          stats_.bufferHighWaterBytes = afterBytes;
+        }
 
 #ifdef DEBUG
-      if (afterBytes > beforeBytes && tick % 100 == 0) {
-        DLFLIB_LOG_DEBUG(
-            "[LogFile][sample] Tick %llu: Added %zu bytes to %s buffer (total: "
-            "%zu)",
-            tick, afterBytes - beforeBytes, filename_, afterBytes);
-      }
+        if (afterBytes > beforeBytes && tick % 100 == 0) {
+          DLFLIB_LOG_DEBUG(
+              "[LogFile][sample] Tick %llu: Added %zu bytes to %s buffer "
+              "(total: %zu)",
+              tick, afterBytes - beforeBytes, filename_, afterBytes);
+        }
 #endif
 
-      if (xStreamBufferIsFull(stream_)) {
-        DLFLIB_LOG_ERROR(
-            "[LogFile][sample] Error: QUEUE_FULL for %s at tick %llu",
-            filename_, tick);
-        state_ = QUEUE_FULL;
+        if (ring_.writable() == 0) {
+          DLFLIB_LOG_ERROR(
+              "[LogFile][sample] Error: QUEUE_FULL for %s at tick %llu",
+              filename_, tick);
+          state_ = QUEUE_FULL;
+        }
       }
     }
   }
+
+  if (anchorQueued_) {
+    writeTimeAnchor(tick);
+  }
+
+  if (indexSink_ && bytesQueued_ > tickOffset && tick >= nextIndexTick_) {
+    queueIndexEntry(tick, tickOffset);
+  }
+
+  // A requested commit is latched on the first tick at or past its target
+  const CommitSeq requestSeq = commitRequestSeq_;
+  const bool commitDue = requestSeq != commitLatchedSeq_ &&
+                         tick >= commitRequestTick_ && state_ == LOGGING;
+
+  const bool checkpointDue =
+      checkpointIntervalTicks_ > 0 && state_ == LOGGING &&
+      ((tick + 1) % checkpointIntervalTicks_ == 0 || commitDue);
+
+  // Column blocks are also cut early so that checkpoints and commits cover
+  // every sample up to their tick
+  if (columnBlockTicks_ > 0) {
+    if (!columnOpen_) {
+      columnFirstTick_ = tick;
+      columnOpen_ = true;
+    }
+    if (tick + 1 - columnFirstTick_ >= columnBlockTicks_ || checkpointDue ||
+        commitDue) {
+      writeColumnBlock(tick);
+    }
+  } else if (blockCuts_ && (checkpointDue || commitDue)) {
+    writeBlockCut(tick);
+  }
+
+  if (checkpointDue) {
+    writeCheckpoint(tick);
+  }
+
+  if (framed_) {
+    publishTickMark(tick + 1);
+  }
+
+  if (commitDue) {
+    commitTargetTick_ = tick;
+    commitTargetBytes_ = bytesQueued_;
+    commitLatchedSeq_ = requestSeq;
+    xTaskNotifyGive(flusherTask_);
+  }
+
+  // Wake the flusher once there is a block's worth to write
+  if (ring_.readable() >= DLF_SD_BLOCK_WRITE_SIZE) {
+    xTaskNotifyGive(flusherTask_);
+  }
 }
 
-void LogFile::close() {
+void LogFile::queueTimeAnchor(int64_t epochUs, dlf_time_source_e source) {
+  if (timeAnchors_) {
+    anchorEpochUs_ = epochUs;
+    anchorSource_ = source;
+    anchorQueued_ = true;
+  }
+}
+
+bool LogFile::close() {
+  if (state_ == QUEUE_FULL || state_ == WRITE_ERROR) {
+    closeAfterError();
+    return false;
+  }
   if (state_ != LOGGING) {
-    return;
+    return false;
+  }
+
+  // The sampler has stopped by now, so this task may write to ring_
+  if (columnOpen_) {
+    writeColumnBlock(lastTick_);
+  }
+  for (auto& h : handles_) {
+    bytesQueued_ += h->encodeTrailerInto(ring_);
+  }
+  if (checkpointIntervalTicks_ > 0) {
+    writeCheckpoint(lastTick_);
+  }
+  if (framed_) {
+    publishTickMark(lastTick_ + 1);
   }
 
   state_ = FLUSHING;
+  xTaskNotifyGive(flusherTask_);
   xSemaphoreTake(syncSemaphore_,
                  portMAX_DELAY);  // wait for flusher to finish up.
   state_ = CLOSED;
 
   // Cleanup dynamic allocations
-  vStreamBufferDelete(stream_);
   vSemaphoreDelete(syncSemaphore_);
   vSemaphoreDelete(fileMutex_);
 
   // Finally, update and close file
   closeFile();
   DLFLIB_LOG_INFO("[LogFile] Logfile closed cleanly");
+  return true;
+}
+
+void LogFile::closeAfterError() {
+  // Wait for the flusher to sync and exit
+  xSemaphoreTake(syncSemaphore_, portMAX_DELAY);
+  vSemaphoreDelete(syncSemaphore_);
+  vSemaphoreDelete(fileMutex_);
+
+  // Neither tick_span nor a final checkpoint is written, as the data may end
+  // mid-tick. Recovery bounds the file instead. Closing the sink still cuts a
+  // preallocated file back to what reached the card.
+  if (indexSink_) {
+    indexSink_->close();
+  }
+  sink_->close();
+  DLFLIB_LOG_ERROR("[LogFile] %s closed after error %d", filename_,
+                   (int)state_);
+}
+
+void LogFile::syncSink() {
+  sink_->sync();
+  if (!preallocated_) {
+    return;
+  }
+
+  // Only data that is on the card may be claimed, so the length is updated
+  // after the sync. Patches are written through to the card.
+  const size_t offset = sizeof(dlf_logfile_header_t) +
+                        offsetof(dlf_logfile_ext_header_t, written_bytes);
+  const uint64_t written = fileBytes_;
+  if (fileBytes_ >= offset + sizeof(written)) {
+    sink_->patch(offset, &written, sizeof(written));
+  }
+}
+
+void LogFile::writeSink(const uint8_t* data, size_t len) {
+  if (sink_->write(data, len) < len) {
+    writeFailed_ = true;
+  }
+}
+
+void LogFile::writeSpans(const dlf::util::ByteRing::Spans& spans) {
+  // The spans point straight into ring_, so the file write is the only copy
+  // between the sampler and the FS cache
+  uint32_t writeStart = micros();
+  writeSink(spans.first, spans.firstLen);
+  if (spans.secondLen > 0) {
+    writeSink(spans.second, spans.secondLen);
+  }
+  stats_.writeLatency.record(micros() - writeStart);
+  ring_.consume(spans.size());
+}
+
+size_t LogFile::writeData(const dlf::util::ByteRing::Spans& spans,
+                          bool idle) {
+  if (framed_) {
+    return writeFrames(spans, idle);
+  }
+  writeSpans(spans);
+  fileBytes_ += spans.size();
+  rawWritten_ += spans.size();
+  return spans.size();
+}
+
+size_t LogFile::writeFrames(const dlf::util::ByteRing::Spans& spans,
+                            bool idle) {
+  const size_t headerBytes = headerBytes_;
+  if (headerBytes == 0) {
+    // The header is still being queued
+    return 0;
+  }
+  collectTickMark();
+
+  const bool closing = state_ == FLUSHING;
+  const size_t avail = spans.size();
+  size_t consumed = 0;
+
+  // The header is written as is, so readers can tell the file is framed
+  if (rawWritten_ < headerBytes) {
+    const size_t n = min(avail, headerBytes - rawWritten_);
+    uint32_t writeStart = micros();
+    for (size_t off = 0; off < n;) {
+      const size_t len = min(n - off, frameRaw_.size());
+      spans.read(off, frameRaw_.data(), len);
+      writeSink(frameRaw_.data(), len);
+      off += len;
+    }
+    stats_.writeLatency.record(micros() - writeStart);
+    ring_.consume(n);
+    consumed += n;
+    rawWritten_ += n;
+    fileBytes_ += n;
+  }
+
+  while (consumed < avail) {
+    const size_t start = rawWritten_;
+    const size_t end = start + (avail - consumed);
+    const size_t limit = start + DLF_FRAME_RAW_BYTES;
+    const size_t reach = min(end, limit);
+
+    // Cut at the furthest tick boundary in reach. The commit point takes
+    // precedence so that the commit can complete right after this frame.
+    size_t cut = 0;
+    dlf_tick_t nextTick = frameTick_;
+    const bool commitPending = commitLatchedSeq_ != commitDoneSeq_;
+    const size_t commitBytes = commitTargetBytes_;
+    const bool atCommit =
+        commitPending && commitBytes > start && commitBytes <= reach;
+    if (atCommit) {
+      cut = commitBytes;
+      nextTick = commitTargetTick_ + 1;
+    } else if (idle || closing || end >= limit) {
+      // Otherwise small frames are only cut when nothing more is coming soon
+      for (size_t i = 0; i < numMarks_; i++) {
+        if (marks_[i].bytes > start && marks_[i].bytes <= reach) {
+          cut = marks_[i].bytes;
+          nextTick = marks_[i].tick;
+        }
+      }
+    }
+
+    uint8_t flags = frameContinued_ ? DLF_FRAME_FLAG_CONTINUED : 0;
+    if (cut == 0) {
+      if (end < limit && !closing) {
+        break;  // Wait for more data
+      }
+      // A single tick larger than a frame, or the tail at close
+      cut = reach;
+      if (cut < end || !closing) {
+        flags |= DLF_FRAME_FLAG_SPLIT;
+      }
+    }
+
+    const size_t len = cut - start;
+    spans.read(consumed, frameRaw_.data(), len);
+    size_t frameBytes =
+        compressor_ ? dlf::format::encodeFrame(*compressor_, frameRaw_.data(),
+                                               len, frameTick_, start, flags,
+                                               frameOut_.data())
+                    : dlf::format::encodeStoredFrame(frameRaw_.data(), len,
+                                                     frameTick_, start, flags,
+                                                     frameOut_.data());
+    if (blockCrc_) {
+      frameBytes = dlf::format::appendFrameCrc(frameOut_.data(), frameBytes);
+    }
+    uint32_t writeStart = micros();
+    writeSink(frameOut_.data(), frameBytes);
+    stats_.writeLatency.record(micros() - writeStart);
+    ring_.consume(len);
+
+    consumed += len;
+    rawWritten_ = cut;
+    fileBytes_ += frameBytes;
+    frameTick_ = nextTick;
+    frameContinued_ = (flags & DLF_FRAME_FLAG_SPLIT) != 0;
+
+    // Forget marks this frame went past
+    size_t keep = 0;
+    for (size_t i = 0; i < numMarks_; i++) {
+      if (marks_[i].bytes > cut) {
+        marks_[keep++] = marks_[i];
+      }
+    }
+    numMarks_ = keep;
+
+    if (atCommit) {
+      // Let the flusher complete the commit before anything else is written
+      break;
+    }
+  }
+  return consumed;
+}
+
+void LogFile::publishTickMark(dlf_tick_t nextTick) {
+  // Odd while the mark is being updated
+  markSeq_ = markSeq_ + 1;
+  markTick_ = nextTick;
+  markBytes_ = bytesQueued_;
+  markSeq_ = markSeq_ + 1;
+}
+
+void LogFile::collectTickMark() {
+  const uint32_t seq = markSeq_;
+  if (seq & 1) {
+    return;
+  }
+  const TickMark mark{markTick_, markBytes_};
+  if (markSeq_ != seq) {
+    return;
+  }
+  if (numMarks_ > 0 && mark.bytes <= marks_[numMarks_ - 1].bytes) {
+    return;
+  }
+  if (numMarks_ == MAX_TICK_MARKS) {
+    // Drop the oldest
+    memmove(&marks_[0], &marks_[1], (MAX_TICK_MARKS - 1) * sizeof(TickMark));
+    numMarks_--;
+  }
+  marks_[numMarks_++] = mark;
+}
+
+void LogFile::queueIndexEntry(dlf_tick_t tick, size_t offset) {
+  const uint32_t queued = indexQueued_;
+  if (queued - indexWritten_ >= DLF_EVENT_INDEX_PENDING) {
+    // The flusher is behind; try again with the next record
+    return;
+  }
+  dlf_event_index_entry_t& e = indexPending_[queued % DLF_EVENT_INDEX_PENDING];
+  e.tick = tick;
+  e.byte_offset = offset;
+  indexQueued_ = queued + 1;
+  nextIndexTick_ = tick + indexIntervalTicks_;
+}
+
+void LogFile::writeIndexEntries() {
+  if (!indexSink_) {
+    return;
+  }
+  // Entries are in offset order, so stop at the first one past the data
+  while (indexWritten_ != indexQueued_) {
+    const dlf_event_index_entry_t& e =
+        indexPending_[indexWritten_ % DLF_EVENT_INDEX_PENDING];
+    if (e.byte_offset >= rawWritten_) {
+      break;
+    }
+    indexSink_->write(reinterpret_cast<const uint8_t*>(&e), sizeof(e));
+    indexWritten_ = indexWritten_ + 1;
+  }
 }
 
 void LogFile::lock() { xSemaphoreTake(fileMutex_, portMAX_DELAY); }
@@ -284,12 +753,274 @@ void LogFile::unlock() { xSemaphoreGive(fileMutex_); }
 void LogFile::writeHeader(dlf_stream_type_e streamType) {
   dlf_logfile_header_t h;
   h.stream_type = streamType;
+  h.tick_span = 0;
   h.num_streams = handles_.size();
-  xStreamBufferSend(stream_, &h, sizeof(h), portMAX_DELAY);
 
+  dlf_logfile_ext_header_t ext;
+  if (checkpointIntervalTicks_ > 0) {
+    ext.flags |= DLF_LOGFILE_FLAG_CHECKPOINTS;
+    ext.checkpoint_interval = checkpointIntervalTicks_;
+  }
+  if (compressor_) {
+    ext.flags |= DLF_LOGFILE_FLAG_BLOCK_COMPRESSION;
+  }
+  if (blockCrc_) {
+    ext.flags |= DLF_LOGFILE_FLAG_BLOCK_CRC;
+  }
+  if (compactEvents_) {
+    ext.flags |= DLF_LOGFILE_FLAG_COMPACT_EVENTS;
+  }
+  if (keyframeIntervalTicks_ > 0) {
+    ext.flags |= DLF_LOGFILE_FLAG_KEYFRAMES;
+  }
+  if (timeAnchors_) {
+    ext.flags |= DLF_LOGFILE_FLAG_TIME_ANCHORS;
+  }
+  if (columnBlockTicks_ > 0) {
+    ext.flags |= DLF_LOGFILE_FLAG_COLUMNAR;
+  }
+  if (preallocated_) {
+    ext.flags |= DLF_LOGFILE_FLAG_PREALLOCATED;
+  }
   for (auto& handle : handles_) {
-    handle->encodeHeaderInto(stream_);
+    ext.flags |= handle->logfileFlags();
+  }
+  blockCuts_ = (ext.flags & DLF_LOGFILE_FLAG_BLOCK_CUTS) != 0;
+  // Only mark the file as extended when a feature needs it, so that default
+  // files stay readable by older readers
+  const bool extended = ext.flags != 0;
+  if (extended) {
+    h.stream_type = static_cast<dlf_stream_type_e>(streamType |
+                                                   DLF_LOGFILE_EXTENDED);
+  }
+
+  bytesQueued_ +=
+      dlf::datastream::AbstractStreamHandle::sendBytes(ring_, &h, sizeof(h));
+  if (extended) {
+    bytesQueued_ += dlf::datastream::AbstractStreamHandle::sendBytes(
+        ring_, &ext, sizeof(ext));
+  }
+
+  for (auto& handle : handles_) {
+    bytesQueued_ += handle->encodeHeaderInto(ring_, ext.flags);
+  }
+  headerBytes_ = bytesQueued_;
+  xTaskNotifyGive(flusherTask_);
+}
+
+void LogFile::sampleEventGroup(dlf_tick_t tick) {
+  // Find the changed streams first, since the group header counts their
+  // records. Message streams may have several.
+  size_t due = 0;
+  size_t count = 0;
+  size_t required = 0;
+  for (size_t i = 0; i < handles_.size(); i++) {
+    auto h =
+        static_cast<dlf::datastream::EventStreamHandle*>(handles_[i].get());
+    if (h->available(tick)) {
+      groupDue_[due++] = i;
+      count += h->groupedRecordCount();
+      required += h->groupedRecordSize();
+    }
+  }
+  if (due == 0) {
+    return;
+  }
+
+  uint8_t head[20];
+  size_t headLen = dlf::format::putVarint(head, tick - lastGroupTick_);
+  headLen += dlf::format::putVarint(head + headLen, count);
+  required += headLen;
+
+  // The hashes only update once a record is written, so a deferred group is
+  // retried in full on the next tick
+  dlf::util::ByteRing::Spans spans = ring_.reserve(required);
+  if (spans.size() < required) {
+    DLFLIB_LOG_WARNING(
+        "[LogFile][sampleEventGroup] Buffer full, deferring %zu events",
+        count);
+    return;
+  }
+  spans.write(0, head, headLen);
+  size_t offset = headLen;
+  for (size_t j = 0; j < due; j++) {
+    auto h = static_cast<dlf::datastream::EventStreamHandle*>(
+        handles_[groupDue_[j]].get());
+    offset += h->encodeGroupedInto(spans, offset);
+  }
+  ring_.commit(required);
+  bytesQueued_ += required;
+  lastGroupTick_ = tick;
+  trackRingUsage(tick);
+}
+
+bool LogFile::writeKeyframe(dlf_tick_t tick) {
+  // In compact files, an empty group introduces the keyframe
+  uint8_t head[MAX_EMPTY_GROUP_BYTES];
+  size_t headLen = 0;
+  if (compactEvents_) {
+    headLen = dlf::format::putVarint(head, tick - lastGroupTick_);
+    head[headLen++] = 0;
   }
+  const size_t required = headLen + sizeof(dlf_keyframe_t) + keyframeBytes_;
+  dlf::util::ByteRing::Spans spans = ring_.reserve(required);
+  if (spans.size() < required) {
+    DLFLIB_LOG_WARNING(
+        "[LogFile][writeKeyframe] Buffer full, deferring keyframe of %s",
+        filename_);
+    return false;
+  }
+
+  spans.write(0, head, headLen);
+  dlf_keyframe_t k;
+  k.tick = tick;
+  k.byte_offset = bytesQueued_ + headLen;
+  spans.write(headLen, &k, sizeof(k));
+  size_t offset = headLen + sizeof(k);
+  for (auto& h : handles_) {
+    offset += static_cast<dlf::datastream::EventStreamHandle*>(h.get())
+                  ->encodeValueInto(spans, offset);
+  }
+  ring_.commit(required);
+  bytesQueued_ += required;
+  lastGroupTick_ = tick;
+  nextKeyframeTick_ = tick + keyframeIntervalTicks_;
+  trackRingUsage(tick);
+  return true;
+}
+
+void LogFile::writeTimeAnchor(dlf_tick_t tick) {
+  anchorQueued_ = false;
+  // In compact files, an empty group introduces the anchor
+  uint8_t head[MAX_EMPTY_GROUP_BYTES];
+  size_t headLen = 0;
+  if (compactEvents_) {
+    headLen = dlf::format::putVarint(head, tick - lastGroupTick_);
+    head[headLen++] = 0;
+  }
+  const size_t required = headLen + sizeof(dlf_time_anchor_t);
+  dlf::util::ByteRing::Spans spans = ring_.reserve(required);
+  if (spans.size() < required) {
+    DLFLIB_LOG_WARNING(
+        "[LogFile][writeTimeAnchor] Buffer full, dropping time anchor of %s",
+        filename_);
+    return;
+  }
+
+  spans.write(0, head, headLen);
+  dlf_time_anchor_t a;
+  a.tick = tick;
+  a.byte_offset = bytesQueued_ + headLen;
+  a.epoch_us = anchorEpochUs_;
+  a.source = anchorSource_;
+  spans.write(headLen, &a, sizeof(a));
+  ring_.commit(required);
+  bytesQueued_ += required;
+  lastGroupTick_ = tick;
+  trackRingUsage(tick);
+}
+
+size_t LogFile::maxColumnBlockBytes(dlf_tick_t blockTicks) const {
+  size_t bytes = sizeof(dlf_column_block_header_t) +
+                 handles_.size() * sizeof(uint32_t);
+  for (auto& h : handles_) {
+    bytes += static_cast<dlf::datastream::PolledStreamHandle*>(h.get())
+                 ->maxColumnBytes(blockTicks);
+  }
+  return bytes;
+}
+
+void LogFile::writeColumnBlock(dlf_tick_t lastTick) {
+  dlf_column_block_header_t h;
+  h.first_tick = columnFirstTick_;
+  h.tick_count = lastTick + 1 - columnFirstTick_;
+
+  const size_t lensBytes = handles_.size() * sizeof(uint32_t);
+  size_t required = sizeof(h) + lensBytes;
+  for (size_t i = 0; i < handles_.size(); i++) {
+    size_t len;
+    columnData_[i] =
+        static_cast<dlf::datastream::PolledStreamHandle*>(handles_[i].get())
+            ->finishColumn(len);
+    columnLens_[i] = len;
+    required += len;
+  }
+
+  // Like polled samples, a block must never be written partially, so wait
+  // for the flusher to make room
+  if (!dlf::datastream::AbstractStreamHandle::waitForSpace(ring_, required)) {
+    DLFLIB_LOG_ERROR("[LogFile][writeColumnBlock] Block of %zu bytes too big",
+                     required);
+    state_ = QUEUE_FULL;
+    return;
+  }
+  dlf::util::ByteRing::Spans spans = ring_.reserve(required);
+  spans.write(0, &h, sizeof(h));
+  spans.write(sizeof(h), columnLens_.data(), lensBytes);
+  size_t offset = sizeof(h) + lensBytes;
+  for (size_t i = 0; i < handles_.size(); i++) {
+    spans.write(offset, columnData_[i], columnLens_[i]);
+    offset += columnLens_[i];
+    static_cast<dlf::datastream::PolledStreamHandle*>(handles_[i].get())
+        ->resetColumn();
+  }
+  ring_.commit(required);
+  bytesQueued_ += required;
+  columnOpen_ = false;
+  trackRingUsage(lastTick);
+}
+
+void LogFile::writeBlockCut(dlf_tick_t tick) {
+  bool pending = false;
+  for (auto& h : handles_) {
+    pending |= static_cast<dlf::datastream::PolledStreamHandle*>(h.get())
+                   ->pendingSamples() > 0;
+  }
+  if (!pending) {
+    return;
+  }
+
+  dlf_block_cut_t c;
+  c.tick = tick;
+  c.byte_offset = bytesQueued_;
+  bytesQueued_ +=
+      dlf::datastream::AbstractStreamHandle::sendBytes(ring_, &c, sizeof(c));
+  for (auto& h : handles_) {
+    bytesQueued_ +=
+        static_cast<dlf::datastream::PolledStreamHandle*>(h.get())->cutBlock(
+            ring_);
+  }
+  trackRingUsage(tick);
+}
+
+void LogFile::trackRingUsage(dlf_tick_t tick) {
+  const size_t afterBytes = ring_.readable();
+  if (afterBytes > stats_.bufferHighWaterBytes) {
+    stats_.bufferHighWaterBytes = afterBytes;
+  }
+  if (ring_.writable() == 0) {
+    DLFLIB_LOG_ERROR("[LogFile][sample] Error: QUEUE_FULL for %s at tick %llu",
+                     filename_, tick);
+    state_ = QUEUE_FULL;
+  }
+}
+
+void LogFile::writeCheckpoint(dlf_tick_t tick) {
+  if (compactEvents_) {
+    // An empty group introduces the checkpoint
+    uint8_t head[MAX_EMPTY_GROUP_BYTES];
+    size_t headLen = dlf::format::putVarint(head, tick - lastGroupTick_);
+    head[headLen++] = 0;
+    bytesQueued_ += dlf::datastream::AbstractStreamHandle::sendBytes(
+        ring_, head, headLen);
+    lastGroupTick_ = tick;
+  }
+
+  dlf_checkpoint_t c;
+  c.tick_span = tick;
+  c.byte_offset = bytesQueued_;
+  bytesQueued_ +=
+      dlf::datastream::AbstractStreamHandle::sendBytes(ring_, &c, sizeof(c));
 }
 
 void LogFile::closeFile() {
@@ -297,82 +1028,99 @@ void LogFile::closeFile() {
       "[LogFile][closeFile] Closing file, tracked end position: %zu",
       fileEndPosition_);
 
-  // Flush and close current write handle
-  file_.flush();
-  file_.close();
-
-  DLFLIB_LOG_INFO(
-      "[LogFile][closeFile] File closed, checking actual size on SD...");
+  if (indexSink_) {
+    indexSink_->close();
+  }
 
-  // Check file size on SD before header update
-  fs::File checkFile = fs_.open(filename_, "r");
-  if (checkFile) {
-    size_t sizeBeforeUpdate = checkFile.size();
-    DLFLIB_LOG_INFO(
-        "[LogFile][closeFile] File size on SD BEFORE header update: %zu "
-        "bytes",
-        sizeBeforeUpdate);
-    checkFile.close();
-  }
-
-  // Reopen file in read/write mode to update the header
-  // IMPORTANT: we use "r+" (read/write) mode instead of "a" (append)
-  // here because any write in append mode will always go to end of file
-  // regardless of any seeks.
-  file_ = fs_.open(filename_, "r+");
-  if (!file_) {
-    DLFLIB_LOG_ERROR(
-        "[LogFile][closeFile] ERROR: Could not reopen file for header "
-        "update!");
+  // Append-only files were closed out by the final checkpoint
+  if (checkpointIntervalTicks_ > 0) {
+    sink_->close();
     return;
   }
 
   // Update header with # of ticks
-  file_.seek(offsetof(dlf_logfile_header_t, tick_span));
-  file_.write(reinterpret_cast<uint8_t*>(&lastTick_), sizeof(dlf_tick_t));
-  file_.flush();
-  file_.close();
-
-  // Check file size after header update
-  checkFile = fs_.open(filename_, "r");
-  if (checkFile) {
-    size_t sizeAfterUpdate = checkFile.size();
-    DLFLIB_LOG_INFO(
-        "[LogFile][closeFile] File size on SD AFTER header update: %zu bytes",
-        sizeAfterUpdate);
-    checkFile.close();
+  if (!sink_->patch(offsetof(dlf_logfile_header_t, tick_span), &lastTick_,
+                    sizeof(dlf_tick_t))) {
+    DLFLIB_LOG_ERROR(
+        "[LogFile][closeFile] ERROR: Could not update header of %s",
+        filename_);
   }
+  sink_->close();
 
   DLFLIB_LOG_INFO("[LogFile][closeFile] Header update complete");
 }
 
-void LogFile::flush() {
-  if (state_ != LOGGING) {
-    return;
+LogFile::CommitSeq LogFile::requestCommit(dlf_tick_t throughTick) {
+  // The sampler reads the seq before the tick, so publish the tick first
+  commitRequestTick_ = throughTick;
+  commitRequestSeq_ = commitRequestSeq_ + 1;
+  return commitRequestSeq_;
+}
+
+bool LogFile::waitForCommit(CommitSeq seq, TickType_t timeout, Commit& out) {
+  // Register before checking so that a commit completing in between still
+  // leaves a notification pending
+  commitWaiter_ = xTaskGetCurrentTaskHandle();
+
+  const TickType_t start = xTaskGetTickCount();
+  const TickType_t slice = pdMS_TO_TICKS(100);
+  bool done = false;
+  while (true) {
+    // Seqs wrap, so compare by difference
+    if (static_cast<int32_t>(commitDoneSeq_ - seq) >= 0) {
+      done = true;
+      break;
+    }
+    const TickType_t elapsed = xTaskGetTickCount() - start;
+    if (state_ != LOGGING || elapsed >= timeout) {
+      break;
+    }
+    // Sliced so that a file that stops logging mid-wait is noticed
+    const TickType_t remaining = timeout - elapsed;
+    ulTaskNotifyTake(pdTRUE, remaining < slice ? remaining : slice);
   }
 
-  // Wait for the stream buffer to be mostly empty
-  // This isn't a perfect guarantee but prevents flushing a file
-  // that the flusher task is actively writing to in large chunks.
-  while (xStreamBufferBytesAvailable(stream_) > DLF_SD_BLOCK_WRITE_SIZE) {
-    vTaskDelay(pdMS_TO_TICKS(10));
+  commitWaiter_ = nullptr;
+  if (done) {
+    out.tick = committedTick_;
+    out.bytes = committedBytes_;
   }
+  return done;
+}
 
-  // Lock the file mutex to prevent race conditions with the flusher task
-  if (xSemaphoreTake(fileMutex_, portMAX_DELAY) == pdTRUE) {
-    // Save current file position (where flusher task will write next)
-    size_t current_pos = file_.position();
+void LogFile::completeCommit() {
+  const CommitSeq seq = commitLatchedSeq_;
+  const dlf_tick_t tick = commitTargetTick_;
+  uint32_t commitStart = micros();
 
-    // Update header with the last known number of ticks
-    file_.seek(offsetof(dlf_logfile_header_t, tick_span));
-    file_.write(reinterpret_cast<uint8_t*>(&lastTick_), sizeof(dlf_tick_t));
-    file_.flush();  // Ensure the header update is written to the SD card
+  // Append-only files carry their own checkpoint at the commit point.
+  // Otherwise, update header with the committed number of ticks.
+  if (checkpointIntervalTicks_ == 0) {
+    sink_->patch(offsetof(dlf_logfile_header_t, tick_span), &tick,
+                 sizeof(dlf_tick_t));
+  }
+  syncSink();
+  if (indexSink_) {
+    writeIndexEntries();
+    indexSink_->sync();
+  }
+  stats_.commitLatency.record(micros() - commitStart);
 
-    // Restore the file pointer to where the flusher task left off
-    file_.seek(current_pos);
+  committedTick_ = tick;
+  // A framed file's last frame ends exactly at the commit point, because
+  // writeFrames() cuts there and then stops
+  committedBytes_ = framed_ ? fileBytes_ : commitTargetBytes_;
+  commitDoneSeq_ = seq;
 
-    xSemaphoreGive(fileMutex_);
+  TaskHandle_t waiter = commitWaiter_;
+  if (waiter != nullptr) {
+    xTaskNotifyGive(waiter);
   }
+
+#ifdef DEBUG
+  DLFLIB_LOG_DEBUG("[LogFile][completeCommit] %s: seq %u durable at %zu",
+                   filename_, seq, committedBytes_);
+#endif
 }
 
 }  // namespace dlf
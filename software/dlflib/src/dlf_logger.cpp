@@ -1,11 +1,92 @@
 #include "dlflib/dlf_logger.h"
 
+#include <unistd.h>
+
 #include "dlflib/components/uploader_component.h"
 #include "dlflib/dlf_cfg.h"
+#include "dlflib/format/frames.h"
+#include "dlflib/format/recovery.h"
+#include "dlflib/format/run_container.h"
 #include "dlflib/log.h"
 
 namespace dlf {
 
+namespace {
+
+class FileByteSource : public dlf::format::ByteSource {
+ public:
+  explicit FileByteSource(fs::File& file) : file_(file), size_(file.size()) {}
+
+  size_t size() override { return size_; }
+
+  size_t read(size_t offset, uint8_t* dst, size_t len) override {
+    if (!file_.seek(offset)) {
+      return 0;
+    }
+    return file_.read(dst, len);
+  }
+
+ private:
+  fs::File& file_;
+  size_t size_;
+};
+
+// Whether `name` is a log file recoverRun() repairs: polled.dlf, event.dlf
+// or a capture file
+bool isLogfileName(const char* name) {
+  return !strcmp(name, "polled.dlf") || !strcmp(name, "event.dlf") ||
+         (!strncmp(name, "raw-", 4) && strlen(name) > 8 &&
+          !strcmp(name + strlen(name) - 4, ".dlf"));
+}
+
+// Finds the end of the valid data of one log file, within the recovery
+// budget that started at `startMs`. `validFileLength` is set to the length
+// the file can be cut to, which for framed files is not the scanned
+// (uncompressed) length.
+dlf::format::RecoveryResult scanLogfile(dlf::format::ByteSource& src,
+                                        const dlf::format::LogfileInfo& info,
+                                        uint32_t startMs, const char* path,
+                                        size_t& validFileLength) {
+  // A preallocated file is only scanned up to the length it last synced
+  dlf::format::TruncatedByteSource written(src,
+                                           info.writtenLength(src.size()));
+  auto scan = [&](dlf::format::ByteSource& data) {
+    dlf::format::RecoveryScanner scanner(data, info);
+    while (!scanner.step(4096) && millis() - startMs < DLF_RECOVERY_BUDGET_MS) {
+    }
+    return scanner.result();
+  };
+  if (!info.framed()) {
+    dlf::format::RecoveryResult r = scan(written);
+    validFileLength = r.validLength;
+    return r;
+  }
+
+  // Scan the uncompressed data. Frames torn by the shutdown are already left
+  // out of the view, and the file can only be cut between frames.
+  dlf::format::FrameByteSource frames(written, info.dataOffset,
+                                      info.blockCrc());
+  dlf::format::RecoveryResult r = scan(frames);
+  validFileLength = frames.fileLength();
+  if (r.validLength < frames.size() && frames.damagedFrames() > 0 &&
+      !frames.frames().empty()) {
+    // The scan stopped at a corrupted frame rather than at the end. The
+    // intact frames after it are kept, and the last one's first tick is as
+    // far as the data is known to go.
+    DLFLIB_LOG_WARNING("[DLFLogger][recoverRun] %s: %zu damaged frames", path,
+                       frames.damagedFrames());
+    const dlf_tick_t lastTick = frames.frames().back().firstTick;
+    r.tickSpan = r.hasTicks ? max(r.tickSpan, lastTick) : lastTick;
+    r.hasTicks = true;
+    r.validLength = frames.size();
+  } else if (r.validLength < frames.size()) {
+    r.complete = false;
+  }
+  return r;
+}
+
+}  // namespace
+
 DLFLogger::DLFLogger(fs::FS& fs, const char* fsDir) : fs_(fs) {
   snprintf(fsDir_, sizeof(fsDir_), "%s", fsDir ? fsDir : "");
   loggerEventGroup_ = xEventGroupCreate();
@@ -50,7 +131,8 @@ bool DLFLogger::begin() {
 }
 
 run_handle_t DLFLogger::startRun(const Encodable& meta,
-                                 std::chrono::microseconds tickRate) {
+                                 std::chrono::microseconds tickRate,
+                                 const Run::Options& options) {
   run_handle_t h = getAvailableHandle();
 
   // A handle of 0 indicates that no more runs can be started (max active runs
@@ -64,8 +146,8 @@ run_handle_t DLFLogger::startRun(const Encodable& meta,
 
   // Initialize new run
   int idx = h - 1;
-  runs_[idx] =
-      dlf::util::make_unique<dlf::Run>(fs_, fsDir_, streams_, tickRate, meta);
+  runs_[idx] = dlf::util::make_unique<dlf::Run>(fs_, fsDir_, streams_,
+                                                tickRate, meta, options);
 
   return h;
 }
@@ -83,6 +165,12 @@ void DLFLogger::stopRun(run_handle_t h) {
   }
 }
 
+DLFLogger& DLFLogger::setVfsMountPoint(const char* mountPoint) {
+  snprintf(vfsMountPoint_, sizeof(vfsMountPoint_), "%s",
+           mountPoint ? mountPoint : "");
+  return *this;
+}
+
 DLFLogger& DLFLogger::syncTo(
     const char* endpoint, const char* deviceUid,
     const dlf::components::UploaderComponent::Options& options) {
@@ -130,6 +218,46 @@ DLFLogger& DLFLogger::watchInternal(const Encodable& value, const char* id,
   return *this;
 }
 
+DLFLogger& DLFLogger::pollFlags(
+    const dlf::datastream::FlagGroup& flags, const char* id,
+    std::chrono::microseconds sampleInterval,
+    const dlf::datastream::PolledStream::Options& options) {
+  streams_.push_back(dlf::util::make_unique<dlf::datastream::PolledFlagStream>(
+      dlf::util::make_unique<dlf::datastream::FlagGroup>(flags), id,
+      sampleInterval, options));
+  return *this;
+}
+
+DLFLogger& DLFLogger::watchFlags(const dlf::datastream::FlagGroup& flags,
+                                 const char* id, const char* notes,
+                                 SemaphoreHandle_t mutex) {
+  streams_.push_back(dlf::util::make_unique<dlf::datastream::EventFlagStream>(
+      dlf::util::make_unique<dlf::datastream::FlagGroup>(flags), id, notes,
+      mutex));
+  return *this;
+}
+
+dlf::datastream::MessageStream* DLFLogger::messages(
+    const char* id, size_t maxSize,
+    const dlf::datastream::MessageStream::Options& options) {
+  auto stream =
+      dlf::util::make_unique<dlf::datastream::MessageStream>(id, maxSize,
+                                                             options);
+  dlf::datastream::MessageStream* raw = stream.get();
+  streams_.push_back(std::move(stream));
+  return raw;
+}
+
+dlf::datastream::CaptureStream* DLFLogger::capture(
+    const char* id, dlf::datastream::CaptureSource& source,
+    const dlf::datastream::CaptureStream::Options& options) {
+  auto stream = dlf::util::make_unique<dlf::datastream::CaptureStream>(
+      id, source, options);
+  dlf::datastream::CaptureStream* raw = stream.get();
+  streams_.push_back(std::move(stream));
+  return raw;
+}
+
 DLFLogger& DLFLogger::pollInternal(const Encodable& value, const char* id,
                                    std::chrono::microseconds sampleInterval,
                                    std::chrono::microseconds phase,
@@ -139,6 +267,39 @@ DLFLogger& DLFLogger::pollInternal(const Encodable& value, const char* id,
   return *this;
 }
 
+DLFLogger& DLFLogger::pollInternal(
+    const Encodable& value, const char* id,
+    std::chrono::microseconds sampleInterval,
+    const dlf::datastream::PolledStream::Options& options) {
+  streams_.push_back(dlf::util::make_unique<dlf::datastream::PolledStream>(
+      value, id, sampleInterval, options));
+  return *this;
+}
+
+DLFLogger& DLFLogger::pollQuantized(
+    std::unique_ptr<dlf::datastream::Quantizer> quantizer, const char* id,
+    std::chrono::microseconds sampleInterval,
+    const dlf::datastream::PolledStream::Options& options) {
+  if (!dlf::datastream::Quantizer::isValid(quantizer->quantization())) {
+    DLFLIB_LOG_ERROR("[DLFLogger][poll] Invalid quantization for %s", id);
+    return *this;
+  }
+  streams_.push_back(dlf::util::make_unique<dlf::datastream::QuantizedStream>(
+      std::move(quantizer), id, sampleInterval, options));
+  return *this;
+}
+
+DLFLogger& DLFLogger::pollTransformed(
+    std::unique_ptr<dlf::datastream::TransformedStream> stream) {
+  if (!stream->transform().valid()) {
+    DLFLIB_LOG_ERROR("[DLFLogger][poll] Invalid transform for %s",
+                     stream->id());
+    return *this;
+  }
+  streams_.push_back(std::move(stream));
+  return *this;
+}
+
 run_handle_t DLFLogger::getAvailableHandle() {
   for (int i = 0; i < MAX_ACTIVE_RUNS; ++i) {
     if (!runs_[i]) {
@@ -158,8 +319,9 @@ void DLFLogger::prune() {
   // Look through all run directories for any runs that still have lockfiles.
   // The presence of a lockfile indicates that the run was not closed properly
   // (for example, due to power loss during a run). In this case, we still want
-  // to upload the data for the run. In order to do that, we'll remove the
-  // lockfile so that the uploader will attempt to upload this run.
+  // to upload the data for the run. In order to do that, we'll repair what
+  // the shutdown left behind, then remove the lockfile so that the uploader
+  // will attempt to upload this run.
   while (fs::File runDir = root.openNextFile()) {
     // Skip files and sys vol information dir
     if (!runDir.isDirectory() ||
@@ -173,8 +335,13 @@ void DLFLogger::prune() {
     char lockfilePath[128];
     dlf::util::joinPath(lockfilePath, sizeof(lockfilePath), runDirPath,
                         LOCKFILE_NAME);
+    char containerPath[128];
+    dlf::util::joinPath(containerPath, sizeof(containerPath), runDirPath,
+                        dlf::storage::RunContainer::FILE_NAME);
+    dlf_run_container_header_t container;
     if (fs_.exists(lockfilePath)) {
       DLFLIB_LOG_INFO("[DLFLogger] Pruning %s", runDirPath);
+      recoverRun(runDirPath);
       if (fs_.remove(lockfilePath)) {
         DLFLIB_LOG_INFO("[DLFLogger] Successfully removed lockfile: %s",
                         lockfilePath);
@@ -182,12 +349,248 @@ void DLFLogger::prune() {
         DLFLIB_LOG_ERROR("[DLFLogger] ERROR: Failed to remove lockfile: %s",
                          lockfilePath);
       }
+    } else if (dlf::storage::RunContainer::readHeader(fs_, containerPath,
+                                                      container) &&
+               container.state == DLF_RUN_OPEN) {
+      // A container still marked open is the same as a lockfile
+      DLFLIB_LOG_INFO("[DLFLogger] Pruning %s", runDirPath);
+      recoverContainer(containerPath);
+      // Capture files are written next to the container
+      recoverRun(runDirPath);
     }
   }
 
   root.close();
 }
 
+void DLFLogger::recoverRun(const char* runDirPath) {
+  const uint32_t startMs = millis();
+
+  // polled.dlf, event.dlf and the capture files (raw-<id>.dlf)
+  struct Logfile {
+    char path[128];
+    dlf::format::LogfileInfo info;
+    dlf::format::RecoveryResult result;
+    size_t validFileLength = 0;
+    bool scanned = false;
+  };
+  std::vector<Logfile> files;
+  fs::File dir = fs_.open(runDirPath);
+  while (fs::File entry = dir.openNextFile()) {
+    if (isLogfileName(entry.name())) {
+      files.emplace_back();
+      dlf::util::joinPath(files.back().path, sizeof(files.back().path),
+                          runDirPath, entry.name());
+    }
+    entry.close();
+  }
+  dir.close();
+  const size_t numFiles = files.size();
+
+  for (size_t i = 0; i < numFiles; i++) {
+    const char* path = files[i].path;
+    fs::File file = fs_.open(path, "r");
+    if (!file) {
+      continue;
+    }
+
+    FileByteSource src(file);
+    if (!dlf::format::readLogfileHeader(src, files[i].info)) {
+      DLFLIB_LOG_WARNING("[DLFLogger][recoverRun] %s: unreadable header",
+                         path);
+      file.close();
+      continue;
+    }
+
+    files[i].result = scanLogfile(src, files[i].info, startMs, path,
+                                  files[i].validFileLength);
+    files[i].scanned = true;
+    file.close();
+    const dlf::format::RecoveryResult& r = files[i].result;
+
+    DLFLIB_LOG_INFO(
+        "[DLFLogger][recoverRun] %s: %zu/%zu valid bytes, last tick %llu%s",
+        path, r.validLength, src.size(), (unsigned long long)r.tickSpan,
+        r.complete ? "" : " (budget exhausted)");
+  }
+
+  // All files are sampled on the same ticks, so a run's span is the furthest
+  // tick any file got to
+  bool hasTicks = false;
+  dlf_tick_t tickSpan = 0;
+  for (const Logfile& f : files) {
+    if (f.scanned && f.result.hasTicks) {
+      tickSpan =
+          hasTicks ? max(tickSpan, f.result.tickSpan) : f.result.tickSpan;
+      hasTicks = true;
+    }
+  }
+
+  for (size_t i = 0; i < numFiles; i++) {
+    if (!files[i].scanned) {
+      continue;
+    }
+
+    const char* path = files[i].path;
+    const dlf::format::LogfileInfo& info = files[i].info;
+    const dlf::format::RecoveryResult& r = files[i].result;
+
+    // Cut off torn records. Only trust the length once the scan finished.
+    bool clean = r.complete;
+    fs::File file = fs_.open(path, "r");
+    const size_t size = file ? file.size() : 0;
+    file.close();
+    if (r.complete && files[i].validFileLength < size &&
+        !truncateFile(path, files[i].validFileLength)) {
+      clean = false;
+    }
+
+    if (info.ext.flags & DLF_LOGFILE_FLAG_CHECKPOINTS) {
+      // Append-only files are closed out with a final checkpoint, which must
+      // land right after the valid data
+      if (!clean || !hasTicks) {
+        continue;
+      }
+      dlf_checkpoint_t c;
+      c.tick_span = tickSpan;
+      c.byte_offset = r.validLength;
+      uint8_t record[dlf::format::maxFrameBytes(sizeof(c)) +
+                     dlf::format::FRAME_CRC_BYTES];
+      size_t recordLen = sizeof(c);
+      if (info.framed()) {
+        recordLen = dlf::format::encodeStoredFrame(
+            reinterpret_cast<uint8_t*>(&c), sizeof(c), tickSpan,
+            r.validLength, 0, record);
+        if (info.blockCrc()) {
+          recordLen = dlf::format::appendFrameCrc(record, recordLen);
+        }
+      } else {
+        memcpy(record, &c, sizeof(c));
+      }
+      file = fs_.open(path, "a");
+      if (file) {
+        file.write(record, recordLen);
+        file.close();
+      }
+    } else if (hasTicks) {
+      file = fs_.open(path, "r+");
+      if (file) {
+        file.seek(offsetof(dlf_logfile_header_t, tick_span));
+        file.write(reinterpret_cast<uint8_t*>(&tickSpan), sizeof(tickSpan));
+        file.close();
+      }
+    }
+
+    // The repaired file ends with its data, including any final checkpoint
+    if (clean && (info.ext.flags & DLF_LOGFILE_FLAG_PREALLOCATED)) {
+      file = fs_.open(path, "r+");
+      if (file) {
+        const uint64_t length = file.size();
+        file.seek(sizeof(dlf_logfile_header_t) +
+                  offsetof(dlf_logfile_ext_header_t, written_bytes));
+        file.write(reinterpret_cast<const uint8_t*>(&length), sizeof(length));
+        file.close();
+      }
+    }
+  }
+
+  DLFLIB_LOG_INFO("[DLFLogger][recoverRun] %s recovered in %u ms", runDirPath,
+                  millis() - startMs);
+}
+
+void DLFLogger::recoverContainer(const char* path) {
+  const uint32_t startMs = millis();
+  fs::File file = fs_.open(path, "r");
+  if (!file) {
+    return;
+  }
+  FileByteSource src(file);
+  dlf::format::RunContainerReader container(src);
+  if (!container.valid()) {
+    DLFLIB_LOG_WARNING("[DLFLogger][recoverRun] %s: not a run container",
+                       path);
+    file.close();
+    return;
+  }
+
+  // Each log file is recovered from its sections as if it were a file of its
+  // own. Torn records can't be cut off in the middle of the container, so the
+  // lengths go into a commit record instead, which readers cut at.
+  const dlf_section_tag_e tags[] = {DLF_SECTION_POLLED, DLF_SECTION_EVENT};
+  uint64_t validBytes[2] = {};
+  bool complete = true;
+  bool hasTicks = false;
+  dlf_tick_t tickSpan = 0;
+  for (size_t i = 0; i < 2; i++) {
+    dlf::format::SectionByteSource section(container, tags[i]);
+    dlf::format::LogfileInfo info;
+    if (!dlf::format::readLogfileHeader(section, info)) {
+      continue;
+    }
+    size_t validLength;
+    const dlf::format::RecoveryResult r =
+        scanLogfile(section, info, startMs, path, validLength);
+    validBytes[i] = validLength;
+    complete = complete && r.complete;
+    if (r.hasTicks) {
+      tickSpan = hasTicks ? max(tickSpan, r.tickSpan) : r.tickSpan;
+      hasTicks = true;
+    }
+  }
+  const size_t validLength = container.validLength();
+  const size_t size = src.size();
+  file.close();
+  DLFLIB_LOG_INFO(
+      "[DLFLogger][recoverRun] %s: %zu/%zu valid bytes, last tick %llu%s",
+      path, validLength, size, (unsigned long long)tickSpan,
+      complete ? "" : " (budget exhausted)");
+
+  // Only trust the lengths once the scans finished. Otherwise readers fall
+  // back to the last commit made while logging.
+  bool clean = complete && hasTicks;
+  if (clean && validLength < size) {
+    clean = truncateFile(path, validLength);
+  }
+  if (clean) {
+    dlf_section_header_t h;
+    h.tag = DLF_SECTION_COMMIT;
+    h.length = sizeof(dlf_container_commit_t);
+    dlf_container_commit_t c;
+    c.tick = tickSpan;
+    c.polled_bytes = validBytes[0];
+    c.event_bytes = validBytes[1];
+    file = fs_.open(path, "a");
+    if (file) {
+      file.write(reinterpret_cast<uint8_t*>(&h), sizeof(h));
+      file.write(reinterpret_cast<uint8_t*>(&c), sizeof(c));
+      file.close();
+    }
+  }
+
+  if (!dlf::storage::RunContainer::writeState(fs_, path, DLF_RUN_CLOSED)) {
+    DLFLIB_LOG_ERROR("[DLFLogger][recoverRun] ERROR: Could not close %s",
+                     path);
+  }
+  DLFLIB_LOG_INFO("[DLFLogger][recoverRun] %s recovered in %u ms", path,
+                  millis() - startMs);
+}
+
+bool DLFLogger::truncateFile(const char* path, size_t length) {
+  char vfsPath[160];
+  if (vfsMountPoint_[0] != '\0' &&
+      dlf::util::joinPath(vfsPath, sizeof(vfsPath), vfsMountPoint_, path) &&
+      truncate(vfsPath, length) == 0) {
+    DLFLIB_LOG_INFO("[DLFLogger][recoverRun] Truncated %s to %zu bytes", path,
+                    length);
+    return true;
+  }
+  DLFLIB_LOG_WARNING(
+      "[DLFLogger][recoverRun] Could not truncate %s (VFS mount point set: "
+      "%d)",
+      path, vfsMountPoint_[0] != '\0');
+  return false;
+}
+
 dlf::components::Component* DLFLogger::findById(size_t id) const {
   // Allow finding DLFLogger itself
   if (id == dlf::util::hashType<DLFLogger>()) {
@@ -1,5 +1,7 @@
 #include "dlflib/dlf_run.h"
 
+#include <esp_timer.h>
+#include <sys/time.h>
 #include <time.h>
 
 #include "dlflib/dlf_cfg.h"
@@ -12,11 +14,13 @@ namespace dlf {
 Run::Run(fs::FS& fs, const char* fsDir,
          const std::vector<std::unique_ptr<dlf::datastream::AbstractStream>>&
              streams,
-         std::chrono::microseconds tickInterval, const Encodable& meta)
+         std::chrono::microseconds tickInterval, const Encodable& meta,
+         const Options& options)
     : fs_(fs),
       streams_(streams),
       tickInterval_(tickInterval),
-      startMillis_(millis()) {
+      startMillis_(millis()),
+      options_(options) {
   assert(tickInterval.count() > 0);
 
   dlf::util::uuidGen(uuid_);
@@ -29,22 +33,70 @@ Run::Run(fs::FS& fs, const char* fsDir,
     status_ = SYNC_CREATE_ERROR;
     return;
   }
+  commitMutex_ = xSemaphoreCreateMutex();
+  if (commitMutex_ == nullptr) {
+    DLFLIB_LOG_ERROR("[Run] Failed to create commitMutex_");
+    status_ = SYNC_CREATE_ERROR;
+    return;
+  }
+  anchorMutex_ = xSemaphoreCreateMutex();
+  if (anchorMutex_ == nullptr) {
+    DLFLIB_LOG_ERROR("[Run] Failed to create anchorMutex_");
+    status_ = SYNC_CREATE_ERROR;
+    return;
+  }
+  timeSource_ = options_.timeSource;
+  if (options_.timeAnchorInterval > std::chrono::microseconds::zero()) {
+    timeAnchorIntervalTicks_ =
+        max(options_.timeAnchorInterval / tickInterval_, 1ll);
+  }
 
   DLFLIB_LOG_INFO("[Run] Starting run %s", uuid_);
 
   // Make directory to contain run files
   fs_.mkdir(runDir_);
 
-  // Create the lockfile first, as the presence of the lockfile indicates that
-  // the run is incomplete and should not be uploaded
-  createLockfile();
+  if (options_.container) {
+    // A new container starts out as DLF_RUN_OPEN, which stands in for the
+    // lockfile
+    char containerPath[128];
+    dlf::util::joinPath(containerPath, sizeof(containerPath), runDir_,
+                        dlf::storage::RunContainer::FILE_NAME);
+    container_ =
+        dlf::util::make_unique<dlf::storage::RunContainer>(fs_, containerPath);
+    if (!container_->open()) {
+      DLFLIB_LOG_ERROR("[Run] Failed to create %s", containerPath);
+      status_ = FILE_OPEN_ERROR;
+      return;
+    }
+  } else {
+    // Create the lockfile first, as the presence of the lockfile indicates
+    // that the run is incomplete and should not be uploaded
+    createLockfile();
+  }
 
   // Writes metafile for this log
   createMetafile(meta);
 
+  // The diagnostics stream is owned by the run rather than registered on the
+  // logger, so it only exists for runs that ask for it.
+  if (options_.diagnosticsInterval > std::chrono::microseconds::zero()) {
+    diagnosticsIntervalTicks_ =
+        max(options_.diagnosticsInterval / tickInterval_, 1ll);
+    diagnosticsStream_ = dlf::util::make_unique<dlf::datastream::PolledStream>(
+        Encodable(diagnostics_, DLF_DIAGNOSTICS_TYPE_STRUCTURE),
+        DLF_DIAGNOSTICS_STREAM_ID, options_.diagnosticsInterval,
+        std::chrono::microseconds::zero(), "Internal LogFile telemetry");
+  }
+
   // Create logfile instances
   createLogfile(POLLED);
   createLogfile(EVENT);
+  for (const auto& stream : streams_) {
+    if (stream && stream->type() == RAW) {
+      createCaptureLogfile(stream.get());
+    }
+  }
 
   DLFLIB_LOG_INFO("[Run] Logfiles inited");
 
@@ -52,13 +104,23 @@ Run::Run(fs::FS& fs, const char* fsDir,
   // to set it before starting the sampler task
   status_ = LOGGING;
 
-  if (xTaskCreate(taskSampler, "Sampler", 2560, this, 5, NULL) != pdPASS) {
+  if (xTaskCreate(taskSampler, "Sampler", DLF_SAMPLER_STACK_SIZE, this, 5,
+                  NULL) != pdPASS) {
     DLFLIB_LOG_ERROR("[Run] Failed to create Sampler task");
     status_ = FLUSHER_CREATE_ERROR;
     return;
   }
 }
 
+Run::~Run() {
+  if (commitMutex_ != nullptr) {
+    vSemaphoreDelete(commitMutex_);
+  }
+  if (anchorMutex_ != nullptr) {
+    vSemaphoreDelete(anchorMutex_);
+  }
+}
+
 void Run::close() {
   DLFLIB_LOG_INFO("[Run] Closing run...");
 
@@ -73,8 +135,44 @@ void Run::close() {
   xSemaphoreTake(syncSemaphore_, portMAX_DELAY);
   vSemaphoreDelete(syncSemaphore_);
 
+  bool clean = true;
   for (auto& lf : logFiles_) {
-    lf->close();
+    clean = lf->close() && clean;
+  }
+
+  // Wait out commit() and addTimeAnchor() calls in flight. Any commit still
+  // waiting gives up once its file stops logging, and later calls see the
+  // status and back off. The mutexes are deleted with the run.
+  xSemaphoreTake(commitMutex_, portMAX_DELAY);
+  xSemaphoreGive(commitMutex_);
+  xSemaphoreTake(anchorMutex_, portMAX_DELAY);
+  xSemaphoreGive(anchorMutex_);
+
+  // A file that stopped on an error may end mid-tick. Leave the run open, as
+  // after a power loss, so that the next begin() recovers it.
+  if (!clean) {
+    DLFLIB_LOG_ERROR("[Run] Logfile error, leaving run open for recovery");
+    if (container_) {
+      container_->close();
+    }
+    return;
+  }
+
+  if (container_) {
+    // The final commit record covers everything, and marking the container
+    // closed is what removing the lockfile does for separate files
+    dlf_container_commit_t c;
+    c.tick = currentTick_;
+    c.polled_bytes = container_->sectionBytes(DLF_SECTION_POLLED);
+    c.event_bytes = container_->sectionBytes(DLF_SECTION_EVENT);
+    container_->commit(c);
+    if (!container_->setState(DLF_RUN_CLOSED)) {
+      DLFLIB_LOG_ERROR("[Run] ERROR: Failed to mark container closed!");
+      return;
+    }
+    container_->close();
+    DLFLIB_LOG_INFO("[Run] Run closed cleanly");
+    return;
   }
 
   // Remove the lockfile last, as the presence of the lockfile indicates that
@@ -91,13 +189,165 @@ void Run::close() {
   DLFLIB_LOG_INFO("[Run] Run closed cleanly");
 }
 
-void Run::flushLogFiles() {
+LogFile::Stats Run::logFileStats(dlf_stream_type_e t) const {
+  for (const auto& lf : logFiles_) {
+    if (lf->streamType() == t) {
+      return lf->stats();
+    }
+  }
+  return LogFile::Stats();
+}
+
+dlf_file_state_e Run::logFileState(dlf_stream_type_e t) const {
+  for (const auto& lf : logFiles_) {
+    if (lf->streamType() == t) {
+      return lf->state();
+    }
+  }
+  return UNINITIALIZED;
+}
+
+void Run::refreshDiagnostics() {
+  // Read the live stats in place; the sampler stack is too small to copy both
+  // histograms on every refresh.
+  for (const auto& lf : logFiles_) {
+    const LogFile::Stats& stats = lf->stats();
+    if (lf->streamType() == POLLED) {
+      diagnostics_.polled_buffer_hwm = stats.bufferHighWaterBytes;
+      diagnostics_.polled_bytes_per_s = stats.bytesPerSecond;
+      diagnostics_.polled_write_max_us = stats.writeLatency.maxUs();
+      diagnostics_.polled_commit_max_us = stats.commitLatency.maxUs();
+    } else if (lf->streamType() == EVENT) {
+      diagnostics_.event_buffer_hwm = stats.bufferHighWaterBytes;
+      diagnostics_.event_bytes_per_s = stats.bytesPerSecond;
+      diagnostics_.event_write_max_us = stats.writeLatency.maxUs();
+      diagnostics_.event_commit_max_us = stats.commitLatency.maxUs();
+    }
+  }
+}
+
+bool Run::commit(dlf_tick_t throughTick, CommitResult& result,
+                 TickType_t timeout) {
   if (status_ != LOGGING) {
-    return;
+    return false;
+  }
+
+  const TickType_t start = xTaskGetTickCount();
+  if (xSemaphoreTake(commitMutex_, timeout) != pdTRUE) {
+    return false;
+  }
+  // close() may have started while this waited for the mutex
+  if (status_ != LOGGING) {
+    xSemaphoreGive(commitMutex_);
+    return false;
   }
 
+  // Request on every file before waiting so that they sync concurrently
+  std::vector<LogFile::CommitSeq> seqs;
   for (auto& lf : logFiles_) {
-    lf->flush();
+    seqs.push_back(lf->requestCommit(throughTick));
+  }
+
+  bool ok = true;
+  result = CommitResult();
+  for (size_t i = 0; i < logFiles_.size(); i++) {
+    const TickType_t elapsed = xTaskGetTickCount() - start;
+    LogFile::Commit c;
+    if (elapsed >= timeout ||
+        !logFiles_[i]->waitForCommit(seqs[i], timeout - elapsed, c)) {
+      DLFLIB_LOG_WARNING(
+          "[Run][commit] %s logfile did not commit tick %llu in time",
+          dlf::datastream::streamTypeToString(logFiles_[i]->streamType()),
+          throughTick);
+      ok = false;
+      break;
+    }
+
+    // Files may latch a tick apart if the request lands mid-tick
+    if (i == 0 || c.tick < result.tick) {
+      result.tick = c.tick;
+    }
+    if (logFiles_[i]->streamType() == POLLED) {
+      result.polledBytes = c.bytes;
+    } else if (logFiles_[i]->streamType() == EVENT) {
+      result.eventBytes = c.bytes;
+    }
+  }
+
+  if (ok && container_) {
+    dlf_container_commit_t c;
+    c.tick = result.tick;
+    c.polled_bytes = result.polledBytes;
+    c.event_bytes = result.eventBytes;
+    result.containerBytes = container_->commit(c);
+  }
+
+  xSemaphoreGive(commitMutex_);
+  return ok;
+}
+
+void Run::setTimeSource(dlf_time_source_e source) {
+  timeSource_ = source;
+  timeSourceChanged_ = true;
+}
+
+bool Run::addTimeAnchor(int64_t epochUs, dlf_time_source_e source) {
+  if (timeAnchorIntervalTicks_ == 0 || status_ != LOGGING) {
+    return false;
+  }
+  const int64_t timerUs = esp_timer_get_time();
+  xSemaphoreTake(anchorMutex_, portMAX_DELAY);
+  if (status_ != LOGGING) {
+    xSemaphoreGive(anchorMutex_);
+    return false;
+  }
+  externalEpochUs_ = epochUs;
+  externalTimerUs_ = timerUs;
+  externalSource_ = source;
+  externalAnchorQueued_ = true;
+  xSemaphoreGive(anchorMutex_);
+  return true;
+}
+
+void Run::queueTimeAnchor(dlf_tick_t tick) {
+  const int64_t timerUs = esp_timer_get_time();
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  const int64_t epochUs =
+      static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+
+  // The monotonic timer doesn't follow the system clock, so a jump in their
+  // difference means the clock was set. Slewing stays well below the limit.
+  const int64_t offsetUs = epochUs - timerUs;
+  const int64_t stepUs = offsetUs - clockOffsetUs_;
+  const bool stepped =
+      tick > 0 && (stepUs > DLF_TIME_STEP_US || stepUs < -DLF_TIME_STEP_US);
+  clockOffsetUs_ = offsetUs;
+
+  bool due = tick >= nextTimeAnchorTick_ || stepped || timeSourceChanged_;
+  timeSourceChanged_ = false;
+  int64_t anchorUs = epochUs;
+  dlf_time_source_e source = timeSource_;
+
+  // Never wait on a caller of addTimeAnchor(); it is picked up next tick
+  if (xSemaphoreTake(anchorMutex_, 0) == pdTRUE) {
+    if (externalAnchorQueued_) {
+      anchorUs = externalEpochUs_ + (timerUs - externalTimerUs_);
+      source = externalSource_;
+      externalAnchorQueued_ = false;
+      due = true;
+    }
+    xSemaphoreGive(anchorMutex_);
+  }
+
+  if (!due) {
+    return;
+  }
+  nextTimeAnchorTick_ = tick + timeAnchorIntervalTicks_;
+  for (auto& lf : logFiles_) {
+    if (lf->streamType() == EVENT) {
+      lf->queueTimeAnchor(anchorUs, source);
+    }
   }
 }
 
@@ -130,19 +380,27 @@ void Run::createMetafile(const Encodable& meta) {
       h.epoch_time_s, h.tick_base_us, h.meta_structure, meta.typeHash);
 #endif
 
+  std::vector<uint8_t> bytes;
+  auto put = [&bytes](const void* p, size_t len) {
+    const uint8_t* b = static_cast<const uint8_t*>(p);
+    bytes.insert(bytes.end(), b, b + len);
+  };
+  put(&h.magic, sizeof(h.magic));
+  put(&h.epoch_time_s, sizeof(h.epoch_time_s));
+  put(&h.tick_base_us, sizeof(h.tick_base_us));
+  put(h.meta_structure, strlen(h.meta_structure) + 1);
+  put(&h.meta_size, sizeof(h.meta_size));
+  put(meta.data, h.meta_size);
+
+  if (container_) {
+    container_->append(DLF_SECTION_META, bytes.data(), bytes.size());
+    return;
+  }
+
   char metaPath[128];
   dlf::util::joinPath(metaPath, sizeof(metaPath), runDir_, "meta.dlf");
   fs::File metaFile = fs_.open(metaPath, "w", true);
-
-  metaFile.write(reinterpret_cast<uint8_t*>(&h.magic), sizeof(h.magic));
-  metaFile.write(reinterpret_cast<uint8_t*>(&h.epoch_time_s),
-                 sizeof(h.epoch_time_s));
-  metaFile.write(reinterpret_cast<uint8_t*>(&h.tick_base_us),
-                 sizeof(h.tick_base_us));
-  metaFile.write((uint8_t*)h.meta_structure, strlen(h.meta_structure) + 1);
-  metaFile.write(reinterpret_cast<uint8_t*>(&h.meta_size), sizeof(h.meta_size));
-  metaFile.write(meta.data, h.meta_size);
-
+  metaFile.write(bytes.data(), bytes.size());
   metaFile.close();
 }
 
@@ -160,8 +418,50 @@ void Run::createLogfile(dlf_stream_type_e t) {
       handles.push_back(stream->createHandle(tickInterval_, idx++));
     }
   }
-  logFiles_.push_back(
-      dlf::util::make_unique<LogFile>(std::move(handles), t, runDir_, fs_));
+  if (t == POLLED && diagnosticsStream_) {
+    handles.push_back(diagnosticsStream_->createHandle(tickInterval_, idx++));
+  }
+  logFiles_.push_back(dlf::util::make_unique<LogFile>(
+      std::move(handles), t, runDir_, fs_, logFileOptions()));
+}
+
+void Run::createCaptureLogfile(dlf::datastream::AbstractStream* stream) {
+  std::vector<std::unique_ptr<dlf::datastream::AbstractStreamHandle>> handles;
+  handles.push_back(stream->createHandle(tickInterval_, 0));
+  char name[48];
+  snprintf(name, sizeof(name), "raw-%s", stream->id());
+  LogFile::Options options = logFileOptions();
+  options.name = name;
+  logFiles_.push_back(dlf::util::make_unique<LogFile>(
+      std::move(handles), RAW, runDir_, fs_, options));
+}
+
+LogFile::Options Run::logFileOptions() const {
+  LogFile::Options options;
+  options.rawVolume = options_.rawVolume;
+  options.rawPreallocateBytes = options_.rawPreallocateBytes;
+  options.container = container_.get();
+  options.compressBlocks = options_.compressBlocks;
+  options.blockCrc = options_.blockCrc;
+  options.compactEvents = options_.compactEvents;
+  if (options_.checkpointInterval > std::chrono::microseconds::zero()) {
+    options.checkpointIntervalTicks =
+        max(options_.checkpointInterval / tickInterval_, 1ll);
+  }
+  if (options_.eventIndexInterval > std::chrono::microseconds::zero()) {
+    options.indexIntervalTicks =
+        max(options_.eventIndexInterval / tickInterval_, 1ll);
+  }
+  if (options_.columnBlockDuration > std::chrono::microseconds::zero()) {
+    options.columnBlockTicks =
+        max(options_.columnBlockDuration / tickInterval_, 1ll);
+  }
+  if (options_.keyframeInterval > std::chrono::microseconds::zero()) {
+    options.keyframeIntervalTicks =
+        max(options_.keyframeInterval / tickInterval_, 1ll);
+  }
+  options.timeAnchors = timeAnchorIntervalTicks_ > 0;
+  return options;
 }
 
 void Run::taskSampler(void* arg) {
@@ -176,6 +476,15 @@ void Run::taskSampler(void* arg) {
 
   // Run at constant tick interval
   for (dlf_tick_t tick = 0; self->status_ == LOGGING; tick++) {
+    self->currentTick_ = tick;
+    if (self->diagnosticsStream_ &&
+        tick % self->diagnosticsIntervalTicks_ == 0) {
+      self->refreshDiagnostics();
+    }
+    if (self->timeAnchorIntervalTicks_ > 0) {
+      self->queueTimeAnchor(tick);
+    }
+
     for (auto& lf : self->logFiles_) {
       lf->sample(tick);
     }
@@ -0,0 +1,463 @@
+#include "dlflib/format/codec.h"
+
+namespace dlf::format {
+
+namespace {
+
+// Longest LEB128 encoding of a value of `typeSize` bytes
+size_t maxVarintBytes(size_t typeSize) { return (typeSize * 8 + 6) / 7; }
+
+bool isIntegerSize(size_t typeSize) {
+  return typeSize == 1 || typeSize == 2 || typeSize == 4 || typeSize == 8;
+}
+
+uint64_t widthMask(size_t typeSize) {
+  return typeSize >= 8 ? ~0ull : (1ull << (typeSize * 8)) - 1;
+}
+
+uint64_t load(const uint8_t* p, size_t typeSize) {
+  uint64_t v = 0;
+  memcpy(&v, p, typeSize);
+  return v;
+}
+
+// Difference of two values of the given width, as a signed number of that
+// width
+int64_t signedDelta(uint64_t cur, uint64_t prev, size_t typeSize) {
+  const unsigned shift = 64 - typeSize * 8;
+  return static_cast<int64_t>((cur - prev) << shift) >> shift;
+}
+
+bool isFloatSize(size_t typeSize) { return typeSize == 4 || typeSize == 8; }
+
+// XOR codec: prefix bits, leading zero count bits and length bits per value
+constexpr unsigned XOR_LEADING_BITS = 5;
+constexpr unsigned XOR_LENGTH_BITS = 6;
+constexpr unsigned XOR_MAX_LEADING = (1u << XOR_LEADING_BITS) - 1;
+constexpr size_t XOR_OVERHEAD_BITS = 2 + XOR_LEADING_BITS + XOR_LENGTH_BITS;
+
+// Reads a bit stream written by BlockEncoder::putBits
+class BitReader {
+ public:
+  BitReader(const uint8_t* data, size_t bytes)
+      : data_(data), bits_(bytes * 8) {}
+
+  bool get(unsigned n, uint64_t& v) {
+    if (bits_ - pos_ < n) {
+      return false;
+    }
+    v = 0;
+    while (n > 0) {
+      const unsigned avail = 8 - (pos_ & 7);
+      const unsigned take = n < avail ? n : avail;
+      const uint8_t byte = data_[pos_ >> 3];
+      v = (v << take) | ((byte >> (avail - take)) & ((1u << take) - 1));
+      pos_ += take;
+      n -= take;
+    }
+    return true;
+  }
+
+  size_t bytesUsed() const { return (pos_ + 7) / 8; }
+
+ private:
+  const uint8_t* data_;
+  size_t bits_;
+  size_t pos_ = 0;
+};
+
+bool decodeXor(size_t typeSize, const uint8_t* payload, size_t payloadBytes,
+               size_t sampleCount, uint8_t* out) {
+  if (sampleCount == 0) {
+    return payloadBytes == 0;
+  }
+  if (payloadBytes < typeSize) {
+    return false;
+  }
+  const unsigned width = typeSize * 8;
+  uint64_t prev = load(payload, typeSize);
+  memcpy(out, payload, typeSize);
+  BitReader bits(payload + typeSize, payloadBytes - typeSize);
+  unsigned leading = 0;
+  unsigned trailing = 0;
+  bool haveWindow = false;
+  for (size_t i = 1; i < sampleCount; i++) {
+    uint64_t b;
+    if (!bits.get(1, b)) {
+      return false;
+    }
+    if (b == 1) {
+      if (!bits.get(1, b)) {
+        return false;
+      }
+      if (b == 1) {
+        uint64_t lead, len;
+        if (!bits.get(XOR_LEADING_BITS, lead) ||
+            !bits.get(XOR_LENGTH_BITS, len) || lead + len + 1 > width) {
+          return false;
+        }
+        leading = lead;
+        trailing = width - lead - (len + 1);
+        haveWindow = true;
+      } else if (!haveWindow) {
+        return false;
+      }
+      uint64_t x;
+      if (!bits.get(width - leading - trailing, x)) {
+        return false;
+      }
+      prev ^= x << trailing;
+    }
+    memcpy(out + i * typeSize, &prev, typeSize);
+  }
+  return typeSize + bits.bytesUsed() == payloadBytes;
+}
+
+}  // namespace
+
+bool codecSupports(dlf_codec_e codec, size_t typeSize) {
+  switch (codec) {
+    case DLF_CODEC_RAW:
+      return true;
+    case DLF_CODEC_DELTA_VARINT:
+      return isIntegerSize(typeSize);
+    case DLF_CODEC_RLE:
+      return typeSize > 0;
+    case DLF_CODEC_XOR:
+      return isFloatSize(typeSize);
+    default:
+      return false;
+  }
+}
+
+size_t maxBlockBytes(dlf_codec_e codec, size_t typeSize, size_t blockSamples,
+                     dlf_validity_e validity) {
+  if (blockSamples == 0) {
+    return 0;
+  }
+  if (validity != DLF_VALIDITY_NONE) {
+    // The bitmap, then at most every sample
+    return validityBitmapBytes(blockSamples) +
+           maxBlockBytes(codec, typeSize, blockSamples);
+  }
+  switch (codec) {
+    case DLF_CODEC_DELTA_VARINT:
+      return typeSize + (blockSamples - 1) * maxVarintBytes(typeSize);
+    case DLF_CODEC_RLE:
+      // Every sample starts a run of length 1
+      return blockSamples * (1 + typeSize);
+    case DLF_CODEC_XOR: {
+      // Every value after the first takes the longest code
+      const size_t bits =
+          (blockSamples - 1) * (XOR_OVERHEAD_BITS + typeSize * 8);
+      return typeSize + (bits + 7) / 8;
+    }
+    default:
+      return blockSamples * typeSize;
+  }
+}
+
+size_t maxBlockSamples(dlf_codec_e codec, size_t typeSize, size_t maxBytes,
+                       dlf_validity_e validity) {
+  const size_t limit = maxBytes < UINT16_MAX ? maxBytes : UINT16_MAX;
+  size_t lo = 1;
+  size_t hi = UINT16_MAX;
+  if (maxBlockBytes(codec, typeSize, lo, validity) > limit) {
+    return 0;
+  }
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo + 1) / 2;
+    if (maxBlockBytes(codec, typeSize, mid, validity) <= limit) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return lo;
+}
+
+size_t putVarint(uint8_t* out, uint64_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = static_cast<uint8_t>(v) | 0x80;
+    v >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(v);
+  return n;
+}
+
+size_t getVarint(const uint8_t* in, size_t len, uint64_t& v) {
+  v = 0;
+  for (size_t i = 0; i < len && i < 10; i++) {
+    v |= static_cast<uint64_t>(in[i] & 0x7F) << (7 * i);
+    if ((in[i] & 0x80) == 0) {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+BlockEncoder::BlockEncoder(dlf_codec_e codec, size_t typeSize,
+                           size_t blockSamples, dlf_validity_e validity)
+    : codec_(codec),
+      typeSize_(typeSize),
+      blockSamples_(blockSamples),
+      validity_(validity),
+      bitmapBytes_(validity == DLF_VALIDITY_NONE
+                       ? 0
+                       : validityBitmapBytes(blockSamples)),
+      out_(maxBlockBytes(codec, typeSize, blockSamples, validity)),
+      zero_(validity == DLF_VALIDITY_ZERO ? typeSize : 0),
+      runValue_(codec == DLF_CODEC_RLE ? typeSize : 0) {
+  reset();
+}
+
+void BlockEncoder::add(const uint8_t* value, bool valid) {
+  if (validity_ != DLF_VALIDITY_NONE) {
+    if (valid) {
+      out_[count_ / 8] |= 1u << (count_ % 8);
+    } else if (validity_ == DLF_VALIDITY_OMIT) {
+      count_++;
+      return;
+    } else {
+      value = zero_.data();
+    }
+  }
+
+  switch (codec_) {
+    case DLF_CODEC_DELTA_VARINT: {
+      const uint64_t cur = load(value, typeSize_);
+      if (stored_ == 0) {
+        memcpy(&out_[len_], value, typeSize_);
+        len_ += typeSize_;
+      } else {
+        len_ += putVarint(&out_[len_],
+                          zigzag(signedDelta(cur, prev_, typeSize_)));
+      }
+      prev_ = cur;
+      break;
+    }
+    case DLF_CODEC_RLE:
+      if (runLength_ > 0 && memcmp(runValue_.data(), value, typeSize_) == 0) {
+        runLength_++;
+      } else {
+        flushRun();
+        memcpy(runValue_.data(), value, typeSize_);
+        runLength_ = 1;
+      }
+      break;
+    case DLF_CODEC_XOR:
+      addXor(value);
+      break;
+    default:
+      memcpy(&out_[len_], value, typeSize_);
+      len_ += typeSize_;
+      break;
+  }
+  count_++;
+  stored_++;
+}
+
+void BlockEncoder::addXor(const uint8_t* value) {
+  const uint64_t cur = load(value, typeSize_);
+  if (stored_ == 0) {
+    memcpy(&out_[len_], value, typeSize_);
+    len_ += typeSize_;
+    prev_ = cur;
+    return;
+  }
+
+  const uint64_t x = cur ^ prev_;
+  prev_ = cur;
+  if (x == 0) {
+    putBits(0, 1);
+    return;
+  }
+
+  const unsigned width = typeSize_ * 8;
+  unsigned leading = __builtin_clzll(x) - (64 - width);
+  if (leading > XOR_MAX_LEADING) {
+    leading = XOR_MAX_LEADING;
+  }
+  const unsigned trailing = __builtin_ctzll(x);
+  if (haveWindow_ && leading >= leading_ && trailing >= trailing_) {
+    // Fits the previous window
+    putBits(0b10, 2);
+    putBits(x >> trailing_, width - leading_ - trailing_);
+    return;
+  }
+
+  const unsigned len = width - leading - trailing;
+  putBits(0b11, 2);
+  putBits(leading, XOR_LEADING_BITS);
+  putBits(len - 1, XOR_LENGTH_BITS);
+  putBits(x >> trailing, len);
+  leading_ = leading;
+  trailing_ = trailing;
+  haveWindow_ = true;
+}
+
+void BlockEncoder::putBits(uint64_t v, unsigned n) {
+  while (n > 0) {
+    if (bitCount_ == 0) {
+      out_[len_] = 0;
+    }
+    const unsigned space = 8 - bitCount_;
+    const unsigned take = n < space ? n : space;
+    const uint8_t chunk = (v >> (n - take)) & ((1u << take) - 1);
+    out_[len_] |= chunk << (space - take);
+    bitCount_ += take;
+    n -= take;
+    if (bitCount_ == 8) {
+      len_++;
+      bitCount_ = 0;
+    }
+  }
+}
+
+void BlockEncoder::flushRun() {
+  if (runLength_ == 0) {
+    return;
+  }
+  len_ += putVarint(&out_[len_], runLength_);
+  memcpy(&out_[len_], runValue_.data(), typeSize_);
+  len_ += typeSize_;
+  runLength_ = 0;
+}
+
+const uint8_t* BlockEncoder::finish(size_t& payloadBytes) {
+  flushRun();
+  if (bitCount_ > 0) {
+    // Pad the last partial byte with zeros
+    len_++;
+    bitCount_ = 0;
+  }
+  if (bitmapBytes_ == 0) {
+    payloadBytes = len_;
+    return out_.data();
+  }
+  // The bitmap of a partial block is shorter than the room reserved for it
+  const size_t bitmap = validityBitmapBytes(count_);
+  uint8_t* start = &out_[bitmapBytes_ - bitmap];
+  memmove(start, out_.data(), bitmap);
+  payloadBytes = len_ - (bitmapBytes_ - bitmap);
+  return start;
+}
+
+void BlockEncoder::reset() {
+  if (bitmapBytes_ > 0) {
+    memset(out_.data(), 0, bitmapBytes_);
+  }
+  len_ = bitmapBytes_;
+  count_ = 0;
+  stored_ = 0;
+  prev_ = 0;
+  runLength_ = 0;
+  bitCount_ = 0;
+  leading_ = 0;
+  trailing_ = 0;
+  haveWindow_ = false;
+}
+
+bool decodeBlock(dlf_codec_e codec, size_t typeSize, const uint8_t* payload,
+                 size_t payloadBytes, size_t sampleCount, uint8_t* out) {
+  size_t pos = 0;
+  switch (codec) {
+    case DLF_CODEC_DELTA_VARINT: {
+      if (!isIntegerSize(typeSize)) {
+        return false;
+      }
+      if (sampleCount == 0) {
+        return payloadBytes == 0;
+      }
+      if (payloadBytes < typeSize) {
+        return false;
+      }
+      const uint64_t mask = widthMask(typeSize);
+      uint64_t prev = load(payload, typeSize);
+      memcpy(out, payload, typeSize);
+      pos = typeSize;
+      for (size_t i = 1; i < sampleCount; i++) {
+        uint64_t z;
+        size_t n = getVarint(payload + pos, payloadBytes - pos, z);
+        if (n == 0) {
+          return false;
+        }
+        pos += n;
+        prev = (prev + static_cast<uint64_t>(unzigzag(z))) & mask;
+        memcpy(out + i * typeSize, &prev, typeSize);
+      }
+      break;
+    }
+    case DLF_CODEC_RLE: {
+      size_t i = 0;
+      while (i < sampleCount) {
+        uint64_t run;
+        size_t n = getVarint(payload + pos, payloadBytes - pos, run);
+        if (n == 0 || run == 0 || run > sampleCount - i ||
+            payloadBytes - pos - n < typeSize) {
+          return false;
+        }
+        pos += n;
+        for (uint64_t r = 0; r < run; r++, i++) {
+          memcpy(out + i * typeSize, payload + pos, typeSize);
+        }
+        pos += typeSize;
+      }
+      break;
+    }
+    case DLF_CODEC_XOR:
+      return isFloatSize(typeSize) &&
+             decodeXor(typeSize, payload, payloadBytes, sampleCount, out);
+    case DLF_CODEC_RAW:
+      if (payloadBytes != sampleCount * typeSize) {
+        return false;
+      }
+      memcpy(out, payload, payloadBytes);
+      pos = payloadBytes;
+      break;
+    default:
+      return false;
+  }
+  return pos == payloadBytes;
+}
+
+bool decodeBlock(dlf_codec_e codec, size_t typeSize, dlf_validity_e validity,
+                 const uint8_t* payload, size_t payloadBytes,
+                 size_t sampleCount, uint8_t* out) {
+  if (validity == DLF_VALIDITY_NONE) {
+    return decodeBlock(codec, typeSize, payload, payloadBytes, sampleCount,
+                       out);
+  }
+  const size_t bitmap = validityBitmapBytes(sampleCount);
+  if (payloadBytes < bitmap) {
+    return false;
+  }
+  auto valid = [&](size_t i) { return (payload[i / 8] >> (i % 8)) & 1; };
+  size_t stored = sampleCount;
+  if (validity == DLF_VALIDITY_OMIT) {
+    stored = 0;
+    for (size_t i = 0; i < sampleCount; i++) {
+      stored += valid(i);
+    }
+  }
+  if (!decodeBlock(codec, typeSize, payload + bitmap, payloadBytes - bitmap,
+                   stored, out)) {
+    return false;
+  }
+
+  // Spread the stored samples out to their places, back to front so that
+  // none is overwritten before it is moved
+  for (size_t i = sampleCount; i-- > 0;) {
+    if (valid(i)) {
+      if (validity == DLF_VALIDITY_OMIT) {
+        memmove(out + i * typeSize, out + --stored * typeSize, typeSize);
+      }
+    } else {
+      memset(out + i * typeSize, 0, typeSize);
+    }
+  }
+  return true;
+}
+
+}  // namespace dlf::format
@@ -0,0 +1,47 @@
+#include "dlflib/format/crc32.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_rom_crc.h>
+#endif
+
+namespace dlf::format {
+
+#ifdef ESP_PLATFORM
+
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc) {
+  return esp_rom_crc32_le(crc, data, len);
+}
+
+#else
+
+namespace {
+
+struct Crc32Table {
+  uint32_t entries[256];
+
+  constexpr Crc32Table() : entries() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      entries[i] = c;
+    }
+  }
+};
+
+constexpr Crc32Table TABLE;
+
+}  // namespace
+
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc = TABLE.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+#endif
+
+}  // namespace dlf::format
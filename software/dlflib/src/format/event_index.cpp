@@ -0,0 +1,52 @@
+#include "dlflib/format/event_index.h"
+
+namespace dlf::format {
+
+bool EventIndex::parse(const uint8_t* data, size_t len, size_t dataLength) {
+  entries_.clear();
+  dlf_event_index_header_t h;
+  if (len < sizeof(h)) {
+    return false;
+  }
+  memcpy(&h, data, sizeof(h));
+  if (h.magic != DLF_EVENT_INDEX_MAGIC) {
+    return false;
+  }
+  interval_ = h.index_interval;
+
+  for (size_t pos = sizeof(h); len - pos >= sizeof(dlf_event_index_entry_t);
+       pos += sizeof(dlf_event_index_entry_t)) {
+    dlf_event_index_entry_t e;
+    memcpy(&e, data + pos, sizeof(e));
+    if (e.byte_offset >= dataLength) {
+      break;
+    }
+    if (!entries_.empty() && (e.tick <= entries_.back().tick ||
+                              e.byte_offset <= entries_.back().byte_offset)) {
+      break;
+    }
+    entries_.push_back(e);
+  }
+  return true;
+}
+
+bool EventIndex::seek(dlf_tick_t tick, dlf_event_index_entry_t& out) const {
+  // First entry past `tick`
+  size_t lo = 0;
+  size_t hi = entries_.size();
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (entries_[mid].tick <= tick) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == 0) {
+    return false;
+  }
+  out = entries_[lo - 1];
+  return true;
+}
+
+}  // namespace dlf::format
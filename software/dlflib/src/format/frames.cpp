@@ -0,0 +1,260 @@
+#include "dlflib/format/frames.h"
+
+#include <algorithm>
+
+#include "dlflib/format/crc32.h"
+
+namespace dlf::format {
+
+namespace {
+
+size_t putFrameHeader(uint8_t* out, uint8_t flags, size_t storedBytes,
+                      size_t rawLen, dlf_tick_t firstTick,
+                      uint64_t rawOffset) {
+  dlf_frame_header_t h;
+  h.flags = flags;
+  h.stored_bytes = static_cast<uint16_t>(storedBytes);
+  h.raw_bytes = static_cast<uint16_t>(rawLen);
+  h.first_tick = firstTick;
+  h.raw_offset = rawOffset;
+  memcpy(out, &h, sizeof(h));
+  return sizeof(h);
+}
+
+}  // namespace
+
+size_t encodeFrame(Lz4Compressor& compressor, const uint8_t* raw,
+                   size_t rawLen, dlf_tick_t firstTick, uint64_t rawOffset,
+                   uint8_t flags, uint8_t* out) {
+  // Compress straight into place, but only keep the result if it is smaller
+  uint8_t* payload = out + sizeof(dlf_frame_header_t);
+  const size_t n = rawLen > 1
+                       ? compressor.compress(raw, rawLen, payload, rawLen - 1)
+                       : 0;
+  if (n == 0) {
+    return encodeStoredFrame(raw, rawLen, firstTick, rawOffset, flags, out);
+  }
+  return putFrameHeader(out, flags & ~DLF_FRAME_FLAG_STORED, n, rawLen,
+                        firstTick, rawOffset) +
+         n;
+}
+
+size_t encodeStoredFrame(const uint8_t* raw, size_t rawLen,
+                         dlf_tick_t firstTick, uint64_t rawOffset,
+                         uint8_t flags, uint8_t* out) {
+  const size_t h = putFrameHeader(out, flags | DLF_FRAME_FLAG_STORED, rawLen,
+                                  rawLen, firstTick, rawOffset);
+  memmove(out + h, raw, rawLen);
+  return h + rawLen;
+}
+
+size_t appendFrameCrc(uint8_t* frame, size_t frameLen) {
+  const uint32_t crc = crc32(frame, frameLen);
+  memcpy(frame + frameLen, &crc, sizeof(crc));
+  return frameLen + FRAME_CRC_BYTES;
+}
+
+FrameByteSource::FrameByteSource(ByteSource& file, size_t dataOffset,
+                                 bool checked)
+    : file_(file),
+      dataOffset_(dataOffset),
+      checked_(checked),
+      fileSize_(file.size()),
+      size_(dataOffset),
+      fileLength_(dataOffset) {
+  const size_t trailer = checked ? FRAME_CRC_BYTES : 0;
+  size_t pos = dataOffset;
+  uint64_t rawOffset = dataOffset;
+  size_t whole = 0;  // Frames up to the last tick boundary
+  while (pos < fileSize_) {
+    dlf_frame_header_t h;
+    if (headerAt(pos, h) && h.raw_offset == rawOffset) {
+      frames_.push_back({static_cast<uint32_t>(pos),
+                         static_cast<uint32_t>(rawOffset), h.stored_bytes,
+                         h.raw_bytes, h.flags, h.first_tick, false});
+      pos += sizeof(h) + h.stored_bytes + trailer;
+      rawOffset += h.raw_bytes;
+      if (!(h.flags & DLF_FRAME_FLAG_SPLIT)) {
+        whole = frames_.size();
+      }
+      continue;
+    }
+    if (!checked) {
+      // Torn or not a frame
+      break;
+    }
+
+    // Either this header is corrupted or the length in the one before it was,
+    // which led the walk astray
+    if (!frames_.empty() && !frames_.back().damaged &&
+        !readFrame(frames_.back().fileOffset, frames_.back().storedBytes)) {
+      pos = frames_.back().fileOffset;
+      rawOffset = frames_.back().rawOffset;
+      frames_.pop_back();
+      whole = std::min(whole, frames_.size());
+    }
+    size_t next;
+    if (!findFrame(pos + 1, rawOffset, next, h)) {
+      // Nothing intact follows, so this is the torn tail
+      break;
+    }
+    const dlf_tick_t tick = frames_.empty() ? 0 : frames_.back().firstTick;
+    frames_.push_back({static_cast<uint32_t>(pos),
+                       static_cast<uint32_t>(rawOffset),
+                       static_cast<uint32_t>(next - pos),
+                       static_cast<uint32_t>(h.raw_offset - rawOffset), 0,
+                       tick, true});
+    pos = next;
+    rawOffset = h.raw_offset;
+  }
+
+  frames_.resize(whole);
+  // A frame torn by the shutdown can still have a plausible header
+  while (checked && !frames_.empty()) {
+    const Frame& last = frames_.back();
+    if (!last.damaged && !(last.flags & DLF_FRAME_FLAG_SPLIT) &&
+        readFrame(last.fileOffset, last.storedBytes)) {
+      break;
+    }
+    frames_.pop_back();
+  }
+  if (!frames_.empty()) {
+    const Frame& last = frames_.back();
+    size_ = last.rawOffset + last.rawBytes;
+    fileLength_ = last.fileOffset + sizeof(dlf_frame_header_t) +
+                  last.storedBytes + trailer;
+  }
+}
+
+size_t FrameByteSource::read(size_t offset, uint8_t* dst, size_t len) {
+  size_t done = 0;
+  while (done < len && offset < size_) {
+    size_t n;
+    if (offset < dataOffset_) {
+      // The header is not framed
+      n = std::min(len - done, dataOffset_ - offset);
+      const size_t got = file_.read(offset, dst + done, n);
+      done += got;
+      offset += got;
+      if (got < n) {
+        break;
+      }
+      continue;
+    }
+
+    // Last frame starting at or before offset
+    auto it = std::upper_bound(
+        frames_.begin(), frames_.end(), offset,
+        [](size_t o, const Frame& f) { return o < f.rawOffset; });
+    const size_t index = (it - frames_.begin()) - 1;
+    if (!load(index)) {
+      break;
+    }
+    const Frame& f = frames_[index];
+    const size_t in = offset - f.rawOffset;
+    n = std::min(len - done, f.rawBytes - in);
+    memcpy(dst + done, raw_.data() + in, n);
+    done += n;
+    offset += n;
+  }
+  return done;
+}
+
+size_t FrameByteSource::frameForTick(dlf_tick_t tick) const {
+  if (frames_.empty()) {
+    return 0;
+  }
+  auto it = std::upper_bound(
+      frames_.begin(), frames_.end(), tick,
+      [](dlf_tick_t t, const Frame& f) { return t < f.firstTick; });
+  size_t index = it == frames_.begin() ? 0 : (it - frames_.begin()) - 1;
+  while (index > 0 && (frames_[index].flags & DLF_FRAME_FLAG_CONTINUED)) {
+    index--;
+  }
+  return index;
+}
+
+size_t FrameByteSource::resumeOffset(size_t offset) const {
+  auto it = std::upper_bound(
+      frames_.begin(), frames_.end(), offset,
+      [](size_t o, const Frame& f) { return o < f.rawOffset; });
+  for (; it != frames_.end(); ++it) {
+    if (!it->damaged && !(it->flags & DLF_FRAME_FLAG_CONTINUED)) {
+      return it->rawOffset;
+    }
+  }
+  return size_;
+}
+
+size_t FrameByteSource::damagedFrames() const {
+  return std::count_if(frames_.begin(), frames_.end(),
+                       [](const Frame& f) { return f.damaged; });
+}
+
+bool FrameByteSource::load(size_t index) {
+  if (index == loaded_) {
+    return true;
+  }
+  loaded_ = SIZE_MAX;
+  Frame& f = frames_[index];
+  if (f.damaged) {
+    return false;
+  }
+  if (!readFrame(f.fileOffset, f.storedBytes)) {
+    f.damaged = checked_;
+    return false;
+  }
+  const uint8_t* payload = stored_.data() + sizeof(dlf_frame_header_t);
+  raw_.resize(f.rawBytes);
+  if (f.flags & DLF_FRAME_FLAG_STORED) {
+    memcpy(raw_.data(), payload, f.rawBytes);
+  } else if (!lz4Decompress(payload, f.storedBytes, raw_.data(),
+                            f.rawBytes)) {
+    return false;
+  }
+  loaded_ = index;
+  return true;
+}
+
+bool FrameByteSource::headerAt(size_t pos, dlf_frame_header_t& h) {
+  if (file_.read(pos, reinterpret_cast<uint8_t*>(&h), sizeof(h)) !=
+      sizeof(h)) {
+    return false;
+  }
+  const size_t payloadPos = pos + sizeof(h);
+  const size_t trailer = checked_ ? FRAME_CRC_BYTES : 0;
+  return h.raw_bytes > 0 && h.stored_bytes > 0 &&
+         h.stored_bytes <= h.raw_bytes &&
+         (!(h.flags & DLF_FRAME_FLAG_STORED) ||
+          h.stored_bytes == h.raw_bytes) &&
+         payloadPos <= fileSize_ &&
+         fileSize_ - payloadPos >= h.stored_bytes + trailer;
+}
+
+bool FrameByteSource::readFrame(size_t fileOffset, size_t storedBytes) {
+  const size_t frameBytes = sizeof(dlf_frame_header_t) + storedBytes;
+  const size_t len = frameBytes + (checked_ ? FRAME_CRC_BYTES : 0);
+  stored_.resize(len);
+  if (file_.read(fileOffset, stored_.data(), len) != len) {
+    return false;
+  }
+  if (!checked_) {
+    return true;
+  }
+  uint32_t crc;
+  memcpy(&crc, stored_.data() + frameBytes, sizeof(crc));
+  return crc == crc32(stored_.data(), frameBytes);
+}
+
+bool FrameByteSource::findFrame(size_t from, uint64_t rawOffset, size_t& pos,
+                                dlf_frame_header_t& h) {
+  for (pos = from; pos + sizeof(h) <= fileSize_; pos++) {
+    if (headerAt(pos, h) && h.raw_offset > rawOffset &&
+        readFrame(pos, h.stored_bytes)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace dlf::format
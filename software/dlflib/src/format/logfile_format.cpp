@@ -0,0 +1,137 @@
+#include "dlflib/format/logfile_format.h"
+
+namespace dlf::format {
+
+namespace {
+
+bool skipString(const uint8_t* data, size_t len, size_t& pos) {
+  const void* nul = memchr(data + pos, 0, len - pos);
+  if (nul == nullptr) {
+    return false;
+  }
+  pos = static_cast<const uint8_t*>(nul) - data + 1;
+  return true;
+}
+
+template <typename T>
+bool readValue(const uint8_t* data, size_t len, size_t& pos, T& out) {
+  if (len - pos < sizeof(T)) {
+    return false;
+  }
+  memcpy(&out, data + pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+}  // namespace
+
+bool parseLogfileHeader(const uint8_t* data, size_t len, LogfileInfo& out) {
+  dlf_logfile_header_t h;
+  if (data == nullptr || len < sizeof(h)) {
+    return false;
+  }
+  memcpy(&h, data, sizeof(h));
+  if (h.magic != DLF_MAGIC) {
+    return false;
+  }
+
+  size_t pos = sizeof(h);
+  const uint8_t rawType = static_cast<uint8_t>(h.stream_type);
+  out.streamType =
+      static_cast<dlf_stream_type_e>(rawType & DLF_LOGFILE_STREAM_TYPE_MASK);
+  out.tickSpan = h.tick_span;
+  out.extended = (rawType & DLF_LOGFILE_EXTENDED) != 0;
+  out.ext = dlf_logfile_ext_header_t();
+  out.ext.ext_size = 0;
+
+  if (out.extended) {
+    uint16_t extSize;
+    if (!readValue(data, len, pos, extSize) || extSize < sizeof(extSize) ||
+        len - (pos - sizeof(extSize)) < extSize) {
+      return false;
+    }
+    // Older writers may produce a shorter extension (missing fields stay
+    // default) and newer ones a longer one (unknown fields are skipped).
+    const size_t known = extSize < sizeof(out.ext) ? extSize : sizeof(out.ext);
+    memcpy(&out.ext, data + pos - sizeof(extSize), known);
+    pos += extSize - sizeof(extSize);
+  }
+
+  out.streams.clear();
+  out.streams.reserve(h.num_streams);
+  for (uint16_t i = 0; i < h.num_streams; i++) {
+    LogfileStreamInfo s;
+    if (!skipString(data, len, pos) ||  // type_structure
+        !skipString(data, len, pos) ||  // id
+        !skipString(data, len, pos) ||  // notes
+        !readValue(data, len, pos, s.typeSize)) {
+      return false;
+    }
+    if (out.streamType == POLLED) {
+      dlf_polled_stream_header_segment_t seg;
+      if (!readValue(data, len, pos, seg)) {
+        return false;
+      }
+      s.tickInterval = seg.tick_interval;
+      s.tickPhase = seg.tick_phase;
+
+      if (out.ext.flags & DLF_LOGFILE_FLAG_STREAM_CODECS) {
+        dlf_polled_stream_codec_segment_t codec;
+        if (!readValue(data, len, pos, codec)) {
+          return false;
+        }
+        s.codec = static_cast<dlf_codec_e>(codec.codec);
+        s.blockSamples = codec.block_samples;
+      }
+      if (out.ext.flags & DLF_LOGFILE_FLAG_VALIDITY) {
+        dlf_polled_stream_validity_segment_t validity;
+        if (!readValue(data, len, pos, validity)) {
+          return false;
+        }
+        s.validity = static_cast<dlf_validity_e>(validity.validity);
+      }
+    } else if (out.ext.flags & DLF_LOGFILE_FLAG_VARIABLE_EVENTS) {
+      dlf_event_stream_segment_t seg;
+      if (!readValue(data, len, pos, seg)) {
+        return false;
+      }
+      s.variable = (seg.flags & DLF_EVENT_STREAM_VARIABLE) != 0;
+    }
+    out.streams.push_back(s);
+  }
+
+  out.dataOffset = pos;
+  return true;
+}
+
+bool checkpointAt(const uint8_t* data, size_t len, size_t pos,
+                  dlf_checkpoint_t* out) {
+  dlf_checkpoint_t c;
+  if (pos > len || len - pos < sizeof(c)) {
+    return false;
+  }
+  memcpy(&c, data + pos, sizeof(c));
+  if (c.marker != DLF_CHECKPOINT_STREAM_IDX || c.byte_offset != pos) {
+    return false;
+  }
+  if (out != nullptr) {
+    *out = c;
+  }
+  return true;
+}
+
+bool findLastCheckpoint(const uint8_t* data, size_t len, size_t dataOffset,
+                        dlf_checkpoint_t& out, size_t& pos) {
+  if (len < sizeof(dlf_checkpoint_t)) {
+    return false;
+  }
+  for (size_t p = len - sizeof(dlf_checkpoint_t) + 1; p-- > dataOffset;) {
+    if (checkpointAt(data, len, p, &out)) {
+      pos = p;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace dlf::format
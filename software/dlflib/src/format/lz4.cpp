@@ -0,0 +1,172 @@
+#include "dlflib/format/lz4.h"
+
+namespace dlf::format {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+// The last match must start this many bytes before the end of the input, and
+// the last this many bytes are always literals (LZ4 block format rules)
+constexpr size_t MF_LIMIT = 12;
+constexpr size_t LAST_LITERALS = 5;
+constexpr size_t MAX_DISTANCE = 65535;
+
+uint32_t read32(const uint8_t* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Bounded output cursor. Writes past the end only set `overflow`.
+struct Output {
+  uint8_t* data;
+  size_t capacity;
+  size_t len = 0;
+  bool overflow = false;
+
+  bool reserve(size_t n) {
+    if (capacity - len < n) {
+      overflow = true;
+    }
+    return !overflow;
+  }
+
+  // Length continuation bytes for a field whose nibble was saturated
+  void putLength(size_t n) {
+    while (n >= 255) {
+      data[len++] = 255;
+      n -= 255;
+    }
+    data[len++] = static_cast<uint8_t>(n);
+  }
+
+  /**
+   * Appends one sequence. `matchLen` of 0 marks the final, literal-only one.
+   */
+  void putSequence(const uint8_t* literals, size_t litLen, size_t offset,
+                   size_t matchLen) {
+    const size_t mlCode = matchLen > 0 ? matchLen - MIN_MATCH : 0;
+    if (!reserve(1 + litLen / 255 + 1 + litLen + 2 + mlCode / 255 + 1)) {
+      return;
+    }
+    uint8_t& token = data[len++];
+    token = (litLen >= 15 ? 15 : litLen) << 4;
+    if (litLen >= 15) {
+      putLength(litLen - 15);
+    }
+    memcpy(data + len, literals, litLen);
+    len += litLen;
+    if (matchLen == 0) {
+      return;
+    }
+    data[len++] = static_cast<uint8_t>(offset);
+    data[len++] = static_cast<uint8_t>(offset >> 8);
+    token |= mlCode >= 15 ? 15 : mlCode;
+    if (mlCode >= 15) {
+      putLength(mlCode - 15);
+    }
+  }
+};
+
+// Reads the continuation bytes of a saturated length field
+bool getLength(const uint8_t* src, size_t len, size_t& pos, size_t& n) {
+  uint8_t b;
+  do {
+    if (pos >= len) {
+      return false;
+    }
+    b = src[pos++];
+    n += b;
+  } while (b == 255);
+  return true;
+}
+
+}  // namespace
+
+size_t Lz4Compressor::compress(const uint8_t* src, size_t len, uint8_t* dst,
+                               size_t dstCapacity) {
+  if (len > UINT16_MAX) {
+    return 0;
+  }
+  Output out{dst, dstCapacity};
+  size_t anchor = 0;
+
+  if (len > MF_LIMIT) {
+    memset(table_, 0, sizeof(table_));
+    const size_t matchEnd = len - LAST_LITERALS;
+    const size_t lastStart = len - MF_LIMIT;
+    size_t ip = 1;
+    while (ip <= lastStart && !out.overflow) {
+      const uint32_t seq = read32(src + ip);
+      const uint32_t h = (seq * 2654435761u) >> (32 - HASH_LOG);
+      size_t ref = table_[h];
+      table_[h] = static_cast<uint16_t>(ip);
+      if (ref >= ip || ip - ref > MAX_DISTANCE || read32(src + ref) != seq) {
+        ip++;
+        continue;
+      }
+
+      // Grow the match backwards over pending literals, then forwards
+      while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+        ip--;
+        ref--;
+      }
+      size_t matchLen = MIN_MATCH;
+      while (ip + matchLen < matchEnd &&
+             src[ip + matchLen] == src[ref + matchLen]) {
+        matchLen++;
+      }
+      out.putSequence(src + anchor, ip - anchor, ip - ref, matchLen);
+      ip += matchLen;
+      anchor = ip;
+    }
+  }
+
+  out.putSequence(src + anchor, len - anchor, 0, 0);
+  return out.overflow ? 0 : out.len;
+}
+
+bool lz4Decompress(const uint8_t* src, size_t len, uint8_t* dst,
+                   size_t dstLen) {
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < len) {
+    const uint8_t token = src[ip++];
+
+    size_t litLen = token >> 4;
+    if (litLen == 15 && !getLength(src, len, ip, litLen)) {
+      return false;
+    }
+    if (litLen > len - ip || litLen > dstLen - op) {
+      return false;
+    }
+    memcpy(dst + op, src + ip, litLen);
+    ip += litLen;
+    op += litLen;
+    if (ip == len) {
+      // The final sequence has no match
+      return op == dstLen;
+    }
+
+    if (len - ip < 2) {
+      return false;
+    }
+    const size_t offset = src[ip] | (src[ip + 1] << 8);
+    ip += 2;
+    size_t matchLen = token & 15;
+    if (matchLen == 15 && !getLength(src, len, ip, matchLen)) {
+      return false;
+    }
+    matchLen += MIN_MATCH;
+    if (offset == 0 || offset > op || matchLen > dstLen - op) {
+      return false;
+    }
+    // Byte by byte, since the match may overlap the bytes it produces
+    for (size_t i = 0; i < matchLen; i++, op++) {
+      dst[op] = dst[op - offset];
+    }
+  }
+  return false;
+}
+
+}  // namespace dlf::format
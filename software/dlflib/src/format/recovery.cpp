@@ -0,0 +1,595 @@
+#include "dlflib/format/recovery.h"
+
+#include <algorithm>
+
+#include "dlflib/format/codec.h"
+
+namespace dlf::format {
+
+namespace {
+
+// Stream headers are short strings; anything bigger is not a DLF header
+constexpr size_t MAX_HEADER_BYTES = 64 * 1024;
+
+struct Schedule {
+  dlf_tick_t interval;
+  dlf_tick_t first;  // First tick t >= 0 with (t + phase) % interval == 0
+};
+
+Schedule schedule(const LogfileStreamInfo& s) {
+  const dlf_tick_t interval = s.tickInterval == 0 ? 1 : s.tickInterval;
+  return {interval, (interval - s.tickPhase % interval) % interval};
+}
+
+// Smallest due tick >= t
+dlf_tick_t nextDue(const Schedule& s, dlf_tick_t t) {
+  if (t <= s.first) {
+    return s.first;
+  }
+  return s.first + (t - s.first + s.interval - 1) / s.interval * s.interval;
+}
+
+// Checks for a checkpoint record at `rec`, which holds `avail` bytes read from
+// file offset `filePos`
+bool checkpointIn(const uint8_t* rec, size_t avail, size_t filePos,
+                  dlf_checkpoint_t& out) {
+  if (avail < sizeof(out)) {
+    return false;
+  }
+  memcpy(&out, rec, sizeof(out));
+  return out.marker == DLF_CHECKPOINT_STREAM_IDX && out.byte_offset == filePos;
+}
+
+// Checks for the header of a keyframe record at `rec`, like checkpointIn()
+bool keyframeIn(const uint8_t* rec, size_t avail, size_t filePos,
+                dlf_keyframe_t& out) {
+  if (avail < sizeof(out)) {
+    return false;
+  }
+  memcpy(&out, rec, sizeof(out));
+  return out.marker == DLF_KEYFRAME_STREAM_IDX && out.byte_offset == filePos;
+}
+
+// Checks for a time anchor record at `rec`, like checkpointIn()
+bool timeAnchorIn(const uint8_t* rec, size_t avail, size_t filePos,
+                  dlf_time_anchor_t& out) {
+  if (avail < sizeof(out)) {
+    return false;
+  }
+  memcpy(&out, rec, sizeof(out));
+  return out.marker == DLF_TIME_ANCHOR_STREAM_IDX && out.byte_offset == filePos;
+}
+
+// Checks for a block cut record at `rec`, like checkpointIn()
+bool blockCutIn(const uint8_t* rec, size_t avail, size_t filePos,
+                dlf_block_cut_t& out) {
+  if (avail < sizeof(out)) {
+    return false;
+  }
+  memcpy(&out, rec, sizeof(out));
+  return out.marker == DLF_BLOCK_CUT_STREAM_IDX && out.byte_offset == filePos;
+}
+
+}  // namespace
+
+bool readLogfileHeader(ByteSource& src, LogfileInfo& out) {
+  const size_t fileSize = src.size();
+  std::vector<uint8_t> buf;
+  for (size_t window = 512;; window *= 2) {
+    const size_t n = window < fileSize ? window : fileSize;
+    buf.resize(n);
+    if (src.read(0, buf.data(), n) != n) {
+      return false;
+    }
+    if (parseLogfileHeader(buf.data(), n, out)) {
+      return true;
+    }
+    if (n == fileSize || window >= MAX_HEADER_BYTES) {
+      return false;
+    }
+  }
+}
+
+uint64_t polledBytesBefore(const LogfileInfo& info, dlf_tick_t ticks) {
+  uint64_t bytes = 0;
+  for (const auto& s : info.streams) {
+    const Schedule sch = schedule(s);
+    if (ticks > sch.first) {
+      bytes += (1 + (ticks - 1 - sch.first) / sch.interval) * s.typeSize;
+    }
+  }
+  return bytes;
+}
+
+uint64_t polledSamplesIn(const LogfileStreamInfo& stream, dlf_tick_t first,
+                         dlf_tick_t count) {
+  const Schedule sch = schedule(stream);
+  auto before = [&sch](dlf_tick_t t) -> uint64_t {
+    return t > sch.first ? 1 + (t - 1 - sch.first) / sch.interval : 0;
+  };
+  return before(first + count) - before(first);
+}
+
+RecoveryScanner::RecoveryScanner(ByteSource& src, const LogfileInfo& info,
+                                 size_t tailScanBytes)
+    : src_(src),
+      info_(info),
+      fileSize_(src.size()),
+      checkpoints_((info.ext.flags & DLF_LOGFILE_FLAG_CHECKPOINTS) != 0),
+      pos_(info.dataOffset),
+      pending_(info.streams.size(), 0) {
+  result_.validLength = pos_;
+  seekToLastCheckpoint(tailScanBytes);
+}
+
+bool RecoveryScanner::step(size_t maxBytes) {
+  if (result_.complete) {
+    return true;
+  }
+  if (pos_ > fileSize_) {
+    // Header claims more bytes than the file has
+    result_.complete = true;
+    return true;
+  }
+
+  bool done;
+  if (info_.streamType == POLLED) {
+    done = stepPolled(maxBytes);
+  } else if (info_.compactEvents()) {
+    done = stepCompactEvent(maxBytes);
+  } else {
+    done = stepEvent(maxBytes);
+  }
+  result_.validLength = pos_;
+  result_.complete = done;
+  return done;
+}
+
+bool RecoveryScanner::stepPolled(size_t maxBytes) {
+  if (!checkpoints_ && !info_.hasCodedStreams() && !info_.columnar()) {
+    // Without checkpoints, tick frames are back to back, so the number of
+    // whole ticks in the file follows from its size.
+    const uint64_t dataLen = fileSize_ - info_.dataOffset;
+    bool anyData = false;
+    for (const auto& s : info_.streams) {
+      anyData |= s.typeSize > 0;
+    }
+    if (!anyData) {
+      return true;
+    }
+
+    // Largest tick count whose data fits
+    dlf_tick_t lo = 0;
+    dlf_tick_t hi = 1;
+    while (polledBytesBefore(info_, hi) <= dataLen) {
+      lo = hi;
+      hi *= 2;
+    }
+    while (hi - lo > 1) {
+      dlf_tick_t mid = lo + (hi - lo) / 2;
+      (polledBytesBefore(info_, mid) <= dataLen ? lo : hi) = mid;
+    }
+    const uint64_t validBytes = polledBytesBefore(info_, lo);
+
+    // Ticks past the last sample carry no data. Report the tick that wrote
+    // the last sample rather than guessing how far the sampler got.
+    dlf_tick_t first = 0;
+    hi = lo;
+    while (first < hi) {
+      dlf_tick_t mid = first + (hi - first) / 2;
+      if (polledBytesBefore(info_, mid) < validBytes) {
+        first = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    pos_ = info_.dataOffset + validBytes;
+    if (first > 0) {
+      noteTick(first - 1);
+    }
+    return true;
+  }
+
+  std::vector<Schedule> schedules;
+  schedules.reserve(info_.streams.size());
+  for (const auto& s : info_.streams) {
+    schedules.push_back(schedule(s));
+  }
+
+  for (size_t scanned = 0; scanned < maxBytes;) {
+    // A checkpoint or block cut may follow any tick's data
+    if (pos_ != lastCheckedPos_) {
+      lastCheckedPos_ = pos_;
+      static_assert(sizeof(dlf_block_cut_t) == sizeof(dlf_checkpoint_t),
+                    "records are told apart by their marker");
+      uint8_t buf[sizeof(dlf_checkpoint_t)];
+      dlf_checkpoint_t c;
+      dlf_block_cut_t cut;
+      size_t n = read(pos_, buf, sizeof(buf));
+      if (checkpointIn(buf, n, pos_, c)) {
+        // The writer cuts every open block before a checkpoint
+        std::fill(pending_.begin(), pending_.end(), 0);
+        noteTick(c.tick_span);
+        nextTick_ = c.tick_span + 1;
+        pos_ += sizeof(c);
+        scanned += sizeof(c);
+        continue;
+      }
+      if (info_.blockCuts() && blockCutIn(buf, n, pos_, cut)) {
+        size_t cutBytes;
+        if (!blockCutAt(cut, cutBytes)) {
+          return true;
+        }
+        pos_ += cutBytes;
+        scanned += cutBytes;
+        continue;
+      }
+    }
+
+    if (info_.columnar()) {
+      size_t blockBytes;
+      if (!columnBlockAt(blockBytes)) {
+        return true;
+      }
+      pos_ += blockBytes;
+      scanned += blockBytes;
+      continue;
+    }
+
+    // Next tick on which any stream writes data
+    bool any = false;
+    dlf_tick_t tick = 0;
+    for (size_t i = 0; i < schedules.size(); i++) {
+      if (info_.streams[i].typeSize == 0) {
+        continue;
+      }
+      dlf_tick_t due = nextDue(schedules[i], nextTick_);
+      if (!any || due < tick) {
+        tick = due;
+        any = true;
+      }
+    }
+    if (!any) {
+      return true;
+    }
+
+    size_t tickBytes = 0;
+    for (size_t i = 0; i < schedules.size(); i++) {
+      const LogfileStreamInfo& s = info_.streams[i];
+      if (nextDue(schedules[i], tick) != tick) {
+        continue;
+      }
+      if (!s.blocked()) {
+        tickBytes += s.typeSize;
+        continue;
+      }
+
+      // Coded streams only write on the tick that fills a block
+      uint64_t samples;
+      if (info_.blockCuts()) {
+        samples = ++pending_[i];
+      } else {
+        samples = (tick - schedules[i].first) / schedules[i].interval + 1;
+      }
+      if (s.blockSamples == 0 || samples % s.blockSamples != 0) {
+        continue;
+      }
+      pending_[i] = 0;
+      dlf_codec_block_header_t b;
+      if (read(pos_ + tickBytes, reinterpret_cast<uint8_t*>(&b), sizeof(b)) !=
+              sizeof(b) ||
+          b.sample_count != s.blockSamples) {
+        return true;
+      }
+      tickBytes += sizeof(b) + b.payload_bytes;
+    }
+    if (tickBytes > fileSize_ - pos_) {
+      return true;
+    }
+
+    // Samples of coded streams are only in the file once their block is, so
+    // a tick with nothing written yet does not count as recovered
+    pos_ += tickBytes;
+    scanned += tickBytes;
+    if (tickBytes > 0) {
+      noteTick(tick);
+    }
+    nextTick_ = tick + 1;
+  }
+  return false;
+}
+
+bool RecoveryScanner::blockCutAt(const dlf_block_cut_t& cut,
+                                 size_t& cutBytes) {
+  // The cut follows the data of its tick, so no tick before pos_ is later
+  if (cut.tick + 1 < nextTick_) {
+    return false;
+  }
+
+  cutBytes = sizeof(cut);
+  for (size_t i = 0; i < info_.streams.size(); i++) {
+    const LogfileStreamInfo& s = info_.streams[i];
+    const uint64_t samples =
+        polledSamplesIn(s, nextTick_, cut.tick + 1 - nextTick_);
+    if (!s.blocked()) {
+      // Raw samples of the skipped ticks would come before the cut
+      if (s.typeSize > 0 && samples > 0) {
+        return false;
+      }
+      continue;
+    }
+
+    // A full block would have been written by its tick
+    const uint64_t pending = pending_[i] + samples;
+    if (pending == 0) {
+      continue;
+    }
+    if (s.blockSamples > 0 && pending >= s.blockSamples) {
+      return false;
+    }
+    dlf_codec_block_header_t b;
+    if (read(pos_ + cutBytes, reinterpret_cast<uint8_t*>(&b), sizeof(b)) !=
+            sizeof(b) ||
+        b.sample_count != pending) {
+      return false;
+    }
+    cutBytes += sizeof(b) + b.payload_bytes;
+  }
+  if (cutBytes > fileSize_ - pos_) {
+    return false;
+  }
+
+  std::fill(pending_.begin(), pending_.end(), 0);
+  noteTick(cut.tick);
+  nextTick_ = cut.tick + 1;
+  return true;
+}
+
+bool RecoveryScanner::columnBlockAt(size_t& blockBytes) {
+  dlf_column_block_header_t h;
+  if (read(pos_, reinterpret_cast<uint8_t*>(&h), sizeof(h)) != sizeof(h) ||
+      h.tick_count == 0) {
+    return false;
+  }
+  // Blocks cover consecutive ticks. The first one starts wherever the
+  // sampler did.
+  if ((pos_ != info_.dataOffset || result_.hasTicks) &&
+      h.first_tick != nextTick_) {
+    return false;
+  }
+
+  blockBytes = sizeof(h);
+  size_t lenPos = pos_ + sizeof(h);
+  for (const auto& s : info_.streams) {
+    uint32_t len;
+    if (read(lenPos, reinterpret_cast<uint8_t*>(&len), sizeof(len)) !=
+        sizeof(len)) {
+      return false;
+    }
+    lenPos += sizeof(len);
+    // Raw columns have an exact size; others are bounded by the codec
+    const uint64_t samples = polledSamplesIn(s, h.first_tick, h.tick_count);
+    const uint64_t limit =
+        !s.blocked()
+            ? samples * s.typeSize
+            : maxBlockBytes(s.codec, s.typeSize, samples, s.validity);
+    if (len > limit || (!s.blocked() && len != limit)) {
+      return false;
+    }
+    blockBytes += sizeof(len) + len;
+  }
+  if (blockBytes > fileSize_ - pos_) {
+    return false;
+  }
+  noteTick(h.first_tick + h.tick_count - 1);
+  nextTick_ = h.first_tick + h.tick_count;
+  return true;
+}
+
+bool RecoveryScanner::stepEvent(size_t maxBytes) {
+  for (size_t scanned = 0; scanned < maxBytes;) {
+    dlf_event_stream_sample_t h;
+    if (read(pos_, reinterpret_cast<uint8_t*>(&h), sizeof(h)) != sizeof(h)) {
+      return true;
+    }
+
+    size_t recordBytes;
+    dlf_tick_t tick;
+    if (h.stream == DLF_CHECKPOINT_STREAM_IDX && checkpoints_) {
+      uint8_t buf[sizeof(dlf_checkpoint_t)];
+      dlf_checkpoint_t c;
+      size_t n = read(pos_, buf, sizeof(buf));
+      if (!checkpointIn(buf, n, pos_, c)) {
+        return true;
+      }
+      recordBytes = sizeof(c);
+      tick = c.tick_span;
+    } else if (h.stream == DLF_KEYFRAME_STREAM_IDX && info_.keyframes()) {
+      uint8_t buf[sizeof(dlf_keyframe_t)];
+      dlf_keyframe_t k;
+      size_t n = read(pos_, buf, sizeof(buf));
+      if (!keyframeIn(buf, n, pos_, k)) {
+        return true;
+      }
+      recordBytes = info_.keyframeBytes();
+      tick = k.tick;
+    } else if (h.stream == DLF_TIME_ANCHOR_STREAM_IDX &&
+               info_.timeAnchors()) {
+      uint8_t buf[sizeof(dlf_time_anchor_t)];
+      dlf_time_anchor_t a;
+      size_t n = read(pos_, buf, sizeof(buf));
+      if (!timeAnchorIn(buf, n, pos_, a)) {
+        return true;
+      }
+      recordBytes = sizeof(a);
+      tick = a.tick;
+    } else if (h.stream < info_.streams.size()) {
+      const LogfileStreamInfo& s = info_.streams[h.stream];
+      size_t valueBytes = s.typeSize;
+      if (s.variable && !messageAt(pos_ + sizeof(h), s, valueBytes)) {
+        return true;
+      }
+      recordBytes = sizeof(h) + valueBytes;
+      tick = h.sample_tick;
+    } else {
+      return true;
+    }
+
+    // Records are written in tick order, so going back in time means garbage
+    if ((result_.hasTicks && tick < lastTick_) ||
+        recordBytes > fileSize_ - pos_) {
+      return true;
+    }
+
+    pos_ += recordBytes;
+    scanned += recordBytes;
+    lastTick_ = tick;
+    noteTick(tick);
+  }
+  return false;
+}
+
+bool RecoveryScanner::stepCompactEvent(size_t maxBytes) {
+  for (size_t scanned = 0; scanned < maxBytes;) {
+    size_t p = pos_;
+    uint64_t delta, count;
+    if (!readVarint(p, delta) || !readVarint(p, count)) {
+      return true;
+    }
+    const dlf_tick_t tick = lastTick_ + delta;
+
+    if (count == 0) {
+      // Empty group: a checkpoint, keyframe or time anchor for this tick
+      // follows
+      uint8_t buf[sizeof(dlf_time_anchor_t)];
+      dlf_checkpoint_t c;
+      dlf_keyframe_t k;
+      dlf_time_anchor_t a;
+      size_t n = read(p, buf, sizeof(buf));
+      if (checkpoints_ && checkpointIn(buf, n, p, c) && c.tick_span == tick) {
+        p += sizeof(c);
+      } else if (info_.keyframes() && keyframeIn(buf, n, p, k) &&
+                 k.tick == tick && info_.keyframeBytes() <= fileSize_ - p) {
+        p += info_.keyframeBytes();
+      } else if (info_.timeAnchors() && timeAnchorIn(buf, n, p, a) &&
+                 a.tick == tick) {
+        p += sizeof(a);
+      } else {
+        return true;
+      }
+    } else {
+      // Only the first group of the file can be at tick 0, and streams
+      // appear in index order, each at most once unless it holds messages
+      if ((delta == 0 && pos_ != info_.dataOffset) ||
+          (count > info_.streams.size() && !info_.hasVariableStreams())) {
+        return true;
+      }
+      uint64_t prevIdx = 0;
+      for (uint64_t i = 0; i < count; i++) {
+        uint64_t idx;
+        if (!readVarint(p, idx) || idx >= info_.streams.size() ||
+            (i > 0 && idx < prevIdx)) {
+          return true;
+        }
+        const LogfileStreamInfo& s = info_.streams[idx];
+        if (i > 0 && idx == prevIdx && !s.variable) {
+          return true;
+        }
+        prevIdx = idx;
+        size_t valueBytes = s.typeSize;
+        if (s.variable && !messageAt(p, s, valueBytes)) {
+          return true;
+        }
+        if (valueBytes > fileSize_ - p) {
+          return true;
+        }
+        p += valueBytes;
+      }
+    }
+
+    scanned += p - pos_;
+    pos_ = p;
+    lastTick_ = tick;
+    noteTick(tick);
+  }
+  return false;
+}
+
+bool RecoveryScanner::messageAt(size_t offset, const LogfileStreamInfo& s,
+                                size_t& valueBytes) {
+  uint64_t len;
+  const size_t start = offset;
+  if (!readVarint(offset, len) || len > s.typeSize) {
+    return false;
+  }
+  valueBytes = offset - start + len;
+  return true;
+}
+
+bool RecoveryScanner::readVarint(size_t& offset, uint64_t& v) {
+  uint8_t buf[10];
+  const size_t n = getVarint(buf, read(offset, buf, sizeof(buf)), v);
+  offset += n;
+  return n > 0;
+}
+
+void RecoveryScanner::seekToLastCheckpoint(size_t tailScanBytes) {
+  if (!checkpoints_ ||
+      fileSize_ < info_.dataOffset + sizeof(dlf_checkpoint_t)) {
+    return;
+  }
+
+  const size_t scanStart = fileSize_ - info_.dataOffset > tailScanBytes
+                               ? fileSize_ - tailScanBytes
+                               : info_.dataOffset;
+
+  // Walk backward in chunks, overlapping by one checkpoint so that records
+  // straddling a chunk boundary are seen
+  uint8_t buf[512 + sizeof(dlf_checkpoint_t) - 1];
+  size_t end = fileSize_;
+  while (end > scanStart) {
+    const size_t chunk = end - scanStart < 512 ? end - scanStart : 512;
+    const size_t start = end - chunk;
+    const size_t avail = fileSize_ - start < sizeof(buf) ? fileSize_ - start
+                                                         : sizeof(buf);
+    const size_t n = src_.read(start, buf, avail);
+
+    for (size_t p = start + chunk; p-- > start;) {
+      dlf_checkpoint_t c;
+      if (p - start < n && checkpointIn(buf + (p - start), n - (p - start), p,
+                                        c)) {
+        pos_ = p + sizeof(c);
+        nextTick_ = c.tick_span + 1;
+        lastTick_ = c.tick_span;
+        noteTick(c.tick_span);
+        result_.validLength = pos_;
+        return;
+      }
+    }
+    end = start;
+  }
+}
+
+void RecoveryScanner::noteTick(dlf_tick_t tick) {
+  if (!result_.hasTicks || tick > result_.tickSpan) {
+    result_.tickSpan = tick;
+  }
+  result_.hasTicks = true;
+}
+
+size_t RecoveryScanner::read(size_t offset, uint8_t* dst, size_t len) {
+  // Records are small and read in file order, so serve them from a window
+  // rather than hitting the filesystem for each one
+  if (offset < cacheStart_ || offset + len > cacheStart_ + cacheLen_) {
+    cacheStart_ = offset;
+    cacheLen_ = src_.read(offset, cache_, sizeof(cache_));
+  }
+  size_t avail = cacheStart_ + cacheLen_ - offset;
+  if (len > avail) {
+    len = avail;
+  }
+  memcpy(dst, cache_ + (offset - cacheStart_), len);
+  return len;
+}
+
+}  // namespace dlf::format
@@ -0,0 +1,129 @@
+#include "dlflib/format/run_container.h"
+
+#include <algorithm>
+
+namespace dlf::format {
+
+RunContainerReader::RunContainerReader(ByteSource& file) : file_(file) {
+  const size_t size = file.size();
+  const size_t headerBytes =
+      file.read(0, reinterpret_cast<uint8_t*>(&header_), sizeof(header_));
+  if (headerBytes < offsetof(dlf_run_container_header_t, state) ||
+      header_.magic != DLF_RUN_CONTAINER_MAGIC ||
+      header_.header_size < offsetof(dlf_run_container_header_t, state) ||
+      header_.header_size > size) {
+    return;
+  }
+  valid_ = true;
+
+  size_t pos = header_.header_size;
+  validLength_ = pos;
+  dlf_section_header_t h;
+  while (file.read(pos, reinterpret_cast<uint8_t*>(&h), sizeof(h)) ==
+         sizeof(h)) {
+    const size_t dataOffset = pos + sizeof(h);
+    if (h.tag == 0 || h.length > size - dataOffset) {
+      // Torn, or never written
+      break;
+    }
+    if (h.tag < DLF_SECTION_TAG_COUNT) {
+      if (counts_[h.tag] % INDEX_STRIDE == 0) {
+        index_[h.tag].push_back({static_cast<uint32_t>(dataOffset),
+                                 static_cast<uint32_t>(bytes_[h.tag]),
+                                 h.length});
+      }
+      counts_[h.tag]++;
+      bytes_[h.tag] += h.length;
+      if (h.tag == DLF_SECTION_COMMIT && h.length >= sizeof(commit_) &&
+          file.read(dataOffset, reinterpret_cast<uint8_t*>(&commit_),
+                    sizeof(commit_)) == sizeof(commit_)) {
+        hasCommit_ = true;
+      }
+    }
+    pos = dataOffset + h.length;
+    validLength_ = pos;
+  }
+}
+
+uint64_t RunContainerReader::sectionBytes(dlf_section_tag_e tag) const {
+  return tag < DLF_SECTION_TAG_COUNT ? bytes_[tag] : 0;
+}
+
+bool RunContainerReader::lastCommit(dlf_container_commit_t& out) const {
+  if (hasCommit_) {
+    out = commit_;
+  }
+  return hasCommit_;
+}
+
+size_t RunContainerReader::readSection(dlf_section_tag_e tag, size_t offset,
+                                       uint8_t* dst, size_t len) {
+  size_t done = 0;
+  while (done < len && offset < sectionBytes(tag)) {
+    Section s;
+    if (!find(tag, offset, s)) {
+      break;
+    }
+    const size_t in = offset - s.logicalOffset;
+    const size_t n = std::min(len - done, s.length - in);
+    const size_t got = file_.read(s.dataOffset + in, dst + done, n);
+    done += got;
+    offset += got;
+    if (got < n) {
+      break;
+    }
+  }
+  return done;
+}
+
+bool RunContainerReader::find(dlf_section_tag_e tag, size_t offset,
+                              Section& out) {
+  if (tag >= DLF_SECTION_TAG_COUNT || index_[tag].empty()) {
+    return false;
+  }
+
+  // Start from the last section read when reading on, and from the nearest
+  // indexed section otherwise
+  Section s = cursor_[tag];
+  if (s.length == 0 || offset < s.logicalOffset) {
+    const auto& index = index_[tag];
+    auto it = std::upper_bound(
+        index.begin(), index.end(), offset,
+        [](size_t o, const Section& e) { return o < e.logicalOffset; });
+    s = it == index.begin() ? index.front() : *(it - 1);
+  }
+
+  size_t pos = s.dataOffset + s.length;
+  while (offset >= s.logicalOffset + s.length) {
+    dlf_section_header_t h;
+    if (pos + sizeof(h) > validLength_ ||
+        file_.read(pos, reinterpret_cast<uint8_t*>(&h), sizeof(h)) !=
+            sizeof(h)) {
+      return false;
+    }
+    if (h.tag == tag) {
+      s = {static_cast<uint32_t>(pos + sizeof(h)),
+           s.logicalOffset + s.length, h.length};
+    }
+    pos += sizeof(h) + h.length;
+  }
+  cursor_[tag] = s;
+  out = s;
+  return true;
+}
+
+SectionByteSource::SectionByteSource(RunContainerReader& container,
+                                     dlf_section_tag_e tag, uint64_t limit)
+    : container_(container),
+      tag_(tag),
+      size_(std::min(container.sectionBytes(tag), limit)) {}
+
+size_t SectionByteSource::read(size_t offset, uint8_t* dst, size_t len) {
+  if (offset >= size_) {
+    return 0;
+  }
+  return container_.readSection(tag_, offset, dst,
+                                std::min(len, size_ - offset));
+}
+
+}  // namespace dlf::format
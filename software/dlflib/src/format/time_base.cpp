@@ -0,0 +1,60 @@
+#include "dlflib/format/time_base.h"
+
+#include <cmath>
+
+namespace dlf::format {
+
+TimeBase::TimeBase(dlf_time_us_t tickBaseUs, dlf_time_t epochTimeS)
+    : tickBaseUs_(tickBaseUs), epochTimeS_(epochTimeS) {}
+
+bool TimeBase::add(const dlf_time_anchor_t& anchor) {
+  if (!anchors_.empty()) {
+    if (anchor.tick < anchors_.back().tick) {
+      return false;
+    }
+    if (anchor.tick == anchors_.back().tick) {
+      anchors_.back() = anchor;
+      return true;
+    }
+  }
+  anchors_.push_back(anchor);
+  return true;
+}
+
+int64_t TimeBase::epochUs(dlf_tick_t tick) const {
+  if (anchors_.empty()) {
+    return static_cast<int64_t>(epochTimeS_) * 1000000 +
+           static_cast<int64_t>(tick * tickBaseUs_);
+  }
+
+  // First anchor past `tick`
+  size_t lo = 0;
+  size_t hi = anchors_.size();
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (anchors_[mid].tick <= tick) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  if (lo == 0) {
+    const dlf_time_anchor_t& first = anchors_.front();
+    return first.epoch_us -
+           static_cast<int64_t>((first.tick - tick) * tickBaseUs_);
+  }
+  const dlf_time_anchor_t& a = anchors_[lo - 1];
+  if (lo == anchors_.size()) {
+    return a.epoch_us + static_cast<int64_t>((tick - a.tick) * tickBaseUs_);
+  }
+  // Spans can be hours of microseconds times millions of ticks, which
+  // overflows integer math
+  const dlf_time_anchor_t& b = anchors_[lo];
+  const double fraction =
+      static_cast<double>(tick - a.tick) / static_cast<double>(b.tick - a.tick);
+  const double spanUs = static_cast<double>(b.epoch_us - a.epoch_us);
+  return a.epoch_us + static_cast<int64_t>(std::llround(spanUs * fraction));
+}
+
+}  // namespace dlf::format
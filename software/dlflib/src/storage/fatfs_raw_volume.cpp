@@ -0,0 +1,92 @@
+#include "dlflib/storage/fatfs_raw_volume.h"
+
+#include <ff.h>
+
+#include "dlflib/log.h"
+#include "dlflib/util/util.h"
+
+namespace dlf::storage {
+
+bool SdmmcBlockDevice::readSectors(uint32_t sector, void* dst, size_t count) {
+  return sdmmc_read_sectors(card_, dst, sector, count) == ESP_OK;
+}
+
+bool SdmmcBlockDevice::writeSectors(uint32_t sector, const void* src,
+                                    size_t count) {
+  return sdmmc_write_sectors(card_, src, sector, count) == ESP_OK;
+}
+
+FatfsRawVolume::FatfsRawVolume(sdmmc_card_t* card, const char* drive)
+    : device_(card) {
+  snprintf(drive_, sizeof(drive_), "%s", drive ? drive : "0:");
+}
+
+void FatfsRawVolume::fatfsPath(char* out, size_t outSize,
+                               const char* path) const {
+  dlf::util::joinPath(out, outSize, drive_, path);
+}
+
+bool FatfsRawVolume::allocate(const char* path, uint64_t bytes,
+                              RawExtent& out) {
+#if FF_USE_EXPAND
+  char p[140];
+  fatfsPath(p, sizeof(p), path);
+
+  FIL fil;
+  FRESULT res = f_open(&fil, p, FA_CREATE_ALWAYS | FA_WRITE);
+  if (res != FR_OK) {
+    DLFLIB_LOG_ERROR("[FatfsRawVolume] f_open(%s) failed: %d", p, res);
+    return false;
+  }
+
+  // opt=1 allocates the clusters now, and fails rather than fragmenting if no
+  // contiguous area of that size is free.
+  res = f_expand(&fil, static_cast<FSIZE_t>(bytes), 1);
+  if (res != FR_OK) {
+    DLFLIB_LOG_ERROR("[FatfsRawVolume] f_expand(%s, %llu) failed: %d", p,
+                     (unsigned long long)bytes, res);
+    f_close(&fil);
+    return false;
+  }
+
+  // Equivalent to FATFS's internal clst2sect(). Data clusters start at 2.
+  FATFS* fs = fil.obj.fs;
+  const size_t ss = device_.sectorSize();
+  out.firstSector = static_cast<uint32_t>(
+      fs->database + static_cast<LBA_t>(fs->csize) * (fil.obj.sclust - 2));
+  out.sectorCount = static_cast<uint32_t>((bytes + ss - 1) / ss);
+
+  return f_close(&fil) == FR_OK;
+#else
+  DLFLIB_LOG_ERROR("[FatfsRawVolume] FATFS built without FF_USE_EXPAND");
+  return false;
+#endif
+}
+
+bool FatfsRawVolume::finalize(const char* path, uint64_t length) {
+  char p[140];
+  fatfsPath(p, sizeof(p), path);
+
+  FIL fil;
+  FRESULT res = f_open(&fil, p, FA_OPEN_EXISTING | FA_WRITE);
+  if (res != FR_OK) {
+    DLFLIB_LOG_ERROR("[FatfsRawVolume] f_open(%s) failed: %d", p, res);
+    return false;
+  }
+
+  // Truncating at `length` frees the unused tail of the preallocation and
+  // writes the real size into the directory entry.
+  res = f_lseek(&fil, static_cast<FSIZE_t>(length));
+  if (res == FR_OK) {
+    res = f_truncate(&fil);
+  }
+  FRESULT closeRes = f_close(&fil);
+  if (res != FR_OK || closeRes != FR_OK) {
+    DLFLIB_LOG_ERROR("[FatfsRawVolume] Truncating %s failed: %d/%d", p, res,
+                     closeRes);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace dlf::storage
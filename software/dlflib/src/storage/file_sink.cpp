@@ -0,0 +1,95 @@
+#include "dlflib/storage/file_sink.h"
+
+#include "dlflib/log.h"
+
+namespace dlf::storage {
+
+FileSink::FileSink(fs::FS& fs, const char* path, bool append)
+    : fs_(fs), append_(append) {
+  snprintf(path_, sizeof(path_), "%s", path ? path : "");
+}
+
+bool FileSink::open() {
+  if (!append_) {
+    file_ = fs_.open(path_, "w", true);
+    return static_cast<bool>(file_);
+  }
+
+  // As in sync(), "r+" rather than "a" so that patch() can still seek
+  file_ = fs_.open(path_, "r+");
+  if (!file_) {
+    return false;
+  }
+  file_.seek(0, SeekEnd);
+  return true;
+}
+
+size_t FileSink::write(const uint8_t* data, size_t len) {
+  return file_.write(data, len);
+}
+
+void FileSink::flush() { file_.flush(); }
+
+void FileSink::sync() {
+  // .flush() commits data the SD card
+  // only on .close() will directory entry be updated (e.g. 9MB to 10MB)
+  file_.flush();
+  file_.close();
+
+  // Reopen file in read/write mode to update the header
+  // IMPORTANT: we use "r+" (read/write) mode instead of "a" (append)
+  // here because any write in append mode will always go to end of file
+  // regardless of any seeks.
+  file_ = fs_.open(path_, "r+");
+  if (!file_) {
+    DLFLIB_LOG_ERROR("[FileSink] ERROR: Could not reopen %s after sync!",
+                     path_);
+    return;
+  }
+  file_.seek(0, SeekEnd);
+}
+
+bool FileSink::patch(size_t offset, const void* data, size_t len) {
+  if (!file_) {
+    return false;
+  }
+
+  // Save current file position (where the next write will go)
+  size_t current_pos = file_.position();
+
+  file_.seek(offset);
+  file_.write(static_cast<const uint8_t*>(data), len);
+  file_.flush();  // Ensure the patch is written to the SD card
+
+  // Restore the file pointer to where writing left off
+  file_.seek(current_pos);
+  return true;
+}
+
+void FileSink::close() {
+  if (!file_) {
+    return;
+  }
+
+  file_.seek(0, SeekEnd);
+  size_t size = file_.position();
+  file_.flush();
+  file_.close();
+  DLFLIB_LOG_INFO("[FileSink] Closed %s (%zu bytes)", path_, size);
+}
+
+size_t ContainerSink::write(const uint8_t* data, size_t len) {
+  return container_.append(tag_, data, len);
+}
+
+void ContainerSink::flush() { container_.flush(); }
+
+void ContainerSink::sync() { container_.sync(); }
+
+bool ContainerSink::patch(size_t offset, const void* data, size_t len) {
+  return container_.patch(tag_, offset, data, len);
+}
+
+void ContainerSink::close() { container_.flush(); }
+
+}  // namespace dlf::storage
@@ -0,0 +1,113 @@
+#include "dlflib/storage/raw_sector_sink.h"
+
+#include "dlflib/log.h"
+#include "dlflib/util/util.h"
+
+namespace dlf::storage {
+
+RawSectorSink::RawSectorSink(RawVolume& volume, const char* path,
+                             uint64_t preallocateBytes,
+                             std::unique_ptr<LogSink> overflow)
+    : volume_(volume),
+      preallocateBytes_(preallocateBytes),
+      overflow_(std::move(overflow)) {
+  snprintf(path_, sizeof(path_), "%s", path ? path : "");
+}
+
+bool RawSectorSink::open() {
+  RawExtent extent;
+  if (!volume_.allocate(path_, preallocateBytes_, extent)) {
+    DLFLIB_LOG_ERROR("[RawSectorSink] Could not allocate %llu bytes for %s",
+                     (unsigned long long)preallocateBytes_, path_);
+    return false;
+  }
+
+  DLFLIB_LOG_INFO("[RawSectorSink] %s: %u sectors starting at sector %u",
+                  path_, extent.sectorCount, extent.firstSector);
+  writer_ = dlf::util::make_unique<SectorWriter>(volume_.device(), extent);
+  return true;
+}
+
+bool RawSectorSink::spill() {
+  // Every sector of the extent holds log data now, so finalizing it at full
+  // length leaves a regular file that the overflow sink appends to
+  if (!overflow_ || !writer_->flush() ||
+      !volume_.finalize(path_, writer_->bytesWritten())) {
+    return false;
+  }
+  if (!overflow_->open()) {
+    DLFLIB_LOG_ERROR("[RawSectorSink] Could not reopen %s for appending",
+                     path_);
+    return false;
+  }
+
+  DLFLIB_LOG_WARNING(
+      "[RawSectorSink] %s: extent full at %llu bytes, continuing through the "
+      "filesystem",
+      path_, (unsigned long long)writer_->bytesWritten());
+  spilled_ = true;
+  writer_.reset();
+  return true;
+}
+
+size_t RawSectorSink::write(const uint8_t* data, size_t len) {
+  if (spilled_) {
+    return overflow_->write(data, len);
+  }
+
+  size_t written = writer_->write(data, len);
+  if (written < len && !writer_->failed() && spill()) {
+    written += overflow_->write(data + written, len - written);
+  }
+  if (written < len) {
+    DLFLIB_LOG_ERROR(
+        "[RawSectorSink] %s: dropped %zu bytes (extent full or device error)",
+        path_, len - written);
+  }
+  return written;
+}
+
+// Until the extent is full, full sectors are written as soon as the staging
+// buffer fills, so there is nothing cheap left to commit.
+void RawSectorSink::flush() {
+  if (spilled_) {
+    overflow_->flush();
+  }
+}
+
+void RawSectorSink::sync() {
+  if (spilled_) {
+    overflow_->sync();
+    return;
+  }
+  writer_->flush();
+}
+
+bool RawSectorSink::patch(size_t offset, const void* data, size_t len) {
+  if (spilled_) {
+    return overflow_->patch(offset, data, len);
+  }
+  return writer_->patch(offset, data, len) && writer_->flush();
+}
+
+void RawSectorSink::close() {
+  if (spilled_) {
+    overflow_->close();
+    return;
+  }
+  if (!writer_) {
+    return;
+  }
+
+  // After a device error, only what reached the card is kept
+  writer_->flush();
+  if (!volume_.finalize(path_, writer_->syncedBytes())) {
+    DLFLIB_LOG_ERROR("[RawSectorSink] Could not finalize %s", path_);
+    return;
+  }
+  DLFLIB_LOG_INFO("[RawSectorSink] Closed %s (%llu bytes)", path_,
+                  (unsigned long long)writer_->syncedBytes());
+  writer_.reset();
+}
+
+}  // namespace dlf::storage
@@ -0,0 +1,214 @@
+#include "dlflib/storage/run_container.h"
+
+#include "dlflib/log.h"
+
+namespace dlf::storage {
+
+namespace {
+
+bool patchHeader(fs::FS& fs, const char* path, size_t offset,
+                 const void* data, size_t len) {
+  fs::File f = fs.open(path, "r+");
+  if (!f) {
+    return false;
+  }
+  dlf_run_container_header_t h;
+  const bool ok =
+      f.read(reinterpret_cast<uint8_t*>(&h), sizeof(h)) == sizeof(h) &&
+      h.magic == DLF_RUN_CONTAINER_MAGIC && f.seek(offset) &&
+      f.write(static_cast<const uint8_t*>(data), len) == len;
+  f.close();
+  return ok;
+}
+
+}  // namespace
+
+RunContainer::RunContainer(fs::FS& fs, const char* path) : fs_(fs) {
+  snprintf(path_, sizeof(path_), "%s", path ? path : "");
+  mutex_ = xSemaphoreCreateMutex();
+}
+
+RunContainer::~RunContainer() {
+  close();
+  if (mutex_ != nullptr) {
+    vSemaphoreDelete(mutex_);
+  }
+}
+
+bool RunContainer::open() {
+  if (mutex_ == nullptr) {
+    return false;
+  }
+  file_ = fs_.open(path_, "w", true);
+  if (!file_) {
+    return false;
+  }
+  dlf_run_container_header_t h;
+  size_ = file_.write(reinterpret_cast<uint8_t*>(&h), sizeof(h));
+  return size_ == sizeof(h);
+}
+
+size_t RunContainer::append(dlf_section_tag_e tag, const uint8_t* data,
+                            size_t len) {
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  const size_t n = appendLocked(tag, data, len);
+  xSemaphoreGive(mutex_);
+  return n;
+}
+
+size_t RunContainer::appendLocked(dlf_section_tag_e tag, const uint8_t* data,
+                                  size_t len) {
+  if (!file_ || len == 0 || tag == 0 || tag >= DLF_SECTION_TAG_COUNT) {
+    return 0;
+  }
+  dlf_section_header_t h;
+  h.tag = tag;
+  h.length = len;
+  if (file_.write(reinterpret_cast<uint8_t*>(&h), sizeof(h)) != sizeof(h)) {
+    return 0;
+  }
+  const size_t n = file_.write(data, len);
+  if (n < len) {
+    // The section header promises more than there is, so readers stop here
+    DLFLIB_LOG_ERROR("[RunContainer] %s: short write (%zu/%zu bytes)", path_,
+                     n, len);
+  }
+  if (first_[tag].dataOffset == 0) {
+    first_[tag].dataOffset = size_ + sizeof(h);
+    first_[tag].length = n;
+  }
+  size_ += sizeof(h) + n;
+  bytes_[tag] += n;
+  return n;
+}
+
+size_t RunContainer::commit(const dlf_container_commit_t& c) {
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  appendLocked(DLF_SECTION_COMMIT, reinterpret_cast<const uint8_t*>(&c),
+               sizeof(c));
+  const size_t end = size_;
+  xSemaphoreGive(mutex_);
+  sync();
+  return end;
+}
+
+bool RunContainer::patch(dlf_section_tag_e tag, size_t offset,
+                         const void* data, size_t len) {
+  if (tag == 0 || tag >= DLF_SECTION_TAG_COUNT) {
+    return false;
+  }
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  const FirstSection& s = first_[tag];
+  const bool ok = s.dataOffset != 0 && offset + len <= s.length &&
+                  patchFile(s.dataOffset + offset, data, len);
+  xSemaphoreGive(mutex_);
+  return ok;
+}
+
+uint64_t RunContainer::sectionBytes(dlf_section_tag_e tag) {
+  if (tag >= DLF_SECTION_TAG_COUNT) {
+    return 0;
+  }
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  const uint64_t n = bytes_[tag];
+  xSemaphoreGive(mutex_);
+  return n;
+}
+
+void RunContainer::flush() {
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  if (file_) {
+    file_.flush();
+  }
+  xSemaphoreGive(mutex_);
+}
+
+void RunContainer::sync() {
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  if (file_) {
+    // As in FileSink::sync(), the directory entry is only updated on close
+    file_.flush();
+    file_.close();
+    file_ = fs_.open(path_, "r+");
+    if (file_) {
+      file_.seek(0, SeekEnd);
+    } else {
+      DLFLIB_LOG_ERROR("[RunContainer] ERROR: Could not reopen %s after sync!",
+                       path_);
+    }
+  }
+  xSemaphoreGive(mutex_);
+}
+
+bool RunContainer::setState(dlf_run_state_e state) {
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  const bool ok = patchFile(offsetof(dlf_run_container_header_t, state),
+                            &state, sizeof(state));
+  xSemaphoreGive(mutex_);
+  return ok;
+}
+
+bool RunContainer::setUploadProgress(uint32_t nextChunk, uint32_t nextOffset) {
+  const uint32_t progress[2] = {nextChunk, nextOffset};
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  const bool ok =
+      patchFile(offsetof(dlf_run_container_header_t, upload_next_chunk),
+                progress, sizeof(progress));
+  xSemaphoreGive(mutex_);
+  return ok;
+}
+
+bool RunContainer::patchFile(size_t offset, const void* data, size_t len) {
+  if (!file_) {
+    return false;
+  }
+  file_.seek(offset);
+  const bool ok =
+      file_.write(static_cast<const uint8_t*>(data), len) == len;
+  file_.flush();
+  file_.seek(size_);
+  return ok;
+}
+
+void RunContainer::close() {
+  if (mutex_ == nullptr) {
+    return;
+  }
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  if (file_) {
+    file_.flush();
+    file_.close();
+    DLFLIB_LOG_INFO("[RunContainer] Closed %s (%zu bytes)", path_, size_);
+  }
+  xSemaphoreGive(mutex_);
+}
+
+bool RunContainer::readHeader(fs::FS& fs, const char* path,
+                              dlf_run_container_header_t& out) {
+  fs::File f = fs.open(path, "r");
+  if (!f) {
+    return false;
+  }
+  const bool ok =
+      f.read(reinterpret_cast<uint8_t*>(&out), sizeof(out)) == sizeof(out) &&
+      out.magic == DLF_RUN_CONTAINER_MAGIC;
+  f.close();
+  return ok;
+}
+
+bool RunContainer::writeState(fs::FS& fs, const char* path,
+                              dlf_run_state_e state) {
+  return patchHeader(fs, path, offsetof(dlf_run_container_header_t, state),
+                     &state, sizeof(state));
+}
+
+bool RunContainer::writeUploadProgress(fs::FS& fs, const char* path,
+                                       uint32_t nextChunk,
+                                       uint32_t nextOffset) {
+  const uint32_t progress[2] = {nextChunk, nextOffset};
+  return patchHeader(fs, path,
+                     offsetof(dlf_run_container_header_t, upload_next_chunk),
+                     progress, sizeof(progress));
+}
+
+}  // namespace dlf::storage
@@ -0,0 +1,121 @@
+#include "dlflib/storage/sector_writer.h"
+
+namespace dlf::storage {
+
+SectorWriter::SectorWriter(BlockDevice& device, const RawExtent& extent,
+                           size_t stagingSectors)
+    : device_(device),
+      extent_(extent),
+      sectorSize_(device.sectorSize()),
+      staging_(sectorSize_ * (stagingSectors > 0 ? stagingSectors : 1), 0) {}
+
+bool SectorWriter::writeStaging(size_t sectors) {
+  if (!device_.writeSectors(extent_.firstSector + stagingSector_,
+                            staging_.data(), sectors)) {
+    failed_ = true;
+    return false;
+  }
+  return true;
+}
+
+size_t SectorWriter::write(const void* data, size_t len) {
+  if (failed_) {
+    return 0;
+  }
+
+  const uint64_t available = capacityBytes() - bytesWritten_;
+  if (len > available) {
+    len = static_cast<size_t>(available);
+  }
+
+  const uint8_t* src = static_cast<const uint8_t*>(data);
+  size_t remaining = len;
+  while (remaining > 0) {
+    size_t n = staging_.size() - stagingFill_;
+    if (n > remaining) {
+      n = remaining;
+    }
+    memcpy(staging_.data() + stagingFill_, src, n);
+    stagingFill_ += n;
+    src += n;
+    remaining -= n;
+    bytesWritten_ += n;
+
+    if (stagingFill_ == staging_.size()) {
+      const size_t stagingSectors = staging_.size() / sectorSize_;
+      if (!writeStaging(stagingSectors)) {
+        return len - remaining;
+      }
+      syncedBytes_ = bytesWritten_;
+      stagingSector_ += stagingSectors;
+      stagingFill_ = 0;
+      memset(staging_.data(), 0, staging_.size());
+    }
+  }
+
+  return len;
+}
+
+bool SectorWriter::flush() {
+  if (failed_) {
+    return false;
+  }
+  if (stagingFill_ == 0) {
+    syncedBytes_ = bytesWritten_;
+    return true;
+  }
+
+  // Bytes past stagingFill_ are always zero, so partial sectors go out padded
+  if (!writeStaging((stagingFill_ + sectorSize_ - 1) / sectorSize_)) {
+    return false;
+  }
+  syncedBytes_ = bytesWritten_;
+  return true;
+}
+
+bool SectorWriter::patch(uint64_t offset, const void* data, size_t len) {
+  if (failed_ || offset + len > bytesWritten_) {
+    return false;
+  }
+
+  const uint8_t* src = static_cast<const uint8_t*>(data);
+  const uint64_t stagingStart =
+      static_cast<uint64_t>(stagingSector_) * sectorSize_;
+
+  // Portion that lies in sectors already written to the device
+  std::vector<uint8_t> sector;
+  while (len > 0 && offset < stagingStart) {
+    if (sector.empty()) {
+      sector.resize(sectorSize_);
+    }
+
+    const uint32_t rel = static_cast<uint32_t>(offset / sectorSize_);
+    const size_t within = static_cast<size_t>(offset % sectorSize_);
+    size_t n = sectorSize_ - within;
+    if (n > len) {
+      n = len;
+    }
+
+    if (!device_.readSectors(extent_.firstSector + rel, sector.data(), 1)) {
+      return false;
+    }
+    memcpy(sector.data() + within, src, n);
+    if (!device_.writeSectors(extent_.firstSector + rel, sector.data(), 1)) {
+      failed_ = true;
+      return false;
+    }
+
+    offset += n;
+    src += n;
+    len -= n;
+  }
+
+  // Remainder is still staged in memory
+  if (len > 0) {
+    memcpy(staging_.data() + (offset - stagingStart), src, len);
+  }
+
+  return true;
+}
+
+}  // namespace dlf::storage
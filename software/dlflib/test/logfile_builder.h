@@ -0,0 +1,333 @@
+#pragma once
+
+#include <initializer_list>
+#include <vector>
+
+#include "dlflib/dlf_types.h"
+#include "dlflib/format/codec.h"
+
+// Builds polled.dlf / event.dlf images byte by byte, the way LogFile lays them
+// out, for tests of the format readers.
+class LogfileBuilder {
+ public:
+  explicit LogfileBuilder(dlf::dlf_stream_type_e type,
+                          dlf::dlf_tick_t checkpointInterval = 0)
+      : type_(type), checkpointInterval_(checkpointInterval) {}
+
+  LogfileBuilder& polledStream(uint32_t typeSize, dlf::dlf_tick_t interval,
+                               dlf::dlf_tick_t phase = 0,
+                               dlf::dlf_codec_e codec = dlf::DLF_CODEC_RAW,
+                               uint16_t blockSamples = 0,
+                               dlf::dlf_validity_e validity =
+                                   dlf::DLF_VALIDITY_NONE) {
+    streams_.push_back(
+        {typeSize, interval, phase, codec, blockSamples, false, validity});
+    if (codec != dlf::DLF_CODEC_RAW) {
+      flags_ |= DLF_LOGFILE_FLAG_STREAM_CODECS;
+    }
+    if (validity != dlf::DLF_VALIDITY_NONE) {
+      flags_ |= DLF_LOGFILE_FLAG_STREAM_CODECS | DLF_LOGFILE_FLAG_VALIDITY;
+    }
+    return *this;
+  }
+
+  // Marks the data section as compressed frames. Only the header changes;
+  // frames are built from the uncompressed image by the test.
+  LogfileBuilder& compressed() {
+    flags_ |= DLF_LOGFILE_FLAG_BLOCK_COMPRESSION;
+    return *this;
+  }
+
+  // Marks frames as carrying CRCs. Like compressed(), only the header changes.
+  LogfileBuilder& blockCrc() {
+    flags_ |= DLF_LOGFILE_FLAG_BLOCK_CRC;
+    return *this;
+  }
+
+  LogfileBuilder& compactEvents() {
+    flags_ |= DLF_LOGFILE_FLAG_COMPACT_EVENTS;
+    return *this;
+  }
+
+  LogfileBuilder& columnar() {
+    flags_ |= DLF_LOGFILE_FLAG_COLUMNAR;
+    return *this;
+  }
+
+  LogfileBuilder& blockCuts() {
+    flags_ |= DLF_LOGFILE_FLAG_BLOCK_CUTS;
+    return *this;
+  }
+
+  LogfileBuilder& keyframes() {
+    flags_ |= DLF_LOGFILE_FLAG_KEYFRAMES;
+    return *this;
+  }
+
+  LogfileBuilder& timeAnchors() {
+    flags_ |= DLF_LOGFILE_FLAG_TIME_ANCHORS;
+    return *this;
+  }
+
+  // Marks the file as written into a preallocated extent. Set the synced
+  // length with writtenBytes() once the header is written.
+  LogfileBuilder& preallocated() {
+    flags_ |= DLF_LOGFILE_FLAG_PREALLOCATED;
+    return *this;
+  }
+
+  // Patches dlf_logfile_ext_header_t::written_bytes in the header
+  LogfileBuilder& writtenBytes(uint64_t len) {
+    memcpy(bytes.data() + sizeof(dlf::dlf_logfile_header_t) +
+               offsetof(dlf::dlf_logfile_ext_header_t, written_bytes),
+           &len, sizeof(len));
+    return *this;
+  }
+
+  LogfileBuilder& eventStream(uint32_t typeSize) {
+    streams_.push_back({typeSize, 0, 0, dlf::DLF_CODEC_RAW, 0});
+    return *this;
+  }
+
+  // An event stream of messages of up to `maxSize` bytes
+  LogfileBuilder& messageStream(uint32_t maxSize) {
+    streams_.push_back({maxSize, 0, 0, dlf::DLF_CODEC_RAW, 0, true});
+    flags_ |= DLF_LOGFILE_FLAG_VARIABLE_EVENTS;
+    return *this;
+  }
+
+  // Writes the file and stream headers. Returns the data offset.
+  size_t header(dlf::dlf_tick_t tickSpan = 0) {
+    dlf::dlf_logfile_header_t h;
+    h.stream_type = type_;
+    h.tick_span = tickSpan;
+    h.num_streams = streams_.size();
+    uint32_t flags = flags_;
+    if (checkpointInterval_ > 0) {
+      flags |= DLF_LOGFILE_FLAG_CHECKPOINTS;
+    }
+    if (flags != 0) {
+      h.stream_type =
+          static_cast<dlf::dlf_stream_type_e>(type_ | DLF_LOGFILE_EXTENDED);
+    }
+    put(h);
+    if (flags != 0) {
+      dlf::dlf_logfile_ext_header_t ext;
+      ext.flags = flags;
+      ext.checkpoint_interval = checkpointInterval_;
+      put(ext);
+    }
+    for (const auto& s : streams_) {
+      putStr("!");
+      putStr("stream");
+      putStr("");
+      put(s.typeSize);
+      if (type_ == dlf::POLLED) {
+        dlf::dlf_polled_stream_header_segment_t seg{s.interval, s.phase};
+        put(seg);
+        if (flags & DLF_LOGFILE_FLAG_STREAM_CODECS) {
+          dlf::dlf_polled_stream_codec_segment_t codec{s.codec,
+                                                       s.blockSamples};
+          put(codec);
+        }
+        if (flags & DLF_LOGFILE_FLAG_VALIDITY) {
+          dlf::dlf_polled_stream_validity_segment_t validity{s.validity};
+          put(validity);
+        }
+      } else if (flags & DLF_LOGFILE_FLAG_VARIABLE_EVENTS) {
+        dlf::dlf_event_stream_segment_t seg{static_cast<uint8_t>(
+            s.variable ? DLF_EVENT_STREAM_VARIABLE : 0)};
+        put(seg);
+      }
+    }
+    return bytes.size();
+  }
+
+  // Appends one polled tick, filling each due raw stream's sample with
+  // `fill`. Coded streams and streams with validity are appended with
+  // block().
+  LogfileBuilder& tick(dlf::dlf_tick_t t, uint8_t fill = 0xAB) {
+    for (const auto& s : streams_) {
+      dlf::dlf_tick_t interval = s.interval == 0 ? 1 : s.interval;
+      if (s.codec == dlf::DLF_CODEC_RAW &&
+          s.validity == dlf::DLF_VALIDITY_NONE &&
+          (t + s.phase) % interval == 0) {
+        bytes.insert(bytes.end(), s.typeSize, fill);
+      }
+    }
+    return *this;
+  }
+
+  // Appends a column block of raw streams over ticks [first, first + count)
+  LogfileBuilder& columnBlock(dlf::dlf_tick_t first, uint32_t count,
+                              uint8_t fill = 0xAB) {
+    dlf::dlf_column_block_header_t h;
+    h.first_tick = first;
+    h.tick_count = count;
+    put(h);
+    std::vector<uint32_t> lens;
+    for (const auto& s : streams_) {
+      dlf::dlf_tick_t interval = s.interval == 0 ? 1 : s.interval;
+      uint32_t samples = 0;
+      for (dlf::dlf_tick_t t = first; t < first + count; t++) {
+        samples += (t + s.phase) % interval == 0;
+      }
+      put(static_cast<uint32_t>(samples * s.typeSize));
+      lens.push_back(samples * s.typeSize);
+    }
+    for (uint32_t len : lens) {
+      bytes.insert(bytes.end(), len, fill);
+    }
+    return *this;
+  }
+
+  LogfileBuilder& event(dlf::dlf_stream_idx_t idx, dlf::dlf_tick_t t,
+                        uint8_t fill = 0xAB) {
+    dlf::dlf_event_stream_sample_t h;
+    h.stream = idx;
+    h.sample_tick = t;
+    put(h);
+    bytes.insert(bytes.end(), streams_[idx].typeSize, fill);
+    return *this;
+  }
+
+  // Appends a record of message stream `idx`
+  LogfileBuilder& message(dlf::dlf_stream_idx_t idx, dlf::dlf_tick_t t,
+                          const char* text) {
+    dlf::dlf_event_stream_sample_t h;
+    h.stream = idx;
+    h.sample_tick = t;
+    put(h);
+    putVarint(strlen(text));
+    bytes.insert(bytes.end(), text, text + strlen(text));
+    return *this;
+  }
+
+  // Appends one compact event group holding a record for each of `idxs`.
+  // Records of message streams hold a message of `messageLen` bytes.
+  LogfileBuilder& group(dlf::dlf_tick_t t,
+                        std::initializer_list<dlf::dlf_stream_idx_t> idxs,
+                        uint8_t fill = 0xAB, size_t messageLen = 3) {
+    putVarint(t - lastGroupTick_);
+    putVarint(idxs.size());
+    for (dlf::dlf_stream_idx_t idx : idxs) {
+      putVarint(idx);
+      size_t len = streams_[idx].typeSize;
+      if (streams_[idx].variable) {
+        len = messageLen;
+        putVarint(len);
+      }
+      bytes.insert(bytes.end(), len, fill);
+    }
+    lastGroupTick_ = t;
+    return *this;
+  }
+
+  // Appends the empty group and checkpoint of a compact event file
+  LogfileBuilder& compactCheckpoint(dlf::dlf_tick_t tickSpan) {
+    putVarint(tickSpan - lastGroupTick_);
+    putVarint(0);
+    lastGroupTick_ = tickSpan;
+    return checkpoint(tickSpan);
+  }
+
+  // Appends a keyframe, filling every stream's value with `fill`. In compact
+  // files the empty group introducing it is written first.
+  LogfileBuilder& keyframe(dlf::dlf_tick_t t, uint8_t fill = 0xEF) {
+    if (flags_ & DLF_LOGFILE_FLAG_COMPACT_EVENTS) {
+      putVarint(t - lastGroupTick_);
+      putVarint(0);
+      lastGroupTick_ = t;
+    }
+    dlf::dlf_keyframe_t k;
+    k.tick = t;
+    k.byte_offset = bytes.size();
+    put(k);
+    for (const auto& s : streams_) {
+      if (s.variable) {
+        bytes.push_back(0);  // Empty message
+      } else {
+        bytes.insert(bytes.end(), s.typeSize, fill);
+      }
+    }
+    return *this;
+  }
+
+  // Appends a time anchor, after an empty group in compact files
+  LogfileBuilder& timeAnchor(dlf::dlf_tick_t t, int64_t epochUs) {
+    if (flags_ & DLF_LOGFILE_FLAG_COMPACT_EVENTS) {
+      putVarint(t - lastGroupTick_);
+      putVarint(0);
+      lastGroupTick_ = t;
+    }
+    dlf::dlf_time_anchor_t a;
+    a.tick = t;
+    a.byte_offset = bytes.size();
+    a.epoch_us = epochUs;
+    a.source = dlf::DLF_TIME_SOURCE_GPS;
+    return put(a);
+  }
+
+  LogfileBuilder& block(uint16_t sampleCount, size_t payloadBytes,
+                        uint8_t fill = 0xCD) {
+    dlf::dlf_codec_block_header_t b;
+    b.sample_count = sampleCount;
+    b.payload_bytes = payloadBytes;
+    put(b);
+    bytes.insert(bytes.end(), payloadBytes, fill);
+    return *this;
+  }
+
+  LogfileBuilder& checkpoint(dlf::dlf_tick_t tickSpan) {
+    dlf::dlf_checkpoint_t c;
+    c.tick_span = tickSpan;
+    c.byte_offset = bytes.size();
+    put(c);
+    return *this;
+  }
+
+  // Appends a block cut record. The partial blocks follow with block().
+  LogfileBuilder& blockCut(dlf::dlf_tick_t t) {
+    dlf::dlf_block_cut_t c;
+    c.tick = t;
+    c.byte_offset = bytes.size();
+    return put(c);
+  }
+
+  template <typename T>
+  LogfileBuilder& put(const T& v) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+    bytes.insert(bytes.end(), p, p + sizeof(T));
+    return *this;
+  }
+
+  LogfileBuilder& putVarint(uint64_t v) {
+    uint8_t buf[10];
+    bytes.insert(bytes.end(), buf, buf + dlf::format::putVarint(buf, v));
+    return *this;
+  }
+
+  LogfileBuilder& putStr(const char* s) {
+    bytes.insert(bytes.end(), s, s + strlen(s) + 1);
+    return *this;
+  }
+
+  std::vector<uint8_t> bytes;
+
+ private:
+  struct Stream {
+    uint32_t typeSize;
+    dlf::dlf_tick_t interval;
+    dlf::dlf_tick_t phase;
+    dlf::dlf_codec_e codec;
+    uint16_t blockSamples;
+    bool variable = false;
+    dlf::dlf_validity_e validity = dlf::DLF_VALIDITY_NONE;
+  };
+
+  dlf::dlf_stream_type_e type_;
+  dlf::dlf_tick_t checkpointInterval_;
+  uint32_t flags_ = 0;
+  dlf::dlf_tick_t lastGroupTick_ = 0;
+  std::vector<Stream> streams_;
+};
@@ -1,6 +1,10 @@
 #pragma once
 // Minimal Arduino stub for native (desktop) unit testing.
 // Provides the standard types that dlflib headers pull in via <Arduino.h>.
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <algorithm>
 #include <cstdint>
 #include <cstddef>
 #include <cstring>
@@ -8,3 +12,15 @@
 #include <memory>
 
 using byte = uint8_t;
+
+using std::max;
+using std::min;
+// Arduino's max() takes mixed integer types, e.g. a duration count and 1ll
+inline long long max(long long a, long long b) { return a > b ? a : b; }
+
+// Log output (dlflib/log.h) is dropped
+struct SerialStub {
+  int printf(const char*, ...) { return 0; }
+  size_t println() { return 0; }
+};
+inline SerialStub Serial;
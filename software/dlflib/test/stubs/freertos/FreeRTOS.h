@@ -0,0 +1,17 @@
+#pragma once
+// Minimal FreeRTOS stub for native unit testing. Tests run single-threaded,
+// so mutexes always succeed and delays return at once.
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef void* SemaphoreHandle_t;
+typedef void* TaskHandle_t;
+
+#define configTICK_RATE_HZ 1000
+#define portMAX_DELAY 0xffffffffu
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
@@ -0,0 +1,7 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) {
+  return pdTRUE;
+}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
@@ -0,0 +1,4 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+
+inline void vTaskDelay(TickType_t) {}
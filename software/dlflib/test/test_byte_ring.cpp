@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dlflib/util/byte_ring.h"
+
+using dlf::util::ByteRing;
+
+TEST(ByteRing, CapacityRoundsUpToPowerOfTwo) {
+  ByteRing ring(100);
+  ASSERT_TRUE(ring.valid());
+  EXPECT_EQ(ring.capacity(), 128u);
+  EXPECT_EQ(ring.writable(), 128u);
+  EXPECT_EQ(ring.readable(), 0u);
+}
+
+TEST(ByteRing, ReservedBytesAreInvisibleUntilCommit) {
+  ByteRing ring(16);
+  ByteRing::Spans s = ring.reserve(4);
+  ASSERT_EQ(s.size(), 4u);
+  s.write(0, "abcd", 4);
+  EXPECT_EQ(ring.readable(), 0u);
+  EXPECT_EQ(ring.peek().size(), 0u);
+
+  ring.commit(4);
+  EXPECT_EQ(ring.readable(), 4u);
+  ByteRing::Spans r = ring.peek();
+  ASSERT_EQ(r.firstLen, 4u);
+  EXPECT_EQ(r.secondLen, 0u);
+  EXPECT_EQ(memcmp(r.first, "abcd", 4), 0);
+}
+
+TEST(ByteRing, ReserveFailsWhenShort) {
+  ByteRing ring(8);
+  EXPECT_TRUE(ring.write("12345678", 8));
+  EXPECT_EQ(ring.writable(), 0u);
+  EXPECT_EQ(ring.reserve(1).size(), 0u);
+  EXPECT_FALSE(ring.write("x", 1));
+
+  ring.consume(3);
+  EXPECT_EQ(ring.reserve(4).size(), 0u);
+  EXPECT_EQ(ring.reserve(3).size(), 3u);
+}
+
+TEST(ByteRing, WrappedRegionsSplitIntoTwoSpans) {
+  ByteRing ring(8);
+  ASSERT_TRUE(ring.write("012345", 6));
+  ring.consume(6);
+
+  // Reservation straddles the end of the buffer
+  ByteRing::Spans s = ring.reserve(5);
+  ASSERT_EQ(s.firstLen, 2u);
+  ASSERT_EQ(s.secondLen, 3u);
+  s.write(0, "abcde", 5);
+  ring.commit(5);
+
+  ByteRing::Spans r = ring.peek();
+  ASSERT_EQ(r.firstLen, 2u);
+  ASSERT_EQ(r.secondLen, 3u);
+  EXPECT_EQ(memcmp(r.first, "ab", 2), 0);
+  EXPECT_EQ(memcmp(r.second, "cde", 3), 0);
+
+  char out[5];
+  EXPECT_EQ(ring.read(out, sizeof(out)), 5u);
+  EXPECT_EQ(memcmp(out, "abcde", 5), 0);
+  EXPECT_EQ(ring.readable(), 0u);
+}
+
+TEST(ByteRing, SpanWriteAtOffsetCrossesWrap) {
+  ByteRing ring(8);
+  ASSERT_TRUE(ring.write("0123456", 7));
+  ring.consume(7);
+
+  ByteRing::Spans s = ring.reserve(6);
+  s.write(0, "h", 1);
+  s.write(1, "ijklm", 5);
+  ring.commit(6);
+
+  char mid[4];
+  ring.peek().read(1, mid, sizeof(mid));
+  EXPECT_EQ(memcmp(mid, "ijkl", 4), 0);
+
+  char out[6];
+  ASSERT_EQ(ring.read(out, sizeof(out)), 6u);
+  EXPECT_EQ(memcmp(out, "hijklm", 6), 0);
+}
+
+TEST(ByteRing, StreamSurvivesManyWraps) {
+  ByteRing ring(64);
+  std::vector<uint8_t> out;
+  uint8_t next = 0;
+  for (int i = 0; i < 1000; i++) {
+    uint8_t chunk[13];
+    for (auto& b : chunk) {
+      b = next++;
+    }
+    ASSERT_TRUE(ring.write(chunk, sizeof(chunk)));
+    uint8_t tmp[64];
+    size_t n = ring.read(tmp, 11);
+    out.insert(out.end(), tmp, tmp + n);
+    if (ring.readable() > 40) {
+      n = ring.read(tmp, sizeof(tmp));
+      out.insert(out.end(), tmp, tmp + n);
+    }
+  }
+  for (size_t i = 0; i < out.size(); i++) {
+    ASSERT_EQ(out[i], static_cast<uint8_t>(i));
+  }
+  EXPECT_EQ(ring.committed(), 13000u);
+}
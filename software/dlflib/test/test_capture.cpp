@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dlflib/datastream/capture_source.h"
+#include "dlflib/format/recovery.h"
+#include "logfile_builder.h"
+
+using namespace dlf;
+using dlf::datastream::MemoryCaptureSource;
+using dlf::datastream::writeCaptureChunk;
+using dlf::util::ByteRing;
+
+namespace {
+
+std::vector<uint8_t> counting(size_t len, uint8_t first = 0) {
+  std::vector<uint8_t> v(len);
+  for (size_t i = 0; i < len; i++) {
+    v[i] = static_cast<uint8_t>(first + i);
+  }
+  return v;
+}
+
+std::vector<uint8_t> drain(ByteRing& ring) {
+  std::vector<uint8_t> out(ring.readable());
+  ring.read(out.data(), out.size());
+  return out;
+}
+
+}  // namespace
+
+TEST(Capture, ChunksAreReadIntoTheRing) {
+  MemoryCaptureSource src;
+  const std::vector<uint8_t> data = counting(40);
+  src.append(data.data(), data.size());
+
+  // The first record wraps around the end of the ring
+  ByteRing ring(64);
+  ASSERT_TRUE(ring.write(counting(50).data(), 50));
+  ring.consume(50);
+
+  const size_t header = sizeof(dlf_event_stream_sample_t) + 1;
+  ASSERT_EQ(writeCaptureChunk(src, 16, 3, 7, ring), header + 16);
+  EXPECT_EQ(src.available(), 24u);
+  std::vector<uint8_t> rec = drain(ring);
+  dlf_event_stream_sample_t h;
+  memcpy(&h, rec.data(), sizeof(h));
+  EXPECT_EQ(h.stream, 3);
+  EXPECT_EQ(h.sample_tick, 7u);
+  EXPECT_EQ(rec[sizeof(h)], 16);
+  EXPECT_EQ(std::vector<uint8_t>(rec.begin() + header, rec.end()),
+            std::vector<uint8_t>(data.begin(), data.begin() + 16));
+
+  // Takes only what is waiting
+  ASSERT_EQ(writeCaptureChunk(src, 64, 3, 8, ring) - header, 24u);
+  EXPECT_EQ(src.available(), 0u);
+  EXPECT_EQ(writeCaptureChunk(src, 64, 3, 9, ring), 0u);
+}
+
+TEST(Capture, LeavesBytesInSourceWhenRingIsFull) {
+  MemoryCaptureSource src;
+  src.append(counting(40).data(), 40);
+  ByteRing ring(32);
+  EXPECT_EQ(writeCaptureChunk(src, 40, 0, 0, ring), 0u);
+  EXPECT_EQ(src.available(), 40u);
+  EXPECT_EQ(ring.readable(), 0u);
+}
+
+TEST(Capture, ShortReadKeepsLengthWidth) {
+  MemoryCaptureSource src;
+  src.append(counting(300).data(), 300);
+  src.setReadLimit(100);
+
+  ByteRing ring(1024);
+  const size_t header = sizeof(dlf_event_stream_sample_t) + 2;
+  ASSERT_EQ(writeCaptureChunk(src, 200, 0, 0, ring), header + 100);
+  std::vector<uint8_t> rec = drain(ring);
+  uint64_t len;
+  EXPECT_EQ(format::getVarint(rec.data() + sizeof(dlf_event_stream_sample_t),
+                              2, len),
+            2u);
+  EXPECT_EQ(len, 100u);
+  EXPECT_EQ(rec.back(), 99);
+}
+
+TEST(Capture, RawFileRecoversLikeEventFile) {
+  LogfileBuilder b(RAW);
+  b.messageStream(32).header();
+
+  MemoryCaptureSource src;
+  ByteRing ring(256);
+  uint8_t next = 0;
+  for (dlf_tick_t t = 0; t < 10; t++) {
+    const size_t n = t * 7 % 45;
+    src.append(counting(n, next).data(), n);
+    next += n;
+    writeCaptureChunk(src, 32, 0, t, ring);
+    const std::vector<uint8_t> rec = drain(ring);
+    b.bytes.insert(b.bytes.end(), rec.begin(), rec.end());
+  }
+  const size_t valid = b.bytes.size();
+  b.bytes.resize(valid + 5, 0xEE);
+
+  format::MemoryByteSource mem(b.bytes.data(), b.bytes.size());
+  format::LogfileInfo info;
+  ASSERT_TRUE(format::readLogfileHeader(mem, info));
+  EXPECT_EQ(info.streamType, RAW);
+  ASSERT_EQ(info.streams.size(), 1u);
+  EXPECT_TRUE(info.streams[0].variable);
+
+  format::RecoveryScanner scanner(mem, info);
+  scanner.step(SIZE_MAX);
+  const format::RecoveryResult& r = scanner.result();
+  ASSERT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 9u);
+}
@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dlflib/format/codec.h"
+
+using namespace dlf;
+using dlf::format::BlockEncoder;
+
+namespace {
+
+template <typename T>
+std::vector<T> roundTrip(dlf_codec_e codec, const std::vector<T>& values,
+                         size_t* payloadBytes = nullptr) {
+  BlockEncoder enc(codec, sizeof(T), values.size());
+  for (const T& v : values) {
+    enc.add(reinterpret_cast<const uint8_t*>(&v));
+  }
+  EXPECT_TRUE(enc.full());
+
+  size_t len;
+  const uint8_t* payload = enc.finish(len);
+  EXPECT_LE(len, format::maxBlockBytes(codec, sizeof(T), values.size()));
+  if (payloadBytes) {
+    *payloadBytes = len;
+  }
+
+  std::vector<T> out(values.size());
+  EXPECT_TRUE(format::decodeBlock(codec, sizeof(T), payload, len,
+                                  values.size(),
+                                  reinterpret_cast<uint8_t*>(out.data())));
+  return out;
+}
+
+}  // namespace
+
+TEST(Codec, VarintRoundTrip) {
+  uint8_t buf[10];
+  for (uint64_t v : {0ull, 1ull, 127ull, 128ull, 300ull, ~0ull}) {
+    size_t n = format::putVarint(buf, v);
+    uint64_t back;
+    EXPECT_EQ(format::getVarint(buf, n, back), n);
+    EXPECT_EQ(back, v);
+  }
+  EXPECT_EQ(format::putVarint(buf, 127), 1u);
+  EXPECT_EQ(format::putVarint(buf, 128), 2u);
+  EXPECT_EQ(format::putVarint(buf, ~0ull), 10u);
+
+  // Truncated
+  format::putVarint(buf, 300);
+  uint64_t v;
+  EXPECT_EQ(format::getVarint(buf, 1, v), 0u);
+}
+
+TEST(Codec, ZigzagMapsSmallMagnitudesToSmallValues) {
+  EXPECT_EQ(format::zigzag(0), 0u);
+  EXPECT_EQ(format::zigzag(-1), 1u);
+  EXPECT_EQ(format::zigzag(1), 2u);
+  EXPECT_EQ(format::zigzag(-2), 3u);
+  EXPECT_EQ(format::unzigzag(format::zigzag(INT64_MIN)), INT64_MIN);
+  EXPECT_EQ(format::unzigzag(format::zigzag(INT64_MAX)), INT64_MAX);
+}
+
+TEST(Codec, DeltaRoundTripsEveryWidth) {
+  std::vector<uint8_t> u8 = {0, 255, 1, 128, 127, 0};
+  EXPECT_EQ(roundTrip(DLF_CODEC_DELTA_VARINT, u8), u8);
+
+  std::vector<int16_t> i16 = {-32768, 32767, 0, -1, 5, -32768};
+  EXPECT_EQ(roundTrip(DLF_CODEC_DELTA_VARINT, i16), i16);
+
+  std::vector<int32_t> i32 = {-70, -65, INT32_MIN, INT32_MAX, 0};
+  EXPECT_EQ(roundTrip(DLF_CODEC_DELTA_VARINT, i32), i32);
+
+  std::vector<uint64_t> u64 = {~0ull, 0, 1ull << 63, 42};
+  EXPECT_EQ(roundTrip(DLF_CODEC_DELTA_VARINT, u64), u64);
+}
+
+TEST(Codec, DeltaShrinksSlowlyChangingValues) {
+  // RSSI drifting around -60 dBm
+  std::vector<int32_t> rssi;
+  for (int i = 0; i < 128; i++) {
+    rssi.push_back(-60 + (i % 7) - 3);
+  }
+  size_t len;
+  EXPECT_EQ(roundTrip(DLF_CODEC_DELTA_VARINT, rssi, &len), rssi);
+  EXPECT_EQ(len, 4u + 127u);  // One byte per delta
+}
+
+TEST(Codec, RleCollapsesRuns) {
+  std::vector<uint32_t> sats(100, 9);
+  sats.insert(sats.end(), 28, 11);
+  size_t len;
+  EXPECT_EQ(roundTrip(DLF_CODEC_RLE, sats, &len), sats);
+  EXPECT_EQ(len, 2u * (1 + 4));
+
+  std::vector<uint8_t> alternating = {1, 2, 1, 2, 1};
+  EXPECT_EQ(roundTrip(DLF_CODEC_RLE, alternating), alternating);
+}
+
+TEST(Codec, XorRoundTripsFloatsAndDoubles) {
+  std::vector<double> d = {36.9101234, 36.9101234, 36.9101301, -121.75,
+                           0.0,        -0.0,       1e300,      36.9101301};
+  EXPECT_EQ(roundTrip(DLF_CODEC_XOR, d), d);
+
+  std::vector<float> f = {12.5f, 12.5f, 12.75f, -3.0f, 1e-30f, 12.5f};
+  EXPECT_EQ(roundTrip(DLF_CODEC_XOR, f), f);
+
+  // Bit patterns with no leading or trailing zeros in the XOR
+  std::vector<uint64_t> bits = {0, ~0ull, 1, 1ull << 63, 0x8000000000000001};
+  EXPECT_EQ(roundTrip(DLF_CODEC_XOR, bits), bits);
+}
+
+TEST(Codec, XorPacksRepeatsAndNearbyValues) {
+  // Repeats cost one bit each
+  std::vector<double> same(128, 36.9101234);
+  size_t len;
+  EXPECT_EQ(roundTrip(DLF_CODEC_XOR, same, &len), same);
+  EXPECT_EQ(len, 8u + (127 + 7) / 8);
+
+  // Slowly moving latitude, as a GPS receiver reports it
+  std::vector<double> lat;
+  for (int i = 0; i < 128; i++) {
+    lat.push_back(36.9101234 + i * 1e-6);
+  }
+  EXPECT_EQ(roundTrip(DLF_CODEC_XOR, lat, &len), lat);
+  EXPECT_LT(len, lat.size() * sizeof(double) * 3 / 4);
+}
+
+TEST(Codec, EncoderIsReusableAfterReset) {
+  BlockEncoder enc(DLF_CODEC_DELTA_VARINT, 2, 2);
+  uint16_t a[] = {1000, 1001};
+  uint16_t b[] = {7, 3};
+  enc.add(reinterpret_cast<uint8_t*>(&a[0]));
+  enc.add(reinterpret_cast<uint8_t*>(&a[1]));
+  size_t len;
+  enc.finish(len);
+  enc.reset();
+  EXPECT_EQ(enc.count(), 0u);
+
+  enc.add(reinterpret_cast<uint8_t*>(&b[0]));
+  enc.add(reinterpret_cast<uint8_t*>(&b[1]));
+  const uint8_t* payload = enc.finish(len);
+  uint16_t out[2];
+  ASSERT_TRUE(format::decodeBlock(DLF_CODEC_DELTA_VARINT, 2, payload, len, 2,
+                                  reinterpret_cast<uint8_t*>(out)));
+  EXPECT_EQ(out[0], 7);
+  EXPECT_EQ(out[1], 3);
+}
+
+TEST(Codec, PartialBlockDecodes) {
+  BlockEncoder enc(DLF_CODEC_RLE, 4, 16);
+  uint32_t v = 5;
+  for (int i = 0; i < 3; i++) {
+    enc.add(reinterpret_cast<uint8_t*>(&v));
+  }
+  EXPECT_FALSE(enc.full());
+  size_t len;
+  const uint8_t* payload = enc.finish(len);
+  uint32_t out[3];
+  ASSERT_TRUE(format::decodeBlock(DLF_CODEC_RLE, 4, payload, len, 3,
+                                  reinterpret_cast<uint8_t*>(out)));
+  EXPECT_EQ(out[2], 5u);
+}
+
+TEST(Codec, ValidityBitmapOmitsInvalidSamples) {
+  BlockEncoder enc(DLF_CODEC_DELTA_VARINT, 4, 10, DLF_VALIDITY_OMIT);
+  const uint32_t values[] = {100, 101, 999, 999, 104, 105, 106, 999, 108};
+  const bool valid[] = {true, true, false, false, true, true, true, false,
+                        true};
+  for (int i = 0; i < 9; i++) {
+    enc.add(reinterpret_cast<const uint8_t*>(&values[i]), valid[i]);
+  }
+  EXPECT_EQ(enc.count(), 9u);
+  EXPECT_FALSE(enc.full());
+
+  // A partial block's bitmap only covers its samples
+  size_t len;
+  const uint8_t* payload = enc.finish(len);
+  ASSERT_EQ(len, 2 + 4 + 5u);
+  EXPECT_EQ(payload[0], 0x73);
+  EXPECT_EQ(payload[1], 0x01);
+  EXPECT_LE(len, format::maxBlockBytes(DLF_CODEC_DELTA_VARINT, 4, 9,
+                                       DLF_VALIDITY_OMIT));
+
+  uint32_t out[9];
+  ASSERT_TRUE(format::decodeBlock(DLF_CODEC_DELTA_VARINT, 4, DLF_VALIDITY_OMIT,
+                                  payload, len, 9,
+                                  reinterpret_cast<uint8_t*>(out)));
+  for (int i = 0; i < 9; i++) {
+    EXPECT_EQ(out[i], valid[i] ? values[i] : 0u) << i;
+  }
+  EXPECT_FALSE(format::decodeBlock(DLF_CODEC_DELTA_VARINT, 4,
+                                   DLF_VALIDITY_ZERO, payload, len, 9,
+                                   reinterpret_cast<uint8_t*>(out)));
+}
+
+TEST(Codec, ValidityBitmapZeroesInvalidSamples) {
+  BlockEncoder enc(DLF_CODEC_RAW, 2, 3, DLF_VALIDITY_ZERO);
+  const uint16_t values[] = {7, 8, 9};
+  for (int i = 0; i < 3; i++) {
+    enc.add(reinterpret_cast<const uint8_t*>(&values[i]), i != 1);
+  }
+  EXPECT_TRUE(enc.full());
+  size_t len;
+  const uint8_t* payload = enc.finish(len);
+  ASSERT_EQ(len, 1 + 3 * 2u);
+  EXPECT_EQ(payload[0], 0x05);
+  EXPECT_EQ(payload[3], 0);
+
+  uint16_t out[3];
+  ASSERT_TRUE(format::decodeBlock(DLF_CODEC_RAW, 2, DLF_VALIDITY_ZERO,
+                                  payload, len, 3,
+                                  reinterpret_cast<uint8_t*>(out)));
+  EXPECT_EQ(out[0], 7);
+  EXPECT_EQ(out[1], 0);
+  EXPECT_EQ(out[2], 9);
+
+  // Reset starts a new bitmap
+  enc.reset();
+  enc.add(reinterpret_cast<const uint8_t*>(&values[0]), false);
+  payload = enc.finish(len);
+  ASSERT_EQ(len, 1 + 2u);
+  EXPECT_EQ(payload[0], 0x00);
+}
+
+TEST(Codec, DecodeRejectsMalformedPayloads) {
+  std::vector<uint8_t> delta = {10, 0, 0, 0, 2, 2};
+  uint32_t out[4];
+  uint8_t* o = reinterpret_cast<uint8_t*>(out);
+
+  EXPECT_TRUE(format::decodeBlock(DLF_CODEC_DELTA_VARINT, 4, delta.data(),
+                                  delta.size(), 3, o));
+  EXPECT_EQ(out[2], 12u);
+  // Too few values, trailing bytes and a torn varint
+  EXPECT_FALSE(format::decodeBlock(DLF_CODEC_DELTA_VARINT, 4, delta.data(),
+                                   delta.size(), 4, o));
+  EXPECT_FALSE(format::decodeBlock(DLF_CODEC_DELTA_VARINT, 4, delta.data(),
+                                   delta.size(), 2, o));
+  delta.back() = 0x80;
+  EXPECT_FALSE(format::decodeBlock(DLF_CODEC_DELTA_VARINT, 4, delta.data(),
+                                   delta.size(), 3, o));
+
+  // Run longer than the block
+  std::vector<uint8_t> rle = {5, 1};
+  EXPECT_FALSE(
+      format::decodeBlock(DLF_CODEC_RLE, 1, rle.data(), rle.size(), 4, o));
+
+  // XOR: window reuse ('10') before any window was set, and a stray byte
+  // after the padded bit stream
+  std::vector<uint8_t> xr = {1, 0, 0, 0, 0x80};
+  EXPECT_FALSE(
+      format::decodeBlock(DLF_CODEC_XOR, 4, xr.data(), xr.size(), 2, o));
+  xr.back() = 0x00;
+  EXPECT_TRUE(
+      format::decodeBlock(DLF_CODEC_XOR, 4, xr.data(), xr.size(), 2, o));
+  EXPECT_EQ(out[1], 1u);
+  xr.push_back(0);
+  EXPECT_FALSE(
+      format::decodeBlock(DLF_CODEC_XOR, 4, xr.data(), xr.size(), 2, o));
+}
+
+TEST(Codec, SupportAndBlockLimits) {
+  EXPECT_TRUE(format::codecSupports(DLF_CODEC_DELTA_VARINT, 8));
+  EXPECT_FALSE(format::codecSupports(DLF_CODEC_DELTA_VARINT, 3));
+  EXPECT_TRUE(format::codecSupports(DLF_CODEC_RLE, 24));
+  EXPECT_TRUE(format::codecSupports(DLF_CODEC_XOR, 4));
+  EXPECT_FALSE(format::codecSupports(DLF_CODEC_XOR, 2));
+
+  size_t n = format::maxBlockSamples(DLF_CODEC_DELTA_VARINT, 8);
+  EXPECT_LE(format::maxBlockBytes(DLF_CODEC_DELTA_VARINT, 8, n), UINT16_MAX);
+  EXPECT_GT(format::maxBlockBytes(DLF_CODEC_DELTA_VARINT, 8, n + 1),
+            UINT16_MAX);
+  EXPECT_EQ(format::maxBlockSamples(DLF_CODEC_RLE, 4, 50), 10u);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dlflib/format/event_index.h"
+
+using namespace dlf;
+using dlf::format::EventIndex;
+
+namespace {
+
+template <typename T>
+void put(std::vector<uint8_t>& out, const T& v) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+  out.insert(out.end(), p, p + sizeof(T));
+}
+
+std::vector<uint8_t> indexFile(
+    dlf_tick_t interval,
+    std::initializer_list<dlf_event_index_entry_t> entries) {
+  std::vector<uint8_t> out;
+  dlf_event_index_header_t h;
+  h.index_interval = interval;
+  put(out, h);
+  for (const auto& e : entries) {
+    put(out, e);
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(EventIndex, SeeksToLastEntryAtOrBeforeTick) {
+  auto bytes = indexFile(100, {{3, 40}, {120, 900}, {260, 2000}, {400, 3100}});
+  EventIndex index;
+  ASSERT_TRUE(index.parse(bytes.data(), bytes.size()));
+  EXPECT_EQ(index.interval(), 100u);
+  ASSERT_EQ(index.entries().size(), 4u);
+
+  dlf_event_index_entry_t e;
+  EXPECT_FALSE(index.seek(2, e));
+  ASSERT_TRUE(index.seek(3, e));
+  EXPECT_EQ(e.byte_offset, 40u);
+  ASSERT_TRUE(index.seek(259, e));
+  EXPECT_EQ(e.byte_offset, 900u);
+  ASSERT_TRUE(index.seek(260, e));
+  EXPECT_EQ(e.byte_offset, 2000u);
+  ASSERT_TRUE(index.seek(100000, e));
+  EXPECT_EQ(e.tick, 400u);
+}
+
+TEST(EventIndex, DropsTornAndUnwrittenEntries) {
+  auto bytes = indexFile(10, {{0, 30}, {10, 90}, {25, 200}});
+  bytes.resize(bytes.size() - 5);
+  EventIndex index;
+  ASSERT_TRUE(index.parse(bytes.data(), bytes.size()));
+  EXPECT_EQ(index.entries().size(), 2u);
+
+  // The data file was cut back to 90 bytes by recovery
+  ASSERT_TRUE(index.parse(bytes.data(), bytes.size(), 90));
+  EXPECT_EQ(index.entries().size(), 1u);
+}
+
+TEST(EventIndex, StopsAtEntriesOutOfOrder) {
+  auto bytes = indexFile(10, {{0, 30}, {10, 90}, {20, 80}, {30, 120}});
+  EventIndex index;
+  ASSERT_TRUE(index.parse(bytes.data(), bytes.size()));
+  EXPECT_EQ(index.entries().size(), 2u);
+}
+
+TEST(EventIndex, RejectsOtherFiles) {
+  std::vector<uint8_t> bytes(32, 0);
+  EventIndex index;
+  EXPECT_FALSE(index.parse(bytes.data(), bytes.size()));
+  EXPECT_FALSE(index.parse(bytes.data(), 1));
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "dlflib/datastream/flag_group.h"
+
+using dlf::datastream::FlagGroup;
+
+TEST(FlagGroup, PacksFlagsInOrder) {
+  bool pump = false, fault = true;
+  uint32_t status = 0;
+  FlagGroup g;
+  ASSERT_TRUE(g.add("pump", pump));
+  ASSERT_TRUE(g.add("fault", fault));
+  ASSERT_TRUE(g.add("gpsFix", status, 5));
+  EXPECT_FALSE(g.add("bad", status, 32));
+  EXPECT_EQ(g.size(), 3u);
+  EXPECT_EQ(g.maskSize(), 4u);
+  EXPECT_EQ(g.validMask(), 0x7u);
+
+  EXPECT_EQ(g.read(), 0x2u);
+  pump = true;
+  status = 1u << 5;
+  EXPECT_EQ(g.read(), 0x7u);
+  fault = false;
+  status = ~(1u << 5);
+  EXPECT_EQ(g.read(), 0x1u);
+}
+
+TEST(FlagGroup, DescribesEachBit) {
+  bool a = false, b = false;
+  FlagGroup g;
+  g.add("a", a);
+  g.add("b", b);
+  EXPECT_STREQ(g.typeStructure(false),
+               "Flags;values:uint32_t:0;a:bit:0;b:bit:1");
+  EXPECT_STREQ(g.typeStructure(true),
+               "Flags;changed:uint32_t:0;values:uint32_t:4;a:bit:32;b:bit:33");
+}
+
+TEST(FlagGroup, HoldsUpTo64Flags) {
+  bool flags[65] = {};
+  std::string names[64];
+  FlagGroup g;
+  for (int i = 0; i < 64; i++) {
+    names[i] = "f" + std::to_string(i);
+    ASSERT_TRUE(g.add(names[i].c_str(), flags[i]));
+    EXPECT_EQ(g.maskSize(), i < 32 ? 4u : 8u);
+  }
+  EXPECT_FALSE(g.add("extra", flags[64]));
+  EXPECT_EQ(g.validMask(), ~0ull);
+
+  flags[63] = true;
+  flags[0] = true;
+  EXPECT_EQ(g.read(), (1ull << 63) | 1);
+  const std::string s = g.typeStructure(true);
+  EXPECT_EQ(s.rfind("Flags;changed:uint64_t:0;values:uint64_t:8;f0:bit:64;", 0),
+            0u);
+  EXPECT_NE(s.find(";f63:bit:127"), std::string::npos);
+}
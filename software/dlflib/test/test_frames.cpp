@@ -0,0 +1,277 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dlflib/format/crc32.h"
+#include "dlflib/format/frames.h"
+#include "dlflib/format/lz4.h"
+#include "logfile_builder.h"
+
+using namespace dlf;
+using dlf::format::FrameByteSource;
+using dlf::format::Lz4Compressor;
+using dlf::format::MemoryByteSource;
+
+namespace {
+
+std::vector<uint8_t> lz4RoundTrip(const std::vector<uint8_t>& in,
+                                  size_t* compressedBytes = nullptr) {
+  Lz4Compressor c;
+  std::vector<uint8_t> packed(format::lz4CompressBound(in.size()));
+  size_t n = c.compress(in.data(), in.size(), packed.data(), packed.size());
+  EXPECT_GT(n, 0u);
+  if (compressedBytes) {
+    *compressedBytes = n;
+  }
+  std::vector<uint8_t> out(in.size());
+  EXPECT_TRUE(format::lz4Decompress(packed.data(), n, out.data(), out.size()));
+  return out;
+}
+
+struct Cut {
+  size_t end;  // Offset in the uncompressed file where the frame ends
+  dlf_tick_t firstTick;
+  uint8_t flags;
+};
+
+// Frames the data section of an uncompressed image the way the flusher does
+std::vector<uint8_t> frame(const std::vector<uint8_t>& image,
+                           size_t dataOffset, const std::vector<Cut>& cuts,
+                           bool crc = false) {
+  std::vector<uint8_t> out(image.begin(), image.begin() + dataOffset);
+  Lz4Compressor c;
+  size_t start = dataOffset;
+  for (const Cut& cut : cuts) {
+    const size_t len = cut.end - start;
+    std::vector<uint8_t> f(format::maxFrameBytes(len) +
+                           format::FRAME_CRC_BYTES);
+    size_t n = format::encodeFrame(c, &image[start], len, cut.firstTick,
+                                   start, cut.flags, f.data());
+    f.resize(crc ? format::appendFrameCrc(f.data(), n) : n);
+    out.insert(out.end(), f.begin(), f.end());
+    start = cut.end;
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(Lz4, RoundTrips) {
+  EXPECT_TRUE(lz4RoundTrip({}).empty());
+  EXPECT_EQ(lz4RoundTrip({7}), std::vector<uint8_t>{7});
+
+  std::vector<uint8_t> noise(3000);
+  uint32_t lcg = 3;
+  for (auto& b : noise) {
+    lcg = lcg * 1664525u + 1013904223u;
+    b = lcg >> 24;
+  }
+  EXPECT_EQ(lz4RoundTrip(noise), noise);
+
+  // Polled ticks repeat with small changes, and long runs need length
+  // continuation bytes
+  std::vector<uint8_t> ticks;
+  for (int t = 0; t < 500; t++) {
+    uint32_t v[3] = {1234, static_cast<uint32_t>(t), 42};
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(v);
+    ticks.insert(ticks.end(), p, p + sizeof(v));
+  }
+  ticks.insert(ticks.end(), 1000, 0);
+  size_t n;
+  EXPECT_EQ(lz4RoundTrip(ticks, &n), ticks);
+  EXPECT_LT(n, ticks.size() / 3);
+}
+
+TEST(Lz4, DecodesReferenceBlock) {
+  // "a", then a match at offset 1 of length 8, then the literals "bcdef"
+  const uint8_t block[] = {0x14, 'a', 0x01, 0x00, 0x50,
+                           'b',  'c', 'd',  'e',  'f'};
+  char out[14];
+  ASSERT_TRUE(format::lz4Decompress(block, sizeof(block),
+                                    reinterpret_cast<uint8_t*>(out),
+                                    sizeof(out)));
+  EXPECT_EQ(memcmp(out, "aaaaaaaaabcdef", sizeof(out)), 0);
+
+  // Wrong output length, torn block and an offset before the output start
+  EXPECT_FALSE(format::lz4Decompress(block, sizeof(block),
+                                     reinterpret_cast<uint8_t*>(out), 13));
+  EXPECT_FALSE(format::lz4Decompress(block, 3,
+                                     reinterpret_cast<uint8_t*>(out), 14));
+  const uint8_t badOffset[] = {0x10, 'a', 0x02, 0x00, 0x00};
+  EXPECT_FALSE(format::lz4Decompress(badOffset, sizeof(badOffset),
+                                     reinterpret_cast<uint8_t*>(out), 5));
+}
+
+TEST(Frames, ByteSourceShowsUncompressedFile) {
+  LogfileBuilder b(EVENT);
+  size_t dataOffset = b.eventStream(4).eventStream(2).compressed().header();
+  std::vector<Cut> cuts;
+  for (dlf_tick_t t = 0; t < 300; t++) {
+    b.event(t % 2, t, t % 2 ? 0x11 : 0x22);
+    if (t % 100 == 99) {
+      cuts.push_back({b.bytes.size(), t - 99, 0});
+    }
+  }
+  std::vector<uint8_t> file = frame(b.bytes, dataOffset, cuts);
+  EXPECT_LT(file.size(), b.bytes.size() * 3 / 4);
+
+  MemoryByteSource src(file.data(), file.size());
+  FrameByteSource frames(src, dataOffset);
+  ASSERT_EQ(frames.frames().size(), 3u);
+  EXPECT_EQ(frames.size(), b.bytes.size());
+  EXPECT_EQ(frames.fileLength(), file.size());
+
+  // Reads may span the header and several frames
+  std::vector<uint8_t> all(b.bytes.size());
+  EXPECT_EQ(frames.read(0, all.data(), all.size()), all.size());
+  EXPECT_EQ(all, b.bytes);
+  uint8_t tail[8];
+  EXPECT_EQ(frames.read(b.bytes.size() - 4, tail, sizeof(tail)), 4u);
+}
+
+TEST(Frames, DropsTornAndSplitTail) {
+  LogfileBuilder b(POLLED);
+  size_t dataOffset = b.polledStream(4, 1).compressed().header();
+  for (dlf_tick_t t = 0; t < 30; t++) {
+    b.tick(t, t);
+  }
+  // Tick 20 is split over the last two frames
+  const size_t tick20 = dataOffset + 20 * 4;
+  std::vector<uint8_t> file =
+      frame(b.bytes, dataOffset,
+            {{dataOffset + 40, 0, 0},
+             {tick20 + 2, 10, DLF_FRAME_FLAG_SPLIT},
+             {b.bytes.size(), 20, DLF_FRAME_FLAG_CONTINUED}});
+
+  {
+    MemoryByteSource src(file.data(), file.size());
+    FrameByteSource frames(src, dataOffset);
+    EXPECT_EQ(frames.size(), b.bytes.size());
+    EXPECT_EQ(frames.frameForTick(25), 1u);
+    EXPECT_EQ(frames.frameForTick(12), 1u);
+    EXPECT_EQ(frames.frameForTick(3), 0u);
+  }
+
+  // Losing the end of the last frame also drops the split one before it
+  file.resize(file.size() - 1);
+  MemoryByteSource src(file.data(), file.size());
+  FrameByteSource frames(src, dataOffset);
+  ASSERT_EQ(frames.frames().size(), 1u);
+  EXPECT_EQ(frames.size(), dataOffset + 40);
+  EXPECT_EQ(frames.fileLength(),
+            dataOffset + frames.frames()[0].storedBytes +
+                sizeof(dlf_frame_header_t));
+}
+
+TEST(Frames, RecoveryScansThroughFrames) {
+  LogfileBuilder b(EVENT, 50);
+  size_t dataOffset = b.eventStream(4).compressed().header();
+  std::vector<Cut> cuts;
+  for (dlf_tick_t t = 0; t < 120; t++) {
+    b.event(0, t);
+    if (t % 50 == 49) {
+      b.checkpoint(t);
+      cuts.push_back({b.bytes.size(), t - 49, 0});
+    }
+  }
+  // Ticks 100..119 never made it into a complete frame
+  std::vector<uint8_t> file = frame(b.bytes, dataOffset, cuts);
+  const size_t complete = file.size();
+  file.insert(file.end(), 10, 0x5A);
+
+  MemoryByteSource src(file.data(), file.size());
+  format::LogfileInfo info;
+  ASSERT_TRUE(format::readLogfileHeader(src, info));
+  ASSERT_TRUE(info.compressed());
+  FrameByteSource frames(src, info.dataOffset);
+  format::RecoveryScanner scanner(frames, info);
+  ASSERT_TRUE(scanner.step(SIZE_MAX));
+  EXPECT_EQ(scanner.result().tickSpan, 99u);
+  EXPECT_EQ(scanner.result().validLength, frames.size());
+  EXPECT_EQ(frames.fileLength(), complete);
+}
+
+TEST(Frames, Crc32MatchesReference) {
+  const char* check = "123456789";
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(check);
+  EXPECT_EQ(format::crc32(p, 9), 0xCBF43926u);
+  // Chunks chain
+  EXPECT_EQ(format::crc32(p + 4, 5, format::crc32(p, 4)), 0xCBF43926u);
+  EXPECT_EQ(format::crc32(p, 0), 0u);
+}
+
+TEST(Frames, SkipsCorruptedFrame) {
+  LogfileBuilder b(POLLED);
+  size_t dataOffset = b.polledStream(4, 1).blockCrc().header();
+  for (dlf_tick_t t = 0; t < 40; t++) {
+    b.tick(t, t);
+  }
+  const size_t tickBytes = 4;
+  std::vector<uint8_t> file =
+      frame(b.bytes, dataOffset,
+            {{dataOffset + 10 * tickBytes, 0, 0},
+             {dataOffset + 20 * tickBytes, 10, 0},
+             {dataOffset + 30 * tickBytes, 20, 0},
+             {b.bytes.size(), 30, 0}},
+            true);
+
+  MemoryByteSource intact(file.data(), file.size());
+  const size_t second =
+      FrameByteSource(intact, dataOffset, true).frames()[1].fileOffset;
+
+  // A flipped payload bit in the second frame is found as it is read
+  std::vector<uint8_t> bad = file;
+  bad[second + sizeof(dlf_frame_header_t) + 1] ^= 0x10;
+  {
+    MemoryByteSource src(bad.data(), bad.size());
+    FrameByteSource frames(src, dataOffset, true);
+    ASSERT_EQ(frames.frames().size(), 4u);
+    EXPECT_EQ(frames.size(), b.bytes.size());
+    std::vector<uint8_t> all(b.bytes.size());
+    const size_t got = frames.read(0, all.data(), all.size());
+    EXPECT_EQ(got, dataOffset + 10 * tickBytes);
+    EXPECT_EQ(frames.damagedFrames(), 1u);
+
+    // Later data is still at its own offset
+    const size_t resume = frames.resumeOffset(got);
+    EXPECT_EQ(resume, dataOffset + 20 * tickBytes);
+    EXPECT_EQ(frames.read(resume, &all[resume], all.size() - resume),
+              all.size() - resume);
+    EXPECT_TRUE(std::equal(all.begin() + resume, all.end(),
+                           b.bytes.begin() + resume));
+  }
+
+  // A corrupted header is skipped over when the view is built
+  bad = file;
+  bad[second + offsetof(dlf_frame_header_t, stored_bytes) + 1] ^= 0x80;
+  MemoryByteSource src(bad.data(), bad.size());
+  FrameByteSource frames(src, dataOffset, true);
+  ASSERT_EQ(frames.frames().size(), 4u);
+  EXPECT_TRUE(frames.frames()[1].damaged);
+  EXPECT_EQ(frames.frames()[2].rawOffset, dataOffset + 20 * tickBytes);
+  EXPECT_EQ(frames.fileLength(), file.size());
+  uint32_t v;
+  ASSERT_EQ(frames.read(dataOffset + 35 * tickBytes,
+                        reinterpret_cast<uint8_t*>(&v), sizeof(v)),
+            sizeof(v));
+  EXPECT_EQ(v, 0x23232323u);
+}
+
+TEST(Frames, CrcDropsTornTail) {
+  LogfileBuilder b(EVENT);
+  size_t dataOffset = b.eventStream(4).blockCrc().header();
+  for (dlf_tick_t t = 0; t < 20; t++) {
+    b.event(0, t);
+  }
+  const size_t half = b.bytes.size() - 10 * (b.bytes.size() - dataOffset) / 20;
+  std::vector<uint8_t> file = frame(
+      b.bytes, dataOffset, {{half, 0, 0}, {b.bytes.size(), 10, 0}}, true);
+
+  // The last frame is complete in length, but its end was never written
+  std::fill(file.end() - 6, file.end(), 0);
+  MemoryByteSource src(file.data(), file.size());
+  FrameByteSource frames(src, dataOffset, true);
+  ASSERT_EQ(frames.frames().size(), 1u);
+  EXPECT_EQ(frames.size(), half);
+  EXPECT_EQ(frames.damagedFrames(), 0u);
+}
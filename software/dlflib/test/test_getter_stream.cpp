@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "dlflib/datastream/getter_stream.h"
+#include "dlflib/datastream/polled_stream_handle.h"
+#include "dlflib/dlf_struct.h"
+#include "dlflib/format/codec.h"
+#include "dlflib/util/byte_ring.h"
+
+using dlf::dlf_tick_t;
+using dlf::datastream::GetterStream;
+using dlf::datastream::PolledStream;
+using dlf::datastream::PolledStreamHandle;
+using dlf::util::ByteRing;
+using std::chrono::milliseconds;
+
+namespace {
+
+struct Fix {
+  double lat;
+  double lng;
+  uint32_t satellites;
+};
+DLF_STRUCT(Fix, lat, lng, satellites)
+
+int calls = 0;
+
+int32_t nextCount() { return ++calls; }
+
+void fillFix(Fix& out) {
+  calls++;
+  out.lat = calls;
+  out.lng = -calls;
+  out.satellites = calls * 2;
+}
+
+std::array<float, 3> nextVector() {
+  calls++;
+  return {1.0f * calls, 2.0f * calls, 3.0f * calls};
+}
+
+// Samples `stream` on ticks [0, ticks) of a 10 ms tick the way the sampler
+// does and returns the ticks it was due on
+std::vector<dlf_tick_t> sample(PolledStream& stream, ByteRing& ring,
+                               dlf_tick_t ticks) {
+  auto handle = stream.createHandle(milliseconds(10), 0);
+  std::vector<dlf_tick_t> due;
+  for (dlf_tick_t t = 0; t < ticks; t++) {
+    if (handle->available(t)) {
+      handle->encodeInto(ring, t);
+      due.push_back(t);
+    }
+  }
+  return due;
+}
+
+// Reads the coded block at the front of `ring` and appends its values
+void readBlock(ByteRing& ring, std::vector<int32_t>& values) {
+  dlf::dlf_codec_block_header_t h;
+  ASSERT_GE(ring.readable(), sizeof(h));
+  ring.read(&h, sizeof(h));
+  std::vector<uint8_t> payload(h.payload_bytes);
+  ASSERT_GE(ring.readable(), payload.size());
+  ring.read(payload.data(), payload.size());
+  std::vector<int32_t> out(h.sample_count);
+  ASSERT_TRUE(dlf::format::decodeBlock(
+      dlf::DLF_CODEC_DELTA_VARINT, sizeof(int32_t), payload.data(),
+      payload.size(), h.sample_count, reinterpret_cast<uint8_t*>(out.data())));
+  values.insert(values.end(), out.begin(), out.end());
+}
+
+}  // namespace
+
+TEST(GetterStream, CallsGetterOnDueTicksOnly) {
+  calls = 0;
+  GetterStream<int32_t> stream(nextCount, "count", milliseconds(30), {});
+  EXPECT_STREQ(stream.typeStructure(), "int32_t");
+  EXPECT_EQ(stream.dataSize(), sizeof(int32_t));
+
+  ByteRing ring(256);
+  EXPECT_EQ(sample(stream, ring, 10), (std::vector<dlf_tick_t>{0, 3, 6, 9}));
+  EXPECT_EQ(calls, 4);
+
+  std::vector<int32_t> values(ring.readable() / sizeof(int32_t));
+  ring.read(values.data(), values.size() * sizeof(int32_t));
+  EXPECT_EQ(values, (std::vector<int32_t>{1, 2, 3, 4}));
+}
+
+TEST(GetterStream, CallsFillerOnDueTicksOnly) {
+  calls = 0;
+  PolledStream::Options options;
+  options.phase = milliseconds(10);
+  GetterStream<Fix> stream(fillFix, "fix", milliseconds(20), options);
+  EXPECT_STREQ(stream.typeStructure(),
+               "Fix;lat:double:0;lng:double:8;satellites:uint32_t:16");
+  EXPECT_EQ(stream.dataSize(), sizeof(Fix));
+
+  ByteRing ring(256);
+  EXPECT_EQ(sample(stream, ring, 6), (std::vector<dlf_tick_t>{1, 3, 5}));
+  EXPECT_EQ(calls, 3);
+
+  ASSERT_EQ(ring.readable(), 3 * sizeof(Fix));
+  for (int i = 1; i <= 3; i++) {
+    Fix f;
+    ring.read(&f, sizeof(f));
+    EXPECT_EQ(f.lat, i);
+    EXPECT_EQ(f.lng, -i);
+    EXPECT_EQ(f.satellites, 2u * i);
+  }
+}
+
+TEST(GetterStream, StoresArrays) {
+  calls = 0;
+  GetterStream<std::array<float, 3>> stream(nextVector, "accel",
+                                            milliseconds(0), {});
+  EXPECT_STREQ(stream.typeStructure(), "float[3]");
+  EXPECT_EQ(stream.dataSize(), 3 * sizeof(float));
+
+  ByteRing ring(256);
+  EXPECT_EQ(sample(stream, ring, 2), (std::vector<dlf_tick_t>{0, 1}));
+
+  float values[6];
+  ASSERT_EQ(ring.readable(), sizeof(values));
+  ring.read(values, sizeof(values));
+  EXPECT_EQ(std::vector<float>(values, values + 6),
+            (std::vector<float>{1, 2, 3, 2, 4, 6}));
+}
+
+TEST(GetterStream, CutBlockWritesSamplesOfOpenBlock) {
+  // A commit after tick 4 must cover the samples of the unfinished block
+  calls = 0;
+  PolledStream::Options options;
+  options.codec = dlf::DLF_CODEC_DELTA_VARINT;
+  options.blockSamples = 4;
+  GetterStream<int32_t> stream(nextCount, "count", milliseconds(10), options);
+  auto handle = stream.createHandle(milliseconds(10), 0);
+  auto* polled = static_cast<PolledStreamHandle*>(handle.get());
+  EXPECT_NE(polled->logfileFlags() & DLF_LOGFILE_FLAG_BLOCK_CUTS, 0u);
+
+  ByteRing ring(256);
+  for (dlf_tick_t t = 0; t <= 4; t++) {
+    handle->encodeInto(ring, t);
+  }
+  EXPECT_EQ(polled->pendingSamples(), 1u);
+  EXPECT_GT(polled->cutBlock(ring), 0u);
+  EXPECT_EQ(polled->pendingSamples(), 0u);
+  EXPECT_EQ(polled->cutBlock(ring), 0u);
+
+  std::vector<int32_t> values;
+  readBlock(ring, values);
+  readBlock(ring, values);
+  EXPECT_EQ(ring.readable(), 0u);
+  EXPECT_EQ(values, (std::vector<int32_t>{1, 2, 3, 4, 5}));
+
+  // The next block starts over with the sample after the cut
+  for (dlf_tick_t t = 5; t <= 8; t++) {
+    handle->encodeInto(ring, t);
+  }
+  values.clear();
+  readBlock(ring, values);
+  EXPECT_EQ(ring.readable(), 0u);
+  EXPECT_EQ(values, (std::vector<int32_t>{6, 7, 8, 9}));
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include "dlflib/util/latency_histogram.h"
+
+using dlf::util::LatencyHistogram;
+
+TEST(LatencyHistogram, EmptyHistogram) {
+  LatencyHistogram h;
+  EXPECT_EQ(h.count(), 0u);
+  EXPECT_EQ(h.maxUs(), 0u);
+  EXPECT_EQ(h.meanUs(), 0u);
+  EXPECT_EQ(h.percentileUs(99), 0u);
+}
+
+TEST(LatencyHistogram, BucketIndexIsPowerOfTwo) {
+  EXPECT_EQ(LatencyHistogram::bucketIndex(0), 0u);
+  EXPECT_EQ(LatencyHistogram::bucketIndex(1), 1u);
+  EXPECT_EQ(LatencyHistogram::bucketIndex(2), 2u);
+  EXPECT_EQ(LatencyHistogram::bucketIndex(3), 2u);
+  EXPECT_EQ(LatencyHistogram::bucketIndex(4), 3u);
+  EXPECT_EQ(LatencyHistogram::bucketIndex(1023), 10u);
+  EXPECT_EQ(LatencyHistogram::bucketIndex(1024), 11u);
+}
+
+TEST(LatencyHistogram, LargeValuesClampToLastBucket) {
+  LatencyHistogram h;
+  h.record(UINT32_MAX);
+  EXPECT_EQ(h.bucketCount(LatencyHistogram::NUM_BUCKETS - 1), 1u);
+  EXPECT_EQ(h.maxUs(), UINT32_MAX);
+  EXPECT_EQ(LatencyHistogram::bucketUpperBoundUs(
+                LatencyHistogram::NUM_BUCKETS - 1),
+            UINT32_MAX);
+}
+
+TEST(LatencyHistogram, TracksCountMaxAndMean) {
+  LatencyHistogram h;
+  h.record(100);
+  h.record(300);
+  h.record(200);
+  EXPECT_EQ(h.count(), 3u);
+  EXPECT_EQ(h.maxUs(), 300u);
+  EXPECT_EQ(h.totalUs(), 600u);
+  EXPECT_EQ(h.meanUs(), 200u);
+}
+
+TEST(LatencyHistogram, PercentileReturnsBucketBound) {
+  LatencyHistogram h;
+  for (int i = 0; i < 99; i++) {
+    h.record(10);  // bucket [8, 16)
+  }
+  h.record(5000);  // bucket [4096, 8192)
+  EXPECT_EQ(h.percentileUs(50), 16u);
+  EXPECT_EQ(h.percentileUs(99), 16u);
+  EXPECT_EQ(h.percentileUs(100), 5000u);
+}
+
+TEST(LatencyHistogram, ResetClearsEverything) {
+  LatencyHistogram h;
+  h.record(42);
+  h.reset();
+  EXPECT_EQ(h.count(), 0u);
+  EXPECT_EQ(h.maxUs(), 0u);
+  EXPECT_EQ(h.bucketCount(LatencyHistogram::bucketIndex(42)), 0u);
+}
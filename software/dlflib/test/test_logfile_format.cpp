@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include "dlflib/format/logfile_format.h"
+#include "logfile_builder.h"
+
+using namespace dlf;
+using dlf::format::LogfileInfo;
+
+TEST(LogfileFormat, ParsesLegacyHeader) {
+  LogfileBuilder b(POLLED);
+  size_t dataOffset = b.polledStream(4, 1).header(17);
+
+  LogfileInfo info;
+  ASSERT_TRUE(format::parseLogfileHeader(b.bytes.data(), b.bytes.size(), info));
+  EXPECT_EQ(info.streamType, POLLED);
+  EXPECT_FALSE(info.extended);
+  EXPECT_EQ(info.tickSpan, 17u);
+  EXPECT_EQ(info.ext.flags, 0u);
+  ASSERT_EQ(info.streams.size(), 1u);
+  EXPECT_EQ(info.streams[0].typeSize, 4u);
+  EXPECT_EQ(info.streams[0].tickInterval, 1u);
+  EXPECT_EQ(info.dataOffset, dataOffset);
+}
+
+TEST(LogfileFormat, ParsesExtendedHeader) {
+  LogfileBuilder b(EVENT, 4);
+  size_t dataOffset = b.eventStream(8).eventStream(2).header();
+
+  LogfileInfo info;
+  ASSERT_TRUE(format::parseLogfileHeader(b.bytes.data(), b.bytes.size(), info));
+  EXPECT_EQ(info.streamType, EVENT);
+  EXPECT_TRUE(info.extended);
+  EXPECT_EQ(info.ext.flags, DLF_LOGFILE_FLAG_CHECKPOINTS);
+  EXPECT_EQ(info.ext.checkpoint_interval, 4u);
+  ASSERT_EQ(info.streams.size(), 2u);
+  EXPECT_EQ(info.streams[1].typeSize, 2u);
+  EXPECT_EQ(info.dataOffset, dataOffset);
+}
+
+TEST(LogfileFormat, ParsesStreamCodecs) {
+  LogfileBuilder b(POLLED);
+  size_t dataOffset = b.polledStream(4, 1)
+                          .polledStream(2, 5, 0, DLF_CODEC_DELTA_VARINT, 64)
+                          .header();
+
+  LogfileInfo info;
+  ASSERT_TRUE(format::parseLogfileHeader(b.bytes.data(), b.bytes.size(), info));
+  EXPECT_EQ(info.ext.flags, DLF_LOGFILE_FLAG_STREAM_CODECS);
+  ASSERT_EQ(info.streams.size(), 2u);
+  EXPECT_EQ(info.streams[0].codec, DLF_CODEC_RAW);
+  EXPECT_EQ(info.streams[1].codec, DLF_CODEC_DELTA_VARINT);
+  EXPECT_EQ(info.streams[1].blockSamples, 64u);
+  EXPECT_EQ(info.streams[1].tickInterval, 5u);
+  EXPECT_TRUE(info.hasCodedStreams());
+  EXPECT_EQ(info.dataOffset, dataOffset);
+}
+
+TEST(LogfileFormat, ParsesStreamValidity) {
+  LogfileBuilder b(POLLED);
+  size_t dataOffset =
+      b.polledStream(4, 1)
+          .polledStream(8, 10, 0, DLF_CODEC_RAW, 32, DLF_VALIDITY_ZERO)
+          .header();
+
+  LogfileInfo info;
+  ASSERT_TRUE(format::parseLogfileHeader(b.bytes.data(), b.bytes.size(), info));
+  EXPECT_EQ(info.ext.flags,
+            DLF_LOGFILE_FLAG_STREAM_CODECS | DLF_LOGFILE_FLAG_VALIDITY);
+  ASSERT_EQ(info.streams.size(), 2u);
+  EXPECT_EQ(info.streams[0].validity, DLF_VALIDITY_NONE);
+  EXPECT_FALSE(info.streams[0].blocked());
+  EXPECT_EQ(info.streams[1].validity, DLF_VALIDITY_ZERO);
+  EXPECT_EQ(info.streams[1].blockSamples, 32u);
+  EXPECT_TRUE(info.streams[1].blocked());
+  EXPECT_TRUE(info.hasCodedStreams());
+  EXPECT_EQ(info.dataOffset, dataOffset);
+}
+
+TEST(LogfileFormat, ParsesMessageStreams) {
+  LogfileBuilder b(EVENT);
+  size_t dataOffset = b.eventStream(4).messageStream(64).header();
+
+  LogfileInfo info;
+  ASSERT_TRUE(format::parseLogfileHeader(b.bytes.data(), b.bytes.size(), info));
+  EXPECT_EQ(info.ext.flags, DLF_LOGFILE_FLAG_VARIABLE_EVENTS);
+  ASSERT_EQ(info.streams.size(), 2u);
+  EXPECT_FALSE(info.streams[0].variable);
+  EXPECT_TRUE(info.streams[1].variable);
+  EXPECT_EQ(info.streams[1].typeSize, 64u);
+  EXPECT_TRUE(info.hasVariableStreams());
+  EXPECT_EQ(info.keyframeBytes(), sizeof(dlf_keyframe_t) + 4 + 1);
+  EXPECT_EQ(info.dataOffset, dataOffset);
+}
+
+TEST(LogfileFormat, RejectsTruncatedHeader) {
+  LogfileBuilder b(POLLED, 4);
+  b.polledStream(4, 1).header();
+
+  LogfileInfo info;
+  for (size_t len = 0; len < b.bytes.size(); len++) {
+    EXPECT_FALSE(format::parseLogfileHeader(b.bytes.data(), len, info)) << len;
+  }
+}
+
+TEST(LogfileFormat, FindsLastCheckpointBeforeTornTail) {
+  LogfileBuilder b(POLLED, 4);
+  size_t dataOffset = b.polledStream(4, 1).header();
+
+  size_t expectedPos = 0;
+  for (dlf_tick_t tick = 0; tick < 10; tick++) {
+    b.tick(tick);
+    if ((tick + 1) % 4 == 0) {
+      expectedPos = b.bytes.size();
+      b.checkpoint(tick);
+    }
+  }
+  // Sample bytes that look like a marker but do not point at themselves
+  b.put(static_cast<uint32_t>(0xFFFFFFFF));
+  // A checkpoint cut off mid-write
+  b.bytes.insert(b.bytes.end(), 5, 0xFF);
+
+  dlf_checkpoint_t c;
+  size_t pos = 0;
+  ASSERT_TRUE(format::findLastCheckpoint(b.bytes.data(), b.bytes.size(),
+                                         dataOffset, c, pos));
+  EXPECT_EQ(c.tick_span, 7u);
+  EXPECT_EQ(pos, expectedPos);
+}
+
+TEST(LogfileFormat, NoCheckpointInData) {
+  LogfileBuilder b(POLLED, 4);
+  size_t dataOffset = b.polledStream(4, 1).header();
+  b.put(static_cast<uint32_t>(0xFFFFFFFF));
+
+  dlf_checkpoint_t c;
+  size_t pos;
+  EXPECT_FALSE(format::findLastCheckpoint(b.bytes.data(), b.bytes.size(),
+                                          dataOffset, c, pos));
+}
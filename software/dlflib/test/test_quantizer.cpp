@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <string.h>
+
+#include "dlflib/datastream/quantizer.h"
+
+using dlf::datastream::Quantization;
+using dlf::datastream::Quantizer;
+
+TEST(Quantizer, StoresCoordinatesExactly) {
+  double lat = 37.4219983;
+  Quantizer q(lat, Quantization{1e-7});
+  ASSERT_EQ(q.size(), 4u);
+  q.sample();
+  int32_t raw;
+  memcpy(&raw, q.data(), sizeof(raw));
+  EXPECT_EQ(raw, 374219983);
+
+  lat = -122.0840575;
+  q.sample();
+  memcpy(&raw, q.data(), sizeof(raw));
+  EXPECT_EQ(raw, -1220840575);
+  EXPECT_STREQ(q.typeStructure(), "Quantized;value:int32_t:0:1e-07:0");
+}
+
+TEST(Quantizer, AppliesOffsetAndSaturates) {
+  const Quantization tenths{0.1, -40, Quantization::INT16};
+  EXPECT_EQ(Quantizer::quantize(-40, tenths), 0);
+  EXPECT_EQ(Quantizer::quantize(21.56, tenths), 616);
+  EXPECT_EQ(Quantizer::quantize(1e6, tenths), INT16_MAX);
+  EXPECT_EQ(Quantizer::quantize(-1e6, tenths), INT16_MIN);
+  EXPECT_EQ(Quantizer::quantize(NAN, tenths), 0);
+  EXPECT_EQ(Quantizer::quantize(1e300, Quantization{1e-7}), INT32_MAX);
+
+  float temperature = 21.56f;
+  Quantizer q(temperature, tenths);
+  ASSERT_EQ(q.size(), 2u);
+  q.sample();
+  int16_t raw;
+  memcpy(&raw, q.data(), sizeof(raw));
+  EXPECT_EQ(raw, 616);
+  EXPECT_STREQ(q.typeStructure(), "Quantized;value:int16_t:0:0.1:-40");
+}
+
+TEST(Quantizer, RejectsUnusableScales) {
+  EXPECT_TRUE(Quantizer::isValid(Quantization{1e-7}));
+  EXPECT_FALSE(Quantizer::isValid(Quantization{0}));
+  EXPECT_FALSE(Quantizer::isValid(Quantization{INFINITY}));
+  EXPECT_FALSE(Quantizer::isValid(Quantization{1, NAN}));
+}
@@ -0,0 +1,591 @@
+#include <gtest/gtest.h>
+
+#include "dlflib/format/recovery.h"
+#include "logfile_builder.h"
+
+using namespace dlf;
+using dlf::format::LogfileInfo;
+using dlf::format::MemoryByteSource;
+using dlf::format::RecoveryResult;
+using dlf::format::RecoveryScanner;
+using dlf::format::TruncatedByteSource;
+
+namespace {
+
+RecoveryResult recover(const std::vector<uint8_t>& bytes,
+                       size_t maxBytes = SIZE_MAX) {
+  MemoryByteSource src(bytes.data(), bytes.size());
+  LogfileInfo info;
+  EXPECT_TRUE(format::readLogfileHeader(src, info));
+  RecoveryScanner scanner(src, info);
+  scanner.step(maxBytes);
+  return scanner.result();
+}
+
+// Scans only the written length of the file, as DLFLogger::recoverRun() does
+RecoveryResult recoverWritten(const std::vector<uint8_t>& bytes) {
+  MemoryByteSource file(bytes.data(), bytes.size());
+  LogfileInfo info;
+  EXPECT_TRUE(format::readLogfileHeader(file, info));
+  TruncatedByteSource src(file, info.writtenLength(file.size()));
+  RecoveryScanner scanner(src, info);
+  scanner.step(SIZE_MAX);
+  return scanner.result();
+}
+
+}  // namespace
+
+TEST(Recovery, PolledBytesFollowSchedule) {
+  LogfileBuilder b(POLLED);
+  b.polledStream(4, 1).polledStream(8, 3, 1).header();
+  LogfileInfo info;
+  ASSERT_TRUE(format::parseLogfileHeader(b.bytes.data(), b.bytes.size(), info));
+
+  // Second stream is due on ticks 2, 5, 8, ...
+  EXPECT_EQ(format::polledBytesBefore(info, 0), 0u);
+  EXPECT_EQ(format::polledBytesBefore(info, 2), 8u);
+  EXPECT_EQ(format::polledBytesBefore(info, 3), 20u);
+  EXPECT_EQ(format::polledBytesBefore(info, 6), 40u);
+}
+
+TEST(Recovery, ReadsLongHeaders) {
+  LogfileBuilder b(EVENT);
+  for (int i = 0; i < 40; i++) {
+    b.eventStream(4);
+  }
+  size_t dataOffset = b.header();
+  b.bytes.insert(b.bytes.end(), 600, 0);
+
+  MemoryByteSource src(b.bytes.data(), b.bytes.size());
+  LogfileInfo info;
+  ASSERT_TRUE(format::readLogfileHeader(src, info));
+  EXPECT_EQ(info.dataOffset, dataOffset);
+}
+
+TEST(Recovery, PolledCutsPartialTick) {
+  LogfileBuilder b(POLLED);
+  size_t dataOffset = b.polledStream(4, 1).polledStream(8, 3, 1).header();
+  for (dlf_tick_t t = 0; t < 6; t++) {
+    b.tick(t);
+  }
+  const size_t valid = b.bytes.size();
+  b.bytes.insert(b.bytes.end(), 3, 0xEE);  // torn tick 6
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(valid - dataOffset, 40u);
+  EXPECT_TRUE(r.hasTicks);
+  EXPECT_EQ(r.tickSpan, 5u);
+}
+
+TEST(Recovery, PolledReportsLastTickWithData) {
+  LogfileBuilder b(POLLED);
+  b.polledStream(2, 10).header();
+  b.tick(0).tick(10).tick(20);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, b.bytes.size());
+  EXPECT_EQ(r.tickSpan, 20u);
+}
+
+TEST(Recovery, PolledEmptyData) {
+  LogfileBuilder b(POLLED);
+  size_t dataOffset = b.polledStream(4, 1).header();
+  b.bytes.push_back(0);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_FALSE(r.hasTicks);
+  EXPECT_EQ(r.validLength, dataOffset);
+}
+
+TEST(Recovery, PolledWalksFromLastCheckpoint) {
+  LogfileBuilder b(POLLED, 4);
+  b.polledStream(4, 1).polledStream(2, 2).header();
+  for (dlf_tick_t t = 0; t < 11; t++) {
+    b.tick(t);
+    if ((t + 1) % 4 == 0 || t == 5) {  // t == 5: requested by a flush
+      b.checkpoint(t);
+    }
+  }
+  const size_t valid = b.bytes.size();
+  b.bytes.insert(b.bytes.end(), 3, 0xEE);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 10u);
+}
+
+TEST(Recovery, PreallocatedStopsAtWrittenLength) {
+  LogfileBuilder b(POLLED);
+  b.preallocated().polledStream(4, 1).polledStream(2, 2).header();
+  for (dlf_tick_t t = 0; t < 6; t++) {
+    b.tick(t);
+  }
+  const size_t synced = b.bytes.size();
+  b.tick(6).tick(7);  // Written after the last sync
+  b.writtenBytes(synced);
+  // The rest of the extent: stale bytes that parse as samples
+  b.bytes.resize(b.bytes.size() + 64 * 1024, 0xAB);
+
+  RecoveryResult r = recoverWritten(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, synced);
+  EXPECT_EQ(r.tickSpan, 5u);
+
+  // Without the written length, the stale bytes would pass as ticks
+  EXPECT_EQ(recover(b.bytes).validLength, b.bytes.size());
+}
+
+TEST(Recovery, PreallocatedIgnoresStaleCheckpoints) {
+  // An earlier, longer run with the same layout left its data in the extent,
+  // checkpoints included, at the offsets this run would write them at
+  LogfileBuilder stale(POLLED, 4);
+  stale.preallocated().polledStream(4, 1).header();
+  for (dlf_tick_t t = 0; t < 40; t++) {
+    stale.tick(t, 0x11);
+    if ((t + 1) % 4 == 0) {
+      stale.checkpoint(t);
+    }
+  }
+
+  LogfileBuilder b(POLLED, 4);
+  b.preallocated().polledStream(4, 1).header();
+  for (dlf_tick_t t = 0; t < 10; t++) {
+    b.tick(t);
+    if ((t + 1) % 4 == 0) {
+      b.checkpoint(t);
+    }
+  }
+  const size_t synced = b.bytes.size();
+  b.writtenBytes(synced);
+  b.bytes.insert(b.bytes.end(), stale.bytes.begin() + synced,
+                 stale.bytes.end());
+
+  RecoveryResult r = recoverWritten(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, synced);
+  EXPECT_EQ(r.tickSpan, 9u);
+}
+
+TEST(Recovery, PolledWalksCodedBlocks) {
+  // Raw stream every tick, coded stream every tick in blocks of 3
+  LogfileBuilder b(POLLED);
+  b.polledStream(4, 1).polledStream(4, 1, 0, DLF_CODEC_DELTA_VARINT, 3);
+  b.header();
+  for (dlf_tick_t t = 0; t < 6; t++) {
+    b.tick(t);
+    if (t % 3 == 2) {
+      b.block(3, 4 + t);  // Block filled on ticks 2 and 5
+    }
+  }
+  const size_t valid = b.bytes.size();
+  b.tick(6).tick(7).tick(8);
+  b.block(3, 20).bytes.resize(b.bytes.size() - 1);  // Torn block at tick 8
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid + 2 * 4);
+  EXPECT_EQ(r.tickSpan, 7u);
+}
+
+TEST(Recovery, PolledCodedBlockMustBeFull) {
+  LogfileBuilder b(POLLED);
+  b.polledStream(4, 1, 0, DLF_CODEC_RLE, 2);
+  b.header();
+  b.block(2, 5);
+  const size_t valid = b.bytes.size();
+  b.block(1, 5);  // Partial blocks only appear after the last tick
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 1u);
+}
+
+TEST(Recovery, PolledWalksBlockCuts) {
+  // Raw stream every tick, coded stream every tick in blocks of 3, cut by a
+  // commit after tick 4
+  LogfileBuilder b(POLLED);
+  b.blockCuts().polledStream(4, 1).polledStream(4, 1, 0, DLF_CODEC_DELTA_VARINT,
+                                                3);
+  b.header();
+  for (dlf_tick_t t = 0; t < 5; t++) {
+    b.tick(t);
+    if (t == 2) {
+      b.block(3, 6);
+    }
+  }
+  b.blockCut(4).block(2, 5);  // Ticks 3 and 4
+  for (dlf_tick_t t = 5; t < 8; t++) {
+    b.tick(t);
+  }
+  b.block(3, 7);  // The next block fills on tick 7, not on tick 8
+  const size_t valid = b.bytes.size();
+  b.tick(8).bytes.resize(b.bytes.size() - 1);  // Torn tick
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 7u);
+}
+
+TEST(Recovery, PolledBlockCutMustHoldOpenSamples) {
+  // Coded stream every other tick in blocks of 4
+  LogfileBuilder b(POLLED);
+  b.blockCuts().polledStream(4, 2, 0, DLF_CODEC_RLE, 4).header();
+  b.blockCut(5).block(3, 5);  // Samples of ticks 0, 2 and 4
+  const size_t valid = b.bytes.size();
+  b.blockCut(7).block(2, 5);  // Only tick 6 was sampled since
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 5u);
+}
+
+TEST(Recovery, PolledWalksValidityBlocks) {
+  // A raw stream with validity is written in blocks like a coded one
+  LogfileBuilder b(POLLED);
+  b.polledStream(4, 1).polledStream(8, 1, 0, DLF_CODEC_RAW, 4,
+                                    DLF_VALIDITY_OMIT);
+  b.header();
+  for (dlf_tick_t t = 0; t < 8; t++) {
+    b.tick(t);
+    if (t == 3) {
+      b.block(4, 1 + 2 * 8);  // Two of four samples valid
+    } else if (t == 7) {
+      b.block(4, 1);  // No valid samples
+    }
+  }
+  const size_t valid = b.bytes.size();
+  b.tick(8).bytes.resize(b.bytes.size() - 1);  // Torn tick
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 7u);
+}
+
+TEST(Recovery, EventStopsAtTornRecord) {
+  LogfileBuilder b(EVENT);
+  b.eventStream(4).eventStream(16).header();
+  b.event(0, 0).event(1, 0).event(0, 7).event(1, 9);
+  const size_t valid = b.bytes.size();
+  b.event(1, 12);
+  b.bytes.resize(b.bytes.size() - 3);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 9u);
+}
+
+TEST(Recovery, EventStopsAtGarbage) {
+  LogfileBuilder b(EVENT);
+  b.eventStream(4).header();
+  b.event(0, 3).event(0, 5);
+  const size_t valid = b.bytes.size();
+
+  auto unknownStream = b;
+  unknownStream.put(static_cast<uint16_t>(7));
+  unknownStream.bytes.insert(unknownStream.bytes.end(), 20, 0);
+  EXPECT_EQ(recover(unknownStream.bytes).validLength, valid);
+
+  auto backInTime = b;
+  backInTime.event(0, 4);
+  EXPECT_EQ(recover(backInTime.bytes).validLength, valid);
+}
+
+TEST(Recovery, EventWalkIsIncremental) {
+  LogfileBuilder b(EVENT, 100);
+  b.eventStream(4).header();
+  for (dlf_tick_t t = 0; t < 500; t++) {
+    b.event(0, t);
+    if ((t + 1) % 100 == 0) {
+      b.checkpoint(t);
+    }
+  }
+  b.event(0, 500);
+  b.bytes.push_back(0);
+
+  MemoryByteSource src(b.bytes.data(), b.bytes.size());
+  LogfileInfo info;
+  ASSERT_TRUE(format::readLogfileHeader(src, info));
+  // No tail window, so the walk starts from the first record
+  RecoveryScanner scanner(src, info, 0);
+  int steps = 1;
+  while (!scanner.step(256)) {
+    steps++;
+  }
+  EXPECT_GT(steps, 10);
+  EXPECT_EQ(scanner.result().validLength, b.bytes.size() - 1);
+  EXPECT_EQ(scanner.result().tickSpan, 500u);
+}
+
+TEST(Recovery, EventStartsFromTailCheckpoint) {
+  LogfileBuilder b(EVENT, 100);
+  b.eventStream(4).header();
+  for (dlf_tick_t t = 0; t < 5000; t++) {
+    b.event(0, t);
+    if ((t + 1) % 100 == 0) {
+      b.checkpoint(t);
+    }
+  }
+  b.event(0, 5000);
+
+  // A single small step is enough since only the tail is walked
+  RecoveryResult r = recover(b.bytes, 4096);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, b.bytes.size());
+  EXPECT_EQ(r.tickSpan, 5000u);
+}
+
+TEST(Recovery, CompactEventStopsAtTornGroup) {
+  LogfileBuilder b(EVENT);
+  b.compactEvents().eventStream(4).eventStream(1).header();
+  b.group(0, {0, 1}).group(7, {1}).group(300, {0, 1});
+  const size_t valid = b.bytes.size();
+  b.group(301, {0, 1});
+  b.bytes.resize(b.bytes.size() - 2);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 300u);
+}
+
+TEST(Recovery, CompactEventStopsAtGarbage) {
+  LogfileBuilder b(EVENT);
+  b.compactEvents().eventStream(4).eventStream(1).header();
+  b.group(0, {0}).group(5, {0, 1});
+  const size_t valid = b.bytes.size();
+
+  auto unknownStream = b;
+  unknownStream.putVarint(1).putVarint(1).putVarint(9);
+  unknownStream.bytes.insert(unknownStream.bytes.end(), 8, 0);
+  EXPECT_EQ(recover(unknownStream.bytes).validLength, valid);
+
+  auto repeatedStream = b;
+  repeatedStream.group(6, {1, 1});
+  EXPECT_EQ(recover(repeatedStream.bytes).validLength, valid);
+
+  // Zeroed space past the end of the data reads as empty groups
+  auto zeros = b;
+  zeros.bytes.insert(zeros.bytes.end(), 16, 0);
+  EXPECT_EQ(recover(zeros.bytes).validLength, valid);
+
+  // An empty group must introduce a checkpoint
+  auto emptyGroup = b;
+  emptyGroup.putVarint(1).putVarint(0);
+  emptyGroup.bytes.insert(emptyGroup.bytes.end(), 16, 0);
+  EXPECT_EQ(recover(emptyGroup.bytes).validLength, valid);
+}
+
+TEST(Recovery, CompactEventStartsFromTailCheckpoint) {
+  LogfileBuilder b(EVENT, 100);
+  b.compactEvents().eventStream(4).eventStream(2).header();
+  for (dlf_tick_t t = 0; t < 5000; t++) {
+    if (t % 3 == 0) {
+      b.group(t, {0, 1});
+    } else if (t % 7 == 0) {
+      b.group(t, {1});
+    }
+    if ((t + 1) % 100 == 0) {
+      b.compactCheckpoint(t);
+    }
+  }
+  b.group(5003, {0});
+
+  RecoveryResult r = recover(b.bytes, 4096);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, b.bytes.size());
+  EXPECT_EQ(r.tickSpan, 5003u);
+
+  // The walk from the start of the file agrees
+  MemoryByteSource src(b.bytes.data(), b.bytes.size());
+  LogfileInfo info;
+  ASSERT_TRUE(format::readLogfileHeader(src, info));
+  RecoveryScanner scanner(src, info, 0);
+  while (!scanner.step(256)) {
+  }
+  EXPECT_EQ(scanner.result().validLength, b.bytes.size());
+  EXPECT_EQ(scanner.result().tickSpan, 5003u);
+}
+
+TEST(Recovery, EventWalksKeyframes) {
+  LogfileBuilder b(EVENT);
+  b.keyframes().eventStream(4).eventStream(16).header();
+  b.keyframe(0).event(1, 3).event(0, 8).keyframe(10).event(0, 12);
+  const size_t valid = b.bytes.size();
+  b.keyframe(20);
+  b.bytes.resize(b.bytes.size() - 4);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 12u);
+
+  // Without the flag, the marker is an unknown stream
+  LogfileBuilder plain(EVENT);
+  plain.eventStream(4).eventStream(16).header();
+  const size_t dataOffset = plain.bytes.size();
+  plain.keyframes().keyframe(0);
+  EXPECT_EQ(recover(plain.bytes).validLength, dataOffset);
+}
+
+TEST(Recovery, CompactEventWalksKeyframes) {
+  LogfileBuilder b(EVENT, 50);
+  b.compactEvents().keyframes().eventStream(4).eventStream(1).header();
+  b.keyframe(0).group(2, {1}).group(9, {0, 1}).keyframe(40);
+  b.compactCheckpoint(49).group(51, {0});
+  const size_t valid = b.bytes.size();
+  b.keyframe(60);
+  b.bytes.resize(b.bytes.size() - 1);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 51u);
+
+  // A keyframe for another tick than its group's is garbage
+  auto wrongTick = b;
+  wrongTick.bytes.resize(valid);
+  wrongTick.putVarint(5).putVarint(0);
+  dlf_keyframe_t k;
+  k.tick = 99;
+  k.byte_offset = wrongTick.bytes.size();
+  wrongTick.put(k);
+  wrongTick.bytes.insert(wrongTick.bytes.end(), 5, 0);
+  EXPECT_EQ(recover(wrongTick.bytes).validLength, valid);
+}
+
+TEST(Recovery, EventWalksTimeAnchors) {
+  LogfileBuilder b(EVENT);
+  b.timeAnchors().eventStream(4).header();
+  b.timeAnchor(0, 1000).event(0, 3).timeAnchor(3, 2000).event(0, 7);
+  const size_t valid = b.bytes.size();
+  b.timeAnchor(9, 3000);
+  b.bytes.resize(b.bytes.size() - 1);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 7u);
+}
+
+TEST(Recovery, CompactEventWalksTimeAnchors) {
+  LogfileBuilder b(EVENT, 20);
+  b.compactEvents().timeAnchors().eventStream(2).header();
+  b.timeAnchor(0, 5).group(4, {0}).timeAnchor(4, 9).compactCheckpoint(19);
+  b.group(25, {0}).timeAnchor(30, 12);
+  const size_t valid = b.bytes.size();
+  b.group(31, {0});
+  b.bytes.resize(b.bytes.size() - 1);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 30u);
+}
+
+TEST(Recovery, EventWalksMessages) {
+  LogfileBuilder b(EVENT);
+  b.eventStream(4).messageStream(8).header();
+  b.event(0, 0).message(1, 0, "idle").message(1, 0, "").event(0, 2);
+  b.message(1, 5, "running");
+  const size_t valid = b.bytes.size();
+  b.message(1, 6, "stopped");
+  b.bytes.resize(b.bytes.size() - 3);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 5u);
+
+  // A message longer than the stream allows is garbage
+  auto tooLong = b;
+  tooLong.bytes.resize(valid);
+  tooLong.message(1, 6, "overflowing");
+  EXPECT_EQ(recover(tooLong.bytes).validLength, valid);
+}
+
+TEST(Recovery, CompactEventWalksMessages) {
+  LogfileBuilder b(EVENT, 20);
+  b.compactEvents().keyframes().eventStream(2).messageStream(16).header();
+  b.keyframe(0).group(3, {0, 1, 1, 1}).group(4, {1}, 0xAB, 0);
+  b.compactCheckpoint(19).keyframe(20).group(22, {1, 1}, 0xAB, 16);
+  const size_t valid = b.bytes.size();
+  b.group(23, {0, 1});
+  b.bytes.resize(b.bytes.size() - 1);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 22u);
+
+  // Only message streams may repeat within a group
+  auto repeated = b;
+  repeated.bytes.resize(valid);
+  repeated.group(23, {0, 0});
+  EXPECT_EQ(recover(repeated.bytes).validLength, valid);
+}
+
+TEST(Recovery, PolledSamplesInFollowSchedule) {
+  format::LogfileStreamInfo s;
+  s.tickInterval = 4;
+  s.tickPhase = 1;  // Due on ticks 3, 7, 11, ...
+  EXPECT_EQ(format::polledSamplesIn(s, 0, 3), 0u);
+  EXPECT_EQ(format::polledSamplesIn(s, 0, 4), 1u);
+  EXPECT_EQ(format::polledSamplesIn(s, 3, 5), 2u);
+  EXPECT_EQ(format::polledSamplesIn(s, 8, 100), 25u);
+}
+
+TEST(Recovery, PolledWalksColumnBlocks) {
+  LogfileBuilder b(POLLED);
+  b.columnar().polledStream(8, 1).polledStream(4, 5, 2).header();
+  b.columnBlock(0, 64).columnBlock(64, 64).columnBlock(128, 10);
+  const size_t valid = b.bytes.size();
+  b.columnBlock(138, 64);
+  b.bytes.resize(b.bytes.size() - 7);
+
+  RecoveryResult r = recover(b.bytes);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, valid);
+  EXPECT_EQ(r.tickSpan, 137u);
+
+  // A block that skips ticks, or whose column does not match the schedule,
+  // is garbage
+  auto gap = b;
+  gap.bytes.resize(valid);
+  gap.columnBlock(140, 64);
+  EXPECT_EQ(recover(gap.bytes).validLength, valid);
+
+  auto shortColumn = b;
+  shortColumn.bytes.resize(valid);
+  dlf_column_block_header_t h;
+  h.first_tick = 138;
+  h.tick_count = 10;
+  shortColumn.put(h).put(uint32_t(80)).put(uint32_t(4));
+  shortColumn.bytes.insert(shortColumn.bytes.end(), 84, 0);
+  EXPECT_EQ(recover(shortColumn.bytes).validLength, valid);
+}
+
+TEST(Recovery, PolledColumnBlocksResumeFromCheckpoint) {
+  LogfileBuilder b(POLLED, 100);
+  b.columnar().polledStream(2, 1).header();
+  for (dlf_tick_t t = 0; t < 3000; t += 50) {
+    b.columnBlock(t, 50);
+    if ((t + 50) % 100 == 0) {
+      b.checkpoint(t + 49);
+    }
+  }
+  b.columnBlock(3000, 20);
+
+  RecoveryResult r = recover(b.bytes, 4096);
+  EXPECT_TRUE(r.complete);
+  EXPECT_EQ(r.validLength, b.bytes.size());
+  EXPECT_EQ(r.tickSpan, 3019u);
+}
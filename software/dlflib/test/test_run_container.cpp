@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dlflib/format/run_container.h"
+#include "logfile_builder.h"
+
+using namespace dlf;
+using dlf::format::MemoryByteSource;
+using dlf::format::RunContainerReader;
+using dlf::format::SectionByteSource;
+
+namespace {
+
+template <typename T>
+void put(std::vector<uint8_t>& out, const T& v) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+  out.insert(out.end(), p, p + sizeof(T));
+}
+
+// Builds run.dlf images the way RunContainer writes them
+struct ContainerBuilder {
+  std::vector<uint8_t> bytes;
+
+  ContainerBuilder() { put(bytes, dlf_run_container_header_t{}); }
+
+  void section(uint8_t tag, const uint8_t* data, size_t len) {
+    bytes.push_back(tag);
+    put(bytes, static_cast<uint32_t>(len));
+    bytes.insert(bytes.end(), data, data + len);
+  }
+
+  void section(uint8_t tag, const std::vector<uint8_t>& data) {
+    section(tag, data.data(), data.size());
+  }
+
+  void commit(dlf_tick_t tick, uint64_t polledBytes, uint64_t eventBytes) {
+    dlf_container_commit_t c;
+    c.tick = tick;
+    c.polled_bytes = polledBytes;
+    c.event_bytes = eventBytes;
+    section(DLF_SECTION_COMMIT, reinterpret_cast<uint8_t*>(&c), sizeof(c));
+  }
+};
+
+std::vector<uint8_t> readAll(RunContainerReader& r, dlf_section_tag_e tag,
+                             size_t offset, size_t len) {
+  std::vector<uint8_t> out(len);
+  out.resize(r.readSection(tag, offset, out.data(), len));
+  return out;
+}
+
+}  // namespace
+
+TEST(RunContainer, ReassemblesInterleavedSections) {
+  ContainerBuilder b;
+  std::vector<uint8_t> polled, event;
+  for (int i = 0; i < 300; i++) {
+    std::vector<uint8_t> p(1 + i % 7, static_cast<uint8_t>(i));
+    std::vector<uint8_t> e(1 + i % 3, static_cast<uint8_t>(0x80 ^ i));
+    b.section(DLF_SECTION_POLLED, p);
+    b.section(DLF_SECTION_EVENT, e);
+    polled.insert(polled.end(), p.begin(), p.end());
+    event.insert(event.end(), e.begin(), e.end());
+  }
+
+  MemoryByteSource src(b.bytes.data(), b.bytes.size());
+  RunContainerReader r(src);
+  ASSERT_TRUE(r.valid());
+  EXPECT_EQ(r.validLength(), b.bytes.size());
+  ASSERT_EQ(r.sectionBytes(DLF_SECTION_POLLED), polled.size());
+  ASSERT_EQ(r.sectionBytes(DLF_SECTION_EVENT), event.size());
+  EXPECT_EQ(r.sectionBytes(DLF_SECTION_META), 0u);
+
+  EXPECT_EQ(readAll(r, DLF_SECTION_POLLED, 0, polled.size()), polled);
+  EXPECT_EQ(readAll(r, DLF_SECTION_EVENT, 0, event.size()), event);
+
+  // Reads spanning sections, going backwards past the sparse index entries
+  for (size_t off = polled.size() - 10; off > 100; off -= 97) {
+    std::vector<uint8_t> want(polled.begin() + off, polled.begin() + off + 10);
+    ASSERT_EQ(readAll(r, DLF_SECTION_POLLED, off, 10), want) << off;
+  }
+  EXPECT_EQ(readAll(r, DLF_SECTION_EVENT, event.size() - 2, 10).size(), 2u);
+}
+
+TEST(RunContainer, DropsTornSectionAndSkipsUnknownTags) {
+  ContainerBuilder b;
+  b.section(DLF_SECTION_POLLED, {1, 2, 3});
+  b.section(0x7F, {9, 9});  // From a newer writer
+  b.section(DLF_SECTION_POLLED, {4, 5});
+  const size_t valid = b.bytes.size();
+  b.section(DLF_SECTION_POLLED, {6, 7, 8, 9});
+  b.bytes.resize(b.bytes.size() - 2);
+
+  MemoryByteSource src(b.bytes.data(), b.bytes.size());
+  RunContainerReader r(src);
+  ASSERT_TRUE(r.valid());
+  EXPECT_EQ(r.validLength(), valid);
+  EXPECT_EQ(readAll(r, DLF_SECTION_POLLED, 0, 16),
+            std::vector<uint8_t>({1, 2, 3, 4, 5}));
+
+  // Zeroed space past the end, as left by a preallocating file system
+  b.bytes.resize(valid);
+  b.bytes.insert(b.bytes.end(), 64, 0);
+  MemoryByteSource zeroed(b.bytes.data(), b.bytes.size());
+  RunContainerReader z(zeroed);
+  EXPECT_EQ(z.validLength(), valid);
+  EXPECT_EQ(z.sectionBytes(DLF_SECTION_POLLED), 5u);
+
+  std::vector<uint8_t> notContainer(64, 0x14);
+  MemoryByteSource other(notContainer.data(), notContainer.size());
+  EXPECT_FALSE(RunContainerReader(other).valid());
+}
+
+TEST(RunContainer, CommitLimitsLogicalFiles) {
+  ContainerBuilder b;
+  b.section(DLF_SECTION_EVENT, {1, 2, 3, 4});
+  b.commit(10, 0, 3);
+  b.section(DLF_SECTION_EVENT, {5, 6});
+
+  MemoryByteSource src(b.bytes.data(), b.bytes.size());
+  RunContainerReader r(src);
+  dlf_container_commit_t c;
+  ASSERT_TRUE(r.lastCommit(c));
+  EXPECT_EQ(c.tick, 10u);
+  EXPECT_EQ(c.event_bytes, 3u);
+
+  SectionByteSource all(r, DLF_SECTION_EVENT);
+  EXPECT_EQ(all.size(), 6u);
+  SectionByteSource committed(r, DLF_SECTION_EVENT, c.event_bytes);
+  EXPECT_EQ(committed.size(), 3u);
+  uint8_t buf[8];
+  EXPECT_EQ(committed.read(1, buf, sizeof(buf)), 2u);
+  EXPECT_EQ(buf[1], 3);
+
+  ContainerBuilder none;
+  MemoryByteSource empty(none.bytes.data(), none.bytes.size());
+  RunContainerReader e(empty);
+  EXPECT_TRUE(e.valid());
+  EXPECT_FALSE(e.lastCommit(c));
+}
+
+TEST(RunContainer, SectionsRecoverLikeFiles) {
+  LogfileBuilder lb(POLLED);
+  lb.polledStream(4, 1).header();
+  for (dlf_tick_t t = 0; t < 20; t++) {
+    lb.tick(t);
+  }
+  const size_t valid = lb.bytes.size();
+  lb.bytes.insert(lb.bytes.end(), 2, 0xEE);  // torn tick 20
+
+  // Split at arbitrary points, as the flusher would
+  ContainerBuilder b;
+  b.section(DLF_SECTION_META, {0});
+  for (size_t off = 0; off < lb.bytes.size(); off += 13) {
+    const size_t n = std::min<size_t>(13, lb.bytes.size() - off);
+    b.section(DLF_SECTION_POLLED, lb.bytes.data() + off, n);
+  }
+
+  MemoryByteSource src(b.bytes.data(), b.bytes.size());
+  RunContainerReader r(src);
+  SectionByteSource polled(r, DLF_SECTION_POLLED);
+  format::LogfileInfo info;
+  ASSERT_TRUE(format::readLogfileHeader(polled, info));
+  format::RecoveryScanner scanner(polled, info);
+  scanner.step(SIZE_MAX);
+  const format::RecoveryResult& res = scanner.result();
+  ASSERT_TRUE(res.complete);
+  EXPECT_EQ(res.tickSpan, 19u);
+  EXPECT_EQ(res.validLength, valid);
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dlflib/storage/memory_block_device.h"
+#include "dlflib/storage/raw_sector_sink.h"
+#include "dlflib/storage/sector_writer.h"
+#include "dlflib/util/util.h"
+
+using dlf::storage::LogSink;
+using dlf::storage::MemoryBlockDevice;
+using dlf::storage::MemoryRawVolume;
+using dlf::storage::RawExtent;
+using dlf::storage::RawSectorSink;
+using dlf::storage::SectorWriter;
+
+namespace {
+
+/**
+ * Stand-in for a FileSink appending to a finalized file of a MemoryRawVolume.
+ */
+class AppendSink : public LogSink {
+ public:
+  AppendSink(MemoryRawVolume& vol, const char* path, std::vector<uint8_t>& out)
+      : vol_(vol), path_(path), out_(out) {}
+
+  bool open() override {
+    out_ = vol_.read(path_);
+    return !out_.empty();
+  }
+  size_t write(const uint8_t* data, size_t len) override {
+    out_.insert(out_.end(), data, data + len);
+    return len;
+  }
+  void flush() override {}
+  void sync() override {}
+  bool patch(size_t offset, const void* data, size_t len) override {
+    if (offset + len > out_.size()) {
+      return false;
+    }
+    memcpy(out_.data() + offset, data, len);
+    return true;
+  }
+  void close() override {}
+
+ private:
+  MemoryRawVolume& vol_;
+  const char* path_;
+  std::vector<uint8_t>& out_;
+};
+
+std::vector<uint8_t> pattern(size_t len) {
+  std::vector<uint8_t> v(len);
+  for (size_t i = 0; i < len; i++) {
+    v[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  return v;
+}
+
+}  // namespace
+
+TEST(SectorWriter, RoundTripThroughVolume) {
+  MemoryBlockDevice dev(256);
+  MemoryRawVolume vol(dev);
+  RawExtent extent;
+  ASSERT_TRUE(vol.allocate("/run/polled.dlf", 64 * 1024, extent));
+
+  SectorWriter w(dev, extent);
+  auto data = pattern(10000);
+  // Odd-sized chunks, like the flusher draining a stream buffer
+  for (size_t off = 0; off < data.size(); off += 333) {
+    size_t n = std::min<size_t>(333, data.size() - off);
+    ASSERT_EQ(w.write(data.data() + off, n), n);
+  }
+  ASSERT_TRUE(w.flush());
+  ASSERT_TRUE(vol.finalize("/run/polled.dlf", w.bytesWritten()));
+
+  EXPECT_EQ(vol.read("/run/polled.dlf"), data);
+}
+
+TEST(SectorWriter, WritesWholeStagingBuffers) {
+  MemoryBlockDevice dev(256);
+  RawExtent extent{0, 256};
+  SectorWriter w(dev, extent, 8);
+
+  // 64 KiB in 512 byte writes: one device write per 4 KiB of staging
+  auto data = pattern(512);
+  for (int i = 0; i < 128; i++) {
+    w.write(data.data(), data.size());
+  }
+  EXPECT_EQ(dev.writeCalls, 16u);
+  EXPECT_EQ(dev.sectorsWritten, 128u);
+  EXPECT_EQ(dev.readCalls, 0u);
+}
+
+TEST(SectorWriter, FlushPadsPartialSectorAndKeepsItStaged) {
+  MemoryBlockDevice dev(16);
+  RawExtent extent{0, 16};
+  SectorWriter w(dev, extent, 8);
+
+  auto data = pattern(700);
+  w.write(data.data(), data.size());
+  ASSERT_TRUE(w.flush());
+  EXPECT_EQ(dev.sectorsWritten, 2u);
+  EXPECT_EQ(memcmp(dev.data(), data.data(), data.size()), 0);
+  EXPECT_EQ(dev.data()[700], 0);
+
+  // Later writes continue in the same sectors
+  w.write(data.data(), 100);
+  ASSERT_TRUE(w.flush());
+  EXPECT_EQ(memcmp(dev.data() + 700, data.data(), 100), 0);
+  EXPECT_EQ(w.bytesWritten(), 800u);
+}
+
+TEST(SectorWriter, PatchesWrittenAndStagedBytes) {
+  MemoryBlockDevice dev(32);
+  RawExtent extent{4, 28};
+  SectorWriter w(dev, extent, 2);
+
+  auto data = pattern(1500);  // 1024 bytes hit the device, 476 stay staged
+  w.write(data.data(), data.size());
+  ASSERT_EQ(dev.writeCalls, 1u);
+
+  const uint8_t header[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  ASSERT_TRUE(w.patch(3, header, sizeof(header)));
+  // Straddles the device/staging boundary
+  ASSERT_TRUE(w.patch(1020, header, sizeof(header)));
+  EXPECT_FALSE(w.patch(1499, header, sizeof(header)));
+
+  ASSERT_TRUE(w.flush());
+  const uint8_t* base = dev.data() + 4 * 512;
+  EXPECT_EQ(memcmp(base + 3, header, 8), 0);
+  EXPECT_EQ(memcmp(base + 1020, header, 8), 0);
+  EXPECT_EQ(base[11], data[11]);
+  EXPECT_EQ(base[1028], data[1028]);
+}
+
+TEST(SectorWriter, StopsAtExtentCapacity) {
+  MemoryBlockDevice dev(8);
+  RawExtent extent{0, 2};
+  SectorWriter w(dev, extent, 1);
+
+  auto data = pattern(1500);
+  EXPECT_EQ(w.write(data.data(), data.size()), 1024u);
+  EXPECT_EQ(w.write(data.data(), 1), 0u);
+  EXPECT_EQ(w.bytesWritten(), w.capacityBytes());
+  EXPECT_FALSE(w.failed());
+  // Nothing may land outside the extent
+  EXPECT_EQ(dev.data()[1024], 0);
+}
+
+TEST(MemoryRawVolume, FailsWhenDeviceIsFull) {
+  MemoryBlockDevice dev(8);
+  MemoryRawVolume vol(dev);
+  RawExtent extent;
+  EXPECT_TRUE(vol.allocate("/a", 3 * 512, extent));
+  EXPECT_FALSE(vol.allocate("/b", 6 * 512, extent));
+  EXPECT_TRUE(vol.read("/a").empty());  // not finalized yet
+}
+
+TEST(RawSectorSink, AppendsPastTheExtentThroughOverflowSink) {
+  MemoryBlockDevice dev(64);
+  MemoryRawVolume vol(dev);
+  std::vector<uint8_t> file;
+  RawSectorSink sink(
+      vol, "/run/polled.dlf", 4 * 512,
+      dlf::util::make_unique<AppendSink>(vol, "/run/polled.dlf", file));
+  ASSERT_TRUE(sink.open());
+
+  auto data = pattern(5000);
+  for (size_t off = 0; off < data.size(); off += 333) {
+    size_t n = std::min<size_t>(333, data.size() - off);
+    ASSERT_EQ(sink.write(data.data() + off, n), n);
+  }
+  // The extent was finalized at full length when it filled up
+  EXPECT_EQ(vol.read("/run/polled.dlf").size(), 4 * 512u);
+
+  // Header updates still land in the raw part of the file
+  const uint8_t tickSpan[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  ASSERT_TRUE(sink.patch(3, tickSpan, sizeof(tickSpan)));
+  sink.sync();
+  sink.close();
+
+  memcpy(data.data() + 3, tickSpan, sizeof(tickSpan));
+  EXPECT_EQ(file, data);
+}
+
+TEST(RawSectorSink, WritesPastTheExtentAreShortWithoutOverflowSink) {
+  MemoryBlockDevice dev(64);
+  MemoryRawVolume vol(dev);
+  RawSectorSink sink(vol, "/run/polled.dlf", 2 * 512);
+  ASSERT_TRUE(sink.open());
+
+  auto data = pattern(1500);
+  EXPECT_EQ(sink.write(data.data(), data.size()), 1024u);
+  EXPECT_EQ(sink.write(data.data(), 1), 0u);
+  sink.close();
+  EXPECT_EQ(vol.read("/run/polled.dlf").size(), 1024u);
+}
+
+TEST(RawSectorSink, CloseAfterDeviceErrorKeepsWhatReachedTheCard) {
+  MemoryBlockDevice dev(64);
+  MemoryRawVolume vol(dev);
+  RawSectorSink sink(vol, "/run/polled.dlf", 32 * 512);
+  ASSERT_TRUE(sink.open());
+
+  // One staging buffer (8 sectors) makes it out before the card goes away
+  auto data = pattern(10000);
+  dev.failAfterWrites = 1;
+  EXPECT_LT(sink.write(data.data(), data.size()), data.size());
+  sink.close();
+
+  auto file = vol.read("/run/polled.dlf");
+  ASSERT_EQ(file.size(), 8 * 512u);
+  EXPECT_TRUE(std::equal(file.begin(), file.end(), data.begin()));
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "dlflib/dlf_struct.h"
+
+namespace {
+
+struct GpsData {
+  double lat;
+  double lng;
+  double alt;
+  uint32_t satellites;
+};
+DLF_STRUCT(GpsData, lat, lng, alt, satellites)
+
+enum class Mode : uint8_t { IDLE, RUNNING };
+
+struct Status {
+  Mode mode;
+  bool fault;
+  int16_t temperature;
+  long counter;
+  unsigned long long uptime;
+  float voltage;
+};
+DLF_STRUCT(Status, mode, fault, temperature, uptime, voltage)
+
+struct Wide {
+  uint8_t a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p;
+};
+DLF_STRUCT(Wide, a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p)
+
+}  // namespace
+
+TEST(Struct, GeneratesTypeStructure) {
+  EXPECT_STREQ(dlf::structTypeStructure<GpsData>(),
+               "GpsData;lat:double:0;lng:double:8;alt:double:16;"
+               "satellites:uint32_t:24");
+}
+
+TEST(Struct, NamesFieldTypesBySizeAndOffsetsByLayout) {
+  const std::string expected =
+      "Status;mode:uint8_t:0;fault:bool:1;temperature:int16_t:2;"
+      "uptime:uint64_t:" +
+      std::to_string(offsetof(Status, uptime)) +
+      ";voltage:float:" + std::to_string(offsetof(Status, voltage));
+  EXPECT_EQ(dlf::structTypeStructure<Status>(), expected);
+}
+
+TEST(Struct, HandlesManyFields) {
+  const std::string s = dlf::structTypeStructure<Wide>();
+  EXPECT_EQ(s.rfind("Wide;a:uint8_t:0;b:uint8_t:1;", 0), 0u);
+  EXPECT_NE(s.find(";p:uint8_t:15"), std::string::npos);
+}
+
+TEST(Struct, DetectsRegisteredTypes) {
+  EXPECT_TRUE(dlf::IsDlfStruct<GpsData>::value);
+  EXPECT_FALSE(dlf::IsDlfStruct<double>::value);
+  EXPECT_FALSE(dlf::IsDlfStruct<Mode>::value);
+}
+
+namespace {
+
+struct Spectrum {
+  uint32_t seq;
+  int16_t bins[8];
+  std::array<float, 3> accel;
+};
+DLF_STRUCT(Spectrum, seq, bins, accel)
+
+}  // namespace
+
+TEST(Struct, NamesArrays) {
+  using Bytes = std::array<uint8_t, 1024>;
+  using Flags = const std::array<bool, 2>;
+  EXPECT_STREQ(dlf::typeStructureOf<float[32]>(), "float[32]");
+  EXPECT_STREQ(dlf::typeStructureOf<Bytes>(), "uint8_t[1024]");
+  EXPECT_STREQ(dlf::typeStructureOf<Mode[4]>(), "uint8_t[4]");
+  EXPECT_STREQ(dlf::typeStructureOf<GpsData>(),
+               dlf::structTypeStructure<GpsData>());
+  EXPECT_STREQ(dlf::structTypeStructure<Spectrum>(),
+               "Spectrum;seq:uint32_t:0;bins:int16_t[8]:4;accel:float[3]:20");
+
+  EXPECT_TRUE(dlf::HasTypeStructure<double[2]>::value);
+  EXPECT_TRUE(dlf::HasTypeStructure<Flags>::value);
+  EXPECT_TRUE(dlf::HasTypeStructure<GpsData>::value);
+  EXPECT_FALSE(dlf::HasTypeStructure<double>::value);
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include "dlflib/format/time_base.h"
+
+using namespace dlf;
+using dlf::format::TimeBase;
+
+namespace {
+
+dlf_time_anchor_t anchor(dlf_tick_t tick, int64_t epochUs) {
+  dlf_time_anchor_t a;
+  a.tick = tick;
+  a.byte_offset = 0;
+  a.epoch_us = epochUs;
+  a.source = DLF_TIME_SOURCE_GPS;
+  return a;
+}
+
+}  // namespace
+
+TEST(TimeBase, FallsBackToMetaWithoutAnchors) {
+  TimeBase t(1000, 1700000000);
+  EXPECT_EQ(t.epochUs(0), 1700000000000000);
+  EXPECT_EQ(t.epochUs(2500), 1700000002500000);
+}
+
+TEST(TimeBase, InterpolatesBetweenAnchors) {
+  // 1 ms ticks on a crystal running 100 ppm fast
+  TimeBase t(1000, 1700000000);
+  ASSERT_TRUE(t.add(anchor(0, 1700000000250000)));
+  ASSERT_TRUE(t.add(anchor(1000000, 1700000999900000)));
+
+  EXPECT_EQ(t.epochUs(0), 1700000000250000);
+  EXPECT_EQ(t.epochUs(500000), 1700000500075000);
+  EXPECT_EQ(t.epochUs(1000000), 1700000999900000);
+  // Past the last anchor, ticks count at the nominal rate
+  EXPECT_EQ(t.epochUs(1000010), 1700000999910000);
+}
+
+TEST(TimeBase, NominalRateBeforeFirstAnchor) {
+  TimeBase t(500, 0);
+  ASSERT_TRUE(t.add(anchor(100, 10000000)));
+  EXPECT_EQ(t.epochUs(40), 9970000);
+}
+
+TEST(TimeBase, RejectsOutOfOrderAndReplacesSameTick) {
+  TimeBase t(1000, 0);
+  ASSERT_TRUE(t.add(anchor(10, 1000)));
+  ASSERT_TRUE(t.add(anchor(20, 2000)));
+  EXPECT_FALSE(t.add(anchor(15, 9999)));
+  ASSERT_TRUE(t.add(anchor(20, 2500)));
+  ASSERT_EQ(t.anchors().size(), 2u);
+  EXPECT_EQ(t.epochUs(20), 2500);
+}
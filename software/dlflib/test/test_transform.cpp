@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dlflib/datastream/transform.h"
+#include "dlflib/dlf_cfg.h"
+
+using dlf::datastream::Transform;
+
+namespace {
+
+// Runs `inputs` through `t` as samples 0, 1, ..., collecting what it passes
+std::vector<double> run(Transform& t, const std::vector<double>& inputs) {
+  std::vector<double> out;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    double v = inputs[i];
+    if (t.apply(v, i)) {
+      out.push_back(v);
+    }
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(Transform, ScalesAndAverages) {
+  Transform t;
+  t.scale(2, 1).movingAverage(3);
+  ASSERT_TRUE(t.valid());
+  EXPECT_EQ(run(t, {1, 2, 3, 4, 5}), (std::vector<double>{3, 4, 5, 7, 9}));
+}
+
+TEST(Transform, LowPassAndDifference) {
+  Transform t;
+  t.lowPass(0.5);
+  EXPECT_EQ(run(t, {4, 8, 8, 0}), (std::vector<double>{4, 6, 7, 3.5}));
+
+  Transform d;
+  d.difference();
+  EXPECT_EQ(run(d, {10, 12, 11}), (std::vector<double>{0, 2, -1}));
+}
+
+TEST(Transform, DecimatesBySampleIndex) {
+  Transform t;
+  t.movingAverage(2).decimate(2).difference().decimate(3);
+  ASSERT_TRUE(t.valid());
+  EXPECT_EQ(t.decimation(), 6u);
+
+  // Averages of (i - 1, i) at even i, differenced, kept at every sixth i
+  std::vector<double> in;
+  for (int i = 0; i < 13; i++) {
+    in.push_back(i);
+  }
+  EXPECT_EQ(run(t, in), (std::vector<double>{0, 2, 2}));
+
+  // Indices, not call counts, pick the samples, so a late start lines up
+  t.reset();
+  double v = 5;
+  EXPECT_FALSE(t.apply(v, 7));
+  EXPECT_TRUE(t.apply(v, 12));
+}
+
+TEST(Transform, ResetClearsState) {
+  Transform t;
+  t.movingAverage(4);
+  run(t, {100, 100, 100});
+  t.reset();
+  EXPECT_EQ(run(t, {1, 3}), (std::vector<double>{1, 2}));
+}
+
+TEST(Transform, RejectsBadStagesAndDescribesChain) {
+  EXPECT_FALSE(Transform().movingAverage(0).valid());
+  EXPECT_FALSE(Transform().movingAverage(DLF_TRANSFORM_MAX_WINDOW + 1).valid());
+  EXPECT_FALSE(Transform().lowPass(0).valid());
+  EXPECT_FALSE(Transform().decimate(0).valid());
+  Transform full;
+  for (size_t i = 0; i <= Transform::MAX_STAGES; i++) {
+    full.difference();
+  }
+  EXPECT_FALSE(full.valid());
+
+  Transform t;
+  t.scale(0.01).lowPass(0.25).decimate(10);
+  EXPECT_EQ(t.describe(), "scale(0.01,0) > lowPass(0.25) > decimate(10)");
+}
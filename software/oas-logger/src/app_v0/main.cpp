@@ -675,6 +675,8 @@ void initializeDLFLogger() {
   options.enableChunkedUpload = ENABLE_CHUNKED_UPLOAD;
   options.partialRunUploadIntervalSecs =
       LOGGER_PARTIAL_RUN_UPLOAD_INTERVAL_SECS;
+  // Lets begin() truncate torn data off runs interrupted by power loss
+  logger.setVfsMountPoint("/sd");  // SD (default mount point)
   logger.syncTo(UPLOAD_ENDPOINT, deviceUid, options).begin();
 
   EZLOG_INFO("DLF logger initialized");
@@ -311,7 +311,8 @@ void loop() {
     }
   }
 
-  // Update WiFi RSSI data
+  // Update WiFi RSSI data. WiFi.RSSI() takes the WiFi API lock, so it is
+  // called here rather than by the sampler.
   static unsigned long lastWifiRssiMillis{0};
   if (now - lastWifiRssiMillis >= 5000) {
     lastWifiRssiMillis = now;
@@ -873,10 +874,10 @@ void initializeDLFLogger() {
   POLL(logger, gpsData.lng, gpsDataLogInterval, gpsDataMutex);
   POLL(logger, gpsData.alt, gpsDataLogInterval, gpsDataMutex);
 
+  // Logs the value cached by loop()
   auto wifiRssiLogInterval{std::chrono::seconds(5)};
-  // Note: we don't use the POLL macro here since we want make sure the stream
-  // id is "wifiRssi" and not "const_cast<int&>(wifiRssi)"
-  logger.poll(const_cast<int&>(wifiRssi), "wifiRssi", wifiRssiLogInterval);
+  logger.poll([]() -> int32_t { return wifiRssi; }, "wifiRssi",
+              wifiRssiLogInterval);
 
   dlf::components::UploaderComponent::Options options;
   options.retentionMode = LOGGER_RETENTION_MODE;
@@ -885,6 +886,8 @@ void initializeDLFLogger() {
   options.enableChunkedUpload = ENABLE_CHUNKED_UPLOAD;
   options.partialRunUploadIntervalSecs =
       LOGGER_PARTIAL_RUN_UPLOAD_INTERVAL_SECS;
+  // Lets begin() truncate torn data off runs interrupted by power loss
+  logger.setVfsMountPoint("/sdcard");  // SD_MMC
   logger.syncTo(UPLOAD_ENDPOINT, deviceUid, options).begin();
 
   EZLOG_INFO("DLF logger initialized");